@@ -0,0 +1,951 @@
+/*@file
+  Implements a benchmarking entry point for the SimilarityChecker project.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include <ScCleanseConfigs.h>
+#include <ScCleanseInput.h>
+#include <ScDistances.h>
+#include <ScSafeInt.h>
+#include <ScSimilarityChecker.h>
+#include <ScStringMisc.h>
+
+#include "ScCommon.h"
+
+///
+/// The minimum duration, in seconds, of every measurement. Measurements are
+/// repeated until it is reached to reduce the timer resolution's impact.
+///
+#define SC_BENCHMARK_MIN_SECONDS  0.25
+
+///
+/// The number of line pairs of every distance benchmark.
+///
+#define SC_BENCHMARK_NUM_LINE_PAIRS  64U
+
+///
+/// The size, in characters, of the synthetic inputs of the cleansing and line
+/// information benchmarks.
+///
+#define SC_BENCHMARK_CLEANSE_SIZE  (512U * 1024U)
+
+///
+/// The names of the cleansing configurations for the benchmark output.
+///
+static const char *const mScBenchmarkConfigNames[ScCleanseConfigTypeMax + 1] = {
+  [ScCleanseConfigTypeC]      = "c",
+  [ScCleanseConfigTypeJava]   = "java",
+  [ScCleanseConfigTypeFSharp] = "fsharp",
+  [ScCleanseConfigTypeMax]    = "unknown"
+};
+
+///
+/// The words synthetic code lines are composed of. They include keywords and
+/// types generalised by the cleansing configurations.
+///
+static const char *const mScBenchmarkWords[] = {
+  "public", "private", "static", "final", "unsigned", "short", "long", "int",
+  "float", "double", "char", "return", "if", "while", "for", "Value",
+  "Count", "Index", "Buffer", "Length", "Result", "=", "+", "-", "*", "<",
+  "==", "(", ")", "[", "]", "{", "}", ";", ",", "0", "1", "42"
+};
+
+///
+/// The compiled cleansing configurations for every sc_cleanse_config_type_t.
+///
+static sc_cleanse_matcher_t mScCleanseMatchers[ScCleanseConfigTypeMax + 1];
+
+///
+/// Prevents the compiler from discarding benchmarked calculations.
+///
+static volatile size_t mScBenchmarkSink;
+
+///
+/// Whether a benchmark result has been output already.
+///
+static bool mScBenchmarkFirstResult = true;
+
+/*
+  Returns the current time, in seconds, of a clock suitable for measuring
+  durations.
+*/
+static double ScBenchmarkGetTime(void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  struct timespec Time;
+  timespec_get(&Time, TIME_UTC);
+  return (double) Time.tv_sec + (double) Time.tv_nsec / 1e9;
+#endif
+}
+
+/*
+  Returns the next value of a deterministic pseudo-random sequence.
+
+  @param[in,out] State  The state of the sequence.
+*/
+static uint64_t ScBenchmarkRandom(
+  uint64_t *State
+  )
+{
+  assert(State != NULL);
+  //
+  // SplitMix64 is fast and yields well distributed values from any seed.
+  //
+  *State += 0x9E3779B97F4A7C15ULL;
+  uint64_t Value = *State;
+  Value = (Value ^ (Value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  Value = (Value ^ (Value >> 27U)) * 0x94D049BB133111EBULL;
+  return Value ^ (Value >> 31U);
+}
+
+/*
+  Returns a pseudo-random value smaller than Bound.
+
+  @param[in,out] State  The state of the sequence.
+  @param[in]     Bound  The exclusive upper bound. It must be larger than 0.
+*/
+static size_t ScBenchmarkRandomBelow(
+  uint64_t *State,
+  size_t   Bound
+  )
+{
+  assert(Bound > 0);
+  return (size_t) (ScBenchmarkRandom(State) % Bound);
+}
+
+/*
+  Starts the output of a benchmark result. The caller outputs the remaining
+  fields and terminates the result with ScBenchmarkEndResult().
+
+  @param[in] Name  The name of the benchmark.
+*/
+static void ScBenchmarkBeginResult(
+  const char *Name
+  )
+{
+  assert(Name != NULL);
+
+  printf(
+    "%s\n    { \"name\": \"%s\"",
+    mScBenchmarkFirstResult ? "" : ",",
+    Name
+    );
+  mScBenchmarkFirstResult = false;
+}
+
+/*
+  Terminates the output of a benchmark result.
+*/
+static void ScBenchmarkEndResult(void)
+{
+  printf(" }");
+}
+
+/*
+  Generates a synthetic line of code.
+
+  @param[in,out] State      The state of the pseudo-random sequence.
+  @param[out]    Line       The buffer to generate the line into.
+  @param[in]     MaxLength  The size, in characters, of Line. It must be larger
+                            than 1.
+
+  @returns  The length, in characters, of the generated line. It is larger
+            than 0 and smaller than MaxLength. The line is not terminated.
+*/
+static size_t ScBenchmarkGenerateLine(
+  uint64_t *State,
+  char     *Line,
+  size_t   MaxLength
+  )
+{
+  assert(Line != NULL);
+  assert(MaxLength > 1);
+  //
+  // Indent the line and append words up to a random length typical for code.
+  //
+  const size_t TargetLength = SC_MIN(
+                                16U + ScBenchmarkRandomBelow(State, 64U),
+                                MaxLength - 1U
+                                );
+  size_t Length = ScBenchmarkRandomBelow(State, 4U) * 2U;
+  Length = SC_MIN(Length, TargetLength - 1U);
+  memset(Line, ' ', Length);
+  //
+  // Every eighth line carries a comment to be cleansed.
+  //
+  const bool Comment = ScBenchmarkRandomBelow(State, 8U) == 0;
+  if (Comment && Length + 3U <= TargetLength) {
+    memcpy(&Line[Length], "// ", 3U);
+    Length += 3U;
+  }
+
+  while (Length < TargetLength) {
+    const char *Word = mScBenchmarkWords[
+                         ScBenchmarkRandomBelow(
+                           State,
+                           SC_ARRAY_LEN(mScBenchmarkWords)
+                           )
+                         ];
+    const size_t WordLength = SC_MIN(strlen(Word), TargetLength - Length);
+    memcpy(&Line[Length], Word, WordLength);
+    Length += WordLength;
+    if (Length < TargetLength) {
+      Line[Length] = ' ';
+      ++Length;
+    }
+  }
+
+  return Length;
+}
+
+/*
+  Generates a synthetic file of code.
+
+  @param[in,out] State     The state of the pseudo-random sequence.
+  @param[in]     NumLines  The number of lines to generate.
+  @param[out]    Length    On success, the length, in characters, of the file.
+
+  @retval NULL   An error has occured.
+  @retval other  The generated file. It is allocated with malloc and
+                 caller-owned.
+*/
+static char *ScBenchmarkGenerateFile(
+  uint64_t *State,
+  size_t   NumLines,
+  size_t   *Length
+  )
+{
+  assert(NumLines > 0);
+  assert(Length != NULL);
+
+  char *File = malloc(NumLines * SC_MAX_LINE_LENGTH);
+  if (File == NULL) {
+    return NULL;
+  }
+
+  size_t FileLength = 0;
+  for (size_t LineIndex = 0; LineIndex < NumLines; ++LineIndex) {
+    FileLength += ScBenchmarkGenerateLine(
+                    State,
+                    &File[FileLength],
+                    SC_MAX_LINE_LENGTH
+                    );
+    File[FileLength] = '\n';
+    ++FileLength;
+  }
+
+  *Length = FileLength;
+  return File;
+}
+
+/*
+  Copies String into Copy and applies pseudo-random edits to it.
+
+  @param[in,out] State       The state of the pseudo-random sequence.
+  @param[out]    Copy        The buffer to copy String into. It must be Length
+                             characters in size.
+  @param[in]     String      The string to copy.
+  @param[in]     Length      The length, in characters, of String.
+  @param[in]     NumEdits    The number of characters to substitute.
+*/
+static void ScBenchmarkMutate(
+  uint64_t   *State,
+  char       *Copy,
+  const char *String,
+  size_t     Length,
+  size_t     NumEdits
+  )
+{
+  assert(Copy != NULL);
+  assert(String != NULL);
+  assert(Length > 0);
+
+  memcpy(Copy, String, Length);
+  for (size_t EditIndex = 0; EditIndex < NumEdits; ++EditIndex) {
+    Copy[ScBenchmarkRandomBelow(State, Length)] =
+      (char) ('a' + ScBenchmarkRandomBelow(State, 26U));
+  }
+}
+
+/*
+  Measures the Levenshtein kernels on line pairs of the same length, a quarter
+  of whose characters differ.
+
+  @param[in] LineLength  The length, in characters, of the lines.
+
+  @returns  Whether the benchmark has been performed successfully.
+*/
+static bool ScBenchmarkLevenshtein(
+  size_t LineLength
+  )
+{
+  assert(LineLength > 0 && LineLength <= SC_MAX_LINE_LENGTH);
+
+  static char     Lines1[SC_BENCHMARK_NUM_LINE_PAIRS][SC_MAX_LINE_LENGTH];
+  static char     Lines2[SC_BENCHMARK_NUM_LINE_PAIRS][SC_MAX_LINE_LENGTH];
+  static uint64_t PeqScratch[SC_LEVENSHTEIN_PEQ_SIZE(SC_MAX_LINE_LENGTH)];
+  static size_t   MatrixInit[SC_MAX_LINE_LENGTH];
+  static size_t   MatrixScratch[SC_MAX_LINE_LENGTH];
+
+  static sc_levenshtein_peq_entry_t Entries[SC_BENCHMARK_NUM_LINE_PAIRS][
+                                      SC_MAX_LINE_LENGTH
+                                      ];
+  size_t NumEntries[SC_BENCHMARK_NUM_LINE_PAIRS];
+
+  uint64_t State = LineLength;
+  for (size_t Index = 0; Index < SC_MAX_LINE_LENGTH; ++Index) {
+    MatrixInit[Index] = Index + 1U;
+  }
+
+  for (
+    size_t PairIndex = 0;
+    PairIndex < SC_BENCHMARK_NUM_LINE_PAIRS;
+    ++PairIndex
+    ) {
+    for (size_t CharIndex = 0; CharIndex < LineLength; ++CharIndex) {
+      Lines1[PairIndex][CharIndex] =
+        (char) ('a' + ScBenchmarkRandomBelow(&State, 26U));
+    }
+
+    ScBenchmarkMutate(
+      &State,
+      Lines2[PairIndex],
+      Lines1[PairIndex],
+      LineLength,
+      LineLength / 4U
+      );
+
+    NumEntries[PairIndex] = ScLevenshteinPeqCompile(
+                              PeqScratch,
+                              Entries[PairIndex],
+                              Lines1[PairIndex],
+                              LineLength
+                              );
+  }
+
+  for (unsigned int Kernel = 0; Kernel < 2U; ++Kernel) {
+    size_t Checksum       = 0;
+    size_t NumRepetitions = 0;
+    double Start          = ScBenchmarkGetTime();
+    double Elapsed;
+    do {
+      for (
+        size_t PairIndex = 0;
+        PairIndex < SC_BENCHMARK_NUM_LINE_PAIRS;
+        ++PairIndex
+        ) {
+        if (Kernel == 0) {
+          Checksum += ScLevenshteinDistanceCompiled(
+                        PeqScratch,
+                        Entries[PairIndex],
+                        NumEntries[PairIndex],
+                        LineLength,
+                        Lines2[PairIndex],
+                        LineLength,
+                        SIZE_MAX
+                        );
+        } else {
+          Checksum += ScLevenshteinDistance(
+                        MatrixInit,
+                        MatrixScratch,
+                        Lines1[PairIndex],
+                        LineLength,
+                        Lines2[PairIndex],
+                        LineLength
+                        );
+        }
+      }
+
+      ++NumRepetitions;
+      Elapsed = ScBenchmarkGetTime() - Start;
+    } while (Elapsed < SC_BENCHMARK_MIN_SECONDS);
+
+    mScBenchmarkSink = Checksum;
+
+    const double NumCells = (double) NumRepetitions
+                              * SC_BENCHMARK_NUM_LINE_PAIRS
+                              * (double) LineLength
+                              * (double) LineLength;
+    ScBenchmarkBeginResult(
+      Kernel == 0 ? "levenshtein_bit_parallel" : "levenshtein_reference"
+      );
+    printf(
+      ", \"line_length\": %zu, \"pairs\": %zu, \"seconds\": %.6f"
+      ", \"cells_per_second\": %.6e, \"checksum\": %zu",
+      LineLength,
+      NumRepetitions * SC_BENCHMARK_NUM_LINE_PAIRS,
+      Elapsed,
+      NumCells / Elapsed,
+      Checksum / NumRepetitions
+      );
+    ScBenchmarkEndResult();
+  }
+
+  return true;
+}
+
+/*
+  Cleanses Buffer with a single cleansing pass.
+
+  @param[in,out] Buffer    The buffer to cleanse.
+  @param[in,out] Length    On input, the length, in characters, of Buffer.
+                           On output, its cleansed length.
+  @param[in]     FileType  The cleansing type to cleanse with.
+  @param[in]     Pass      The index of the pass.
+*/
+static void ScBenchmarkCleansePass(
+  char                     *Buffer,
+  size_t                   *Length,
+  sc_cleanse_config_type_t FileType,
+  unsigned int             Pass
+  )
+{
+  const sc_cleanse_config_t *Config = gScCleanseConfigs[FileType];
+  switch (Pass) {
+    case 0:
+      ScCleanseInput(Buffer, Length, &mScCleanseMatchers[FileType]);
+      break;
+
+    case 1:
+      ScCleanseLines(Buffer, *Length, Config);
+      break;
+
+    case 2:
+      ScCleanseWhitespacesInLines(Buffer, *Length, Config);
+      break;
+
+    case 3:
+      ScCleanseGeneralisees(Buffer, *Length, Config);
+      break;
+
+    default:
+      assert(Pass == 4);
+      ScCleanseRemoveSpaces(Buffer, Length);
+      break;
+  }
+}
+
+/*
+  Measures every cleansing pass for every cleansing configuration, as well as
+  ScStrGetLineInfo(), on synthetic code.
+
+  @returns  Whether the benchmark has been performed successfully.
+*/
+static bool ScBenchmarkCleanse(void)
+{
+  static const char *const PassNames[] = {
+    "cleanse_input",
+    "cleanse_lines",
+    "cleanse_whitespaces_in_lines",
+    "cleanse_generalisees",
+    "cleanse_remove_spaces"
+  };
+
+  uint64_t State = 1;
+  size_t   Length;
+  char     *Input = ScBenchmarkGenerateFile(
+                      &State,
+                      SC_BENCHMARK_CLEANSE_SIZE / 48U,
+                      &Length
+                      );
+  char     *Buffer = malloc(SC_MAX(Length, 1U));
+  if (Input == NULL || Buffer == NULL) {
+    free(Input);
+    free(Buffer);
+    return false;
+  }
+
+  for (
+    sc_cleanse_config_type_t FileType = ScCleanseConfigTypeMin;
+    FileType <= ScCleanseConfigTypeMax;
+    ++FileType
+    ) {
+    for (unsigned int Pass = 0; Pass < SC_ARRAY_LEN(PassNames); ++Pass) {
+      //
+      // Only time the pass itself and not the restoration of the input.
+      //
+      size_t NumRepetitions = 0;
+      size_t Checksum       = 0;
+      double Elapsed        = 0;
+      do {
+        memcpy(Buffer, Input, Length);
+        size_t CleansedLength = Length;
+
+        const double Start = ScBenchmarkGetTime();
+        ScBenchmarkCleansePass(Buffer, &CleansedLength, FileType, Pass);
+        Elapsed += ScBenchmarkGetTime() - Start;
+
+        Checksum += CleansedLength;
+        ++NumRepetitions;
+      } while (Elapsed < SC_BENCHMARK_MIN_SECONDS);
+
+      mScBenchmarkSink = Checksum;
+
+      ScBenchmarkBeginResult(PassNames[Pass]);
+      printf(
+        ", \"config\": \"%s\", \"bytes\": %zu, \"seconds\": %.6f"
+        ", \"megabytes_per_second\": %.3f",
+        mScBenchmarkConfigNames[FileType],
+        Length,
+        Elapsed,
+        (double) Length * (double) NumRepetitions / Elapsed / 1e6
+        );
+      ScBenchmarkEndResult();
+    }
+  }
+
+  size_t NumRepetitions = 0;
+  size_t NumLines       = 0;
+  double Start          = ScBenchmarkGetTime();
+  double Elapsed;
+  do {
+    sc_str_lines_info_t *LinesInfo = ScStrGetLineInfo(Input, Length);
+    if (LinesInfo == NULL) {
+      free(Input);
+      free(Buffer);
+      return false;
+    }
+
+    NumLines = LinesInfo->NumLines;
+    free(LinesInfo);
+
+    ++NumRepetitions;
+    Elapsed = ScBenchmarkGetTime() - Start;
+  } while (Elapsed < SC_BENCHMARK_MIN_SECONDS);
+
+  ScBenchmarkBeginResult("str_get_line_info");
+  printf(
+    ", \"bytes\": %zu, \"lines\": %zu, \"seconds\": %.6f"
+    ", \"megabytes_per_second\": %.3f",
+    Length,
+    NumLines,
+    Elapsed,
+    (double) Length * (double) NumRepetitions / Elapsed / 1e6
+    );
+  ScBenchmarkEndResult();
+
+  free(Input);
+  free(Buffer);
+  return true;
+}
+
+///
+/// The results of rating all pairings of the files of a context.
+///
+typedef struct {
+  ///
+  /// The number of pairings rated per batch.
+  ///
+  size_t NumPairings;
+  ///
+  /// The duration, in seconds, of the first batch.
+  ///
+  double FirstSeconds;
+  ///
+  /// The duration, in seconds, of all batches.
+  ///
+  double Seconds;
+  ///
+  /// The number of batches rated.
+  ///
+  size_t NumBatches;
+  ///
+  /// The mean score of all pairings.
+  ///
+  double MeanScore;
+  ///
+  /// The mean score of the pairings of every derived file with its original.
+  ///
+  double DerivedMeanScore;
+} sc_benchmark_compare_t;
+
+/*
+  Rates all pairings of the files of Context.
+
+  @param[in]  Context       The context to rate the files of.
+  @param[in]  NumFiles      The number of files of Context. It must be at
+                            least 2.
+  @param[in]  NumOriginals  The number of original files. Every file with an
+                            index I of at least NumOriginals is derived from
+                            the file with the index I - NumOriginals.
+  @param[out] Results       On success, the results of the rating.
+
+  @returns  Whether the pairings have been rated successfully.
+*/
+static bool ScBenchmarkCompare(
+  const sc_context_t     *Context,
+  unsigned int           NumFiles,
+  unsigned int           NumOriginals,
+  sc_benchmark_compare_t *Results
+  )
+{
+  assert(Context != NULL);
+  assert(NumFiles >= 2);
+  assert(NumOriginals <= NumFiles);
+  assert(Results != NULL);
+
+  const size_t         NumPairings = (size_t) NumFiles * (NumFiles - 1U) / 2U;
+  sc_context_pairing_t *Pairings   = malloc(NumPairings * sizeof(*Pairings));
+  if (Pairings == NULL) {
+    return false;
+  }
+
+  size_t PairingIndex = 0;
+  for (unsigned int File1Index = 0; File1Index < NumFiles; ++File1Index) {
+    for (
+      unsigned int File2Index = File1Index + 1U;
+      File2Index < NumFiles;
+      ++File2Index
+      ) {
+      Pairings[PairingIndex].File1Index = File1Index;
+      Pairings[PairingIndex].File2Index = File2Index;
+      ++PairingIndex;
+    }
+  }
+  //
+  // The line pair distance cache is shared by all batches, hence only the
+  // first batch measures uncached comparisons.
+  //
+  size_t NumBatches      = 0;
+  size_t NumDerived      = 0;
+  double ScoreSum        = 0;
+  double DerivedScoreSum = 0;
+  double FirstSeconds    = 0;
+  double Start           = ScBenchmarkGetTime();
+  double Elapsed;
+  do {
+    ScContextCompareBatch(Context, Pairings, NumPairings);
+    ++NumBatches;
+    Elapsed = ScBenchmarkGetTime() - Start;
+    if (NumBatches > 1) {
+      continue;
+    }
+
+    FirstSeconds = Elapsed;
+    for (PairingIndex = 0; PairingIndex < NumPairings; ++PairingIndex) {
+      const sc_context_pairing_t *Pairing = &Pairings[PairingIndex];
+      ScoreSum += Pairing->Score;
+      if (Pairing->File2Index >= NumOriginals
+       && Pairing->File2Index - NumOriginals == Pairing->File1Index) {
+        DerivedScoreSum += Pairing->Score;
+        ++NumDerived;
+      }
+    }
+  } while (Elapsed < SC_BENCHMARK_MIN_SECONDS);
+
+  free(Pairings);
+
+  Results->NumPairings      = NumPairings;
+  Results->FirstSeconds     = FirstSeconds;
+  Results->Seconds          = Elapsed;
+  Results->NumBatches       = NumBatches;
+  Results->MeanScore        = ScoreSum / (double) NumPairings;
+  Results->DerivedMeanScore = NumDerived > 0
+                                ? DerivedScoreSum / (double) NumDerived
+                                : 0;
+  return true;
+}
+
+/*
+  Outputs the fields of the results of ScBenchmarkCompare().
+
+  @param[in] Results  The results to output.
+*/
+static void ScBenchmarkPrintCompare(
+  const sc_benchmark_compare_t *Results
+  )
+{
+  assert(Results != NULL);
+
+  printf(
+    ", \"pairs\": %zu, \"first_seconds\": %.6f"
+    ", \"first_pairs_per_second\": %.3f, \"pairs_per_second\": %.3f"
+    ", \"mean_score\": %.6f, \"derived_mean_score\": %.6f",
+    Results->NumPairings,
+    Results->FirstSeconds,
+    (double) Results->NumPairings / Results->FirstSeconds,
+    (double) Results->NumPairings * (double) Results->NumBatches
+      / Results->Seconds,
+    Results->MeanScore,
+    Results->DerivedMeanScore
+    );
+}
+
+/*
+  Measures the rating of all pairings of a synthetic corpus. Half of the files
+  are original, every other file is derived from an original one.
+
+  @param[in] NumFiles     The number of files of the corpus. It must be at
+                          least 2.
+  @param[in] NumLines     The number of lines of every file.
+  @param[in] Plagiarism   The fraction of lines of the derived files copied
+                          from their originals, between 0 and 1. Copied lines
+                          are edited slightly.
+
+  @returns  Whether the benchmark has been performed successfully.
+*/
+static bool ScBenchmarkCorpus(
+  unsigned int NumFiles,
+  size_t       NumLines,
+  double       Plagiarism
+  )
+{
+  assert(NumFiles >= 2);
+  assert(NumLines > 0);
+  assert(Plagiarism >= 0 && Plagiarism <= 1);
+
+  sc_context_t *Context = ScContextCreate(0);
+  if (Context == NULL) {
+    return false;
+  }
+
+  const unsigned int NumOriginals = (NumFiles + 1U) / 2U;
+
+  uint64_t State      = NumFiles * NumLines;
+  char     **Originals = calloc(NumOriginals, sizeof(*Originals));
+  size_t   *Lengths    = calloc(NumOriginals, sizeof(*Lengths));
+  char     *File       = malloc(NumLines * SC_MAX_LINE_LENGTH);
+  bool     Result      = Originals != NULL && Lengths != NULL && File != NULL;
+  size_t   NumBytes    = 0;
+  double   AddSeconds  = 0;
+  for (
+    unsigned int FileIndex = 0;
+    Result && FileIndex < NumFiles;
+    ++FileIndex
+    ) {
+    size_t Length;
+    if (FileIndex < NumOriginals) {
+      Originals[FileIndex] = ScBenchmarkGenerateFile(
+                               &State,
+                               NumLines,
+                               &Lengths[FileIndex]
+                               );
+      Result = Originals[FileIndex] != NULL;
+      if (!Result) {
+        break;
+      }
+
+      memcpy(File, Originals[FileIndex], Lengths[FileIndex]);
+      Length = Lengths[FileIndex];
+    } else {
+      //
+      // Derive the file line by line from an original.
+      //
+      const unsigned int OriginalIndex = FileIndex - NumOriginals;
+      const char         *Original     = Originals[OriginalIndex];
+      const char         *OriginalEnd  = Original + Lengths[OriginalIndex];
+      Length = 0;
+      while (Original < OriginalEnd) {
+        const char   *LineEnd    = memchr(
+                                     Original,
+                                     '\n',
+                                     (size_t) (OriginalEnd - Original)
+                                     );
+        const size_t LineLength  = (size_t) (LineEnd - Original);
+        const double Probability = (double) ScBenchmarkRandomBelow(
+                                              &State,
+                                              1000U
+                                              ) / 1000.;
+        if (Probability < Plagiarism && LineLength > 0) {
+          ScBenchmarkMutate(
+            &State,
+            &File[Length],
+            Original,
+            LineLength,
+            ScBenchmarkRandomBelow(&State, 3U)
+            );
+          Length += LineLength;
+        } else {
+          Length += ScBenchmarkGenerateLine(
+                      &State,
+                      &File[Length],
+                      SC_MAX_LINE_LENGTH
+                      );
+        }
+
+        File[Length] = '\n';
+        ++Length;
+        Original = LineEnd + 1;
+      }
+    }
+
+    unsigned int AddedIndex;
+    const double Start = ScBenchmarkGetTime();
+    Result = ScContextAddBuffer(
+               Context,
+               File,
+               Length,
+               ScCleanseConfigTypeC,
+               &AddedIndex
+               );
+    AddSeconds += ScBenchmarkGetTime() - Start;
+    NumBytes   += Length;
+  }
+
+  sc_benchmark_compare_t Compare;
+  Result = Result && ScBenchmarkCompare(
+                       Context,
+                       NumFiles,
+                       NumOriginals,
+                       &Compare
+                       );
+  if (Result) {
+    ScBenchmarkBeginResult("compare_synthetic");
+    printf(
+      ", \"files\": %u, \"lines\": %zu, \"plagiarism\": %.2f"
+      ", \"bytes\": %zu, \"add_megabytes_per_second\": %.3f",
+      NumFiles,
+      NumLines,
+      Plagiarism,
+      NumBytes,
+      (double) NumBytes / AddSeconds / 1e6
+      );
+    ScBenchmarkPrintCompare(&Compare);
+    ScBenchmarkEndResult();
+  }
+
+  if (Originals != NULL) {
+    for (
+      unsigned int FileIndex = 0;
+      FileIndex < NumOriginals;
+      ++FileIndex
+      ) {
+      free(Originals[FileIndex]);
+    }
+  }
+
+  free(File);
+  free(Lengths);
+  free(Originals);
+  ScContextDestroy(Context);
+  return Result;
+}
+
+/*
+  Measures the rating of all pairings of a real corpus.
+
+  @param[in] NumFiles   The number of files of the corpus. It must be at
+                        least 2.
+  @param[in] FileNames  The names of the files of the corpus. Their cleansing
+                        types are detected by their file extensions.
+
+  @returns  Whether the benchmark has been performed successfully.
+*/
+static bool ScBenchmarkFiles(
+  unsigned int      NumFiles,
+  const char *const *FileNames
+  )
+{
+  assert(NumFiles >= 2);
+  assert(FileNames != NULL);
+
+  sc_context_t *Context = ScContextCreate(0);
+  if (Context == NULL) {
+    return false;
+  }
+
+  bool         Result   = true;
+  unsigned int NumAdded = 0;
+  double       Start    = ScBenchmarkGetTime();
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    unsigned int AddedIndex;
+    Result = ScContextAddFile(
+               Context,
+               FileNames[FileIndex],
+               ScCleanseConfigTypeMax,
+               &AddedIndex
+               );
+    if (!Result) {
+      fprintf(stderr, "Failed to add file %s\n", FileNames[FileIndex]);
+      break;
+    }
+
+    ++NumAdded;
+  }
+
+  const double AddSeconds = ScBenchmarkGetTime() - Start;
+
+  sc_benchmark_compare_t Compare;
+  Result = Result && ScBenchmarkCompare(Context, NumAdded, NumAdded, &Compare);
+  if (Result) {
+    ScBenchmarkBeginResult("compare_files");
+    printf(
+      ", \"files\": %u, \"add_seconds\": %.6f",
+      NumAdded,
+      AddSeconds
+      );
+    ScBenchmarkPrintCompare(&Compare);
+    ScBenchmarkEndResult();
+  }
+
+  ScContextDestroy(Context);
+  return Result;
+}
+
+int main(int argc, char *argv[]) {
+  ScCleanseMatchersInitialise(mScCleanseMatchers);
+
+  printf(
+    "{\n  \"max_line_length\": %u,\n  \"num_lines_swap\": %u,\n"
+    "  \"results\": [",
+    SC_MAX_LINE_LENGTH,
+    SC_NUM_LINES_SWAP
+    );
+
+  static const size_t LineLengths[] = { 16, 32, 64, 128, 256, 512 };
+  bool Result = true;
+  for (
+    size_t LengthIndex = 0;
+    Result && LengthIndex < SC_ARRAY_LEN(LineLengths);
+    ++LengthIndex
+    ) {
+    if (LineLengths[LengthIndex] <= SC_MAX_LINE_LENGTH) {
+      Result = ScBenchmarkLevenshtein(LineLengths[LengthIndex]);
+    }
+  }
+
+  Result = Result && ScBenchmarkCleanse();
+
+  static const double Plagiarisms[] = { 0, 0.5, 0.9 };
+  for (
+    size_t LevelIndex = 0;
+    Result && LevelIndex < SC_ARRAY_LEN(Plagiarisms);
+    ++LevelIndex
+    ) {
+    Result = ScBenchmarkCorpus(32, 200, Plagiarisms[LevelIndex]);
+  }
+  //
+  // Optionally, measure the files passed as real-world workload.
+  //
+  if (Result && argc > 2) {
+    Result = ScBenchmarkFiles(
+               (unsigned int) argc - 1U,
+               (const char *const *) &argv[1]
+               );
+  }
+
+  printf("\n  ]\n}\n");
+
+  if (!Result) {
+    fprintf(stderr, "Benchmark error\n");
+    return -1;
+  }
+
+  return 0;
+}
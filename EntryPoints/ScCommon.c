@@ -14,63 +14,684 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <ScArena.h>
 #include <ScCleanseConfigs.h>
 #include <ScCleanseInput.h>
 #include <ScDistances.h>
 #include <ScFileIo.h>
+#include <ScInstrument.h>
+#include <ScMinHash.h>
 #include <ScSafeInt.h>
+#include <ScStringMisc.h>
 
 #include "ScCommon.h"
 
 ///
-/// Statically allocate the Levenshtein matrix buffers to avoid reallocations.
+/// Requests a function to be inlined into every caller, so that it is
+/// specialised for constant arguments.
 ///
-size_t mScLevenshteinMatrixInit[SC_MAX_LINE_LENGTH];
+#if defined(__GNUC__)
+  #define SC_ALWAYS_INLINE  inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+  #define SC_ALWAYS_INLINE  __forceinline
+#else
+  #define SC_ALWAYS_INLINE  inline
+#endif
 
-void ScLevenshteinSwapInitialise(void)
+///
+/// The magic value identifying a cleansed file cache entry.
+///
+#define SC_CLEANSE_CACHE_MAGIC  0x3145484341434353ULL
+
+///
+/// The revision of the cleansed file cache entry layout.
+///
+#define SC_CLEANSE_CACHE_LAYOUT_VERSION  3U
+
+///
+/// The alignment, in bytes, of the sections of a cleansed file cache entry.
+///
+#define SC_CLEANSE_CACHE_ALIGNMENT  SC_LINE_PROFILES_ALIGNMENT
+
+///
+/// The trailer of a cleansed file cache entry. An entry consists of the
+/// cleansed buffer, the line profiles as laid out by ScLayOutLineProfiles(),
+/// the uncleansed file contents and this trailer, each aligned to
+/// SC_CLEANSE_CACHE_ALIGNMENT. The trailer is stored last so that the cleansed
+/// buffer starts at the start of the mapping. All data is stored in native
+/// representation.
+///
+typedef struct {
+  ///
+  /// SC_CLEANSE_CACHE_MAGIC.
+  ///
+  uint64_t Magic;
+  ///
+  /// The ScStrHash64() value of the uncleansed file contents. It only selects
+  /// the entry, which is trusted only if its stored contents are equal.
+  ///
+  uint64_t ContentHash;
+  ///
+  /// The length, in characters, of the uncleansed file contents.
+  ///
+  uint64_t ContentLength;
+  ///
+  /// The length, in characters, of the cleansed buffer.
+  ///
+  uint64_t CleansedLength;
+  ///
+  /// The number of line profiles.
+  ///
+  uint64_t NumLines;
+  ///
+  /// The length of the longest line.
+  ///
+  uint64_t MaxLineLength;
+  ///
+  /// The number of compiled Levenshtein bitmask entries.
+  ///
+  uint64_t NumPeqEntries;
+  ///
+  /// SC_CLEANSE_CACHE_LAYOUT_VERSION.
+  ///
+  uint32_t LayoutVersion;
+  ///
+  /// SC_CLEANSE_CONFIGS_VERSION.
+  ///
+  uint32_t ConfigsVersion;
+  ///
+  /// The cleansing type the file has been cleansed with.
+  ///
+  uint32_t FileType;
+  ///
+  /// SC_LEVENSHTEIN_HISTOGRAM_SIZE to reject entries of other builds.
+  ///
+  uint32_t HistogramSize;
+  ///
+  /// The size of sc_levenshtein_peq_entry_t to reject entries of other builds.
+  ///
+  uint32_t PeqEntrySize;
+  ///
+  /// SC_MAX_LINE_LENGTH, as longer lines are rejected before caching.
+  ///
+  uint32_t MaxSupportedLineLength;
+} sc_cleanse_cache_trailer_t;
+
+_Static_assert(
+  _Alignof(sc_cleanse_cache_trailer_t) <= SC_CLEANSE_CACHE_ALIGNMENT,
+  "The cleansed file cache entry sections would be misaligned."
+  );
+
+void ScCleanseMatchersInitialise(
+  sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
+  )
 {
-  //
-  // Matrix[0,0] = 0 is implicit by the loop in ScLevenshteinDistance().
-  // This is equivalent to: Fill Matrix[0,1:] with 0,...,Str2Length.
-  //
-  #pragma omp simd
+  assert(Matchers != NULL);
+
   for (
-    size_t ColumnIndexMinus1 = 0;
-    ColumnIndexMinus1 < SC_MAX_LINE_LENGTH;
-    ++ColumnIndexMinus1
+    sc_cleanse_config_type_t FileType = ScCleanseConfigTypeMin;
+    FileType <= ScCleanseConfigTypeMax;
+    ++FileType
     ) {
-    mScLevenshteinMatrixInit[ColumnIndexMinus1] = ColumnIndexMinus1 + 1;
+    ScCleanseCompileConfig(
+      &Matchers[FileType],
+      gScCleanseConfigs[FileType]
+      );
   }
 }
 
-double ScLevenshteinSwap(
+/*
+  Checks whether the distance of two profiled lines is worth caching.
+
+  @param[in] Cache       The line pair distance cache. It may be NULL.
+  @param[in] Profiles1   The line profiles of the first file.
+  @param[in] Line1Index  The index of the first line within Profiles1.
+  @param[in] Profiles2   The line profiles of the second file.
+  @param[in] Line2Index  The index of the second line within Profiles2.
+
+  @returns  Whether Cache is to be used for the line pair.
+*/
+static bool ScLineProfileCacheable(
+  const sc_line_cache_t    *Cache,
+  const sc_line_profiles_t *Profiles1,
+  size_t                   Line1Index,
+  const sc_line_profiles_t *Profiles2,
+  size_t                   Line2Index
+  )
+{
+  //
+  // Only consult the cache for line pairs that are more expensive to compute
+  // than to look up.
+  //
+  const size_t NumCells = (size_t) Profiles1->Lengths[Line1Index]
+                            * Profiles2->Lengths[Line2Index];
+  return Cache != NULL && NumCells >= SC_LINE_CACHE_MIN_CELLS;
+}
+
+/*
+  Determines the Levenshtein distance between two profiled lines, if possible,
+  without calculating it. This covers identical lines, lower bounds exceeding
+  MaxDistance and cached distances. Line pairs skipped by a lower bound are
+  counted as pruned and all others determined as resolved.
+
+  @param[in,out] Cache       The line pair distance cache. It may be NULL.
+  @param[in]     Buffer1     The buffer of the first file.
+  @param[in]     Profiles1   The line profiles of the first file.
+  @param[in]     Line1Index  The index of the first line within Profiles1.
+  @param[in]     Buffer2     The buffer of the second file.
+  @param[in]     Profiles2   The line profiles of the second file.
+  @param[in]     Line2Index  The index of the second line within Profiles2.
+  @param[in]     MaxDistance The maximum distance of interest.
+  @param[out]    Distance    On success, the Levenshtein distance between both
+                             lines if it is at most MaxDistance, otherwise a
+                             value larger than MaxDistance.
+
+  @returns  Whether Distance has been determined. Otherwise, the distance needs
+            to be calculated and should be recorded with
+            ScLineProfileRecordDistance().
+*/
+static bool ScLineProfileKnownDistance(
+  sc_line_cache_t          *Cache,
+  const char               *Buffer1,
+  const sc_line_profiles_t *Profiles1,
+  size_t                   Line1Index,
+  const char               *Buffer2,
+  const sc_line_profiles_t *Profiles2,
+  size_t                   Line2Index,
+  size_t                   MaxDistance,
+  size_t                   *Distance
+  )
+{
+  assert(Line1Index < Profiles1->NumLines);
+  assert(Line2Index < Profiles2->NumLines);
+  assert(Distance != NULL);
+
+  const size_t Length1 = Profiles1->Lengths[Line1Index];
+  const size_t Length2 = Profiles2->Lengths[Line2Index];
+  assert(Length1 <= SC_MAX_LINE_LENGTH);
+  assert(Length2 <= SC_MAX_LINE_LENGTH);
+
+  const uint64_t Hash1 = Profiles1->Hashes[Line1Index];
+  const uint64_t Hash2 = Profiles2->Hashes[Line2Index];
+  //
+  // Cleansed code repeats a lot, hence check for identical lines first. The
+  // hash only serves as a filter to not compare mismatches.
+  //
+  if (Hash1 == Hash2 && Length1 == Length2) {
+    const int Result = memcmp(
+      &Buffer1[Profiles1->Offsets[Line1Index]],
+      &Buffer2[Profiles2->Offsets[Line2Index]],
+      Length1
+      );
+    if (Result == 0) {
+      SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowResolved, 1);
+      *Distance = 0;
+      return true;
+    }
+  }
+  //
+  // Skip the calculation if the length difference already exceeds
+  // MaxDistance.
+  //
+  const size_t LengthBound = Length1 > Length2
+                               ? Length1 - Length2
+                               : Length2 - Length1;
+  if (LengthBound > MaxDistance) {
+    SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowPruned, 1);
+    *Distance = LengthBound;
+    return true;
+  }
+  //
+  // Cached lower bounds can still prove a pair irrelevant.
+  //
+  const bool Cacheable = ScLineProfileCacheable(
+                           Cache,
+                           Profiles1,
+                           Line1Index,
+                           Profiles2,
+                           Line2Index
+                           );
+  if (Cacheable) {
+    size_t     CachedDistance;
+    bool       Exact;
+    const bool Found = ScLineCacheLookup(
+      Cache,
+      Hash1,
+      Hash2,
+      &CachedDistance,
+      &Exact
+      );
+    if (Found && (Exact || CachedDistance > MaxDistance)) {
+      SC_INSTRUMENT_COUNT(
+        CachedDistance > MaxDistance
+          ? ScInstrumentCounterWindowPruned
+          : ScInstrumentCounterWindowResolved,
+        1
+        );
+      *Distance = CachedDistance;
+      return true;
+    }
+  }
+  //
+  // The character class histograms yield a tighter, but more expensive lower
+  // bound. It may be weaker than the length difference due to saturation,
+  // which is fine as the length difference has been checked already.
+  //
+  const size_t HistogramBound = ScLevenshteinHistogramBound(
+    Profiles1->Histograms[Line1Index],
+    Profiles2->Histograms[Line2Index]
+    );
+  if (HistogramBound > MaxDistance) {
+    SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowPruned, 1);
+    if (Cacheable) {
+      ScLineCacheInsert(Cache, Hash1, Hash2, HistogramBound, false);
+    }
+
+    *Distance = HistogramBound;
+    return true;
+  }
+
+  return false;
+}
+
+/*
+  Records a calculated Levenshtein distance between two profiled lines in the
+  line pair distance cache.
+
+  @param[in,out] Cache       The line pair distance cache. It may be NULL.
+  @param[in]     Profiles1   The line profiles of the first file.
+  @param[in]     Line1Index  The index of the first line within Profiles1.
+  @param[in]     Profiles2   The line profiles of the second file.
+  @param[in]     Line2Index  The index of the second line within Profiles2.
+  @param[in]     MaxDistance The maximum distance the calculation was limited
+                             to.
+  @param[in]     Distance    The calculated distance.
+*/
+static void ScLineProfileRecordDistance(
+  sc_line_cache_t          *Cache,
+  const sc_line_profiles_t *Profiles1,
+  size_t                   Line1Index,
+  const sc_line_profiles_t *Profiles2,
+  size_t                   Line2Index,
+  size_t                   MaxDistance,
+  size_t                   Distance
+  )
+{
+  const bool Cacheable = ScLineProfileCacheable(
+                           Cache,
+                           Profiles1,
+                           Line1Index,
+                           Profiles2,
+                           Line2Index
+                           );
+  if (!Cacheable) {
+    return;
+  }
+  //
+  // If the calculation has been terminated early, Distance is a lower bound.
+  //
+  ScLineCacheInsert(
+    Cache,
+    Profiles1->Hashes[Line1Index],
+    Profiles2->Hashes[Line2Index],
+    Distance,
+    Distance <= MaxDistance
+    );
+}
+
+/*
+  Calculates the Levenshtein distance between two profiled lines.
+
+  @param[in,out] PeqScratch  The bit-parallel scratch buffer. All elements must
+                             be 0 on input and are 0 on output.
+  @param[in,out] Cache       The line pair distance cache. It may be NULL.
+  @param[in]     Buffer1     The buffer of the first file.
+  @param[in]     Profiles1   The line profiles of the first file.
+  @param[in]     Line1Index  The index of the first line within Profiles1.
+  @param[in]     Buffer2     The buffer of the second file.
+  @param[in]     Profiles2   The line profiles of the second file.
+  @param[in]     Line2Index  The index of the second line within Profiles2.
+  @param[in]     MaxDistance The maximum distance of interest. SIZE_MAX
+                             requests the exact distance in any case.
+
+  @returns  The Levenshtein distance between both lines if it is at most
+            MaxDistance, otherwise a value larger than MaxDistance.
+*/
+static size_t ScLineProfileDistance(
+  uint64_t                 *PeqScratch,
+  sc_line_cache_t          *Cache,
+  const char               *Buffer1,
+  const sc_line_profiles_t *Profiles1,
+  size_t                   Line1Index,
+  const char               *Buffer2,
+  const sc_line_profiles_t *Profiles2,
+  size_t                   Line2Index,
+  size_t                   MaxDistance
+  )
+{
+  size_t     Distance;
+  const bool Known = ScLineProfileKnownDistance(
+                       Cache,
+                       Buffer1,
+                       Profiles1,
+                       Line1Index,
+                       Buffer2,
+                       Profiles2,
+                       Line2Index,
+                       MaxDistance,
+                       &Distance
+                       );
+  if (Known) {
+    return Distance;
+  }
+  //
+  // The Levenshtein distance is symmetric. Use the shorter line as the pattern
+  // to minimise the number of bit-parallel blocks.
+  //
+  const sc_line_profiles_t *PatternProfiles = Profiles1;
+  size_t                   PatternIndex     = Line1Index;
+  const char               *TextBuffer      = Buffer2;
+  const sc_line_profiles_t *TextProfiles    = Profiles2;
+  size_t                   TextIndex        = Line2Index;
+  if (Profiles1->Lengths[Line1Index] > Profiles2->Lengths[Line2Index]) {
+    PatternProfiles = Profiles2;
+    PatternIndex    = Line2Index;
+    TextBuffer      = Buffer1;
+    TextProfiles    = Profiles1;
+    TextIndex       = Line1Index;
+  }
+  //
+  // The bit-parallel kernel yields the same distances as
+  // ScLevenshteinDistance() at a fraction of the cost.
+  //
+  Distance = ScLevenshteinDistanceCompiled(
+    PeqScratch,
+    &PatternProfiles->PeqEntries[PatternProfiles->PeqOffsets[PatternIndex]],
+    PatternProfiles->NumLinePeqEntries[PatternIndex],
+    PatternProfiles->Lengths[PatternIndex],
+    &TextBuffer[TextProfiles->Offsets[TextIndex]],
+    TextProfiles->Lengths[TextIndex],
+    MaxDistance
+    );
+
+  ScLineProfileRecordDistance(
+    Cache,
+    Profiles1,
+    Line1Index,
+    Profiles2,
+    Line2Index,
+    MaxDistance,
+    Distance
+    );
+
+  return Distance;
+}
+
+/*
+  Calculates the largest line distance whose score improves the best score of
+  the current window search.
+
+  @param[in]  BestScore    The best score found thus far.
+  @param[in]  MatchLength  The match length of the candidate line pair.
+  @param[in]  TieWins      Whether a score equal to BestScore improves it.
+  @param[out] MaxDistance  On success, the largest improving distance.
+
+  @returns  Whether any distance improves BestScore.
+*/
+static bool ScGetImprovingDistance(
+  double BestScore,
+  size_t MatchLength,
+  bool   TieWins,
+  size_t *MaxDistance
+  )
+{
+  assert(BestScore >= 0 && BestScore <= 1);
+  assert(MatchLength > 0 && MatchLength <= SC_MAX_LINE_LENGTH);
+  assert(MaxDistance != NULL);
+  //
+  // Start from the rounded estimate and correct it with the same arithmetics
+  // ScLevenshteinSwap() uses for scoring, so that the limit is exact.
+  //
+  size_t Distance = (size_t) (BestScore * (double) MatchLength);
+  Distance = SC_MIN(Distance + 1U, MatchLength);
+
+  while (true) {
+    const double Score = (double) Distance / (double) MatchLength;
+    if (Score < BestScore || (TieWins && Score == BestScore)) {
+      break;
+    }
+
+    if (Distance == 0) {
+      return false;
+    }
+
+    --Distance;
+  }
+
+  *MaxDistance = Distance;
+  return true;
+}
+
+///
+/// The best match of a line of file 1 within the window search of
+/// ScLevenshteinSwap().
+///
+typedef struct {
+  ///
+  /// The score of the match, DBL_MAX if there is none yet.
+  ///
+  double Score;
+  ///
+  /// The index of the matched line within file 2, SIZE_MAX if there is none.
+  ///
+  size_t Index;
+  ///
+  /// The Levenshtein distance between both lines.
+  ///
+  size_t Distance;
+  ///
+  /// The length of the longer of both lines.
+  ///
+  size_t MatchLength;
+} sc_swap_match_t;
+
+/*
+  Replaces the best match of the current window search with a candidate if it
+  is a better match. Ties are resolved in favour of the lower index, which
+  yields the same results regardless of the evaluation order.
+
+  @param[in,out] Best         The best match found thus far.
+  @param[in]     Line2Index   The index of the candidate line within file 2.
+  @param[in]     Distance     The exact distance of the candidate line pair.
+  @param[in]     MatchLength  The match length of the candidate line pair.
+*/
+static void ScSwapMatchUpdate(
+  sc_swap_match_t *Best,
+  size_t          Line2Index,
+  size_t          Distance,
+  size_t          MatchLength
+  )
+{
+  assert(Best != NULL);
+  assert(Line2Index != SIZE_MAX);
+  assert(MatchLength > 0);
+
+  double Score;
+  if (Distance == 0) {
+    Score = 0;
+  } else {
+    Score = (double) Distance / (double) MatchLength;
+  }
+
+  if (Score < Best->Score
+   || (Score == Best->Score && Line2Index < Best->Index)) {
+    Best->Score       = Score;
+    Best->Index       = Line2Index;
+    Best->Distance    = Distance;
+    Best->MatchLength = MatchLength;
+  }
+}
+
+/*
+  Calculates the distances of a line of file 1 to a batch of lines of file 2
+  and records them in the line pair distance cache.
+
+  @param[in,out] PeqScratch   The bit-parallel scratch buffer. All elements
+                              must be 0 on input and are 0 on output.
+  @param[in,out] Cache        The line pair distance cache. It may be NULL.
+  @param[in]     Profiles1    The line profiles of file 1.
+  @param[in]     Line1Index   The index of the line within Profiles1.
+  @param[in]     Profiles2    The line profiles of file 2.
+  @param[in]     Texts        The lines of file 2 to compare with and the
+                              maximum distances of interest.
+  @param[in]     Line2Indices The indices of the lines of Texts within
+                              Profiles2.
+  @param[in]     NumLines     The number of elements in Texts and
+                              Line2Indices. It must be larger than 0.
+  @param[out]    Distances    The distances of the lines of Texts, with the
+                              semantics of ScLineProfileDistance().
+*/
+static void ScLineProfileDistanceBatch(
+  uint64_t                    *PeqScratch,
+  sc_line_cache_t             *Cache,
+  const sc_line_profiles_t    *Profiles1,
+  size_t                      Line1Index,
+  const sc_line_profiles_t    *Profiles2,
+  const sc_levenshtein_text_t *Texts,
+  const size_t                *Line2Indices,
+  size_t                      NumLines,
+  size_t                      Distances[SC_LINE_BATCH_SIZE]
+  )
+{
+  assert(NumLines > 0 && NumLines <= SC_LINE_BATCH_SIZE);
+  //
+  // The line of file 1 serves as the pattern of the whole batch, so that its
+  // bitmasks are set up only once.
+  //
+  ScLevenshteinDistanceCompiledBatch(
+    PeqScratch,
+    &Profiles1->PeqEntries[Profiles1->PeqOffsets[Line1Index]],
+    Profiles1->NumLinePeqEntries[Line1Index],
+    Profiles1->Lengths[Line1Index],
+    Texts,
+    NumLines,
+    Distances
+    );
+
+  for (size_t BatchIndex = 0; BatchIndex < NumLines; ++BatchIndex) {
+    ScLineProfileRecordDistance(
+      Cache,
+      Profiles1,
+      Line1Index,
+      Profiles2,
+      Line2Indices[BatchIndex],
+      Texts[BatchIndex].MaxDistance,
+      Distances[BatchIndex]
+      );
+  }
+}
+
+/*
+  Calculates the distances of a line of file 1 to a batch of lines of file 2
+  and updates the best match of the current window search with them.
+
+  @param[in,out] PeqScratch   The bit-parallel scratch buffer. All elements
+                              must be 0 on input and are 0 on output.
+  @param[in,out] Cache        The line pair distance cache. It may be NULL.
+  @param[in]     Profiles1    The line profiles of file 1.
+  @param[in]     Line1Index   The index of the line within Profiles1.
+  @param[in]     Profiles2    The line profiles of file 2.
+  @param[in]     Texts        The lines of file 2 to compare with and the
+                              maximum distances that can improve Best.
+  @param[in]     Line2Indices The indices of the lines of Texts within
+                              Profiles2.
+  @param[in]     NumLines     The number of elements in Texts and
+                              Line2Indices.
+  @param[in,out] Best         The best match found thus far.
+*/
+static void ScSwapMatchBatch(
+  uint64_t                    *PeqScratch,
+  sc_line_cache_t             *Cache,
+  const sc_line_profiles_t    *Profiles1,
+  size_t                      Line1Index,
+  const sc_line_profiles_t    *Profiles2,
+  const sc_levenshtein_text_t *Texts,
+  const size_t                *Line2Indices,
+  size_t                      NumLines,
+  sc_swap_match_t             *Best
+  )
+{
+  assert(NumLines <= SC_LINE_BATCH_SIZE);
+
+  if (NumLines == 0) {
+    return;
+  }
+
+  size_t Distances[SC_LINE_BATCH_SIZE];
+  ScLineProfileDistanceBatch(
+    PeqScratch,
+    Cache,
+    Profiles1,
+    Line1Index,
+    Profiles2,
+    Texts,
+    Line2Indices,
+    NumLines,
+    Distances
+    );
+
+  for (size_t BatchIndex = 0; BatchIndex < NumLines; ++BatchIndex) {
+    const size_t Line2Index = Line2Indices[BatchIndex];
+    //
+    // A better match found after the batch has been assembled might have
+    // lowered the limit, which ScSwapMatchUpdate() accounts for.
+    //
+    if (Distances[BatchIndex] <= Texts[BatchIndex].MaxDistance) {
+      ScSwapMatchUpdate(
+        Best,
+        Line2Index,
+        Distances[BatchIndex],
+        SC_MAX(Profiles1->Lengths[Line1Index], Profiles2->Lengths[Line2Index])
+        );
+    }
+  }
+}
+
+/*
+  Implements ScLevenshteinSwap(). It is inlined into callers with constant
+  line swap radii to specialise the window search for them.
+*/
+static SC_ALWAYS_INLINE double ScLevenshteinSwapWindow(
   const sc_cleanse_file_t *File1,
   const sc_cleanse_file_t *File2,
-  size_t                  NumLinesSwap
+  size_t                  NumLinesSwap,
+  uint64_t                *PeqScratch,
+  sc_line_cache_t         *Cache
   )
 {
   assert(File1 != NULL);
   assert(File1->Buffer != NULL || File1->Length == 0);
-  assert(File1->LinesInfo != NULL);
+  assert(File1->Profiles.Hashes != NULL);
   assert(File2 != NULL);
   assert(File2->Buffer != NULL || File2->Length == 0);
-  assert(File2->LinesInfo != NULL);
+  assert(File2->Profiles.Hashes != NULL);
+  assert(PeqScratch != NULL);
   //
   // Make sure File1 is the shorter file to improve the control flow below.
   //
-  const sc_str_lines_info_t  *LinesInfo1;
-  const sc_str_lines_info_t  *LinesInfo2;
-  if (File1->LinesInfo->NumLines > File2->LinesInfo->NumLines) {
-    LinesInfo1 = File2->LinesInfo;
-    LinesInfo2 = File1->LinesInfo;
-  } else {
-    LinesInfo1 = File1->LinesInfo;
-    LinesInfo2 = File2->LinesInfo;
+  if (File1->Profiles.NumLines > File2->Profiles.NumLines) {
+    const sc_cleanse_file_t *const FileTmp = File1;
+    File1 = File2;
+    File2 = FileTmp;
   }
+
   //
-  // Allocate the scratch buffer on the stack to allow parallelisation.
+  // Copy the profiles to let the compiler keep their arrays in registers.
   //
-  size_t MatrixScratch[SC_MAX_LINE_LENGTH];
+  const sc_line_profiles_t Profiles1 = File1->Profiles;
+  const sc_line_profiles_t Profiles2 = File2->Profiles;
+  const size_t             NumLines1 = Profiles1.NumLines;
+  const size_t             NumLines2 = Profiles2.NumLines;
   //
   // Pair all lines in file 1 with appropiate lines in file 2.
   //
@@ -78,11 +699,9 @@ double ScLevenshteinSwap(
   size_t TotalLength = 0;
   for (
     size_t Line1Index = 0;
-    Line1Index < LinesInfo1->NumLines;
+    Line1Index < NumLines1;
     ++Line1Index
     ) {
-    size_t BestMatch   = SIZE_MAX;
-    size_t MatchLength = 1;
     //
     // Lines were cleansed such that there are no subsequent new lines. As such,
     // the number of lines in a buffer can be at most Size / 2. Use this
@@ -93,65 +712,152 @@ double ScLevenshteinSwap(
       "The addition may overflow."
       );
     //
-    // The subtraction LinesInfo2->NumLines - 1 is safe because
-    // 0 < LinesInfo1->NumLines <= LinesInfo2->NumLines
+    // The subtraction NumLines2 - 1 is safe because
+    // 0 < NumLines1 <= NumLines2
     //
-    assert(LinesInfo2->NumLines >= LinesInfo1->NumLines);
+    assert(NumLines2 >= NumLines1);
     //
     // Check [min{Line1Index - NumLinesSwap, 0},
-    //        min{Line1Index + NumLinesSwap, LinesInfo2->NumLines - 1}]
+    //        min{Line1Index + NumLinesSwap, NumLines2 - 1}]
     //
     const size_t StartIndex = Line1Index > NumLinesSwap
                                 ? Line1Index - NumLinesSwap
                                 : 0;
-    const size_t TopIndex = LinesInfo2->NumLines - Line1Index > NumLinesSwap
+    const size_t TopIndex = NumLines2 - Line1Index > NumLinesSwap
                               ? Line1Index + NumLinesSwap + 1
-                              : LinesInfo2->NumLines;
+                              : NumLines2;
 
-    double BestScore = DBL_MAX;
+    sc_swap_match_t Best = { DBL_MAX, SIZE_MAX, SIZE_MAX, 1 };
     //
-    // TODO: Only match lines in file 2 once?
+    // Line pairs whose distances need to be calculated are collected to
+    // share the setup of the pattern.
     //
-    for (size_t Line2Index = StartIndex; Line2Index < TopIndex; ++Line2Index) {
-      assert(Line2Index < LinesInfo2->NumLines);
-
-      assert(LinesInfo1->MaxLineLength <= SC_MAX_LINE_LENGTH);
-      assert(
-        LinesInfo1->Lines[Line1Index].Length <= LinesInfo1->MaxLineLength
-        );
-      assert(LinesInfo2->MaxLineLength <= SC_MAX_LINE_LENGTH);
-      assert(
-        LinesInfo2->Lines[Line2Index].Length <= LinesInfo2->MaxLineLength
-        );
+    sc_levenshtein_text_t Texts[SC_LINE_BATCH_SIZE];
+    size_t                Line2Indices[SC_LINE_BATCH_SIZE];
+    size_t                NumBatched = 0;
+    //
+    // Lines in file 2 may be matched more than once. ScLevenshteinAlign()
+    // matches them only once.
+    //
+    // The line at the same index is the most likely best match, hence
+    // evaluate it first to tighten the bounds for all other candidates.
+    //
+    assert(StartIndex <= Line1Index && Line1Index < TopIndex);
+    for (size_t Step = 0; Step < TopIndex - StartIndex; ++Step) {
+      size_t Line2Index = Line1Index;
+      if (Step > 0) {
+        Line2Index = StartIndex + Step - 1U;
+        if (Line2Index >= Line1Index) {
+          ++Line2Index;
+        }
+      }
 
-      size_t Distance = ScLevenshteinDistance(
-        mScLevenshteinMatrixInit,
-        MatrixScratch,
-        LinesInfo1->Lines[Line1Index].Start,
-        LinesInfo1->Lines[Line1Index].Length,
-        LinesInfo2->Lines[Line2Index].Start,
-        LinesInfo2->Lines[Line2Index].Length
-        );
+      assert(Line2Index < NumLines2);
+      SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowCandidates, 1);
 
       size_t MatchLengthTmp = SC_MAX(
-        LinesInfo1->Lines[Line1Index].Length,
-        LinesInfo2->Lines[Line2Index].Length
+        Profiles1.Lengths[Line1Index],
+        Profiles2.Lengths[Line2Index]
         );
-      double CurLineScore;
-      if (Distance == 0) {
-        CurLineScore = 0;
+      //
+      // Limit the calculation to distances that can improve the best score.
+      //
+      size_t MaxDistance = SIZE_MAX;
+      if (Best.Index != SIZE_MAX) {
+        const bool Improvable = ScGetImprovingDistance(
+          Best.Score,
+          MatchLengthTmp,
+          Line2Index < Best.Index,
+          &MaxDistance
+          );
+        if (!Improvable) {
+          SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowPruned, 1);
+          continue;
+        }
+      }
+
+      size_t Distance;
+      if (Best.Index == SIZE_MAX) {
+        Distance = ScLineProfileDistance(
+          PeqScratch,
+          Cache,
+          File1->Buffer,
+          &Profiles1,
+          Line1Index,
+          File2->Buffer,
+          &Profiles2,
+          Line2Index,
+          MaxDistance
+          );
       } else {
-        CurLineScore = (double) Distance / (double) MatchLengthTmp;
+        const bool Known = ScLineProfileKnownDistance(
+                             Cache,
+                             File1->Buffer,
+                             &Profiles1,
+                             Line1Index,
+                             File2->Buffer,
+                             &Profiles2,
+                             Line2Index,
+                             MaxDistance,
+                             &Distance
+                             );
+        if (!Known) {
+          Texts[NumBatched].Text =
+            &File2->Buffer[Profiles2.Offsets[Line2Index]];
+          Texts[NumBatched].Length      = Profiles2.Lengths[Line2Index];
+          Texts[NumBatched].MaxDistance = MaxDistance;
+          Line2Indices[NumBatched]      = Line2Index;
+          ++NumBatched;
+
+          if (NumBatched == SC_LINE_BATCH_SIZE) {
+            ScSwapMatchBatch(
+              PeqScratch,
+              Cache,
+              &Profiles1,
+              Line1Index,
+              &Profiles2,
+              Texts,
+              Line2Indices,
+              NumBatched,
+              &Best
+              );
+            NumBatched = 0;
+          }
+
+          continue;
+        }
+      }
+
+      if (Distance > MaxDistance) {
+        continue;
       }
+
+      ScSwapMatchUpdate(&Best, Line2Index, Distance, MatchLengthTmp);
       //
-      // Update the highest score of the pairing process for this line.
+      // An identical line cannot be improved upon. Any tie is an identical
+      // line too and yields the same match. Identical lines are never
+      // batched, hence no batched line can improve upon it either.
       //
-      if (BestScore > CurLineScore) {
-        BestScore   = CurLineScore;
-        BestMatch   = Distance;
-        MatchLength = MatchLengthTmp;
+      if (Distance == 0) {
+        NumBatched = 0;
+        break;
       }
     }
+
+    ScSwapMatchBatch(
+      PeqScratch,
+      Cache,
+      &Profiles1,
+      Line1Index,
+      &Profiles2,
+      Texts,
+      Line2Indices,
+      NumBatched,
+      &Best
+      );
+
+    const size_t BestMatch   = Best.Distance;
+    const size_t MatchLength = Best.MatchLength;
     //
     // As MatchLength can at most be the maximum of each line's length, it may
     // overflow TotalLength.
@@ -171,9 +877,574 @@ double ScLevenshteinSwap(
   return 1. - ((double) TotalDiff / (double) TotalLength);
 }
 
+double ScLevenshteinSwap(
+  const sc_cleanse_file_t *File1,
+  const sc_cleanse_file_t *File2,
+  size_t                  NumLinesSwap,
+  uint64_t                *PeqScratch,
+  sc_line_cache_t         *Cache
+  )
+{
+  //
+  // Specialise the window search for common radii, so that the compiler can
+  // resolve the window bounds and unroll the candidate loop.
+  //
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterPairings, 1);
+  switch (NumLinesSwap) {
+    case 0:
+      return ScLevenshteinSwapWindow(File1, File2, 0, PeqScratch, Cache);
+
+    case 1:
+      return ScLevenshteinSwapWindow(File1, File2, 1, PeqScratch, Cache);
+
+    case 3:
+      return ScLevenshteinSwapWindow(File1, File2, 3, PeqScratch, Cache);
+
+    case 8:
+      return ScLevenshteinSwapWindow(File1, File2, 8, PeqScratch, Cache);
+
+    default:
+      return ScLevenshteinSwapWindow(
+               File1,
+               File2,
+               NumLinesSwap,
+               PeqScratch,
+               Cache
+               );
+  }
+}
+
+///
+/// The maximum number of cells of a row of the line alignment of
+/// ScLevenshteinAlign() that are kept on the stack. Wider bands are
+/// allocated.
+///
+#define SC_ALIGN_STACK_WIDTH  (2U * 16U + 2U)
+
+///
+/// A cell of the line alignment of ScLevenshteinAlign(). It describes the best
+/// alignment of the lines of file 1 up to the current one with the lines of
+/// file 2 up to the cell's one.
+///
+typedef struct {
+  ///
+  /// The sum of the scores of all lines of file 1, which is 1 for unmatched
+  /// lines.
+  ///
+  double Cost;
+  ///
+  /// The sum of the distances of all lines of file 1.
+  ///
+  size_t Diff;
+  ///
+  /// The sum of the match lengths of all lines of file 1.
+  ///
+  size_t Length;
+} sc_align_cell_t;
+
+/*
+  Calculates the distances of a line of file 1 to a batch of lines of file 2
+  and stores those of interest in the row of the line alignment.
+
+  @param[in,out] PeqScratch   The bit-parallel scratch buffer. All elements
+                              must be 0 on input and are 0 on output.
+  @param[in,out] Cache        The line pair distance cache. It may be NULL.
+  @param[in]     Profiles1    The line profiles of file 1.
+  @param[in]     Line1Index   The index of the line within Profiles1.
+  @param[in]     Profiles2    The line profiles of file 2.
+  @param[in]     Texts        The lines of file 2 to compare with and the
+                              maximum distances of interest.
+  @param[in]     Line2Indices The indices of the lines of Texts within
+                              Profiles2.
+  @param[in]     Columns      The columns of the lines of Texts within the row.
+  @param[in]     NumLines     The number of elements in Texts, Line2Indices
+                              and Columns.
+  @param[in,out] Distances    The distances of the row. Distances larger than
+                              the maximum of interest are not stored.
+*/
+static void ScAlignDistanceBatch(
+  uint64_t                    *PeqScratch,
+  sc_line_cache_t             *Cache,
+  const sc_line_profiles_t    *Profiles1,
+  size_t                      Line1Index,
+  const sc_line_profiles_t    *Profiles2,
+  const sc_levenshtein_text_t *Texts,
+  const size_t                *Line2Indices,
+  const size_t                *Columns,
+  size_t                      NumLines,
+  size_t                      *Distances
+  )
+{
+  assert(NumLines <= SC_LINE_BATCH_SIZE);
+  assert(Distances != NULL);
+
+  if (NumLines == 0) {
+    return;
+  }
+
+  size_t BatchDistances[SC_LINE_BATCH_SIZE];
+  ScLineProfileDistanceBatch(
+    PeqScratch,
+    Cache,
+    Profiles1,
+    Line1Index,
+    Profiles2,
+    Texts,
+    Line2Indices,
+    NumLines,
+    BatchDistances
+    );
+
+  for (size_t BatchIndex = 0; BatchIndex < NumLines; ++BatchIndex) {
+    if (BatchDistances[BatchIndex] <= Texts[BatchIndex].MaxDistance) {
+      Distances[Columns[BatchIndex]] = BatchDistances[BatchIndex];
+    }
+  }
+}
+
+double ScLevenshteinAlign(
+  const sc_cleanse_file_t *File1,
+  const sc_cleanse_file_t *File2,
+  size_t                  NumLinesSwap,
+  uint64_t                *PeqScratch,
+  sc_line_cache_t         *Cache
+  )
+{
+  assert(File1 != NULL);
+  assert(File1->Buffer != NULL || File1->Length == 0);
+  assert(File1->Profiles.Hashes != NULL);
+  assert(File2 != NULL);
+  assert(File2->Buffer != NULL || File2->Length == 0);
+  assert(File2->Profiles.Hashes != NULL);
+  assert(PeqScratch != NULL);
+
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterPairings, 1);
+  //
+  // Make sure File1 is the shorter file, so that all of its lines may be
+  // matched.
+  //
+  if (File1->Profiles.NumLines > File2->Profiles.NumLines) {
+    const sc_cleanse_file_t *const FileTmp = File1;
+    File1 = File2;
+    File2 = FileTmp;
+  }
+  //
+  // As every line of file 2 is matched at most once, the sums of all cells
+  // are bounded by the lengths of both files.
+  //
+  size_t     TotalLength;
+  const bool Overflow = ScSafeAddSize(
+                          File1->Length,
+                          File2->Length,
+                          &TotalLength
+                          );
+  if (Overflow) {
+    return (double) INFINITY;
+  }
+
+  const sc_line_profiles_t Profiles1 = File1->Profiles;
+  const sc_line_profiles_t Profiles2 = File2->Profiles;
+  const size_t             NumLines1 = Profiles1.NumLines;
+  const size_t             NumLines2 = Profiles2.NumLines;
+  assert(NumLines1 > 0 && NumLines2 >= NumLines1);
+  //
+  // Column Column of the row of line Line1Index of file 1 denotes the lines of
+  // file 2 before Line1Index - Radius + Column. The first column is left of
+  // the band and only reached by unmatched lines. Wider bands than file 2 do
+  // not add any lines.
+  //
+  const size_t Radius = SC_MIN(NumLinesSwap, NumLines2);
+  const size_t Width  = 2U * Radius + 2U;
+
+  sc_align_cell_t StackCells[2U * SC_ALIGN_STACK_WIDTH];
+  size_t          StackDistances[SC_ALIGN_STACK_WIDTH];
+  sc_align_cell_t *Cells     = StackCells;
+  size_t          *Distances = StackDistances;
+  if (Width > SC_ALIGN_STACK_WIDTH) {
+    Cells     = malloc(2U * Width * sizeof(*Cells));
+    Distances = malloc(Width * sizeof(*Distances));
+    if (Cells == NULL || Distances == NULL) {
+      free(Cells);
+      free(Distances);
+      return (double) INFINITY;
+    }
+  }
+  //
+  // Only the rows of the previous and of the current line are kept. Before
+  // the first line, all costs are 0.
+  //
+  sc_align_cell_t *Previous = Cells;
+  sc_align_cell_t *Current  = &Cells[Width];
+  memset(Previous, 0, Width * sizeof(*Previous));
+
+  for (size_t Line1Index = 0; Line1Index < NumLines1; ++Line1Index) {
+    const size_t Length1 = Profiles1.Lengths[Line1Index];
+    //
+    // Calculate the distances of all line pairs in the band exactly once.
+    // Line pairs whose distances need to be calculated are collected to share
+    // the setup of the pattern.
+    //
+    sc_levenshtein_text_t Texts[SC_LINE_BATCH_SIZE];
+    size_t                Line2Indices[SC_LINE_BATCH_SIZE];
+    size_t                Columns[SC_LINE_BATCH_SIZE];
+    size_t                NumBatched = 0;
+    for (size_t Column = 0; Column < Width; ++Column) {
+      Distances[Column] = SIZE_MAX;
+    }
+
+    for (size_t Column = 1; Column < Width; ++Column) {
+      if (Line1Index + Column < Radius + 1U) {
+        continue;
+      }
+
+      const size_t Line2Index = Line1Index + Column - Radius - 1U;
+      if (Line2Index >= NumLines2) {
+        break;
+      }
+
+      SC_INSTRUMENT_COUNT(ScInstrumentCounterWindowCandidates, 1);
+
+      const size_t MatchLength = SC_MAX(Length1, Profiles2.Lengths[Line2Index]);
+      //
+      // A match is only chosen if it is at least as good as leaving the line
+      // of file 1 unmatched, which limits the distances of interest. The
+      // bound is subject to rounding, hence allow one more distance than it
+      // yields, which is finer than any rounding error of the costs.
+      //
+      const double Bound = Previous[SC_MIN(Column + 1U, Width - 1U)].Cost + 1
+                             - Previous[Column].Cost;
+      size_t MaxDistance = SIZE_MAX;
+      if (Bound < 1) {
+        const bool Improvable = ScGetImprovingDistance(
+          SC_MAX(Bound, 0.0),
+          MatchLength,
+          true,
+          &MaxDistance
+          );
+        MaxDistance = Improvable ? MaxDistance + 1U : 0;
+        if (MaxDistance > MatchLength) {
+          MaxDistance = SIZE_MAX;
+        }
+      }
+
+      size_t     Distance;
+      const bool Known = ScLineProfileKnownDistance(
+                           Cache,
+                           File1->Buffer,
+                           &Profiles1,
+                           Line1Index,
+                           File2->Buffer,
+                           &Profiles2,
+                           Line2Index,
+                           MaxDistance,
+                           &Distance
+                           );
+      if (Known) {
+        if (Distance <= MaxDistance) {
+          Distances[Column] = Distance;
+        }
+
+        continue;
+      }
+
+      Texts[NumBatched].Text   = &File2->Buffer[Profiles2.Offsets[Line2Index]];
+      Texts[NumBatched].Length = Profiles2.Lengths[Line2Index];
+      Texts[NumBatched].MaxDistance = MaxDistance;
+      Line2Indices[NumBatched]      = Line2Index;
+      Columns[NumBatched]           = Column;
+      ++NumBatched;
+      if (NumBatched == SC_LINE_BATCH_SIZE) {
+        ScAlignDistanceBatch(
+          PeqScratch,
+          Cache,
+          &Profiles1,
+          Line1Index,
+          &Profiles2,
+          Texts,
+          Line2Indices,
+          Columns,
+          NumBatched,
+          Distances
+          );
+        NumBatched = 0;
+      }
+    }
+
+    ScAlignDistanceBatch(
+      PeqScratch,
+      Cache,
+      &Profiles1,
+      Line1Index,
+      &Profiles2,
+      Texts,
+      Line2Indices,
+      Columns,
+      NumBatched,
+      Distances
+      );
+    //
+    // Every line of file 1 is either matched with a line of file 2 that none
+    // of its previous lines is matched with, or it is unmatched, which scores
+    // like a match with an empty line. Lines of file 2 may be skipped for
+    // free. Ties prefer matches, so that a radius of 0 yields the results of
+    // ScLevenshteinSwap().
+    //
+    for (size_t Column = 0; Column < Width; ++Column) {
+      sc_align_cell_t Best = Previous[SC_MIN(Column + 1U, Width - 1U)];
+      Best.Cost   += 1;
+      Best.Diff   += Length1;
+      Best.Length += Length1;
+
+      if (Column > 0 && Current[Column - 1U].Cost <= Best.Cost) {
+        Best = Current[Column - 1U];
+      }
+
+      if (Distances[Column] != SIZE_MAX) {
+        const size_t Line2Index  = Line1Index + Column - Radius - 1U;
+        const size_t MatchLength = SC_MAX(
+          Length1,
+          Profiles2.Lengths[Line2Index]
+          );
+        const double Score = Distances[Column] == 0
+          ? 0
+          : (double) Distances[Column] / (double) MatchLength;
+        const double Cost  = Previous[Column].Cost + Score;
+        if (Cost <= Best.Cost) {
+          Best.Cost   = Cost;
+          Best.Diff   = Previous[Column].Diff + Distances[Column];
+          Best.Length = Previous[Column].Length + MatchLength;
+        }
+      }
+
+      assert(Best.Diff <= Best.Length && Best.Length <= TotalLength);
+      Current[Column] = Best;
+    }
+
+    sc_align_cell_t *const RowTmp = Previous;
+    Previous = Current;
+    Current  = RowTmp;
+  }
+  //
+  // The result aligns all lines of both files. Lines of file 2 right of the
+  // band of the last line of file 1 are skipped.
+  //
+  const sc_align_cell_t Result = Previous[
+                                   SC_MIN(
+                                     NumLines2 - NumLines1 + Radius + 1U,
+                                     Width - 1U
+                                     )
+                                   ];
+  if (Cells != StackCells) {
+    free(Cells);
+    free(Distances);
+  }
+
+  return 1. - ((double) Result.Diff / (double) Result.Length);
+}
+
+void ScSketchCleansedFile(
+  sc_min_hash_t           *Sketch,
+  const sc_cleanse_file_t *File
+  )
+{
+  assert(Sketch != NULL);
+  assert(File != NULL);
+  assert(File->Profiles.Hashes != NULL);
+
+  SC_INSTRUMENT_PHASE_START(SketchTimer);
+
+  ScMinHashInitialise(Sketch);
+
+  const size_t NumLines = File->Profiles.NumLines;
+  for (size_t LineIndex = 0; LineIndex < NumLines; ++LineIndex) {
+    ScMinHashAdd(Sketch, File->Profiles.Hashes[LineIndex]);
+  }
+
+  SC_INSTRUMENT_PHASE_STOP(SketchTimer, ScInstrumentPhaseSketch);
+}
+
+/*
+  Calculates the size of the line profiles of a file and lays them out in
+  Memory. Every array starts at a multiple of SC_LINE_PROFILES_ALIGNMENT bytes
+  from Memory.
+
+  @param[out] Profiles       If Memory is not NULL, the profiles pointing into
+                             Memory.
+  @param[in]  Memory         The memory to lay the profiles out in. It may be
+                             NULL to only calculate the size.
+  @param[in]  NumLines       The number of profiled lines.
+  @param[in]  NumPeqEntries  The number of compiled Levenshtein bitmask entries
+                             of all lines.
+  @param[out] Size           The size, in bytes, of the profiles.
+
+  @returns  Whether the size could be calculated without overflows.
+*/
+static bool ScLayOutLineProfiles(
+  sc_line_profiles_t *Profiles,
+  unsigned char      *Memory,
+  size_t             NumLines,
+  size_t             NumPeqEntries,
+  size_t             *Size
+  )
+{
+  assert(Profiles != NULL || Memory == NULL);
+  assert(Size != NULL);
+  //
+  // The arrays in the order of sc_line_profiles_t.
+  //
+  const size_t ElementSizes[] = {
+    sizeof(*Profiles->Hashes),
+    sizeof(*Profiles->Offsets),
+    sizeof(*Profiles->PeqOffsets),
+    sizeof(*Profiles->Lengths),
+    sizeof(*Profiles->NumLinePeqEntries),
+    sizeof(*Profiles->Histograms),
+    sizeof(*Profiles->PeqEntries)
+  };
+  size_t Offsets[SC_ARRAY_LEN(ElementSizes)];
+
+  _Static_assert(
+    SC_LINE_PROFILES_ALIGNMENT % _Alignof(sc_levenshtein_peq_entry_t) == 0
+      && SC_LINE_PROFILES_ALIGNMENT % _Alignof(uint64_t) == 0,
+    "The line profile arrays would be misaligned."
+    );
+
+  size_t Offset   = 0;
+  bool   Overflow = false;
+  for (size_t Index = 0; Index < SC_ARRAY_LEN(ElementSizes); ++Index) {
+    const size_t NumElements = Index == SC_ARRAY_LEN(ElementSizes) - 1U
+                                 ? NumPeqEntries
+                                 : NumLines;
+    size_t ArraySize;
+    Offsets[Index] = Offset;
+    Overflow |= ScSafeMulSize(NumElements, ElementSizes[Index], &ArraySize);
+    Overflow |= ScSafeAddSize(Offset, ArraySize, &Offset);
+    Overflow |= ScSafeAddSize(Offset, SC_LINE_PROFILES_ALIGNMENT - 1U, &Offset);
+    Offset   &= ~(size_t) (SC_LINE_PROFILES_ALIGNMENT - 1U);
+  }
+
+  if (Overflow) {
+    return false;
+  }
+
+  *Size = Offset;
+
+  if (Memory != NULL) {
+    Profiles->NumLines          = NumLines;
+    Profiles->NumPeqEntries     = NumPeqEntries;
+    Profiles->Hashes            = (uint64_t *) (void *) &Memory[Offsets[0]];
+    Profiles->Offsets           = (uint32_t *) (void *) &Memory[Offsets[1]];
+    Profiles->PeqOffsets        = (uint32_t *) (void *) &Memory[Offsets[2]];
+    Profiles->Lengths           = (uint16_t *) (void *) &Memory[Offsets[3]];
+    Profiles->NumLinePeqEntries = (uint16_t *) (void *) &Memory[Offsets[4]];
+    Profiles->Histograms        = (void *) &Memory[Offsets[5]];
+    Profiles->PeqEntries        = (void *) &Memory[Offsets[6]];
+  }
+
+  return true;
+}
+
+/*
+  Precomputes the comparison profiles of all lines of File.
+
+  @param[in,out] File  The file to profile. Its lines information must be valid
+                       and no line may be longer than SC_MAX_LINE_LENGTH.
+
+  @returns  Whether the profiles have been computed successfully.
+*/
+static bool ScInitialiseLineProfiles(
+  sc_cleanse_file_t *File
+  )
+{
+  assert(File != NULL);
+  assert(File->LinesInfo != NULL);
+  assert(File->LinesInfo->MaxLineLength <= SC_MAX_LINE_LENGTH);
+
+  const sc_str_lines_info_t *LinesInfo = File->LinesInfo;
+  //
+  // The bitmask entries are compiled line by line, hence the scratch buffer
+  // only needs to fit the longest line.
+  //
+  uint64_t PeqScratch[SC_LEVENSHTEIN_PEQ_SIZE(SC_MAX_LINE_LENGTH)] = { 0 };
+  //
+  // Count the bitmask entries first to allocate all profile data at once.
+  // Every line has at most as many entries as characters, hence the sum
+  // cannot exceed File->Length.
+  //
+  size_t NumPeqEntries = 0;
+  for (size_t Index = 0; Index < LinesInfo->NumLines; ++Index) {
+    NumPeqEntries += ScLevenshteinPeqCompile(
+      PeqScratch,
+      NULL,
+      LinesInfo->Lines[Index].Start,
+      LinesInfo->Lines[Index].Length
+      );
+  }
+
+  assert(NumPeqEntries <= File->Length);
+
+  size_t ProfilesSize;
+  bool   Result = ScLayOutLineProfiles(
+                    NULL,
+                    NULL,
+                    LinesInfo->NumLines,
+                    NumPeqEntries,
+                    &ProfilesSize
+                    );
+  if (!Result) {
+    return false;
+  }
+
+  unsigned char *Memory = malloc(ProfilesSize);
+  if (Memory == NULL) {
+    return false;
+  }
+
+  sc_line_profiles_t *Profiles = &File->Profiles;
+  ScLayOutLineProfiles(
+    Profiles,
+    Memory,
+    LinesInfo->NumLines,
+    NumPeqEntries,
+    &ProfilesSize
+    );
+
+  size_t PeqOffset = 0;
+  for (size_t Index = 0; Index < LinesInfo->NumLines; ++Index) {
+    const sc_str_line_info_t *Line = &LinesInfo->Lines[Index];
+
+    const size_t NumLinePeqEntries = ScLevenshteinPeqCompile(
+      PeqScratch,
+      &Profiles->PeqEntries[PeqOffset],
+      Line->Start,
+      Line->Length
+      );
+    //
+    // The casts are safe due to the file size and line length constraints.
+    //
+    Profiles->Hashes[Index]     = ScStrHash64(Line->Start, Line->Length);
+    Profiles->Offsets[Index]    = (uint32_t) (Line->Start - File->Buffer);
+    Profiles->PeqOffsets[Index] = (uint32_t) PeqOffset;
+    Profiles->Lengths[Index]    = (uint16_t) Line->Length;
+    Profiles->NumLinePeqEntries[Index] = (uint16_t) NumLinePeqEntries;
+    ScLevenshteinHistogramInitialise(
+      Profiles->Histograms[Index],
+      Line->Start,
+      Line->Length
+      );
+
+    PeqOffset += NumLinePeqEntries;
+  }
+
+  assert(PeqOffset == NumPeqEntries);
+
+  return true;
+}
+
 bool ScInitialiseCleanseFile(
-  sc_cleanse_file_t        *File,
-  sc_cleanse_config_type_t FileType
+  sc_cleanse_file_t          *File,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
   )
 {
   assert(File != NULL);
@@ -182,10 +1453,16 @@ bool ScInitialiseCleanseFile(
   assert(FileType >= ScCleanseConfigTypeMin
       && FileType <= ScCleanseConfigTypeMax);
   assert((unsigned int) FileType < SC_ARRAY_LEN(gScCleanseConfigs));
+  assert(Matchers != NULL);
+
+  File->Cached  = false;
+  File->InArena = false;
   //
   // Cleanse the read file's contents using the configuration for FileType.
   //
-  ScCleanseInput(File->Buffer, &File->Length, gScCleanseConfigs[FileType]);
+  SC_INSTRUMENT_PHASE_START(CleanseTimer);
+  ScCleanseInput(File->Buffer, &File->Length, &Matchers[FileType]);
+  SC_INSTRUMENT_PHASE_STOP(CleanseTimer, ScInstrumentPhaseCleanse);
   //
   // There is no point in returning an empty file.
   //
@@ -195,6 +1472,7 @@ bool ScInitialiseCleanseFile(
   //
   // Retrieve the file lines information for the cleansed content.
   //
+  SC_INSTRUMENT_PHASE_START(LineInfoTimer);
   File->LinesInfo = ScStrGetLineInfo(File->Buffer, File->Length);
   if (File->LinesInfo == NULL) {
     return false;
@@ -213,20 +1491,449 @@ bool ScInitialiseCleanseFile(
     free(File->LinesInfo);
     return false;
   }
+  //
+  // Precompute the line profiles once so that no comparison needs to.
+  //
+  bool Result = ScInitialiseLineProfiles(File);
+  SC_INSTRUMENT_PHASE_STOP(LineInfoTimer, ScInstrumentPhaseLineInfo);
+  if (!Result) {
+    free(File->LinesInfo);
+    return false;
+  }
 
   return true;
 }
 
-bool ScReadCleansedFile(
+bool ScLoadFile(
+  sc_cleanse_file_t *File,
+  const char        *FileName,
+  size_t            MaxFileSize,
+  bool              Prefetch
+  )
+{
+  assert(File != NULL);
+  assert(FileName != NULL);
+  assert(MaxFileSize <= SC_MAX_FILE_SIZE);
+  //
+  // Map the file if possible, as cleansing only touches every byte once.
+  //
+  SC_INSTRUMENT_PHASE_START(ReadTimer);
+  File->Buffer = ScMapFile(
+    &File->Length,
+    &File->MappingSize,
+    FileName,
+    MaxFileSize,
+    Prefetch
+    );
+  SC_INSTRUMENT_PHASE_STOP(ReadTimer, ScInstrumentPhaseRead);
+  return File->Buffer != NULL;
+}
+
+/*
+  Calculates the layout of a cleansed file cache entry.
+
+  @param[in]  Length          The length, in characters, of the cleansed
+                              buffer.
+  @param[in]  NumLines        The number of line profiles.
+  @param[in]  NumPeqEntries   The number of compiled Levenshtein bitmask
+                              entries.
+  @param[in]  ContentLength   The length, in characters, of the uncleansed
+                              file contents.
+  @param[out] ProfilesOffset  The offset of the line profiles.
+  @param[out] ContentOffset   The offset of the uncleansed file contents.
+  @param[out] TrailerOffset   The offset of the trailer.
+
+  @returns  Whether the layout could be calculated without overflows.
+*/
+static bool ScGetCacheEntryLayout(
+  size_t Length,
+  size_t NumLines,
+  size_t NumPeqEntries,
+  size_t ContentLength,
+  size_t *ProfilesOffset,
+  size_t *ContentOffset,
+  size_t *TrailerOffset
+  )
+{
+  assert(ProfilesOffset != NULL);
+  assert(ContentOffset != NULL);
+  assert(TrailerOffset != NULL);
+
+  size_t ProfilesSize;
+  bool   Overflow = ScSafeAddSize(
+                      Length,
+                      SC_CLEANSE_CACHE_ALIGNMENT - 1U,
+                      ProfilesOffset
+                      );
+  *ProfilesOffset &= ~(size_t) (SC_CLEANSE_CACHE_ALIGNMENT - 1U);
+  Overflow |= !ScLayOutLineProfiles(
+                 NULL,
+                 NULL,
+                 NumLines,
+                 NumPeqEntries,
+                 &ProfilesSize
+                 );
+  Overflow = Overflow
+    || ScSafeAddSize(*ProfilesOffset, ProfilesSize, ContentOffset);
+  Overflow = Overflow
+    || ScSafeAddSize(
+         *ContentOffset,
+         SC_CLEANSE_CACHE_ALIGNMENT - 1U,
+         ContentOffset
+         );
+  *ContentOffset &= ~(size_t) (SC_CLEANSE_CACHE_ALIGNMENT - 1U);
+  Overflow = Overflow
+    || ScSafeAddSize(*ContentOffset, ContentLength, TrailerOffset);
+  Overflow = Overflow
+    || ScSafeAddSize(
+         *TrailerOffset,
+         SC_CLEANSE_CACHE_ALIGNMENT - 1U,
+         TrailerOffset
+         );
+  *TrailerOffset &= ~(size_t) (SC_CLEANSE_CACHE_ALIGNMENT - 1U);
+  return !Overflow;
+}
+
+/*
+  Builds the path of the cleansed file cache entry for the given file contents.
+
+  @param[in] CacheDir       The path of the cache directory.
+  @param[in] ContentHash    The ScStrHash64() value of the file contents.
+  @param[in] ContentLength  The length, in characters, of the file contents.
+  @param[in] FileType       The cleansing type of the file.
+
+  @retval NULL   An error has occured.
+  @retval other  The path of the cache entry. It is allocated with malloc and
+                 caller-owned.
+*/
+static char *ScGetCacheEntryPath(
+  const char               *CacheDir,
+  uint64_t                 ContentHash,
+  size_t                   ContentLength,
+  sc_cleanse_config_type_t FileType
+  )
+{
+  assert(CacheDir != NULL);
+
+  const char *const Format = "%s/%016llx-%llx-%u.scc";
+
+  const int PathLength = snprintf(
+    NULL,
+    0,
+    Format,
+    CacheDir,
+    (unsigned long long) ContentHash,
+    (unsigned long long) ContentLength,
+    (unsigned int) FileType
+    );
+  if (PathLength < 0) {
+    return NULL;
+  }
+
+  char *Path = malloc((size_t) PathLength + 1U);
+  if (Path == NULL) {
+    return NULL;
+  }
+
+  snprintf(
+    Path,
+    (size_t) PathLength + 1U,
+    Format,
+    CacheDir,
+    (unsigned long long) ContentHash,
+    (unsigned long long) ContentLength,
+    (unsigned int) FileType
+    );
+  return Path;
+}
+
+/*
+  Loads a cleansed file from the cache entry at Path. The entry is validated
+  such that corrupted entries cannot cause invalid memory accesses. As the
+  content hash is not collision-resistant, the entry is only accepted if the
+  file contents it stores equal Content.
+
+  @param[out] File           On success, the cleansed file.
+  @param[in]  Path           The path of the cache entry.
+  @param[in]  Content        The uncleansed file contents.
+  @param[in]  ContentHash    The ScStrHash64() value of the file contents.
+  @param[in]  ContentLength  The length, in characters, of the file contents.
+  @param[in]  FileType       The cleansing type of the file.
+
+  @returns  Whether a valid entry has been loaded.
+*/
+static bool ScLoadCachedFile(
   sc_cleanse_file_t        *File,
-  const char               *FileName,
+  const char               *Path,
+  const char               *Content,
+  uint64_t                 ContentHash,
+  size_t                   ContentLength,
+  sc_cleanse_config_type_t FileType
+  )
+{
+  assert(File != NULL);
+  assert(Path != NULL);
+  assert(Content != NULL);
+
+  //
+  // Every line and every bitmask entry accounts for at least one character,
+  // which bounds the size of valid entries.
+  //
+  size_t ProfilesOffset;
+  size_t ContentOffset;
+  size_t MaxEntrySize;
+  bool Result = ScGetCacheEntryLayout(
+    SC_MAX_FILE_SIZE,
+    SC_MAX_FILE_SIZE,
+    SC_MAX_FILE_SIZE,
+    SC_MAX_FILE_SIZE,
+    &ProfilesOffset,
+    &ContentOffset,
+    &MaxEntrySize
+    );
+  Result = Result && !ScSafeAddSize(
+                        MaxEntrySize,
+                        sizeof(sc_cleanse_cache_trailer_t),
+                        &MaxEntrySize
+                        );
+  if (!Result) {
+    MaxEntrySize = SIZE_MAX;
+  }
+
+  size_t EntrySize;
+  size_t MappingSize;
+  char   *Entry = ScMapFile(
+                    &EntrySize,
+                    &MappingSize,
+                    Path,
+                    MaxEntrySize,
+                    false
+                    );
+  if (Entry == NULL) {
+    return false;
+  }
+
+  if (EntrySize < sizeof(sc_cleanse_cache_trailer_t)) {
+    ScUnmapFile(Entry, MappingSize);
+    return false;
+  }
+
+  sc_cleanse_cache_trailer_t Trailer;
+  memcpy(
+    &Trailer,
+    &Entry[EntrySize - sizeof(Trailer)],
+    sizeof(Trailer)
+    );
+  //
+  // Only accept entries for the same contents from a compatible build.
+  // Bounding all sizes by the file size keeps the calculations below safe.
+  //
+  bool Valid = Trailer.Magic == SC_CLEANSE_CACHE_MAGIC
+    && Trailer.LayoutVersion == SC_CLEANSE_CACHE_LAYOUT_VERSION
+    && Trailer.ConfigsVersion == SC_CLEANSE_CONFIGS_VERSION
+    && Trailer.FileType == (uint32_t) FileType
+    && Trailer.ContentHash == ContentHash
+    && Trailer.ContentLength == ContentLength
+    && Trailer.HistogramSize == SC_LEVENSHTEIN_HISTOGRAM_SIZE
+    && Trailer.PeqEntrySize == sizeof(sc_levenshtein_peq_entry_t)
+    && Trailer.MaxSupportedLineLength == SC_MAX_LINE_LENGTH
+    && Trailer.CleansedLength > 0
+    && Trailer.CleansedLength <= SC_MAX_FILE_SIZE
+    && Trailer.NumLines > 0
+    && Trailer.NumLines <= Trailer.CleansedLength
+    && Trailer.NumPeqEntries <= Trailer.CleansedLength
+    && Trailer.MaxLineLength > 0
+    && Trailer.MaxLineLength <= SC_MAX_LINE_LENGTH;
+
+  size_t TrailerOffset = 0;
+  if (Valid) {
+    Valid = ScGetCacheEntryLayout(
+      (size_t) Trailer.CleansedLength,
+      (size_t) Trailer.NumLines,
+      (size_t) Trailer.NumPeqEntries,
+      ContentLength,
+      &ProfilesOffset,
+      &ContentOffset,
+      &TrailerOffset
+      );
+    Valid = Valid && TrailerOffset == EntrySize - sizeof(Trailer);
+    Valid = Valid
+      && memcmp(&Entry[ContentOffset], Content, ContentLength) == 0;
+  }
+
+  if (!Valid) {
+    ScUnmapFile(Entry, MappingSize);
+    return false;
+  }
+
+  const size_t NumLines      = (size_t) Trailer.NumLines;
+  const size_t NumPeqEntries = (size_t) Trailer.NumPeqEntries;
+
+  sc_line_profiles_t Profiles;
+  size_t             ProfilesSize;
+  ScLayOutLineProfiles(
+    &Profiles,
+    (unsigned char *) &Entry[ProfilesOffset],
+    NumLines,
+    NumPeqEntries,
+    &ProfilesSize
+    );
+  //
+  // Rebuild the lines information from the profiles, validating them on the
+  // way.
+  //
+  sc_str_lines_info_t *LinesInfo = malloc(
+    sizeof(*LinesInfo) + NumLines * sizeof(LinesInfo->Lines[0])
+    );
+  if (LinesInfo == NULL) {
+    ScUnmapFile(Entry, MappingSize);
+    return false;
+  }
+
+  LinesInfo->MaxLineLength = (size_t) Trailer.MaxLineLength;
+  LinesInfo->NumLines      = NumLines;
+
+  for (size_t Index = 0; Index < NumLines && Valid; ++Index) {
+    const size_t Length            = Profiles.Lengths[Index];
+    const size_t Offset            = Profiles.Offsets[Index];
+    const size_t PeqOffset         = Profiles.PeqOffsets[Index];
+    const size_t NumLinePeqEntries = Profiles.NumLinePeqEntries[Index];
+
+    Valid = Length > 0
+      && Length <= Trailer.MaxLineLength
+      && Offset <= Trailer.CleansedLength - Length
+      && PeqOffset <= NumPeqEntries
+      && NumLinePeqEntries <= NumPeqEntries - PeqOffset;
+
+    for (
+      size_t PeqIndex = 0;
+      Valid && PeqIndex < NumLinePeqEntries;
+      ++PeqIndex
+      ) {
+      Valid = Profiles.PeqEntries[PeqOffset + PeqIndex].Index
+                < SC_LEVENSHTEIN_PEQ_SIZE(Length);
+    }
+
+    LinesInfo->Lines[Index].Start  = &Entry[Offset];
+    LinesInfo->Lines[Index].Length = Length;
+  }
+
+  if (!Valid) {
+    free(LinesInfo);
+    ScUnmapFile(Entry, MappingSize);
+    return false;
+  }
+
+  File->Buffer       = Entry;
+  File->Length       = (size_t) Trailer.CleansedLength;
+  File->MappingSize  = MappingSize;
+  File->LinesInfo    = LinesInfo;
+  File->Profiles     = Profiles;
+  File->Cached       = true;
+  File->InArena      = false;
+
+  return true;
+}
+
+/*
+  Stores cleansed File as a cache entry at Path. Failures are ignored, as the
+  entry will be recreated by later runs.
+
+  @param[in] File           The cleansed file to cache.
+  @param[in] Path           The path of the cache entry.
+  @param[in] Content        The uncleansed file contents.
+  @param[in] ContentHash    The ScStrHash64() value of the file contents.
+  @param[in] ContentLength  The length, in characters, of the file contents.
+  @param[in] FileType       The cleansing type of the file.
+*/
+static void ScStoreCachedFile(
+  const sc_cleanse_file_t  *File,
+  const char               *Path,
+  const char               *Content,
+  uint64_t                 ContentHash,
+  size_t                   ContentLength,
   sc_cleanse_config_type_t FileType
   )
 {
   assert(File != NULL);
+  assert(Path != NULL);
+  assert(Content != NULL);
+  assert(!File->Cached);
+
+  const size_t NumLines      = File->Profiles.NumLines;
+  const size_t NumPeqEntries = File->Profiles.NumPeqEntries;
+
+  size_t ProfilesOffset;
+  size_t ContentOffset;
+  size_t TrailerOffset;
+  bool Result = ScGetCacheEntryLayout(
+    File->Length,
+    NumLines,
+    NumPeqEntries,
+    ContentLength,
+    &ProfilesOffset,
+    &ContentOffset,
+    &TrailerOffset
+    );
+  if (!Result) {
+    return;
+  }
+
+  const size_t EntrySize = TrailerOffset + sizeof(sc_cleanse_cache_trailer_t);
+  char         *Entry    = calloc(1, EntrySize);
+  if (Entry == NULL) {
+    return;
+  }
+  //
+  // The profiles are copied as one block, as their layout only depends on
+  // their counts.
+  //
+  size_t ProfilesSize;
+  ScLayOutLineProfiles(NULL, NULL, NumLines, NumPeqEntries, &ProfilesSize);
+
+  memcpy(Entry, File->Buffer, File->Length);
+  memcpy(&Entry[ProfilesOffset], File->Profiles.Hashes, ProfilesSize);
+  memcpy(&Entry[ContentOffset], Content, ContentLength);
+
+  const sc_cleanse_cache_trailer_t Trailer = {
+    SC_CLEANSE_CACHE_MAGIC,
+    ContentHash,
+    ContentLength,
+    File->Length,
+    NumLines,
+    File->LinesInfo->MaxLineLength,
+    NumPeqEntries,
+    SC_CLEANSE_CACHE_LAYOUT_VERSION,
+    SC_CLEANSE_CONFIGS_VERSION,
+    (uint32_t) FileType,
+    SC_LEVENSHTEIN_HISTOGRAM_SIZE,
+    sizeof(sc_levenshtein_peq_entry_t),
+    SC_MAX_LINE_LENGTH
+  };
+  memcpy(&Entry[TrailerOffset], &Trailer, sizeof(Trailer));
+  //
+  // Concurrent runs, e.g. of shards sharing the cache, never observe
+  // partially written entries.
+  //
+  ScReplaceFile(Path, EntrySize, Entry);
+
+  free(Entry);
+}
+
+bool ScCleanseLoadedFile(
+  sc_cleanse_file_t          *File,
+  const char                 *FileName,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1],
+  const char                 *CacheDir
+  )
+{
+  assert(File != NULL);
+  assert(File->Buffer != NULL);
   assert(FileName != NULL);
   assert(FileType >= ScCleanseConfigTypeMin
       && FileType <= ScCleanseConfigTypeMax);
+  assert(Matchers != NULL);
   //
   // Use ScCleanseConfigTypeMax as a wildcard to automatically detect the
   // cleansing configuration.
@@ -275,21 +1982,185 @@ bool ScReadCleansedFile(
         && FileType <= ScCleanseConfigTypeMax);
   }
   //
-  // Read the file at FileName.
+  // Cleanse the loaded file's contents using the configuration for FileType.
+  // ScInitialiseCleanseFile() requires a non-empty buffer.
   //
-  File->Buffer = ScReadFile(&File->Length, FileName, SC_MAX_FILE_SIZE);
-  if (File->Buffer == NULL) {
+  bool Result = File->Length > 0;
+  if (!Result) {
+    ScUnmapFile(File->Buffer, File->MappingSize);
     return false;
   }
   //
-  // Cleanse the read file's contents using the configuration for FileType.
+  // Look the file up in the cache by its uncleansed contents.
+  //
+  uint64_t ContentHash   = 0;
+  size_t   ContentLength = File->Length;
+  char     *CachePath    = NULL;
+  if (CacheDir != NULL) {
+    ContentHash = ScStrHash64(File->Buffer, File->Length);
+    CachePath   = ScGetCacheEntryPath(
+                    CacheDir,
+                    ContentHash,
+                    ContentLength,
+                    FileType
+                    );
+  }
+
+  if (CachePath != NULL) {
+    sc_cleanse_file_t CachedFile;
+    SC_INSTRUMENT_PHASE_START(ReadTimer);
+    Result = ScLoadCachedFile(
+      &CachedFile,
+      CachePath,
+      File->Buffer,
+      ContentHash,
+      ContentLength,
+      FileType
+      );
+    SC_INSTRUMENT_PHASE_STOP(ReadTimer, ScInstrumentPhaseRead);
+    if (Result) {
+      free(CachePath);
+      ScUnmapFile(File->Buffer, File->MappingSize);
+
+      CachedFile.Reserved = File->Reserved;
+      *File = CachedFile;
+      return true;
+    }
+  }
+
   //
-  bool Result = ScInitialiseCleanseFile(File, FileType);
+  // Cleansing works in-place, so keep the contents to store them with the
+  // entry. Without them, the file is not cached.
+  //
+  char *Content = NULL;
+  if (CachePath != NULL) {
+    Content = malloc(ContentLength);
+    if (Content != NULL) {
+      memcpy(Content, File->Buffer, ContentLength);
+    }
+  }
+
+  Result = ScInitialiseCleanseFile(File, FileType, Matchers);
   if (!Result) {
-    free(File->Buffer);
+    free(Content);
+    free(CachePath);
+    ScUnmapFile(File->Buffer, File->MappingSize);
+    return false;
+  }
+
+  if (Content != NULL) {
+    ScStoreCachedFile(
+      File,
+      CachePath,
+      Content,
+      ContentHash,
+      ContentLength,
+      FileType
+      );
   }
 
-  return Result;
+  free(Content);
+  free(CachePath);
+  return true;
+}
+
+bool ScReadCleansedFile(
+  sc_cleanse_file_t          *File,
+  const char                 *FileName,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
+  )
+{
+  assert(File != NULL);
+  assert(FileName != NULL);
+  assert(FileType >= ScCleanseConfigTypeMin
+      && FileType <= ScCleanseConfigTypeMax);
+  //
+  // Read the file at FileName.
+  //
+  bool Result = ScLoadFile(File, FileName, SC_MAX_FILE_SIZE, false);
+  if (!Result) {
+    return false;
+  }
+
+  return ScCleanseLoadedFile(File, FileName, FileType, Matchers, NULL);
+}
+
+bool ScMoveCleansedFileToArena(
+  sc_cleanse_file_t *File,
+  sc_arena_t        *Arena
+  )
+{
+  assert(File != NULL);
+  assert(File->Buffer != NULL);
+  assert(File->LinesInfo != NULL);
+  assert(File->Profiles.Hashes != NULL);
+  assert(!File->InArena);
+  assert(Arena != NULL);
+
+  const sc_str_lines_info_t *LinesInfo = File->LinesInfo;
+  const size_t              NumLines   = LinesInfo->NumLines;
+  //
+  // All sizes are bounded by the file size and line length constraints, as
+  // they have been allocated successfully before.
+  //
+  const size_t LinesInfoSize = sizeof(*LinesInfo)
+                                 + NumLines * sizeof(LinesInfo->Lines[0]);
+  size_t       ProfilesSize;
+  ScLayOutLineProfiles(
+    NULL,
+    NULL,
+    NumLines,
+    File->Profiles.NumPeqEntries,
+    &ProfilesSize
+    );
+  //
+  // Align the profiles maximally, so that their arrays are vector-aligned.
+  //
+  unsigned char *Profiles = ScArenaAllocate(
+                              Arena,
+                              ProfilesSize,
+                              _Alignof(max_align_t)
+                              );
+  sc_str_lines_info_t *NewLinesInfo = ScArenaAllocate(
+                                        Arena,
+                                        LinesInfoSize,
+                                        _Alignof(sc_str_lines_info_t)
+                                        );
+  char *Buffer = ScArenaAllocate(Arena, File->Length, 1);
+  if (Profiles == NULL || NewLinesInfo == NULL || Buffer == NULL) {
+    return false;
+  }
+
+  memcpy(Buffer, File->Buffer, File->Length);
+  memcpy(NewLinesInfo, LinesInfo, LinesInfoSize);
+  memcpy(Profiles, File->Profiles.Hashes, ProfilesSize);
+  //
+  // The lines information points into the buffer, while the profiles only
+  // store offsets.
+  //
+  for (size_t Index = 0; Index < NumLines; ++Index) {
+    NewLinesInfo->Lines[Index].Start = Buffer
+      + (LinesInfo->Lines[Index].Start - File->Buffer);
+  }
+
+  const size_t NumPeqEntries = File->Profiles.NumPeqEntries;
+  ScFreeCleansedFile(File);
+
+  File->Buffer      = Buffer;
+  File->MappingSize = 0;
+  File->LinesInfo   = NewLinesInfo;
+  File->Cached      = false;
+  File->InArena     = true;
+  ScLayOutLineProfiles(
+    &File->Profiles,
+    Profiles,
+    NumLines,
+    NumPeqEntries,
+    &ProfilesSize
+    );
+
+  return true;
 }
 
 void ScFreeCleansedFile(
@@ -297,7 +2168,17 @@ void ScFreeCleansedFile(
   )
 {
   assert(File != NULL);
+  //
+  // Files in an arena are freed together with it.
+  //
+  if (File->InArena) {
+    return;
+  }
+
+  if (!File->Cached) {
+    free(File->Profiles.Hashes);
+  }
 
   free(File->LinesInfo);
-  free(File->Buffer);
+  ScUnmapFile(File->Buffer, File->MappingSize);
 }
@@ -9,9 +9,14 @@
 #define SC_COMMON_H_
 
 #include <limits.h>
+#include <stdint.h>
 
+#include <ScArena.h>
 #include <ScCleanseConfigs.h>
 #include <ScCleanseInput.h>
+#include <ScDistances.h>
+#include <ScLineCache.h>
+#include <ScMinHash.h>
 
 ///
 /// Defines the maximum file size supported by this tool.
@@ -35,6 +40,31 @@
   #define SC_NUM_LINES_SWAP  3U
 #endif
 
+///
+/// Defines the maximum number of window lines of file 2 whose distances to a
+/// line of file 1 are calculated in a single batch.
+///
+#ifndef SC_LINE_BATCH_SIZE
+  #define SC_LINE_BATCH_SIZE  16U
+#endif
+
+///
+/// Defines the binary logarithm of the number of slots of the line pair
+/// distance cache.
+///
+#ifndef SC_LINE_CACHE_SIZE_LOG2
+  #define SC_LINE_CACHE_SIZE_LOG2  20U
+#endif
+
+///
+/// Defines the minimum number of Levenshtein matrix cells of a line pair for
+/// its distance to be cached. Cheaper pairs are faster to recompute than to
+/// look up.
+///
+#ifndef SC_LINE_CACHE_MIN_CELLS
+  #define SC_LINE_CACHE_MIN_CELLS  64U
+#endif
+
 //
 // As per ScStrGetLineInfo() precondition, the maximum file size value must
 // be smaller than SIZE_MAX.
@@ -44,46 +74,202 @@ _Static_assert(
   "The maximum file size is not smaller than the maximum buffer size."
   );
 
+_Static_assert(
+  SC_LINE_BATCH_SIZE > 0,
+  "The line batch size must not be 0."
+  );
+
+//
+// The line pair distance cache must be able to hold every line distance.
+//
+_Static_assert(
+  SC_MAX_LINE_LENGTH <= SC_LINE_CACHE_MAX_DISTANCE,
+  "The line pair distance cache cannot hold all distances."
+  );
+
+//
+// The line profiles store offsets and lengths in narrow types.
+//
+_Static_assert(
+  SC_MAX_FILE_SIZE <= UINT32_MAX && SC_MAX_LINE_LENGTH <= UINT16_MAX,
+  "The line profile types need to be adapted."
+  );
+
+///
+/// The alignment, in bytes, of the arrays of sc_line_profiles_t relative to
+/// the start of their allocation.
+///
+#define SC_LINE_PROFILES_ALIGNMENT  16U
+
+///
+/// Precomputed comparison profiles of all lines of a cleansed file. They are
+/// stored as parallel arrays indexed by line, so that the window search of
+/// ScLevenshteinSwap() only loads the fields it inspects. All arrays reside in
+/// one allocation starting at Hashes.
+///
+typedef struct {
+  ///
+  /// The number of profiled lines.
+  ///
+  size_t                     NumLines;
+  ///
+  /// The number of compiled Levenshtein bitmask entries of all lines.
+  ///
+  size_t                     NumPeqEntries;
+  ///
+  /// The hashes of the lines' contents.
+  ///
+  uint64_t                   *Hashes;
+  ///
+  /// The offsets, in characters, of the lines within the file buffer.
+  ///
+  uint32_t                   *Offsets;
+  ///
+  /// The indices of the lines' first compiled Levenshtein bitmask entries.
+  ///
+  uint32_t                   *PeqOffsets;
+  ///
+  /// The lengths, in characters, of the lines.
+  ///
+  uint16_t                   *Lengths;
+  ///
+  /// The numbers of compiled Levenshtein bitmask entries of the lines.
+  ///
+  uint16_t                   *NumLinePeqEntries;
+  ///
+  /// The character class histograms of the lines to bound distances.
+  ///
+  uint8_t                    (*Histograms)[SC_LEVENSHTEIN_HISTOGRAM_SIZE];
+  ///
+  /// The compiled Levenshtein bitmask entries referenced by PeqOffsets.
+  ///
+  sc_levenshtein_peq_entry_t *PeqEntries;
+} sc_line_profiles_t;
+
 typedef struct {
   ///
   /// The buffer holding the cleansed file's contents.
   ///
-  char                *Buffer;
+  char                             *Buffer;
   ///
   /// The length, in characters, of Buffer.
   ///
-  size_t              Length;
+  size_t                           Length;
+  ///
+  /// The size of the file mapping backing Buffer, or 0 if Buffer is allocated
+  /// by malloc.
+  ///
+  size_t                           MappingSize;
   ///
   /// The lines information for Buffer.
   ///
-  sc_str_lines_info_t *LinesInfo;
+  sc_str_lines_info_t              *LinesInfo;
+  ///
+  /// The comparison profiles of the lines in LinesInfo.
+  ///
+  sc_line_profiles_t               Profiles;
+  ///
+  /// Whether the file has been loaded from the cleansed file cache. If so,
+  /// Profiles reside within the mapping of Buffer.
+  ///
+  bool                             Cached;
+  ///
+  /// Whether all resources of the file have been moved to an arena by
+  /// ScMoveCleansedFileToArena(). If so, they are freed with the arena.
+  ///
+  bool                             InArena;
   ///
   /// This field is reserved for usage by the consumer.
   ///
-  unsigned int        Reserved;
+  unsigned int                     Reserved;
 } sc_cleanse_file_t;
 
 /*
-  Initialises the environment to allow the execution of ScLevenshteinSwap().
+  Calculates the Levenshtein distance from File1 to File2 on per-line basis.
+  It does not depend on any global state and may be called concurrently with
+  distinct scratch buffers.
+
+  Identical lines are detected by their hashes and not compared. If Cache is
+  not NULL, the distances of line pairs are memoised in and retrieved from it.
+
+  @param[in]     File1         The first file to compare.
+  @param[in]     File2         The second file compare.
+  @param[in]     NumLinesSwap  The radius to pick lines in file 2 from to
+                               compare to lines of file 1.
+  @param[in,out] PeqScratch    The bit-parallel scratch buffer. It must be at
+                               least SC_LEVENSHTEIN_PEQ_SIZE(MaxLineLength)
+                               elements for the longest line of both files.
+                               All elements must be 0 on input and are 0 on
+                               output.
+  @param[in,out] Cache         The line pair distance cache shared by all
+                               comparisons. It may be NULL.
+
+  @retval INFINITY  An error occured while comparing File1 and File2.
+  @retval other     The Levenshtein distance between File1 and File2.
 */
-void ScLevenshteinSwapInitialise(void);
+double ScLevenshteinSwap(
+  const sc_cleanse_file_t *File1,
+  const sc_cleanse_file_t *File2,
+  size_t                  NumLinesSwap,
+  uint64_t                *PeqScratch,
+  sc_line_cache_t         *Cache
+  );
 
 /*
-  Calculates the Levenshtein distance from File1 to File2 on per-line basis.
-  ScLevenshteinSwapInitialise() must be called before calling this one.
+  Calculates the Levenshtein distance from File1 to File2 on per-line basis
+  like ScLevenshteinSwap(), but matches every line of file 2 at most once and
+  preserves the order of the matched lines. The lines are aligned globally
+  within the band of the radius NumLinesSwap, and lines of the file with fewer
+  lines that are left unmatched count as completely different. The distance of
+  every line pair in the band is calculated at most once.
+  It does not depend on any global state and may be called concurrently with
+  distinct scratch buffers.
 
-  @param[in] File1         The first file to compare.
-  @param[in] File2         The second file compare.
-  @param[in] NumLinesSwap  The radius to pick lines in file 2 from to compare to
-                           lines of file 1.
+  @param[in]     File1         The first file to compare.
+  @param[in]     File2         The second file compare.
+  @param[in]     NumLinesSwap  The radius to pick lines in file 2 from to
+                               compare to lines of file 1.
+  @param[in,out] PeqScratch    The bit-parallel scratch buffer. It must be at
+                               least SC_LEVENSHTEIN_PEQ_SIZE(MaxLineLength)
+                               elements for the longest line of both files.
+                               All elements must be 0 on input and are 0 on
+                               output.
+  @param[in,out] Cache         The line pair distance cache shared by all
+                               comparisons. It may be NULL.
 
   @retval INFINITY  An error occured while comparing File1 and File2.
   @retval other     The Levenshtein distance between File1 and File2.
 */
-double ScLevenshteinSwap(
+double ScLevenshteinAlign(
   const sc_cleanse_file_t *File1,
   const sc_cleanse_file_t *File2,
-  size_t                  NumLinesSwap
+  size_t                  NumLinesSwap,
+  uint64_t                *PeqScratch,
+  sc_line_cache_t         *Cache
+  );
+
+/*
+  Calculates the MinHash sketch of the set of line hashes of File. The
+  similarity of two sketches estimates the share of lines both files have in
+  common.
+
+  @param[out] Sketch  The sketch of File.
+  @param[in]  File    The cleansed file to sketch.
+*/
+void ScSketchCleansedFile(
+  sc_min_hash_t           *Sketch,
+  const sc_cleanse_file_t *File
+  );
+
+/*
+  Compiles the cleansing configurations of all sc_cleanse_config_type_t
+  values. The result must be passed to all functions that cleanse files.
+
+  @param[out] Matchers  The compiled configurations, indexed by
+                        sc_cleanse_config_type_t.
+*/
+void ScCleanseMatchersInitialise(
+  sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
   );
 
 /*
@@ -97,17 +283,74 @@ double ScLevenshteinSwap(
                         If ScCleanseConfigTypeMax is passed, the type will be
                         automatically detected based on the file extension of
                         FileName.
+  @param[in]  Matchers  The compiled configurations initialised by
+                        ScCleanseMatchersInitialise().
 
   @returns  Whether the file has been read and cleansed successfully.
 */
 bool ScReadCleansedFile(
-  sc_cleanse_file_t        *File,
-  const char               *FileName,
-  sc_cleanse_config_type_t FileType
+  sc_cleanse_file_t          *File,
+  const char                 *FileName,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
+  );
+
+/*
+  Loads the file from path FileName without cleansing it. Together with
+  ScCleanseLoadedFile(), this is equivalent to ScReadCleansedFile().
+
+  @param[out] File         A pointer to return the file buffer into. On
+                           failure, File->Buffer is NULL.
+  @param[in]  FileName     The path of the file to load. It needs to be
+                           correctly terminated.
+  @param[in]  MaxFileSize  The maximum size, in bytes, of the file. It must be
+                           at most SC_MAX_FILE_SIZE.
+  @param[in]  Prefetch     Whether to start reading the file asynchronously,
+                           so that many files can be fetched concurrently
+                           before cleansing any of them.
+
+  @returns  Whether the file has been loaded successfully.
+*/
+bool ScLoadFile(
+  sc_cleanse_file_t *File,
+  const char        *FileName,
+  size_t            MaxFileSize,
+  bool              Prefetch
+  );
+
+/*
+  Cleanses a file loaded by ScLoadFile() by internal configuration for
+  FileType. On failure, the file buffer is freed.
+
+  If CacheDir is not NULL, the cleansed file and its line profiles are looked
+  up in the cache directory CacheDir by the file's contents and FileType. On
+  a hit, the cache entry is mapped instead of cleansing the file. On a miss,
+  the file is cleansed and a new cache entry is stored on a best-effort basis.
+
+  @param[in,out] File      The loaded file to cleanse.
+  @param[in]     FileName  The path the file has been loaded from.
+  @param[in]     FileType  The cleansing type of the file.
+                           If ScCleanseConfigTypeMax is passed, the type will
+                           be automatically detected based on the file
+                           extension of FileName.
+  @param[in]     Matchers  The compiled configurations initialised by
+                           ScCleanseMatchersInitialise().
+  @param[in]     CacheDir  The path of an existing cache directory. It may be
+                           NULL to not use a cache.
+
+  @returns  Whether the file has been cleansed successfully.
+*/
+bool ScCleanseLoadedFile(
+  sc_cleanse_file_t          *File,
+  const char                 *FileName,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1],
+  const char                 *CacheDir
   );
 
 /*
   Initialise File based on File->Buffer, File->Length and FileType.
+  This includes the precomputation of the comparison profile of every line.
   Ownership of the resources is temporarily transfered to thos function.
   On failure, File->Buffer is freed.
 
@@ -115,12 +358,33 @@ bool ScReadCleansedFile(
                            length.
                            On output, File is a valid cleansed file instance.
   @param[in]     FileType  The cleansing type of the file.
+  @param[in]     Matchers  The compiled configurations initialised by
+                           ScCleanseMatchersInitialise().
 
   @returns  Whether the file has been cleansed successfully.
 */
 bool ScInitialiseCleanseFile(
-  sc_cleanse_file_t        *File,
-  sc_cleanse_config_type_t FileType
+  sc_cleanse_file_t          *File,
+  sc_cleanse_config_type_t   FileType,
+  const sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1]
+  );
+
+/*
+  Moves the cleansed buffer, the lines information and the line profiles of
+  File to Arena and frees their previous storage. This stores many files
+  contiguously, trims the buffer to its cleansed length and allows to free
+  all of them at once. On failure, File is left unchanged.
+
+  @param[in,out] File   The cleansed file to move. It must have been
+                        successfully constructed by ScInitialiseCleanseFile()
+                        or ScCleanseLoadedFile().
+  @param[in,out] Arena  The arena to move File to.
+
+  @returns  Whether File has been moved successfully.
+*/
+bool ScMoveCleansedFileToArena(
+  sc_cleanse_file_t *File,
+  sc_arena_t        *Arena
   );
 
 /*
@@ -133,6 +397,4 @@ void ScFreeCleansedFile(
   sc_cleanse_file_t *File
   );
 
-extern size_t mScLevenshteinMatrixInit[SC_MAX_LINE_LENGTH];
-
 #endif // SC_COMMON_H_
@@ -0,0 +1,472 @@
+/*@file
+  Implements the library APIs to compare code inputs within a long-lived
+  context.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include <ScArena.h>
+#include <ScCleanseConfigs.h>
+#include <ScCleanseInput.h>
+#include <ScLineCache.h>
+#include <ScSafeInt.h>
+#include <ScSimilarityChecker.h>
+
+#include "ScCommon.h"
+
+///
+/// The initial number of files a context can hold without reallocation.
+///
+#define SC_CONTEXT_INITIAL_NUM_FILES  64U
+
+struct sc_context_ {
+  ///
+  /// The compiled cleansing configurations for every sc_cleanse_config_type_t.
+  ///
+  sc_cleanse_matcher_t Matchers[ScCleanseConfigTypeMax + 1];
+  ///
+  /// The line pair distance cache shared by all comparisons.
+  ///
+  sc_line_cache_t      *LineCache;
+  ///
+  /// The arena holding the cleansed files.
+  ///
+  sc_arena_t           Arena;
+  ///
+  /// The cleansed files added to the context.
+  ///
+  sc_cleanse_file_t    *Files;
+  ///
+  /// The number of elements in Files.
+  ///
+  unsigned int         NumFiles;
+  ///
+  /// The number of elements Files has been allocated for.
+  ///
+  unsigned int         MaxNumFiles;
+  ///
+  /// The number of threads to compare batches with.
+  ///
+  unsigned int         NumThreads;
+  ///
+  /// The radius to pick lines in file 2 from to compare to lines of file 1.
+  ///
+  size_t               NumLinesSwap;
+  ///
+  /// Whether every line of file 2 is matched at most once and in order.
+  ///
+  bool                 AlignLines;
+  ///
+  /// The maximum size, in characters, of the file contents to add.
+  ///
+  size_t               MaxFileSize;
+  ///
+  /// The maximum line length of the cleansed files to add.
+  ///
+  size_t               MaxLineLength;
+  ///
+  /// The length of the longest line of all files added, which sizes the
+  /// bit-parallel scratch buffers of batches.
+  ///
+  size_t               LongestLineLength;
+};
+
+sc_context_t *ScContextCreate(
+  unsigned int NumThreads
+  )
+{
+  sc_context_t *Context = malloc(sizeof(*Context));
+  if (Context == NULL) {
+    return NULL;
+  }
+
+  Context->LineCache = ScLineCacheCreate(SC_LINE_CACHE_SIZE_LOG2);
+  if (Context->LineCache == NULL) {
+    free(Context);
+    return NULL;
+  }
+
+  ScCleanseMatchersInitialise(Context->Matchers);
+  ScArenaInitialise(&Context->Arena);
+
+#ifdef _OPENMP
+  if (NumThreads == 0) {
+    NumThreads = (unsigned int) omp_get_max_threads();
+  }
+#else
+  NumThreads = 1;
+#endif
+
+  Context->Files             = NULL;
+  Context->NumFiles          = 0;
+  Context->MaxNumFiles       = 0;
+  Context->NumThreads        = NumThreads;
+  Context->NumLinesSwap      = SC_NUM_LINES_SWAP;
+  Context->AlignLines        = false;
+  Context->MaxFileSize       = SC_MAX_FILE_SIZE;
+  Context->MaxLineLength     = SC_MAX_LINE_LENGTH;
+  Context->LongestLineLength = 0;
+
+  return Context;
+}
+
+void ScContextDestroy(
+  sc_context_t *Context
+  )
+{
+  if (Context == NULL) {
+    return;
+  }
+
+  for (
+    unsigned int FileIndex = 0;
+    FileIndex < Context->NumFiles;
+    ++FileIndex
+    ) {
+    ScFreeCleansedFile(&Context->Files[FileIndex]);
+  }
+
+  ScArenaFree(&Context->Arena);
+  free(Context->Files);
+  free(Context->LineCache);
+  free(Context);
+}
+
+void ScContextSetWindow(
+  sc_context_t *Context,
+  size_t       NumLinesSwap
+  )
+{
+  assert(Context != NULL);
+
+  Context->NumLinesSwap = NumLinesSwap;
+}
+
+void ScContextSetAlignment(
+  sc_context_t *Context,
+  bool         AlignLines
+  )
+{
+  assert(Context != NULL);
+
+  Context->AlignLines = AlignLines;
+}
+
+bool ScContextSetFileLimits(
+  sc_context_t *Context,
+  size_t       MaxFileSize,
+  size_t       MaxLineLength
+  )
+{
+  assert(Context != NULL);
+
+  if (MaxFileSize > SC_MAX_FILE_SIZE || MaxLineLength > SC_MAX_LINE_LENGTH) {
+    return false;
+  }
+
+  Context->MaxFileSize   = MaxFileSize;
+  Context->MaxLineLength = MaxLineLength;
+  return true;
+}
+
+/*
+  Reserves the storage for one more file in Context.
+
+  @param[in,out] Context  The context to grow.
+
+  @returns  Whether the storage has been reserved successfully.
+*/
+static bool ScContextReserveFile(
+  sc_context_t *Context
+  )
+{
+  assert(Context != NULL);
+  assert(Context->NumFiles <= Context->MaxNumFiles);
+
+  if (Context->NumFiles < Context->MaxNumFiles) {
+    return true;
+  }
+  //
+  // Grow geometrically to amortise the reallocations.
+  //
+  unsigned int MaxNumFiles = SC_CONTEXT_INITIAL_NUM_FILES;
+  if (Context->MaxNumFiles > 0) {
+    if (Context->MaxNumFiles > UINT_MAX / 2U) {
+      return false;
+    }
+
+    MaxNumFiles = Context->MaxNumFiles * 2U;
+  }
+
+  size_t     Size;
+  const bool Overflow = ScSafeMulSize(
+                          MaxNumFiles,
+                          sizeof(*Context->Files),
+                          &Size
+                          );
+  if (Overflow) {
+    return false;
+  }
+
+  sc_cleanse_file_t *Files = realloc(Context->Files, Size);
+  if (Files == NULL) {
+    return false;
+  }
+
+  Context->Files       = Files;
+  Context->MaxNumFiles = MaxNumFiles;
+  return true;
+}
+
+/*
+  Adds the cleansed file at the end of the file list of Context to it, if it
+  satisfies the line length limit.
+
+  @param[in,out] Context    The context to add the file to.
+  @param[out]    FileIndex  On success, the index of the file within Context.
+
+  @returns  Whether the file has been added successfully. Otherwise, the file
+            has been freed.
+*/
+static bool ScContextCommitFile(
+  sc_context_t *Context,
+  unsigned int *FileIndex
+  )
+{
+  assert(Context != NULL);
+  assert(Context->NumFiles < Context->MaxNumFiles);
+  assert(FileIndex != NULL);
+
+  sc_cleanse_file_t *File = &Context->Files[Context->NumFiles];
+  if (File->LinesInfo->MaxLineLength > Context->MaxLineLength) {
+    ScFreeCleansedFile(File);
+    return false;
+  }
+  //
+  // If the file cannot be moved, it keeps its own allocations.
+  //
+  ScMoveCleansedFileToArena(File, &Context->Arena);
+
+  Context->LongestLineLength = SC_MAX(
+                                 Context->LongestLineLength,
+                                 File->LinesInfo->MaxLineLength
+                                 );
+
+  File->Reserved = Context->NumFiles;
+  *FileIndex     = Context->NumFiles;
+  ++Context->NumFiles;
+  return true;
+}
+
+bool ScContextAddFile(
+  sc_context_t             *Context,
+  const char               *FileName,
+  sc_cleanse_config_type_t FileType,
+  unsigned int             *FileIndex
+  )
+{
+  assert(Context != NULL);
+  assert(FileName != NULL);
+  assert(FileType >= ScCleanseConfigTypeMin
+      && FileType <= ScCleanseConfigTypeMax);
+  assert(FileIndex != NULL);
+
+  bool Result = ScContextReserveFile(Context);
+  if (!Result) {
+    return false;
+  }
+
+  sc_cleanse_file_t *File = &Context->Files[Context->NumFiles];
+  Result = ScLoadFile(File, FileName, Context->MaxFileSize, false);
+  if (!Result) {
+    return false;
+  }
+
+  Result = ScCleanseLoadedFile(
+    File,
+    FileName,
+    FileType,
+    Context->Matchers,
+    NULL
+    );
+  if (!Result) {
+    return false;
+  }
+
+  return ScContextCommitFile(Context, FileIndex);
+}
+
+bool ScContextAddBuffer(
+  sc_context_t             *Context,
+  const char               *Buffer,
+  size_t                   Length,
+  sc_cleanse_config_type_t FileType,
+  unsigned int             *FileIndex
+  )
+{
+  assert(Context != NULL);
+  assert(Buffer != NULL || Length == 0);
+  assert(FileType >= ScCleanseConfigTypeMin
+      && FileType <= ScCleanseConfigTypeMax);
+  assert(FileIndex != NULL);
+  //
+  // ScInitialiseCleanseFile() requires a non-empty buffer.
+  //
+  if (Length == 0 || Length > Context->MaxFileSize) {
+    return false;
+  }
+
+  bool Result = ScContextReserveFile(Context);
+  if (!Result) {
+    return false;
+  }
+  //
+  // Cleansing is performed in-place, hence work on a copy the context owns.
+  //
+  sc_cleanse_file_t *File = &Context->Files[Context->NumFiles];
+  File->Buffer      = malloc(Length);
+  File->Length      = Length;
+  File->MappingSize = 0;
+  if (File->Buffer == NULL) {
+    return false;
+  }
+
+  memcpy(File->Buffer, Buffer, Length);
+
+  Result = ScInitialiseCleanseFile(File, FileType, Context->Matchers);
+  if (!Result) {
+    free(File->Buffer);
+    return false;
+  }
+
+  return ScContextCommitFile(Context, FileIndex);
+}
+
+/*
+  Rates the similarity of the files with indices File1Index and File2Index
+  like ScContextComparePair() with the scratch buffer of the caller.
+
+  @param[in]     Context     The context holding the files.
+  @param[in]     File1Index  The index of the first file within Context.
+  @param[in]     File2Index  The index of the second file within Context.
+  @param[in,out] PeqScratch  The zeroed bit-parallel scratch buffer for the
+                             longest line of both files.
+
+  @retval INFINITY  An error occured while comparing the files.
+  @retval other     The similarity of the files.
+*/
+static double ScContextCompareWithScratch(
+  const sc_context_t *Context,
+  unsigned int       File1Index,
+  unsigned int       File2Index,
+  uint64_t           *PeqScratch
+  )
+{
+  assert(Context != NULL);
+  assert(File1Index < Context->NumFiles);
+  assert(File2Index < Context->NumFiles);
+
+  if (Context->AlignLines) {
+    return ScLevenshteinAlign(
+      &Context->Files[File1Index],
+      &Context->Files[File2Index],
+      Context->NumLinesSwap,
+      PeqScratch,
+      Context->LineCache
+      );
+  }
+
+  return ScLevenshteinSwap(
+    &Context->Files[File1Index],
+    &Context->Files[File2Index],
+    Context->NumLinesSwap,
+    PeqScratch,
+    Context->LineCache
+    );
+}
+
+double ScContextComparePair(
+  const sc_context_t *Context,
+  unsigned int       File1Index,
+  unsigned int       File2Index
+  )
+{
+  assert(Context != NULL);
+  assert(File1Index < Context->NumFiles);
+  assert(File2Index < Context->NumFiles);
+  //
+  // The scratch buffer only needs to fit the longest line of both files.
+  //
+  const sc_cleanse_file_t *File1        = &Context->Files[File1Index];
+  const sc_cleanse_file_t *File2        = &Context->Files[File2Index];
+  const size_t            MaxLineLength = SC_MAX(
+                                            File1->LinesInfo->MaxLineLength,
+                                            File2->LinesInfo->MaxLineLength
+                                            );
+  uint64_t *PeqScratch = calloc(
+                           SC_MAX(SC_LEVENSHTEIN_PEQ_SIZE(MaxLineLength), 1U),
+                           sizeof(*PeqScratch)
+                           );
+  if (PeqScratch == NULL) {
+    return (double) INFINITY;
+  }
+
+  const double Score = ScContextCompareWithScratch(
+                         Context,
+                         File1Index,
+                         File2Index,
+                         PeqScratch
+                         );
+  free(PeqScratch);
+  return Score;
+}
+
+void ScContextCompareBatch(
+  const sc_context_t   *Context,
+  sc_context_pairing_t *Pairings,
+  size_t               NumPairings
+  )
+{
+  assert(Context != NULL);
+  assert(Pairings != NULL || NumPairings == 0);
+  //
+  // Every thread reuses its scratch buffer for all of its pairings.
+  //
+  const size_t PeqSize = SC_LEVENSHTEIN_PEQ_SIZE(Context->LongestLineLength);
+  #pragma omp parallel num_threads(Context->NumThreads)
+  {
+    uint64_t *PeqScratch = calloc(SC_MAX(PeqSize, 1U), sizeof(*PeqScratch));
+    //
+    // The costs of the pairings vary heavily, hence distribute them
+    // dynamically.
+    //
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t PairingIndex = 0; PairingIndex < NumPairings; ++PairingIndex) {
+      sc_context_pairing_t *Pairing = &Pairings[PairingIndex];
+      Pairing->Score = (double) INFINITY;
+      if (PeqScratch != NULL) {
+        Pairing->Score = ScContextCompareWithScratch(
+                           Context,
+                           Pairing->File1Index,
+                           Pairing->File2Index,
+                           PeqScratch
+                           );
+      }
+    }
+
+    free(PeqScratch);
+  }
+}
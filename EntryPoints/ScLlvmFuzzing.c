@@ -12,15 +12,27 @@
 
 #include <ScCleanseConfigs.h>
 #include <ScCleanseInput.h>
+#include <ScLineCache.h>
 
 #include "ScCommon.h"
 
+///
+/// The compiled cleansing configurations for every sc_cleanse_config_type_t.
+///
+static sc_cleanse_matcher_t mScCleanseMatchers[ScCleanseConfigTypeMax + 1];
+
+///
+/// The bit-parallel scratch buffer required for ScLevenshteinSwap().
+///
+static uint64_t mScPeqScratch[SC_LEVENSHTEIN_PEQ_SIZE(SC_MAX_LINE_LENGTH)];
+
 static void FuzzCleanseAndLevenshteinSwap(
   uint8_t                  *Data1,
   size_t                   Data1Size,
   uint8_t                  *Data2,
   size_t                   Data2Size,
-  sc_cleanse_config_type_t FileType
+  sc_cleanse_config_type_t FileType,
+  sc_line_cache_t          *LineCache
   )
 {
   assert(Data1 != NULL || Data1Size == 0);
@@ -35,11 +47,29 @@ static void FuzzCleanseAndLevenshteinSwap(
   //
   // Test cleansing on both logical files.
   //
-  sc_cleanse_file_t File1 = { (char *) Data1, Data1Size, NULL, 0 };
-  sc_cleanse_file_t File2 = { (char *) Data2, Data2Size, NULL, 0 };
+  sc_cleanse_file_t File1 = {
+    (char *) Data1,
+    Data1Size,
+    0,
+    NULL,
+    { 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL },
+    false,
+    false,
+    0
+    };
+  sc_cleanse_file_t File2 = {
+    (char *) Data2,
+    Data2Size,
+    0,
+    NULL,
+    { 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL },
+    false,
+    false,
+    0
+    };
 
-  bool Result1 = ScInitialiseCleanseFile(&File1, FileType);
-  bool Result2 = ScInitialiseCleanseFile(&File2, FileType);
+  bool Result1 = ScInitialiseCleanseFile(&File1, FileType, mScCleanseMatchers);
+  bool Result2 = ScInitialiseCleanseFile(&File2, FileType, mScCleanseMatchers);
   if (Result1 && Result2) {
     //
     // Test ScLevenshteinSwap() with maximum line swap radius on both logical
@@ -49,17 +79,21 @@ static void FuzzCleanseAndLevenshteinSwap(
     ScLevenshteinSwap(
       &File1,
       &File2,
-      Data2Size + (Data2Size < SIZE_MAX ? 1 : 0)
+      Data2Size + (Data2Size < SIZE_MAX ? 1 : 0),
+      mScPeqScratch,
+      LineCache
       );
   }
   //
   // Free all allocated resources.
   //
   if (Result1) {
+    free(File1.Profiles.Hashes);
     free(File1.LinesInfo);
   }
   
   if (Result2) {
+    free(File2.Profiles.Hashes);
     free(File2.LinesInfo);
   }
 }
@@ -86,7 +120,15 @@ int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
   uint8_t      *Data2    = &DataCopy[Data1Size];
   const size_t Data2Size = Size - Data1Size;
 
-  ScLevenshteinSwapInitialise();
+  ScCleanseMatchersInitialise(mScCleanseMatchers);
+  //
+  // Use a small line pair distance cache to exercise evictions.
+  //
+  sc_line_cache_t *LineCache = ScLineCacheCreate(8);
+  if (LineCache == NULL) {
+    free(DataCopy);
+    return 0;
+  }
   //
   // Test cleansing and distances against all configurations.
   //
@@ -107,12 +149,14 @@ int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
       Data1Size,
       Data2,
       Data2Size,
-      ConfigIndex
+      ConfigIndex,
+      LineCache
       );
   }
   //
   // Free all allocated resources.
   //
+  free(LineCache);
   free(DataCopy);
   return 0;
 }
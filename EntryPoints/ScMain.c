@@ -6,33 +6,196 @@
 */
 
 #include <assert.h>
-#include <limits.h>
-#include <math.h>
 #include <stdbool.h>
-#include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "ScCommon.h"
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h>
+#endif
+
+#include <ScFileIo.h>
+#include <ScOutput.h>
+#include <ScSafeInt.h>
+#include <ScShard.h>
+
+#include "ScMainOptions.h"
+#include "ScRating.h"
+
+///
+/// The size, in bytes, of the stdout buffer for the binary output formats.
+///
+#define SC_OUTPUT_BUFFER_SIZE  (1U * 1024U * 1024U)
 
 /*
-  Calculates the Gauss Sum of x.
+  Collects the input file paths from the command line arguments and the file
+  list of Options.
+
+  @param[in]  Options      The command line options of this tool.
+  @param[in]  NumArgFiles  The number of elements in ArgFiles.
+  @param[in]  ArgFiles     The input file paths from argv.
+  @param[out] FileList     On success, the contents of the file list the
+                           returned paths point into, or NULL. It is
+                           allocated with malloc and caller-owned.
+  @param[out] NumFiles     On success, the number of returned paths.
+
+  @retval NULL   An error has occured.
+  @retval other  The input file paths, those of ArgFiles first. They are
+                 allocated with malloc and caller-owned.
 */
-#define SC_GAUSS_SUM(x)  (((x) * ((x) + 1U)) / 2U)
-
-//
-// Define SC_MAX_NUM_FILES such that no memory size overflows can occur.
-//
-#if SIZE_MAX == UINT16_MAX
-  #define SC_MAX_NUM_FILES  INT8_MAX
-#elif SIZE_MAX == UINT32_MAX
-  #define SC_MAX_NUM_FILES  INT16_MAX
-#elif SIZE_MAX == UINT64_MAX
-  #define SC_MAX_NUM_FILES  INT32_MAX
-#else
-  #error The definition needs to be adapted.
-#endif
+static char **ScGetInputFiles(
+  const sc_main_options_t *Options,
+  size_t                  NumArgFiles,
+  char *const             *ArgFiles,
+  char                    **FileList,
+  size_t                  *NumFiles
+  )
+{
+  assert(Options != NULL);
+  assert(ArgFiles != NULL || NumArgFiles == 0);
+  assert(FileList != NULL);
+  assert(NumFiles != NULL);
+
+  char   *List       = NULL;
+  char   **ListPaths = NULL;
+  size_t NumListed   = 0;
+  if (Options->FileListPath != NULL) {
+    FILE *ListHandle = stdin;
+    if (strcmp(Options->FileListPath, "-") != 0) {
+      ListHandle = fopen(Options->FileListPath, "rb");
+      if (ListHandle == NULL) {
+        return NULL;
+      }
+    }
+
+    List = ScReadFileList(
+             &ListPaths,
+             &NumListed,
+             ListHandle,
+             Options->FileListNul
+             );
+    if (ListHandle != stdin) {
+      fclose(ListHandle);
+    }
+
+    if (List == NULL) {
+      return NULL;
+    }
+  }
+
+  char   **Files = NULL;
+  size_t NumPaths;
+  size_t Size;
+  if (!ScSafeAddSize(NumArgFiles, NumListed, &NumPaths)
+   && !ScSafeMulSize(NumPaths, sizeof(*Files), &Size)) {
+    Files = malloc(SC_MAX(Size, 1U));
+  }
+
+  if (Files == NULL) {
+    free(ListPaths);
+    free(List);
+    return NULL;
+  }
+
+  memcpy(Files, ArgFiles, NumArgFiles * sizeof(*Files));
+  if (ListPaths != NULL) {
+    memcpy(&Files[NumArgFiles], ListPaths, NumListed * sizeof(*Files));
+  }
+  free(ListPaths);
+
+  *FileList = List;
+  *NumFiles = NumPaths;
+  return Files;
+}
+
+/*
+  Merges the text or record outputs of all shards into the regular output.
+
+  @param[in] Options    The command line options of this tool.
+  @param[in] FileNames  The paths of the shard outputs.
+  @param[in] NumFiles   The number of elements in FileNames.
+
+  @returns  Whether the outputs have been merged successfully.
+*/
+static bool ScMergeShardOutputs(
+  const sc_main_options_t *Options,
+  char *const             *FileNames,
+  size_t                  NumFiles
+  )
+{
+  assert(Options != NULL);
+  assert(FileNames != NULL || NumFiles == 0);
+
+  FILE **Handles = calloc(SC_MAX(NumFiles, 1U), sizeof(*Handles));
+  if (Handles == NULL) {
+    fprintf(stderr, "Allocation error\n");
+    return false;
+  }
+
+  bool Result = true;
+  for (size_t Index = 0; Index < NumFiles; ++Index) {
+    Handles[Index] = fopen(FileNames[Index], "rb");
+    if (Handles[Index] == NULL) {
+      fprintf(stderr, "Shard output read error: %s\n", FileNames[Index]);
+      Result = false;
+      break;
+    }
+  }
+
+  if (Result) {
+    size_t                  FailedIndex = 0;
+    const sc_shard_status_t Status      = ScShardMergeOutputs(
+                                            stdout,
+                                            Options->OutputFormat,
+                                            Options->TopMatches,
+                                            Handles,
+                                            NumFiles,
+                                            &FailedIndex
+                                            );
+    switch (Status) {
+      case ScShardStatusSuccess:
+        break;
+
+      case ScShardStatusAllocationError:
+        fprintf(stderr, "Allocation error\n");
+        break;
+
+      case ScShardStatusReadError:
+        fprintf(
+          stderr,
+          "Shard output read error: %s\n",
+          FileNames[FailedIndex]
+          );
+        break;
+
+      case ScShardStatusUnordered:
+        fprintf(
+          stderr,
+          "Shard output is not ordered: %s\n",
+          FileNames[FailedIndex]
+          );
+        break;
+
+      case ScShardStatusOutputError:
+        fprintf(stderr, "Output error\n");
+        break;
+    }
+
+    Result = Status == ScShardStatusSuccess;
+  }
+
+  for (size_t Index = 0; Index < NumFiles; ++Index) {
+    if (Handles[Index] != NULL) {
+      fclose(Handles[Index]);
+    }
+  }
+
+  free(Handles);
+  return Result;
+}
 
 /*
   Main entry point to the SimilarityChecker project. A list of similarity scores
@@ -50,210 +213,76 @@ int main(int argc, char *argv[]) {
   //
   assert(argc >= 1);
 
-  if (argc < 3) {
-    fprintf(stderr, "%s [input file 1] ... [input file n]\n", argv[0]);
-    return 0;
+  sc_main_options_t Options;
+  int               FirstFile;
+  bool              OptionsResult = ScParseOptions(
+                                      argc,
+                                      argv,
+                                      &Options,
+                                      &FirstFile
+                                      );
+  if (!OptionsResult) {
+    ScPrintUsage(argv[0]);
+    return -1;
   }
   //
-  // Allocate, read and cleanse one file per argument.
-  //
-  unsigned int NumFiles   = (unsigned int) argc - 1U;
-  char         **FileArgs = &argv[1];
-  //
-  // Limit the amount of input files to prevent memory overflows.
+  // Binary output is written in large blocks. It is not meant to be read
+  // interactively.
   //
-  if (argc - 1 > SC_MAX_NUM_FILES) {
-    fprintf(
-      stderr,
-      "Truncated input files to %llu.\n",
-      (unsigned long long) SC_MAX_NUM_FILES
-      );
-    NumFiles = SC_MAX_NUM_FILES;
+  if (Options.OutputFormat != ScOutputFormatText) {
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    setvbuf(stdout, NULL, _IOFBF, SC_OUTPUT_BUFFER_SIZE);
   }
-  //
-  // SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) is safe because multiplications
-  // in one power of two space with at most one value being one larger than its
-  // maximum value cannot overflow in any space of a higher power of two.
-  //
-  // This ensures
-  //   1) SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) cannot overflow in size_t.
-  //   2) sizeof(*Files) * NumFiles cannot overflow in size_t.
-  //
-  _Static_assert(
-    sizeof(sc_cleanse_file_t) <= UINT_MAX
-    && SC_MAX_NUM_FILES <= UINT32_MAX
-    && SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) <= SIZE_MAX / sizeof(double),
-    "The memory arithmetics below may overflow."
-    );
-
-  sc_cleanse_file_t *Files = malloc(sizeof(*Files) * NumFiles);
-  //
-  // Allocate the ratings result list. As NumFiles files must be
-  // cross-compared, its size is precisely the Gauss Sum of NumFiles.
-  //
-  double *Ratings = malloc(SC_GAUSS_SUM((size_t) NumFiles) * sizeof(double));
 
-  if (Files == NULL || Ratings == NULL) {
-    fprintf(stderr, "Allocation error\n");
-    free(Files);
-    free(Ratings);
-    return -1;
-  }
   //
-  // Read and cleanse all provided files.
+  // Append the paths of the file list to those of argv.
   //
-  bool FilesResult = true;
-  #pragma omp parallel for
-  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
-    //
-    // Always automatically detect the cleanse config for the moment.
-    //
-    bool Result = ScReadCleansedFile(
-      &Files[FileIndex],
-      FileArgs[FileIndex],
-      ScCleanseConfigTypeMax
-      );
-    //
-    // Use the Reserved field to store the associated file name index.
-    //
-    Files[FileIndex].Reserved = FileIndex;
-
-    if (!Result) {
-      #pragma omp critical
-      fprintf(stderr, "Cleansed read error: %s\n", FileArgs[FileIndex]);
-      //
-      // FilesResult is not read within the parallel block and hence this
-      // write does not need to be atomic.
-      //
-      FilesResult = false;
-      //
-      // Files[FileIndex].Buffer == NULL iff reading or cleansing failed.
-      //
-      Files[FileIndex].Buffer = NULL;
+  char   *FileList;
+  size_t NumInputFiles;
+  char   **FileArgs = ScGetInputFiles(
+                        &Options,
+                        (size_t) (argc - FirstFile),
+                        &argv[FirstFile],
+                        &FileList,
+                        &NumInputFiles
+                        );
+  if (FileArgs == NULL) {
+    if (Options.FileListPath != NULL) {
+      fprintf(stderr, "File list read error: %s\n", Options.FileListPath);
     } else {
-      assert(Files[FileIndex].Buffer != NULL);
+      fprintf(stderr, "Allocation error\n");
     }
-  }
-  //
-  // If an error occured for any file reading or cleansing, eliminate the
-  // invalid entries. This is done in a separate step from reading to not harm
-  // parallelisation. As this is clearly a user error condition, performance is
-  // allowed to drop in such case.
-  //
-  if (!FilesResult) {
-    for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
-      if (Files[FileIndex].Buffer == NULL) {
-        --NumFiles;
-        memmove(
-          &Files[FileIndex],
-          &Files[FileIndex + 1],
-          (NumFiles - FileIndex) * sizeof(*Files)
-          );
-        --FileIndex;
-      }
-    }
-  }
-
-  ScLevenshteinSwapInitialise();
-  //
-  // Cross-compare all files and store their ratings.
-  //
-  const unsigned int NumFilesMinus1      = NumFiles - 1;
-  const size_t       NumFilesMinus1Gauss = SC_GAUSS_SUM(NumFilesMinus1);
-
-  #pragma omp parallel for
-  for (unsigned int File1Index = 0; File1Index < NumFiles; ++File1Index) {
-    //
-    // Calculate loop invariants early to benefit parallelism.
-    // NumFiles - (File1Index + 1) files need to be processed starting from
-    // File1Index + 1.
-    //
-    const unsigned int FilesLeft = NumFilesMinus1 - File1Index;
-    //
-    // Each step needs NumFiles - (File1Index + 1) result spots.
-    // Calculate the Gauss Sum entirely to not harm parallelisation.
-    //
-    const size_t File1DistStart = NumFilesMinus1Gauss - SC_GAUSS_SUM(FilesLeft);
-
-    sc_cleanse_file_t *const Files2 = &Files[File1Index + 1]; 
-
-    #pragma omp parallel for
-    for (
-      unsigned int File2Index = 0;
-      File2Index < FilesLeft;
-      ++File2Index
-      ) {
-      double Score = ScLevenshteinSwap(
-        &Files[File1Index],
-        &Files2[File2Index],
-        SC_NUM_LINES_SWAP
-        );
-      //
-      // Check for greater-equals to silence compiler warnings as no float value
-      // can be bigger anyway.
-      //
-      if (Score >= (double) INFINITY) {
-        #pragma omp critical
-        fprintf(
-          stderr,
-          "Failed to compare files %s and %s\n",
-          FileArgs[Files[File1Index].Reserved],
-          FileArgs[Files2[File2Index].Reserved]
-          );
-      }
 
-      Ratings[File1DistStart + File2Index] = Score;
-    }
+    return -1;
   }
-  //
-  // Print the results separately from the distance loop to not harm
-  // parallelisation.
-  //
-  size_t DistIndex = 0;
-  for (unsigned int File1Index = 0; File1Index < NumFiles; ++File1Index) {
-    //
-    // These constants are used in the assert below. They are declared in the
-    // same exact way as in the loop above to illustrate its correctness.
-    //
-    const unsigned int FilesLeft = NumFilesMinus1 - File1Index;
-    const size_t File1DistStart = NumFilesMinus1Gauss - SC_GAUSS_SUM(FilesLeft);
-    //
-    // Silence the compiler for when asserts are disabled.
-    //
-    (void) File1DistStart;
-    for (
-      unsigned int File2Index = File1Index + 1;
-      File2Index < NumFiles;
-      ++File2Index
-      ) {
-      //
-      // This implicitly sanitises the correctness of above's loop and ensures
-      // both stay in-sync in terms of data.
-      //
-      assert(DistIndex == File1DistStart + (File2Index - (File1Index + 1)));
-      //
-      // The Reserved field is used to store the associated file name index.
-      //
-      fprintf(
-        stdout,
-        "%u %u %f\n",
-        Files[File1Index].Reserved,
-        Files[File2Index].Reserved,
-        Ratings[DistIndex]
-        );
-      ++DistIndex;
-    }
+
+  if (Options.Merge && NumInputFiles > 0) {
+    const bool MergeResult = ScMergeShardOutputs(
+                               &Options,
+                               FileArgs,
+                               NumInputFiles
+                               );
+    free(FileArgs);
+    free(FileList);
+    return MergeResult ? 0 : -1;
   }
-  //
-  // Free all allocated files and information structures.
-  //
-  #pragma omp parallel for
-  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
-    ScFreeCleansedFile(&Files[FileIndex]);
+
+  if (NumInputFiles < 2) {
+    ScPrintUsage(argv[0]);
+    free(FileArgs);
+    free(FileList);
+    return 0;
   }
 
-  free(Ratings);
-  free(Files);
+  const bool RatingsResult = ScRateInputFiles(
+                               &Options,
+                               FileArgs,
+                               NumInputFiles
+                               );
+  free(FileArgs);
+  free(FileList);
 
-  return 0;
+  return RatingsResult ? 0 : -1;
 }
@@ -0,0 +1,607 @@
+/*@file
+  Implements the command line options of the similarity checker tool.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ScOutput.h>
+
+#include "ScCommon.h"
+#include "ScMainOptions.h"
+
+///
+/// The maximum number of matches to keep per file in top-K mode.
+///
+#define SC_MAX_TOP_MATCHES  1024U
+
+///
+/// The maximum memory budget, in MiB.
+///
+#define SC_MAX_MEMORY_BUDGET  (1024U * 1024U)
+
+///
+/// The maximum number of shards.
+///
+#define SC_MAX_NUM_SHARDS  1024U
+
+_Static_assert(
+  SC_MAX_FILE_SIZE <= UINT_MAX && SC_NUM_LINES_SWAP <= SC_MAX_FILE_SIZE,
+  "The limit options cannot hold their defaults."
+  );
+
+void ScPrintUsage(
+  const char *ToolName
+  )
+{
+  assert(ToolName != NULL);
+
+  fprintf(
+    stderr,
+    "%s [options] [input file 1] ... [input file n]\n"
+    "  --prefilter <cutoff>  Only rate file pairings with an estimated\n"
+    "                        similarity of at least cutoff (0 to 1).\n"
+    "  --omit-pruned         Do not output pairings pruned by the pre-filter.\n"
+    "  --threshold <score>   Only output pairings with a score of at least\n"
+    "                        score (0 to 1), as soon as they are rated.\n"
+    "  --top <k>             Only output the k best matches of every file, as\n"
+    "                        soon as all of its pairings are rated.\n"
+    "  --batch-io            Start reading all input files before cleansing\n"
+    "                        any, e.g. for network storage.\n"
+    "  --cache <directory>   Reuse cleansed files of previous runs from the\n"
+    "                        existing directory and store new ones in it.\n"
+    "  --queries <n>         Only rate pairings that involve any of the first\n"
+    "                        n input files, e.g. new files against a corpus.\n"
+    "  --window <n>          Compare every line to the lines up to n lines\n"
+    "                        before and after it (default %u).\n"
+    "  --max-line-length <n> Reject files with cleansed lines longer than n\n"
+    "                        characters (default and maximum %u).\n"
+    "  --max-file-size <n>   Reject input files larger than n bytes (default\n"
+    "                        and maximum %u).\n"
+    "  --rescore <fraction>  Rate all pairings with the coarse window first\n"
+    "                        and rate the best fraction (0 to 1) of them\n"
+    "                        again with the regular window. Only those are\n"
+    "                        output.\n"
+    "  --coarse-window <n>   The window of the coarse rating (default 0).\n"
+    "  --files-from <file>   Read further input file paths from file, one per\n"
+    "                        line. - denotes stdin.\n"
+    "  --null                Separate the paths of --files-from by NUL\n"
+    "                        characters instead of new lines.\n"
+    "  --memory-budget <n>   Load the files in blocks of at most about n MiB\n"
+    "                        in total while rating and output the pairings\n"
+    "                        as soon as they are rated.\n"
+    "  --output <format>     Output the ratings as text (default), as binary\n"
+    "                        records, or as a binary matrix.\n"
+    "  --shard <i>/<n>       Only rate the pairings of shard i (0 to n - 1)\n"
+    "                        of n cost-balanced shards, e.g. on many nodes.\n"
+    "  --merge               Merge the text or record outputs of all shards,\n"
+    "                        given as input files, into the regular output.\n"
+    "  --engine <engine>     Rate the pairings by their line-based distance\n"
+    "                        (levenshtein, default) or by their shared\n"
+    "                        winnowing fingerprints (winnow).\n"
+    "  --align               Match every line of a file at most once and in\n"
+    "                        order within the window.\n"
+    "  --                    Treat all subsequent arguments as input files.\n",
+    ToolName,
+    SC_NUM_LINES_SWAP,
+    SC_MAX_LINE_LENGTH,
+    SC_MAX_FILE_SIZE
+    );
+#if SC_INSTRUMENTATION
+  fprintf(
+    stderr,
+    "  --report <file>       Write the instrumentation report to file instead\n"
+    "                        of stderr.\n"
+    );
+#endif
+#if SC_OFFLOAD
+  fprintf(
+    stderr,
+    "                        offload rates the line-based distance on the\n"
+    "                        OpenMP offload device.\n"
+    );
+#endif
+}
+
+/*
+  Parses the value of the option at argv[*ArgIndex] as a fraction between 0
+  and 1.
+
+  @param[in]     argc      The number of elements in argv.
+  @param[in]     argv      The arguments given to this tool.
+  @param[in,out] ArgIndex  On input, the index of the option.
+                           On output, the index of its value.
+  @param[out]    Value     On success, the parsed value.
+
+  @returns  Whether the value has been parsed successfully.
+*/
+static bool ScParseFractionValue(
+  int    argc,
+  char   *argv[],
+  int    *ArgIndex,
+  double *Value
+  )
+{
+  assert(ArgIndex != NULL);
+  assert(*ArgIndex < argc);
+  assert(Value != NULL);
+
+  const char *Option = argv[*ArgIndex];
+  if (*ArgIndex + 1 >= argc) {
+    fprintf(stderr, "Missing value for option %s\n", Option);
+    return false;
+  }
+
+  ++(*ArgIndex);
+  const char   *Arg = argv[*ArgIndex];
+  char         *End;
+  const double Result = strtod(Arg, &End);
+  if (End == Arg || *End != '\0' || !(Result >= 0 && Result <= 1)) {
+    fprintf(stderr, "Invalid value for option %s: %s\n", Option, Arg);
+    return false;
+  }
+
+  *Value = Result;
+  return true;
+}
+
+/*
+  Retrieves the value of the option at argv[*ArgIndex] as a string.
+
+  @param[in]     argc      The number of elements in argv.
+  @param[in]     argv      The arguments given to this tool.
+  @param[in,out] ArgIndex  On input, the index of the option.
+                           On output, the index of its value.
+  @param[out]    Value     On success, the value.
+
+  @returns  Whether the value has been retrieved successfully.
+*/
+static bool ScParseStringValue(
+  int        argc,
+  char       *argv[],
+  int        *ArgIndex,
+  const char **Value
+  )
+{
+  assert(ArgIndex != NULL);
+  assert(*ArgIndex < argc);
+  assert(Value != NULL);
+
+  const char *Option = argv[*ArgIndex];
+  if (*ArgIndex + 1 >= argc) {
+    fprintf(stderr, "Missing value for option %s\n", Option);
+    return false;
+  }
+
+  ++(*ArgIndex);
+  *Value = argv[*ArgIndex];
+  return true;
+}
+
+/*
+  Parses the value of the option at argv[*ArgIndex] as a count.
+
+  @param[in]     argc      The number of elements in argv.
+  @param[in]     argv      The arguments given to this tool.
+  @param[in,out] ArgIndex  On input, the index of the option.
+                           On output, the index of its value.
+  @param[in]     MinValue  The minimum valid value.
+  @param[in]     MaxValue  The maximum valid value.
+  @param[out]    Value     On success, the parsed value.
+
+  @returns  Whether the value has been parsed successfully.
+*/
+static bool ScParseCountValue(
+  int          argc,
+  char         *argv[],
+  int          *ArgIndex,
+  unsigned int MinValue,
+  unsigned int MaxValue,
+  unsigned int *Value
+  )
+{
+  assert(ArgIndex != NULL);
+  assert(*ArgIndex < argc);
+  assert(Value != NULL);
+
+  const char *Option = argv[*ArgIndex];
+  if (*ArgIndex + 1 >= argc) {
+    fprintf(stderr, "Missing value for option %s\n", Option);
+    return false;
+  }
+
+  ++(*ArgIndex);
+  const char          *Arg = argv[*ArgIndex];
+  char                *End;
+  const unsigned long Result = strtoul(Arg, &End, 10);
+  if (End == Arg
+   || *End != '\0'
+   || Arg[0] == '-'
+   || Result < MinValue
+   || Result > MaxValue) {
+    fprintf(stderr, "Invalid value for option %s: %s\n", Option, Arg);
+    return false;
+  }
+
+  *Value = (unsigned int) Result;
+  return true;
+}
+
+/*
+  Parses the value of the option at argv[*ArgIndex] as a shard "i/n".
+
+  @param[in]     argc        The number of elements in argv.
+  @param[in]     argv        The arguments given to this tool.
+  @param[in,out] ArgIndex    On input, the index of the option.
+                             On output, the index of its value.
+  @param[out]    ShardIndex  On success, the parsed shard index i.
+  @param[out]    NumShards   On success, the parsed number of shards n.
+
+  @returns  Whether the value has been parsed successfully.
+*/
+static bool ScParseShardValue(
+  int          argc,
+  char         *argv[],
+  int          *ArgIndex,
+  unsigned int *ShardIndex,
+  unsigned int *NumShards
+  )
+{
+  assert(ArgIndex != NULL);
+  assert(*ArgIndex < argc);
+  assert(ShardIndex != NULL);
+  assert(NumShards != NULL);
+
+  const char *Option = argv[*ArgIndex];
+  if (*ArgIndex + 1 >= argc) {
+    fprintf(stderr, "Missing value for option %s\n", Option);
+    return false;
+  }
+
+  ++(*ArgIndex);
+  const char          *Arg   = argv[*ArgIndex];
+  char                *End;
+  const unsigned long Index  = strtoul(Arg, &End, 10);
+  unsigned long       Count  = 0;
+  bool                Result = End != Arg
+                            && *End == '/'
+                            && Arg[0] != '-'
+                            && End[1] != '-';
+  if (Result) {
+    const char *CountArg = End + 1;
+    Count  = strtoul(CountArg, &End, 10);
+    Result = End != CountArg
+          && *End == '\0'
+          && Count > 0
+          && Count <= SC_MAX_NUM_SHARDS
+          && Index < Count;
+  }
+
+  if (!Result) {
+    fprintf(stderr, "Invalid value for option %s: %s\n", Option, Arg);
+    return false;
+  }
+
+  *ShardIndex = (unsigned int) Index;
+  *NumShards  = (unsigned int) Count;
+  return true;
+}
+
+bool ScParseOptions(
+  int               argc,
+  char              *argv[],
+  sc_main_options_t *Options,
+  int               *FirstFile
+  )
+{
+  assert(argc >= 1);
+  assert(argv != NULL);
+  assert(Options != NULL);
+  assert(FirstFile != NULL);
+
+  Options->PrefilterCutoff    = -1.0;
+  Options->OmitPruned         = false;
+  Options->Threshold          = -1.0;
+  Options->TopMatches         = 0;
+  Options->BatchIo            = false;
+  Options->CacheDir           = NULL;
+  Options->NumQueries         = 0;
+  Options->NumLinesSwap       = SC_NUM_LINES_SWAP;
+  Options->MaxLineLength      = SC_MAX_LINE_LENGTH;
+  Options->MaxFileSize        = SC_MAX_FILE_SIZE;
+  Options->RescoreFraction    = -1.0;
+  Options->CoarseNumLinesSwap = 0;
+  Options->FileListPath       = NULL;
+  Options->FileListNul        = false;
+  Options->MemoryBudget       = 0;
+  Options->OutputFormat       = ScOutputFormatText;
+  Options->NumShards          = 0;
+  Options->ShardIndex         = 0;
+  Options->Merge              = false;
+  Options->Engine             = ScEngineLevenshtein;
+  Options->AlignLines         = false;
+#if SC_INSTRUMENTATION
+  Options->ReportPath         = NULL;
+#endif
+
+  int ArgIndex = 1;
+  for (; ArgIndex < argc; ++ArgIndex) {
+    const char *Arg = argv[ArgIndex];
+    if (strncmp(Arg, "--", 2) != 0) {
+      break;
+    }
+
+    if (strcmp(Arg, "--") == 0) {
+      ++ArgIndex;
+      break;
+    }
+
+    bool Result = true;
+    if (strcmp(Arg, "--prefilter") == 0) {
+      Result = ScParseFractionValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->PrefilterCutoff
+        );
+    } else if (strcmp(Arg, "--omit-pruned") == 0) {
+      Options->OmitPruned = true;
+    } else if (strcmp(Arg, "--threshold") == 0) {
+      Result = ScParseFractionValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->Threshold
+        );
+    } else if (strcmp(Arg, "--batch-io") == 0) {
+      Options->BatchIo = true;
+    } else if (strcmp(Arg, "--cache") == 0) {
+      Result = ScParseStringValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->CacheDir
+        );
+    } else if (strcmp(Arg, "--queries") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        1,
+        SC_MAX_NUM_FILES,
+        &Options->NumQueries
+        );
+    } else if (strcmp(Arg, "--top") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        1,
+        SC_MAX_TOP_MATCHES,
+        &Options->TopMatches
+        );
+    } else if (strcmp(Arg, "--window") == 0) {
+      //
+      // No file can have more lines than it has characters.
+      //
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        0,
+        SC_MAX_FILE_SIZE,
+        &Options->NumLinesSwap
+        );
+    } else if (strcmp(Arg, "--max-line-length") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        1,
+        SC_MAX_LINE_LENGTH,
+        &Options->MaxLineLength
+        );
+    } else if (strcmp(Arg, "--max-file-size") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        1,
+        SC_MAX_FILE_SIZE,
+        &Options->MaxFileSize
+        );
+    } else if (strcmp(Arg, "--rescore") == 0) {
+      Result = ScParseFractionValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->RescoreFraction
+        );
+    } else if (strcmp(Arg, "--coarse-window") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        0,
+        SC_MAX_FILE_SIZE,
+        &Options->CoarseNumLinesSwap
+        );
+    } else if (strcmp(Arg, "--files-from") == 0) {
+      Result = ScParseStringValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->FileListPath
+        );
+    } else if (strcmp(Arg, "--null") == 0) {
+      Options->FileListNul = true;
+    } else if (strcmp(Arg, "--memory-budget") == 0) {
+      Result = ScParseCountValue(
+        argc,
+        argv,
+        &ArgIndex,
+        1,
+        SC_MAX_MEMORY_BUDGET,
+        &Options->MemoryBudget
+        );
+    } else if (strcmp(Arg, "--output") == 0) {
+      const char *Format;
+      Result = ScParseStringValue(argc, argv, &ArgIndex, &Format);
+      if (Result && strcmp(Format, "text") == 0) {
+        Options->OutputFormat = ScOutputFormatText;
+      } else if (Result && strcmp(Format, "records") == 0) {
+        Options->OutputFormat = ScOutputFormatRecords;
+      } else if (Result && strcmp(Format, "matrix") == 0) {
+        Options->OutputFormat = ScOutputFormatMatrix;
+      } else if (Result) {
+        fprintf(stderr, "Invalid value for option %s: %s\n", Arg, Format);
+        Result = false;
+      }
+    } else if (strcmp(Arg, "--shard") == 0) {
+      Result = ScParseShardValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->ShardIndex,
+        &Options->NumShards
+        );
+    } else if (strcmp(Arg, "--merge") == 0) {
+      Options->Merge = true;
+    } else if (strcmp(Arg, "--align") == 0) {
+      Options->AlignLines = true;
+    } else if (strcmp(Arg, "--engine") == 0) {
+      const char *Engine;
+      Result = ScParseStringValue(argc, argv, &ArgIndex, &Engine);
+      if (Result && strcmp(Engine, "levenshtein") == 0) {
+        Options->Engine = ScEngineLevenshtein;
+      } else if (Result && strcmp(Engine, "winnow") == 0) {
+        Options->Engine = ScEngineWinnow;
+#if SC_OFFLOAD
+      } else if (Result && strcmp(Engine, "offload") == 0) {
+        Options->Engine = ScEngineOffload;
+#endif
+      } else if (Result) {
+        fprintf(stderr, "Invalid value for option %s: %s\n", Arg, Engine);
+        Result = false;
+      }
+#if SC_INSTRUMENTATION
+    } else if (strcmp(Arg, "--report") == 0) {
+      Result = ScParseStringValue(
+        argc,
+        argv,
+        &ArgIndex,
+        &Options->ReportPath
+        );
+#endif
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", Arg);
+      Result = false;
+    }
+
+    if (!Result) {
+      return false;
+    }
+  }
+
+  //
+  // Rating again requires all first ratings to be known.
+  //
+  if (Options->RescoreFraction >= 0
+   && (Options->Threshold >= 0 || Options->TopMatches > 0)) {
+    fprintf(stderr, "--rescore cannot be combined with --threshold or --top\n");
+    return false;
+  }
+  //
+  // Budgeted loading reads the files as they are needed, possibly repeatedly,
+  // and never holds all ratings.
+  //
+  if (Options->MemoryBudget > 0
+   && (Options->RescoreFraction >= 0 || Options->BatchIo)) {
+    fprintf(
+      stderr,
+      "--memory-budget cannot be combined with --rescore or --batch-io\n"
+      );
+    return false;
+  }
+  //
+  // Shards rate a cost-balanced subset of the tiles of the whole matrix, which
+  // neither budgeted mode nor rating again preserves.
+  //
+  if (Options->NumShards > 0
+   && (Options->MemoryBudget > 0 || Options->RescoreFraction >= 0)) {
+    fprintf(
+      stderr,
+      "--shard cannot be combined with --memory-budget or --rescore\n"
+      );
+    return false;
+  }
+  //
+  // The matrix holds all ratings and hence cannot be streamed.
+  //
+  if (Options->OutputFormat == ScOutputFormatMatrix
+   && (Options->Threshold >= 0
+    || Options->TopMatches > 0
+    || Options->MemoryBudget > 0
+    || Options->NumShards > 0
+    || Options->Merge)) {
+    fprintf(
+      stderr,
+      "--output matrix cannot be combined with --threshold, --top, "
+      "--memory-budget, --shard or --merge\n"
+      );
+    return false;
+  }
+
+  //
+  // The winnowing engine rates all pairings of a file at once from the
+  // fingerprints of all files, which must hence be resident. It is cheaper
+  // than the pre-filter and the coarse rating.
+  //
+  if (Options->Engine == ScEngineWinnow
+   && (Options->PrefilterCutoff >= 0
+    || Options->RescoreFraction >= 0
+    || Options->MemoryBudget > 0
+    || Options->NumShards > 0)) {
+    fprintf(
+      stderr,
+      "--engine winnow cannot be combined with --prefilter, --rescore, "
+      "--memory-budget or --shard\n"
+      );
+    return false;
+  }
+  //
+  // The winnowing engine does not compare lines.
+  //
+  if (Options->Engine == ScEngineWinnow && Options->AlignLines) {
+    fprintf(stderr, "--engine winnow cannot be combined with --align\n");
+    return false;
+  }
+#if SC_OFFLOAD
+  //
+  // The device rates whole pairings of resident files with the window search
+  // and returns their scores only.
+  //
+  if (Options->Engine == ScEngineOffload
+   && (Options->PrefilterCutoff >= 0
+    || Options->RescoreFraction >= 0
+    || Options->MemoryBudget > 0
+    || Options->AlignLines)) {
+    fprintf(
+      stderr,
+      "--engine offload cannot be combined with --prefilter, --rescore, "
+      "--memory-budget or --align\n"
+      );
+    return false;
+  }
+#endif
+
+  *FirstFile = ArgIndex;
+  return true;
+}
@@ -0,0 +1,191 @@
+/*@file
+  Provides the command line options of the similarity checker tool.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_MAIN_OPTIONS_H_
+#define SC_MAIN_OPTIONS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ScInstrument.h>
+#include <ScOutput.h>
+
+//
+// Define SC_MAX_NUM_FILES such that no memory size overflows can occur.
+//
+#if SIZE_MAX == UINT16_MAX
+  #define SC_MAX_NUM_FILES  INT8_MAX
+#elif SIZE_MAX == UINT32_MAX
+  #define SC_MAX_NUM_FILES  INT16_MAX
+#elif SIZE_MAX == UINT64_MAX
+  #define SC_MAX_NUM_FILES  INT32_MAX
+#else
+  #error The definition needs to be adapted.
+#endif
+
+///
+/// The engines to rate the file pairings with.
+///
+typedef enum {
+  ///
+  /// The line-based Levenshtein distance of the cleansed files.
+  ///
+  ScEngineLevenshtein,
+  ///
+  /// The Jaccard similarity of the winnowing fingerprints of the cleansed
+  /// files. It trades accuracy for screening large corpora.
+  ///
+  ScEngineWinnow,
+#if SC_OFFLOAD
+  ///
+  /// The line-based Levenshtein distance of the cleansed files, rated on the
+  /// OpenMP offload device.
+  ///
+  ScEngineOffload,
+#endif
+} sc_engine_t;
+
+///
+/// The command line options of this tool.
+///
+typedef struct {
+  ///
+  /// The minimum estimated similarity of a file pairing to be rated. If it is
+  /// negative, the pre-filter is disabled.
+  ///
+  double             PrefilterCutoff;
+  ///
+  /// Whether to omit pairings that have been pruned by the pre-filter from the
+  /// output.
+  ///
+  bool               OmitPruned;
+  ///
+  /// The minimum score of a file pairing to be output. If it is negative, all
+  /// pairings are output.
+  ///
+  double             Threshold;
+  ///
+  /// The number of best matches to output per file. If it is 0, all matches
+  /// are output.
+  ///
+  unsigned int       TopMatches;
+  ///
+  /// Whether to start fetching all files before cleansing any.
+  ///
+  bool               BatchIo;
+  ///
+  /// The directory to cache cleansed files in. If it is NULL, no cache is
+  /// used.
+  ///
+  const char         *CacheDir;
+  ///
+  /// The number of leading input files to compare against all input files.
+  /// Pairings of the remaining files among each other are not rated. If it is
+  /// 0, all pairings are rated.
+  ///
+  unsigned int       NumQueries;
+  ///
+  /// The radius to pick lines in file 2 from to compare to lines of file 1.
+  ///
+  unsigned int       NumLinesSwap;
+  ///
+  /// The maximum line length of accepted cleansed files.
+  ///
+  unsigned int       MaxLineLength;
+  ///
+  /// The maximum size, in bytes, of accepted input files.
+  ///
+  unsigned int       MaxFileSize;
+  ///
+  /// The fraction of the best rated file pairings to rate again with
+  /// NumLinesSwap after all pairings have been rated with CoarseNumLinesSwap.
+  /// If it is negative, all pairings are rated with NumLinesSwap only.
+  ///
+  double             RescoreFraction;
+  ///
+  /// The line swap radius of the coarse rating if RescoreFraction is not
+  /// negative.
+  ///
+  unsigned int       CoarseNumLinesSwap;
+  ///
+  /// The path of the file to read further input file paths from. "-" denotes
+  /// stdin. If it is NULL, only the input files from argv are used.
+  ///
+  const char         *FileListPath;
+  ///
+  /// Whether the paths in the file list are separated by NUL characters
+  /// instead of new lines.
+  ///
+  bool               FileListNul;
+  ///
+  /// The budget, in MiB, for the memory of the loaded files. If it is not 0,
+  /// the files are loaded block by block while rating and are freed once all
+  /// of their pairings have been rated.
+  ///
+  unsigned int       MemoryBudget;
+  ///
+  /// The format to output the ratings in.
+  ///
+  sc_output_format_t OutputFormat;
+  ///
+  /// The number of shards the pairings are split into. If it is 0, sharding
+  /// is disabled.
+  ///
+  unsigned int       NumShards;
+  ///
+  /// The index of the shard whose pairings are rated if NumShards is not 0.
+  ///
+  unsigned int       ShardIndex;
+  ///
+  /// Whether to merge the outputs of shards given as input files instead of
+  /// rating any pairings.
+  ///
+  bool               Merge;
+  ///
+  /// The engine to rate the file pairings with.
+  ///
+  sc_engine_t        Engine;
+  ///
+  /// Whether to align the lines of both files of a pairing globally within
+  /// the window, so that every line is matched at most once.
+  ///
+  bool               AlignLines;
+#if SC_INSTRUMENTATION
+  ///
+  /// The path of the file to write the instrumentation report to. If it is
+  /// NULL, the report is written to stderr.
+  ///
+  const char         *ReportPath;
+#endif
+} sc_main_options_t;
+
+/*
+  Prints the usage information of this tool to stderr.
+
+  @param[in] ToolName  The name this tool has been invoked as.
+*/
+void ScPrintUsage(
+  const char *ToolName
+  );
+
+/*
+  Parses the leading options of the command line arguments.
+
+  @param[in]  argc       The number of elements in argv.
+  @param[in]  argv       The arguments given to this tool.
+  @param[out] Options    On success, the parsed options.
+  @param[out] FirstFile  On success, the index of the first input file in argv.
+
+  @returns  Whether the options have been parsed successfully.
+*/
+bool ScParseOptions(
+  int               argc,
+  char              *argv[],
+  sc_main_options_t *Options,
+  int               *FirstFile
+  );
+
+#endif // SC_MAIN_OPTIONS_H_
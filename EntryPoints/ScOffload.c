@@ -0,0 +1,389 @@
+/*@file
+  Implements the rating of file pairings on an OpenMP offload device.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <float.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ScSafeInt.h>
+#include <ScSimilarityChecker.h>
+
+#include "ScCommon.h"
+#include "ScOffload.h"
+
+//
+// The device calculates distances in narrow rows.
+//
+_Static_assert(
+  SC_MAX_LINE_LENGTH < UINT16_MAX,
+  "The offload distance row type needs to be adapted."
+  );
+
+#pragma omp declare target
+
+/*
+  Calculates the Levenshtein distance of two lines with a single row of the
+  matrix. Device threads have little private memory and diverge on the
+  bit-parallel kernel's branches, hence the plain recurrence is faster there.
+
+  @param[in] String1      The first line.
+  @param[in] Length1      The length, in characters, of String1.
+  @param[in] String2      The second line.
+  @param[in] Length2      The length, in characters, of String2. It must be at
+                          most SC_MAX_LINE_LENGTH.
+  @param[in] MaxDistance  The largest distance of interest.
+
+  @returns  The Levenshtein distance of String1 and String2, or a value larger
+            than MaxDistance if it exceeds MaxDistance.
+*/
+static size_t ScOffloadDistance(
+  const char *String1,
+  size_t     Length1,
+  const char *String2,
+  size_t     Length2,
+  size_t     MaxDistance
+  )
+{
+  const size_t LengthDiff = Length1 > Length2
+                              ? Length1 - Length2
+                              : Length2 - Length1;
+  if (LengthDiff > MaxDistance) {
+    return MaxDistance + 1U;
+  }
+
+  uint16_t Row[SC_MAX_LINE_LENGTH + 1U];
+  for (size_t Index2 = 0; Index2 <= Length2; ++Index2) {
+    Row[Index2] = (uint16_t) Index2;
+  }
+
+  for (size_t Index1 = 0; Index1 < Length1; ++Index1) {
+    uint16_t Diagonal = Row[0];
+    uint16_t RowMin   = (uint16_t) (Index1 + 1U);
+    Row[0] = RowMin;
+    for (size_t Index2 = 0; Index2 < Length2; ++Index2) {
+      const uint16_t Above = Row[Index2 + 1U];
+      uint16_t       Value = (uint16_t) (
+                               Diagonal + (String1[Index1] != String2[Index2])
+                               );
+      Value = SC_MIN(Value, (uint16_t) (Above + 1U));
+      Value = SC_MIN(Value, (uint16_t) (Row[Index2] + 1U));
+
+      Diagonal         = Above;
+      Row[Index2 + 1U] = Value;
+      RowMin           = SC_MIN(RowMin, Value);
+    }
+    //
+    // The minimum of a row never decreases with the following rows, hence it
+    // bounds the distance from below.
+    //
+    if (RowMin > MaxDistance) {
+      return MaxDistance + 1U;
+    }
+  }
+
+  return Row[Length2];
+}
+
+/*
+  Calculates the largest line distance whose score improves the best score of
+  the current window search, like ScGetImprovingDistance() does on the host.
+
+  @param[in]  BestScore    The best score found thus far.
+  @param[in]  MatchLength  The match length of the candidate line pair.
+  @param[in]  TieWins      Whether a score equal to BestScore improves it.
+  @param[out] MaxDistance  On success, the largest improving distance.
+
+  @returns  Whether any distance improves BestScore.
+*/
+static bool ScOffloadImprovingDistance(
+  double BestScore,
+  size_t MatchLength,
+  bool   TieWins,
+  size_t *MaxDistance
+  )
+{
+  size_t Distance = (size_t) (BestScore * (double) MatchLength);
+  Distance = SC_MIN(Distance + 1U, MatchLength);
+
+  while (true) {
+    const double Score = (double) Distance / (double) MatchLength;
+    if (Score < BestScore || (TieWins && Score == BestScore)) {
+      break;
+    }
+
+    if (Distance == 0) {
+      return false;
+    }
+
+    --Distance;
+  }
+
+  *MaxDistance = Distance;
+  return true;
+}
+
+#pragma omp end declare target
+
+bool ScOffloadCreate(
+  sc_offload_t            *Offload,
+  const sc_cleanse_file_t *Files,
+  unsigned int            NumFiles
+  )
+{
+  assert(Offload != NULL);
+  assert(Files != NULL || NumFiles == 0);
+
+  size_t NumChars = 0;
+  size_t NumLines = 0;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    bool Overflow = ScSafeAddSize(
+                      NumChars,
+                      Files[FileIndex].Length,
+                      &NumChars
+                      );
+    Overflow |= ScSafeAddSize(
+                  NumLines,
+                  Files[FileIndex].Profiles.NumLines,
+                  &NumLines
+                  );
+    if (Overflow) {
+      return false;
+    }
+  }
+
+  size_t OffsetsSize;
+  size_t LengthsSize;
+  bool   Overflow = ScSafeMulSize(
+                      SC_MAX(NumLines, 1U),
+                      sizeof(*Offload->Offsets),
+                      &OffsetsSize
+                      );
+  Overflow |= ScSafeMulSize(
+                SC_MAX(NumLines, 1U),
+                sizeof(*Offload->Lengths),
+                &LengthsSize
+                );
+  if (Overflow) {
+    return false;
+  }
+
+  char     *Chars      = malloc(SC_MAX(NumChars, 1U));
+  uint64_t *Offsets    = malloc(OffsetsSize);
+  uint16_t *Lengths    = malloc(LengthsSize);
+  uint64_t *LineStarts = malloc(((size_t) NumFiles + 1U) * sizeof(*LineStarts));
+  if (Chars == NULL
+   || Offsets == NULL
+   || Lengths == NULL
+   || LineStarts == NULL) {
+    free(Chars);
+    free(Offsets);
+    free(Lengths);
+    free(LineStarts);
+    return false;
+  }
+  //
+  // Keep the layout of every cleansed file, so that the line offsets of its
+  // profiles only need to be rebased.
+  //
+  size_t CharIndex = 0;
+  size_t LineIndex = 0;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    const sc_cleanse_file_t  *File     = &Files[FileIndex];
+    const sc_line_profiles_t *Profiles = &File->Profiles;
+    memcpy(&Chars[CharIndex], File->Buffer, File->Length);
+
+    LineStarts[FileIndex] = LineIndex;
+    for (size_t Line = 0; Line < Profiles->NumLines; ++Line) {
+      Offsets[LineIndex] = CharIndex + Profiles->Offsets[Line];
+      Lengths[LineIndex] = Profiles->Lengths[Line];
+      ++LineIndex;
+    }
+
+    CharIndex += File->Length;
+  }
+
+  LineStarts[NumFiles] = LineIndex;
+  //
+  // Upload the files once. All ratings refer to the device copy.
+  //
+  #pragma omp target enter data map(to: Chars[0:SC_MAX(NumChars, 1U)], \
+    Offsets[0:SC_MAX(NumLines, 1U)], Lengths[0:SC_MAX(NumLines, 1U)], \
+    LineStarts[0:NumFiles + 1U])
+
+  Offload->Chars      = Chars;
+  Offload->Offsets    = Offsets;
+  Offload->Lengths    = Lengths;
+  Offload->LineStarts = LineStarts;
+  Offload->NumChars   = SC_MAX(NumChars, 1U);
+  Offload->NumLines   = SC_MAX(NumLines, 1U);
+  Offload->NumFiles   = NumFiles;
+  return true;
+}
+
+void ScOffloadFree(
+  sc_offload_t *Offload
+  )
+{
+  assert(Offload != NULL);
+
+  char     *Chars      = Offload->Chars;
+  uint64_t *Offsets    = Offload->Offsets;
+  uint16_t *Lengths    = Offload->Lengths;
+  uint64_t *LineStarts = Offload->LineStarts;
+  if (Chars != NULL) {
+    #pragma omp target exit data map(delete: Chars[0:Offload->NumChars], \
+      Offsets[0:Offload->NumLines], Lengths[0:Offload->NumLines], \
+      LineStarts[0:Offload->NumFiles + 1U])
+  }
+
+  free(Chars);
+  free(Offsets);
+  free(Lengths);
+  free(LineStarts);
+  Offload->Chars      = NULL;
+  Offload->Offsets    = NULL;
+  Offload->Lengths    = NULL;
+  Offload->LineStarts = NULL;
+}
+
+void ScOffloadRatePairings(
+  const sc_offload_t   *Offload,
+  sc_context_pairing_t *Pairings,
+  size_t               NumPairings,
+  size_t               NumLinesSwap
+  )
+{
+  assert(Offload != NULL);
+  assert(Offload->Chars != NULL);
+  assert(Pairings != NULL || NumPairings == 0);
+  assert(NumPairings <= SC_OFFLOAD_BATCH_SIZE);
+
+  const char     *Chars      = Offload->Chars;
+  const uint64_t *Offsets    = Offload->Offsets;
+  const uint16_t *Lengths    = Offload->Lengths;
+  const uint64_t *LineStarts = Offload->LineStarts;
+  const size_t   NumChars    = Offload->NumChars;
+  const size_t   NumLines    = Offload->NumLines;
+  const size_t   NumFiles    = Offload->NumFiles;
+  //
+  // The files are present on the device already, hence only the pairings are
+  // transferred.
+  //
+  #pragma omp target teams distribute map(tofrom: Pairings[0:NumPairings]) \
+    map(to: Chars[0:NumChars], Offsets[0:NumLines], Lengths[0:NumLines], \
+    LineStarts[0:NumFiles + 1U])
+  for (size_t PairingIndex = 0; PairingIndex < NumPairings; ++PairingIndex) {
+    uint64_t Start1    = LineStarts[Pairings[PairingIndex].File1Index];
+    uint64_t Start2    = LineStarts[Pairings[PairingIndex].File2Index];
+    uint64_t NumLines1 = LineStarts[Pairings[PairingIndex].File1Index + 1U]
+                           - Start1;
+    uint64_t NumLines2 = LineStarts[Pairings[PairingIndex].File2Index + 1U]
+                           - Start2;
+    //
+    // Make sure file 1 is the shorter file like ScLevenshteinSwap() does.
+    //
+    if (NumLines1 > NumLines2) {
+      const uint64_t StartTmp    = Start1;
+      const uint64_t NumLinesTmp = NumLines1;
+      Start1    = Start2;
+      NumLines1 = NumLines2;
+      Start2    = StartTmp;
+      NumLines2 = NumLinesTmp;
+    }
+    //
+    // The sums are bounded by the number of lines times SC_MAX_LINE_LENGTH,
+    // which cannot overflow 64 bits.
+    //
+    uint64_t TotalDiff   = 0;
+    uint64_t TotalLength = 0;
+    #pragma omp parallel for reduction(+: TotalDiff, TotalLength)
+    for (uint64_t Line1Index = 0; Line1Index < NumLines1; ++Line1Index) {
+      const uint64_t StartIndex = Line1Index > NumLinesSwap
+                                    ? Line1Index - NumLinesSwap
+                                    : 0;
+      const uint64_t TopIndex   = NumLines2 - Line1Index > NumLinesSwap
+                                    ? Line1Index + NumLinesSwap + 1U
+                                    : NumLines2;
+      const char     *Line1     = &Chars[Offsets[Start1 + Line1Index]];
+      const size_t   Length1    = Lengths[Start1 + Line1Index];
+      //
+      // Pick the best match with the lowest index like ScSwapMatchUpdate().
+      // The line at the same index is evaluated first to tighten the bounds
+      // for all other candidates like ScLevenshteinSwap() does.
+      //
+      double   BestScore       = DBL_MAX;
+      uint64_t BestIndex       = UINT64_MAX;
+      size_t   BestDistance    = 0;
+      size_t   BestMatchLength = 1;
+      for (uint64_t Step = 0; Step < TopIndex - StartIndex; ++Step) {
+        uint64_t Line2Index = Line1Index;
+        if (Step > 0) {
+          Line2Index = StartIndex + Step - 1U;
+          if (Line2Index >= Line1Index) {
+            ++Line2Index;
+          }
+        }
+
+        const size_t Length2     = Lengths[Start2 + Line2Index];
+        const size_t MatchLength = SC_MAX(Length1, Length2);
+        //
+        // Limit the calculation to distances that can improve the best score.
+        //
+        size_t MaxDistance = SIZE_MAX;
+        if (BestIndex != UINT64_MAX) {
+          const bool Improvable = ScOffloadImprovingDistance(
+                                    BestScore,
+                                    MatchLength,
+                                    Line2Index < BestIndex,
+                                    &MaxDistance
+                                    );
+          if (!Improvable) {
+            continue;
+          }
+        }
+
+        const size_t Distance = ScOffloadDistance(
+                                  &Chars[Offsets[Start2 + Line2Index]],
+                                  Length2,
+                                  Line1,
+                                  Length1,
+                                  MaxDistance
+                                  );
+        if (Distance > MaxDistance) {
+          continue;
+        }
+
+        const double Score = Distance == 0
+                               ? 0
+                               : (double) Distance / (double) MatchLength;
+        if (Score < BestScore
+         || (Score == BestScore && Line2Index < BestIndex)) {
+          BestScore       = Score;
+          BestIndex       = Line2Index;
+          BestDistance    = Distance;
+          BestMatchLength = MatchLength;
+        }
+        //
+        // An identical line cannot be improved upon.
+        //
+        if (Distance == 0) {
+          break;
+        }
+      }
+
+      TotalDiff   += BestDistance;
+      TotalLength += BestMatchLength;
+    }
+
+    Pairings[PairingIndex].Score = 1.
+      - ((double) TotalDiff / (double) TotalLength);
+  }
+}
@@ -0,0 +1,112 @@
+/*@file
+  Provides APIs to rate file pairings on an OpenMP offload device.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_OFFLOAD_H_
+#define SC_OFFLOAD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ScSimilarityChecker.h>
+
+#include "ScCommon.h"
+
+///
+/// Defines the maximum number of file pairings that are rated by a single
+/// launch on the device.
+///
+#ifndef SC_OFFLOAD_BATCH_SIZE
+  #define SC_OFFLOAD_BATCH_SIZE  (64U * 1024U)
+#endif
+
+_Static_assert(
+  SC_OFFLOAD_BATCH_SIZE > 0,
+  "The offload batch size must not be 0."
+  );
+
+///
+/// The packed lines of all files, which reside on the device for all
+/// subsequent ratings.
+///
+typedef struct {
+  ///
+  /// The contents of all files, one after another.
+  ///
+  char         *Chars;
+  ///
+  /// The offsets, in characters, of all lines of all files within Chars.
+  ///
+  uint64_t     *Offsets;
+  ///
+  /// The lengths, in characters, of all lines of all files.
+  ///
+  uint16_t     *Lengths;
+  ///
+  /// The index of the first line of every file within Offsets and Lengths,
+  /// followed by the number of elements in them.
+  ///
+  uint64_t     *LineStarts;
+  ///
+  /// The number of elements in Chars.
+  ///
+  size_t       NumChars;
+  ///
+  /// The number of elements in Offsets and Lengths.
+  ///
+  size_t       NumLines;
+  ///
+  /// The number of files.
+  ///
+  unsigned int NumFiles;
+} sc_offload_t;
+
+/*
+  Packs the lines of all files and uploads them to the default device.
+
+  @param[out] Offload   On success, the device copy of the files.
+  @param[in]  Files     The cleansed files.
+  @param[in]  NumFiles  The number of elements in Files.
+
+  @returns  Whether the files have been uploaded successfully.
+*/
+bool ScOffloadCreate(
+  sc_offload_t            *Offload,
+  const sc_cleanse_file_t *Files,
+  unsigned int            NumFiles
+  );
+
+/*
+  Frees the resources of Offload on both the host and the device.
+
+  @param[in,out] Offload  The device copy of the files to free.
+*/
+void ScOffloadFree(
+  sc_offload_t *Offload
+  );
+
+/*
+  Rates file pairings on the device with the results of ScLevenshteinSwap().
+  Every pairing is rated by a team of device threads, which share the lines
+  of the file with fewer lines. Like on the host, every line pair is only
+  calculated up to the distance that improves the best match of its line.
+
+  @param[in]     Offload       The device copy of the files.
+  @param[in,out] Pairings      The pairings to rate. Their scores are set on
+                               return.
+  @param[in]     NumPairings   The number of elements in Pairings. It must be
+                               at most SC_OFFLOAD_BATCH_SIZE.
+  @param[in]     NumLinesSwap  The number of lines before and after the line
+                               of equal index to compare to.
+*/
+void ScOffloadRatePairings(
+  const sc_offload_t   *Offload,
+  sc_context_pairing_t *Pairings,
+  size_t               NumPairings,
+  size_t               NumLinesSwap
+  );
+
+#endif // SC_OFFLOAD_H_
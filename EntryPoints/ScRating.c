@@ -0,0 +1,2284 @@
+/*@file
+  Implements the rating of all file pairings of the similarity checker tool.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include <ScFileBlocks.h>
+#include <ScFileIo.h>
+#include <ScInstrument.h>
+#include <ScNuma.h>
+#include <ScOutput.h>
+#include <ScPairTiles.h>
+#include <ScRescore.h>
+#include <ScSafeInt.h>
+#include <ScShard.h>
+#include <ScTopMatches.h>
+#include <ScWinnow.h>
+
+#include "ScCommon.h"
+#include "ScMainOptions.h"
+#include "ScRating.h"
+
+#if SC_OFFLOAD
+  #include "ScOffload.h"
+#endif
+
+/*
+  Calculates the Gauss Sum of x.
+*/
+#define SC_GAUSS_SUM(x)  (((x) * ((x) + 1U)) / 2U)
+
+///
+/// The rating of a file pairing that has been pruned by the pre-filter.
+///
+#define SC_RATING_PRUNED  (-1.0)
+
+///
+/// The rating of a file pairing that has not been selected to be rated again.
+/// Its coarse rating is not comparable to those rated again and is not output.
+///
+#define SC_RATING_SKIPPED  (-2.0)
+
+///
+/// The minimum number of tiles per shard to balance the shards by.
+///
+#define SC_SHARD_MIN_TILES  64U
+
+///
+/// The compiled cleansing configurations for every sc_cleanse_config_type_t.
+///
+static sc_cleanse_matcher_t mScCleanseMatchers[ScCleanseConfigTypeMax + 1];
+
+///
+/// The state shared by the rating of all file pairings.
+///
+typedef struct {
+  ///
+  /// The command line options of this tool.
+  ///
+  const sc_main_options_t *Options;
+  ///
+  /// The file list.
+  ///
+  const sc_cleanse_file_t *Files;
+  ///
+  /// The file paths, indexed by the Reserved field of the files.
+  ///
+  char *const             *FileArgs;
+  ///
+  /// The number of elements in Files.
+  ///
+  unsigned int            NumFiles;
+  ///
+  /// The ratings result list in the order of output. It is NULL if ratings
+  /// are streamed.
+  ///
+  double                  *Ratings;
+  ///
+  /// The per-file match lists in top-K mode.
+  ///
+  sc_top_matches_t        *TopMatches;
+  ///
+  /// The ratings of the tiles of this shard. It is NULL if ratings are not
+  /// sharded or in top-K mode.
+  ///
+  sc_shard_ratings_t      *ShardRatings;
+  ///
+  /// The pre-filter sketches of the files. It is NULL if the pre-filter is
+  /// disabled.
+  ///
+  const sc_min_hash_t     *Sketches;
+  ///
+  /// The line pair distance cache shared by all comparisons.
+  ///
+  sc_line_cache_t         *LineCache;
+  ///
+  /// The zeroed bit-parallel scratch buffers of all threads, one after
+  /// another, each for the lines of the maximum length of the options. The
+  /// buffer of a thread is indexed by its OpenMP thread number.
+  ///
+  uint64_t                *PeqScratch;
+  ///
+  /// The number of elements of every buffer of PeqScratch.
+  ///
+  size_t                  PeqSize;
+  ///
+  /// The line swap radius to rate the pairings with.
+  ///
+  unsigned int            NumLinesSwap;
+  ///
+  /// If it is not negative, only the pairings with a recorded rating of at
+  /// least this value are rated again and all other rated pairings are
+  /// marked as skipped.
+  ///
+  double                  RescoreCutoff;
+  ///
+  /// The NUMA domain that holds the data of every file of Files. It is NULL
+  /// if the threads are not bound to multiple domains.
+  ///
+  const unsigned int      *FileDomains;
+  ///
+  /// The number of NUMA domains the threads are bound to.
+  ///
+  unsigned int            NumDomains;
+  ///
+  /// The NUMA domain of every OpenMP place. It is NULL if the threads are not
+  /// bound to multiple domains.
+  ///
+  const unsigned int      *PlaceDomains;
+} sc_rating_context_t;
+
+///
+/// The state of rating the file pairings block by block in budgeted mode.
+///
+typedef struct {
+  ///
+  /// The rating context. Its Files are loaded and freed by the schedule.
+  ///
+  const sc_rating_context_t *Context;
+  ///
+  /// The file list, which Context->Files refers to.
+  ///
+  sc_cleanse_file_t         *Files;
+  ///
+  /// The pre-filter sketches of the files, which Context->Sketches refers to.
+  /// It is NULL if the pre-filter is disabled.
+  ///
+  sc_min_hash_t             *Sketches;
+  ///
+  /// Whether loading has failed for every file, so that it is not retried.
+  ///
+  bool                      *Failed;
+  ///
+  /// The blocks partitioning the file list.
+  ///
+  sc_file_block_t           *Blocks;
+  ///
+  /// The number of elements in Blocks.
+  ///
+  unsigned int              NumBlocks;
+  ///
+  /// NumArenas arenas for every block, which hold its loaded files.
+  ///
+  sc_arena_t                *Arenas;
+  ///
+  /// The number of arenas per block.
+  ///
+  unsigned int              NumArenas;
+} sc_block_schedule_t;
+
+/*
+  Flushes stdout and reports whether all output has been written
+  successfully. Ratings are output without checking every single write, hence
+  this must be called once all output is complete.
+
+  @returns  Whether all output has been written successfully.
+*/
+static bool ScFinishOutput(void)
+{
+  const bool Result = ScOutputFinish(stdout);
+  if (!Result) {
+    fprintf(stderr, "Output error\n");
+  }
+
+  return Result;
+}
+
+/*
+  Returns the input path index of every file, which is stored in the Reserved
+  field of the file.
+
+  @param[in] Files     The file list.
+  @param[in] NumFiles  The number of elements in Files.
+
+  @returns  The input path indices, or NULL on allocation failure. They are
+            allocated with malloc and caller-owned.
+*/
+static unsigned int *ScCreateFileIndices(
+  const sc_cleanse_file_t *Files,
+  unsigned int            NumFiles
+  )
+{
+  assert(Files != NULL || NumFiles == 0);
+
+  unsigned int *FileIndices = malloc(
+                                SC_MAX(NumFiles, 1U) * sizeof(*FileIndices)
+                                );
+  if (FileIndices == NULL) {
+    return NULL;
+  }
+
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    FileIndices[FileIndex] = Files[FileIndex].Reserved;
+  }
+
+  return FileIndices;
+}
+
+/*
+  Outputs the ratings result list in the matrix format. Pruned pairings are
+  reported as not similar or, with --omit-pruned, as not rated, and pairings
+  skipped by the second rating as not rated, for which their ratings are
+  replaced in the list.
+
+  @param[in]     Options      The command line options of this tool.
+  @param[in]     Files        The file list.
+  @param[in]     NumFiles     The number of elements in Files.
+  @param[in]     NumRowFiles  The number of leading query files.
+  @param[in,out] Ratings      The ratings result list.
+
+  @returns  Whether the matrix has been written successfully.
+*/
+static bool ScWriteRatingsMatrix(
+  const sc_main_options_t *Options,
+  const sc_cleanse_file_t *Files,
+  unsigned int            NumFiles,
+  unsigned int            NumRowFiles,
+  double                  *Ratings
+  )
+{
+  assert(Options != NULL);
+  assert(Files != NULL);
+  assert(NumRowFiles <= NumFiles);
+  assert(Ratings != NULL || NumRowFiles == 0);
+
+  unsigned int *FileIndices = ScCreateFileIndices(Files, NumFiles);
+  if (FileIndices == NULL) {
+    return false;
+  }
+
+  size_t NumRatings = 0;
+  for (unsigned int File1Index = 0; File1Index < NumRowFiles; ++File1Index) {
+    NumRatings += NumFiles - File1Index - 1U;
+  }
+
+  for (size_t DistIndex = 0; DistIndex < NumRatings; ++DistIndex) {
+    if (Ratings[DistIndex] == SC_RATING_PRUNED) {
+      Ratings[DistIndex] = Options->OmitPruned ? (double) NAN : 0;
+    } else if (Ratings[DistIndex] == SC_RATING_SKIPPED) {
+      Ratings[DistIndex] = (double) NAN;
+    }
+  }
+
+  const bool Result = ScOutputWriteMatrix(
+                        stdout,
+                        FileIndices,
+                        NumFiles,
+                        NumRowFiles,
+                        Ratings
+                        );
+  free(FileIndices);
+  return Result;
+}
+
+/*
+  Outputs the ratings of the tiles of this shard ordered by their files, so
+  that the outputs of all shards can be merged as streams.
+
+  @param[in] Options       The command line options of this tool.
+  @param[in] Files         The file list.
+  @param[in] ShardRatings  The ratings of the tiles of this shard.
+
+  @returns  Whether the ratings have been written successfully.
+*/
+static bool ScWriteShardRatings(
+  const sc_main_options_t  *Options,
+  const sc_cleanse_file_t  *Files,
+  const sc_shard_ratings_t *ShardRatings
+  )
+{
+  assert(Options != NULL);
+  assert(ShardRatings != NULL);
+
+  unsigned int *FileIndices = ScCreateFileIndices(
+                                Files,
+                                ShardRatings->NumFiles
+                                );
+  if (FileIndices == NULL) {
+    fprintf(stderr, "Allocation error\n");
+    return false;
+  }
+
+  ScShardRatingsWrite(
+    ShardRatings,
+    stdout,
+    Options->OutputFormat,
+    FileIndices
+    );
+  free(FileIndices);
+  return true;
+}
+
+/*
+  Outputs the final match list of the file with index FileIndex in top-K mode.
+  No other thread may access the list anymore.
+
+  @param[in,out] TopMatches  The per-file match lists.
+  @param[in]     Options     The command line options of this tool.
+  @param[in]     Files       The file list.
+  @param[in]     FileIndex   The index of the file to output the list of.
+*/
+static void ScTopMatchesOutput(
+  sc_top_matches_t        *TopMatches,
+  const sc_main_options_t *Options,
+  const sc_cleanse_file_t *Files,
+  unsigned int            FileIndex
+  )
+{
+  assert(TopMatches != NULL);
+  assert(Options != NULL);
+  assert(Files != NULL);
+
+  unsigned int      NumMatches;
+  const sc_match_t *Matches = ScTopMatchesFinalise(
+                                TopMatches,
+                                FileIndex,
+                                &NumMatches
+                                );
+  //
+  // Only the output is serialised.
+  //
+  #pragma omp critical
+  for (unsigned int MatchIndex = 0; MatchIndex < NumMatches; ++MatchIndex) {
+    ScOutputWriteRating(
+      stdout,
+      Options->OutputFormat,
+      Files[FileIndex].Reserved,
+      Files[Matches[MatchIndex].FileIndex].Reserved,
+      Matches[MatchIndex].Score
+      );
+  }
+}
+
+/*
+  Records the rating of a file pairing in top-K mode and outputs the match list
+  of every file that has no pairings pending anymore.
+
+  @param[in,out] TopMatches  The per-file match lists.
+  @param[in]     Options     The command line options of this tool.
+  @param[in]     Files       The file list.
+  @param[in]     File1Index  The index of the first file of the pairing.
+  @param[in]     File2Index  The index of the second file of the pairing.
+  @param[in]     Score       The score of the pairing.
+  @param[in]     Valid       Whether the pairing is to be added to the lists.
+*/
+static void ScTopMatchesRecord(
+  sc_top_matches_t        *TopMatches,
+  const sc_main_options_t *Options,
+  const sc_cleanse_file_t *Files,
+  unsigned int            File1Index,
+  unsigned int            File2Index,
+  double                  Score,
+  bool                    Valid
+  )
+{
+  unsigned int       Final[2];
+  const unsigned int NumFinal = ScTopMatchesAdd(
+                                  TopMatches,
+                                  File1Index,
+                                  File2Index,
+                                  Score,
+                                  Valid,
+                                  Final
+                                  );
+  for (unsigned int Index = 0; Index < NumFinal; ++Index) {
+    ScTopMatchesOutput(TopMatches, Options, Files, Final[Index]);
+  }
+}
+
+/*
+  Calculates the index of the rating of a file pairing within the ratings
+  result list.
+
+  @param[in] Context     The rating context.
+  @param[in] File1Index  The index of the first file of the pairing.
+  @param[in] File2Index  The index of the second file of the pairing. It must
+                         be larger than File1Index.
+
+  @returns  The index of the rating within Context->Ratings.
+*/
+static size_t ScGetRatingIndex(
+  const sc_rating_context_t *Context,
+  unsigned int              File1Index,
+  unsigned int              File2Index
+  )
+{
+  assert(Context != NULL);
+  assert(File1Index < File2Index && File2Index < Context->NumFiles);
+  //
+  // File1Index's pairings start after those of all previous files, which
+  // are precisely the Gauss Sum of NumFiles - 1 minus the Gauss Sum of
+  // the number of files left.
+  //
+  const unsigned int NumFilesMinus1 = Context->NumFiles - 1U;
+  const size_t       File1DistStart = SC_GAUSS_SUM((size_t) NumFilesMinus1)
+                                        - SC_GAUSS_SUM(
+                                            (size_t) (NumFilesMinus1
+                                                        - File1Index)
+                                            );
+  return File1DistStart + (File2Index - (File1Index + 1U));
+}
+
+/*
+  Applies the output filters of Options to the rating of a file pairing.
+
+  @param[in]     Options  The command line options of this tool.
+  @param[in,out] Score    The score of the pairing. It is SC_RATING_PRUNED if
+                          the pairing has been pruned and INFINITY if rating
+                          it has failed. Pruned pairings are set to 0.
+
+  @returns  Whether the pairing is output.
+*/
+static bool ScFilterRating(
+  const sc_main_options_t *Options,
+  double                  *Score
+  )
+{
+  assert(Options != NULL);
+  assert(Score != NULL);
+  //
+  // Pruned pairings are reported as not similar. Failed pairings have been
+  // reported already.
+  //
+  const bool Failed = *Score >= (double) INFINITY;
+  const bool Pruned = *Score == SC_RATING_PRUNED;
+  const bool Valid  = !Failed && !(Pruned && Options->OmitPruned);
+  if (Pruned) {
+    *Score = 0;
+  }
+
+  return Valid && *Score >= Options->Threshold;
+}
+
+/*
+  Records or outputs the rating of the pairing of the files with indices
+  File1Index and File2Index as configured.
+
+  @param[in,out] Context     The rating context.
+  @param[in]     File1Index  The index of the first file of the pairing.
+  @param[in]     File2Index  The index of the second file of the pairing. It
+                             must be larger than File1Index.
+  @param[in]     Score       The score of the pairing. It is SC_RATING_PRUNED
+                             if the pairing has been pruned and INFINITY if
+                             rating it has failed.
+*/
+static void ScRecordRating(
+  const sc_rating_context_t *Context,
+  unsigned int              File1Index,
+  unsigned int              File2Index,
+  double                    Score
+  )
+{
+  assert(Context != NULL);
+  assert(File1Index < File2Index && File2Index < Context->NumFiles);
+
+  const sc_main_options_t *Options = Context->Options;
+  const sc_cleanse_file_t *Files   = Context->Files;
+
+  if (Context->Ratings != NULL) {
+    Context->Ratings[ScGetRatingIndex(Context, File1Index, File2Index)] = Score;
+    return;
+  }
+
+  const bool Valid = ScFilterRating(Options, &Score);
+  //
+  // Shards output their ratings ordered by their files once all are rated.
+  // Filtered ratings are stored as NaN to not be output.
+  //
+  if (Context->ShardRatings != NULL) {
+    Context->ShardRatings->Ratings[
+      ScShardRatingsGetIndex(Context->ShardRatings, File1Index, File2Index)
+      ] = Valid ? Score : (double) NAN;
+    return;
+  }
+
+  if (Options->TopMatches > 0) {
+    ScTopMatchesRecord(
+      Context->TopMatches,
+      Options,
+      Files,
+      File1Index,
+      File2Index,
+      Score,
+      Valid
+      );
+  } else if (Valid) {
+    #pragma omp critical
+    ScOutputWriteRating(
+      stdout,
+      Options->OutputFormat,
+      Files[File1Index].Reserved,
+      Files[File2Index].Reserved,
+      Score
+      );
+  }
+}
+
+/*
+  Rates the pairing of the files with indices File1Index and File2Index and
+  records or outputs the result as configured.
+
+  @param[in,out] Context     The rating context.
+  @param[in]     File1Index  The index of the first file of the pairing.
+  @param[in]     File2Index  The index of the second file of the pairing. It
+                             must be larger than File1Index.
+*/
+static void ScRatePairing(
+  const sc_rating_context_t *Context,
+  unsigned int              File1Index,
+  unsigned int              File2Index
+  )
+{
+  assert(Context != NULL);
+  assert(File1Index < File2Index && File2Index < Context->NumFiles);
+
+  const sc_main_options_t *Options = Context->Options;
+  const sc_cleanse_file_t *Files   = Context->Files;
+  //
+  // In budgeted mode, files that failed to load remain in the file list and
+  // their pairings are not rated.
+  //
+  if (Files[File1Index].Buffer == NULL || Files[File2Index].Buffer == NULL) {
+    assert(Context->Ratings == NULL);
+
+    if (Options->TopMatches > 0) {
+      ScTopMatchesRecord(
+        Context->TopMatches,
+        Options,
+        Files,
+        File1Index,
+        File2Index,
+        0,
+        false
+        );
+    }
+
+    return;
+  }
+  //
+  // When rating again, only rate the pairings whose first rating qualifies.
+  // The others are marked as skipped, while pruned and failed pairings keep
+  // their ratings.
+  //
+  if (Context->RescoreCutoff >= 0) {
+    assert(Context->Ratings != NULL);
+
+    double *Rating = &Context->Ratings[
+                       ScGetRatingIndex(Context, File1Index, File2Index)
+                       ];
+    if (!(*Rating >= 0 && *Rating < (double) INFINITY)) {
+      return;
+    }
+
+    if (*Rating < Context->RescoreCutoff) {
+      *Rating = SC_RATING_SKIPPED;
+      return;
+    }
+  }
+  //
+  // Skip the rating of pairings that are estimated to be too dissimilar.
+  // The estimate is orders of magnitude cheaper than the rating.
+  //
+  double Score  = SC_RATING_PRUNED;
+  bool   Pruned = false;
+  if (Context->Sketches != NULL) {
+    const double Estimate = ScMinHashSimilarity(
+      &Context->Sketches[File1Index],
+      &Context->Sketches[File2Index]
+      );
+    Pruned = Estimate < Options->PrefilterCutoff;
+  }
+
+  size_t ThreadIndex = 0;
+#ifdef _OPENMP
+  ThreadIndex = (size_t) omp_get_thread_num();
+#endif
+  uint64_t *PeqScratch = &Context->PeqScratch[ThreadIndex * Context->PeqSize];
+  if (!Pruned && Options->AlignLines) {
+    Score = ScLevenshteinAlign(
+      &Files[File1Index],
+      &Files[File2Index],
+      Context->NumLinesSwap,
+      PeqScratch,
+      Context->LineCache
+      );
+  } else if (!Pruned) {
+    Score = ScLevenshteinSwap(
+      &Files[File1Index],
+      &Files[File2Index],
+      Context->NumLinesSwap,
+      PeqScratch,
+      Context->LineCache
+      );
+  }
+  //
+  // Check for greater-equals to silence compiler warnings as no float value
+  // can be bigger anyway.
+  //
+  const bool Failed = Score >= (double) INFINITY;
+  if (Failed) {
+    #pragma omp critical
+    fprintf(
+      stderr,
+      "Failed to compare files %s and %s\n",
+      Context->FileArgs[Files[File1Index].Reserved],
+      Context->FileArgs[Files[File2Index].Reserved]
+      );
+  }
+
+  ScRecordRating(Context, File1Index, File2Index, Score);
+}
+
+/*
+  Returns the number of tiles to balance the load of rating across.
+
+  @param[in] Options  The command line options of this tool.
+*/
+static size_t ScGetMinNumTiles(
+  const sc_main_options_t *Options
+  )
+{
+  assert(Options != NULL);
+  //
+  // All shards must split the pairings identically, independent of the number
+  // of threads of their nodes.
+  //
+  if (Options->NumShards > 0) {
+    return (size_t) Options->NumShards * SC_SHARD_MIN_TILES;
+  }
+
+  unsigned int NumThreads = 1;
+#ifdef _OPENMP
+  NumThreads = (unsigned int) omp_get_max_threads();
+#endif
+  return (size_t) NumThreads * 8U;
+}
+
+/*
+  Splits the pairings of the files with indices in [RowStart, RowEnd) with the
+  larger files with indices in [ColumnStart, ColumnEnd) into tiles ordered from
+  most to least expensive, see ScPairTilesCreate(). Files that failed to load
+  are not rated and hence do not add to the cost.
+
+  @param[in]  Files        The file list.
+  @param[in]  NumFiles     The number of elements in Files.
+  @param[in]  RowStart     The index of the first file of the rows.
+  @param[in]  RowEnd       The index past the last file of the rows.
+  @param[in]  ColumnStart  The index of the first file of the columns.
+  @param[in]  ColumnEnd    The index past the last file of the columns.
+  @param[in]  MinNumTiles  The number of tiles to balance the load across.
+  @param[out] NumTiles     On success, the number of returned tiles.
+  @param[out] TileSize     On success, the edge length, in files, of the tiles.
+
+  @retval NULL   An error has occured.
+  @retval other  The tiles. They are allocated with malloc and caller-owned.
+*/
+static sc_pair_tile_t *ScCreatePairTiles(
+  const sc_cleanse_file_t *Files,
+  unsigned int            NumFiles,
+  unsigned int            RowStart,
+  unsigned int            RowEnd,
+  unsigned int            ColumnStart,
+  unsigned int            ColumnEnd,
+  size_t                  MinNumTiles,
+  size_t                  *NumTiles,
+  unsigned int            *TileSize
+  )
+{
+  assert(Files != NULL || NumFiles == 0);
+  assert(ColumnEnd <= NumFiles);
+
+  sc_tile_file_t *TileFiles = malloc(SC_MAX(NumFiles, 1U) * sizeof(*TileFiles));
+  if (TileFiles == NULL) {
+    return NULL;
+  }
+
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    TileFiles[FileIndex].NumLines = 0;
+    TileFiles[FileIndex].Length   = 0;
+    if (Files[FileIndex].Buffer != NULL) {
+      TileFiles[FileIndex].NumLines = Files[FileIndex].LinesInfo->NumLines;
+      TileFiles[FileIndex].Length   = Files[FileIndex].Length;
+    }
+  }
+
+  sc_pair_tile_t *Tiles = ScPairTilesCreate(
+                            TileFiles,
+                            RowStart,
+                            RowEnd,
+                            ColumnStart,
+                            ColumnEnd,
+                            MinNumTiles,
+                            NumTiles,
+                            TileSize
+                            );
+  free(TileFiles);
+  return Tiles;
+}
+
+/*
+  Rates all file pairings of Tile as configured by Context.
+
+  @param[in] Context  The rating context.
+  @param[in] Tile     The tile of file pairings to rate.
+*/
+static void ScRateTile(
+  const sc_rating_context_t *Context,
+  const sc_pair_tile_t      *Tile
+  )
+{
+  assert(Context != NULL);
+  assert(Tile != NULL);
+
+  SC_INSTRUMENT_PHASE_START(CompareTimer);
+
+  for (
+    unsigned int File1Index = Tile->RowStart;
+    File1Index < Tile->RowEnd;
+    ++File1Index
+    ) {
+    for (
+      unsigned int File2Index = SC_MAX(Tile->ColumnStart, File1Index + 1U);
+      File2Index < Tile->ColumnEnd;
+      ++File2Index
+      ) {
+      ScRatePairing(Context, File1Index, File2Index);
+    }
+  }
+
+  SC_INSTRUMENT_PHASE_STOP(CompareTimer, ScInstrumentPhaseCompare);
+}
+
+/*
+  Rates all file pairings of Tiles as configured by Context.
+
+  @param[in] Context   The rating context.
+  @param[in] Tiles     The tiles of file pairings to rate.
+  @param[in] NumTiles  The number of elements in Tiles.
+*/
+static void ScRateTiles(
+  const sc_rating_context_t *Context,
+  const sc_pair_tile_t      *Tiles,
+  size_t                    NumTiles
+  )
+{
+  assert(Context != NULL);
+  assert(Tiles != NULL || NumTiles == 0);
+  sc_domain_queue_t *Queues = NULL;
+  if (Context->FileDomains != NULL) {
+    Queues = ScPairTilesCreateQueues(Tiles, NumTiles, Context->NumDomains);
+  }
+  //
+  // The tiles' costs vary heavily, hence distribute them dynamically.
+  //
+  if (Queues == NULL) {
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+      ScRateTile(Context, &Tiles[TileIndex]);
+    }
+
+    return;
+  }
+  //
+  // The tiles are grouped by their domains, and every thread prefers those of
+  // its own.
+  //
+  const unsigned int NumDomains = Context->NumDomains;
+  #pragma omp parallel
+  {
+    const unsigned int Home = ScNumaGetThreadDomain(Context->PlaceDomains)
+                                % NumDomains;
+    unsigned int       Step = 0;
+    size_t             TileIndex;
+    while (ScPairTilesDequeue(Queues, NumDomains, Home, &Step, &TileIndex)) {
+      ScRateTile(Context, &Tiles[TileIndex]);
+    }
+  }
+
+  free(Queues);
+}
+
+#if SC_OFFLOAD
+/*
+  Rates a batch of file pairings on the OpenMP offload device and records
+  their ratings.
+
+  @param[in]     Context      The rating context.
+  @param[in]     Offload      The device copy of the files of Context.
+  @param[in,out] Pairings     The pairings to rate.
+  @param[in]     NumPairings  The number of elements in Pairings.
+*/
+static void ScRateOffloadBatch(
+  const sc_rating_context_t *Context,
+  const sc_offload_t        *Offload,
+  sc_context_pairing_t      *Pairings,
+  size_t                    NumPairings
+  )
+{
+  assert(Context != NULL);
+  assert(Offload != NULL);
+  assert(Pairings != NULL || NumPairings == 0);
+
+  SC_INSTRUMENT_PHASE_START(CompareTimer);
+  ScOffloadRatePairings(Offload, Pairings, NumPairings, Context->NumLinesSwap);
+  SC_INSTRUMENT_PHASE_STOP(CompareTimer, ScInstrumentPhaseCompare);
+
+  for (size_t PairingIndex = 0; PairingIndex < NumPairings; ++PairingIndex) {
+    ScRecordRating(
+      Context,
+      Pairings[PairingIndex].File1Index,
+      Pairings[PairingIndex].File2Index,
+      Pairings[PairingIndex].Score
+      );
+  }
+}
+
+/*
+  Rates all file pairings of Tiles on the OpenMP offload device. The files are
+  uploaded once, and the pairings are rated in batches of
+  SC_OFFLOAD_BATCH_SIZE. Without a device, the pairings are rated by the
+  threads of the host like with the default engine.
+
+  @param[in] Context   The rating context.
+  @param[in] Tiles     The tiles of file pairings to rate.
+  @param[in] NumTiles  The number of elements in Tiles.
+
+  @returns  Whether all pairings have been rated successfully.
+*/
+static bool ScRateTilesOffloaded(
+  const sc_rating_context_t *Context,
+  const sc_pair_tile_t      *Tiles,
+  size_t                    NumTiles
+  )
+{
+  assert(Context != NULL);
+  assert(Tiles != NULL || NumTiles == 0);
+  //
+  // The offload runtime would silently run the device code on a single host
+  // thread, which is far slower than the default engine.
+  //
+  bool HasDevice = false;
+#ifdef _OPENMP
+  HasDevice = omp_get_num_devices() > 0;
+#endif
+  if (!HasDevice) {
+    fprintf(
+      stderr,
+      "No offload device available, rating on the host instead\n"
+      );
+    ScRateTiles(Context, Tiles, NumTiles);
+    return true;
+  }
+
+  sc_context_pairing_t *Pairings = malloc(
+                                     SC_OFFLOAD_BATCH_SIZE * sizeof(*Pairings)
+                                     );
+  if (Pairings == NULL) {
+    return false;
+  }
+
+  sc_offload_t Offload;
+  const bool   Result = ScOffloadCreate(
+                          &Offload,
+                          Context->Files,
+                          Context->NumFiles
+                          );
+  if (!Result) {
+    free(Pairings);
+    return false;
+  }
+
+  size_t NumPairings = 0;
+  for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+    const sc_pair_tile_t *Tile = &Tiles[TileIndex];
+    for (
+      unsigned int File1Index = Tile->RowStart;
+      File1Index < Tile->RowEnd;
+      ++File1Index
+      ) {
+      for (
+        unsigned int File2Index = SC_MAX(Tile->ColumnStart, File1Index + 1U);
+        File2Index < Tile->ColumnEnd;
+        ++File2Index
+        ) {
+        Pairings[NumPairings].File1Index = File1Index;
+        Pairings[NumPairings].File2Index = File2Index;
+        ++NumPairings;
+
+        if (NumPairings == SC_OFFLOAD_BATCH_SIZE) {
+          ScRateOffloadBatch(Context, &Offload, Pairings, NumPairings);
+          NumPairings = 0;
+        }
+      }
+    }
+  }
+
+  ScRateOffloadBatch(Context, &Offload, Pairings, NumPairings);
+
+  ScOffloadFree(&Offload);
+  free(Pairings);
+  return true;
+}
+#endif
+
+/*
+  Rates all file pairings of the NumRowFiles leading files by the Jaccard
+  similarity of the winnowing fingerprints of the files. Hashes that occur in
+  many files are considered boilerplate and are disregarded.
+
+  @param[in] Context      The rating context.
+  @param[in] NumRowFiles  The number of leading files to rate the pairings of.
+
+  @returns  Whether all pairings have been rated successfully.
+*/
+static bool ScRateFilesWinnowed(
+  const sc_rating_context_t *Context,
+  unsigned int              NumRowFiles
+  )
+{
+  assert(Context != NULL);
+  assert(NumRowFiles <= Context->NumFiles);
+
+  const sc_main_options_t *Options  = Context->Options;
+  const sc_cleanse_file_t *Files    = Context->Files;
+  const unsigned int      NumFiles = Context->NumFiles;
+  //
+  // Pairings that share no indexed hash have a similarity of 0. Unless such
+  // ratings are output, only the pairings found through the index are
+  // recorded, and the match lists of top-K mode are output once all are.
+  //
+  const bool Sparse = Context->Ratings == NULL
+                   && (Options->TopMatches > 0 || Options->Threshold > 0);
+
+  sc_winnow_corpus_t Corpus;
+  if (!ScWinnowCorpusCreate(&Corpus, NumFiles)) {
+    return false;
+  }
+
+  bool Result = true;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    SC_INSTRUMENT_PHASE_START(SketchTimer);
+    const bool FingerprintResult = ScWinnowCorpusAddFile(
+                                     &Corpus,
+                                     FileIndex,
+                                     Files[FileIndex].Buffer,
+                                     Files[FileIndex].Length
+                                     );
+    SC_INSTRUMENT_PHASE_STOP(SketchTimer, ScInstrumentPhaseSketch);
+    //
+    // Result is not read within the parallel block and hence this write does
+    // not need to be atomic.
+    //
+    if (!FingerprintResult) {
+      Result = false;
+    }
+  }
+
+  if (Result) {
+    Result = ScWinnowCorpusIndex(&Corpus);
+  }
+
+  if (Result) {
+    #pragma omp parallel
+    {
+      sc_winnow_scan_t Scan;
+      const bool       Allocated = ScWinnowScanCreate(&Scan, &Corpus, Sparse);
+      //
+      // Files with many hashes are expensive, hence distribute them
+      // dynamically.
+      //
+      #pragma omp for schedule(dynamic, 1)
+      for (
+        unsigned int File1Index = 0;
+        File1Index < NumRowFiles;
+        ++File1Index
+        ) {
+        if (!Allocated) {
+          continue;
+        }
+
+        SC_INSTRUMENT_PHASE_START(CompareTimer);
+        const size_t NumSharing = ScWinnowScanFile(&Corpus, &Scan, File1Index);
+        for (
+          size_t SharingIndex = 0;
+          Sparse && SharingIndex < NumSharing;
+          ++SharingIndex
+          ) {
+          const unsigned int File2Index = Scan.Sharing[SharingIndex];
+          ScRecordRating(
+            Context,
+            File1Index,
+            File2Index,
+            ScWinnowScanRate(&Corpus, &Scan, File2Index)
+            );
+        }
+
+        for (
+          unsigned int File2Index = File1Index + 1U;
+          !Sparse && File2Index < NumFiles;
+          ++File2Index
+          ) {
+          ScRecordRating(
+            Context,
+            File1Index,
+            File2Index,
+            ScWinnowScanRate(&Corpus, &Scan, File2Index)
+            );
+        }
+
+        SC_INSTRUMENT_PHASE_STOP(CompareTimer, ScInstrumentPhaseCompare);
+      }
+
+      if (!Allocated) {
+        Result = false;
+      }
+
+      ScWinnowScanFree(&Scan);
+    }
+  }
+  //
+  // The match lists of files with unrecorded pairings are final once all
+  // pairings have been rated.
+  //
+  for (
+    unsigned int FileIndex = 0;
+    Result && Sparse && Options->TopMatches > 0 && FileIndex < NumFiles;
+    ++FileIndex
+    ) {
+    if (Context->TopMatches->NumPending[FileIndex] > 0) {
+      ScTopMatchesOutput(Context->TopMatches, Options, Files, FileIndex);
+    }
+  }
+
+  ScWinnowCorpusFree(&Corpus);
+  return Result;
+}
+
+/*
+  Reads and cleanses the input file at FileName into File and moves it to
+  Arena.
+
+  @param[in]     Options     The command line options of this tool.
+  @param[out]    File        The file to load. On failure, its Buffer is NULL.
+  @param[in]     FileName    The path of the file.
+  @param[in]     FileIndex   The index of FileName within the file paths.
+  @param[in]     Prefetched  Whether File has been read by ScLoadFile()
+                             already.
+  @param[in,out] Arena       The arena to move the cleansed file to.
+
+  @returns  Whether the file has been loaded successfully.
+*/
+static bool ScLoadInputFile(
+  const sc_main_options_t *Options,
+  sc_cleanse_file_t       *File,
+  const char              *FileName,
+  unsigned int            FileIndex,
+  bool                    Prefetched,
+  sc_arena_t              *Arena
+  )
+{
+  assert(Options != NULL);
+  assert(File != NULL);
+  assert(FileName != NULL);
+  assert(Arena != NULL);
+
+  bool Result;
+  if (Prefetched) {
+    Result = File->Buffer != NULL;
+  } else {
+    Result = ScLoadFile(File, FileName, Options->MaxFileSize, false);
+  }
+  //
+  // Always automatically detect the cleanse config for the moment.
+  //
+  if (Result) {
+    Result = ScCleanseLoadedFile(
+      File,
+      FileName,
+      ScCleanseConfigTypeMax,
+      mScCleanseMatchers,
+      Options->CacheDir
+      );
+  }
+  //
+  // Cleansing shortens lines, hence only apply the line length limit to the
+  // cleansed file.
+  //
+  if (Result && File->LinesInfo->MaxLineLength > Options->MaxLineLength) {
+    ScFreeCleansedFile(File);
+    Result = false;
+  }
+  //
+  // If the file cannot be moved, it keeps its own allocations.
+  //
+  if (Result) {
+    ScMoveCleansedFileToArena(File, Arena);
+  }
+  //
+  // Use the Reserved field to store the associated file name index.
+  //
+  File->Reserved = FileIndex;
+
+  if (!Result) {
+    #pragma omp critical
+    fprintf(stderr, "Cleansed read error: %s\n", FileName);
+    //
+    // File->Buffer == NULL iff reading or cleansing failed.
+    //
+    File->Buffer = NULL;
+  }
+
+  return Result;
+}
+
+/*
+  Loads the file with index FileIndex of the block with index BlockIndex in
+  budgeted mode, unless loading it has failed before.
+*/
+static void ScLoadBlockFile(
+  const sc_block_schedule_t *Schedule,
+  unsigned int              BlockIndex,
+  unsigned int              FileIndex
+  )
+{
+  assert(Schedule != NULL);
+  assert(BlockIndex < Schedule->NumBlocks);
+  assert(FileIndex >= Schedule->Blocks[BlockIndex].Start
+      && FileIndex < Schedule->Blocks[BlockIndex].End);
+
+  if (Schedule->Failed[FileIndex]) {
+    return;
+  }
+
+  unsigned int ArenaIndex = 0;
+#ifdef _OPENMP
+  ArenaIndex = (unsigned int) omp_get_thread_num();
+#endif
+  assert(ArenaIndex < Schedule->NumArenas);
+
+  const sc_rating_context_t *Context = Schedule->Context;
+  sc_cleanse_file_t         *File    = &Schedule->Files[FileIndex];
+  const bool                Result   = ScLoadInputFile(
+                                         Context->Options,
+                                         File,
+                                         Context->FileArgs[FileIndex],
+                                         FileIndex,
+                                         false,
+                                         &Schedule->Arenas[
+                                           (size_t) BlockIndex
+                                             * Schedule->NumArenas
+                                             + ArenaIndex
+                                           ]
+                                         );
+  Schedule->Failed[FileIndex] = !Result;
+
+  if (Result && Schedule->Sketches != NULL) {
+    ScSketchCleansedFile(&Schedule->Sketches[FileIndex], File);
+  }
+}
+
+/*
+  Frees all loaded files of the block with index BlockIndex in budgeted mode.
+*/
+static void ScEvictBlock(
+  const sc_block_schedule_t *Schedule,
+  unsigned int              BlockIndex
+  )
+{
+  assert(Schedule != NULL);
+  assert(BlockIndex < Schedule->NumBlocks);
+
+  const sc_file_block_t *Block = &Schedule->Blocks[BlockIndex];
+  for (
+    unsigned int FileIndex = Block->Start;
+    FileIndex < Block->End;
+    ++FileIndex
+    ) {
+    if (Schedule->Files[FileIndex].Buffer != NULL) {
+      ScFreeCleansedFile(&Schedule->Files[FileIndex]);
+      Schedule->Files[FileIndex].Buffer = NULL;
+    }
+  }
+
+  sc_arena_t *Arenas = &Schedule->Arenas[
+                         (size_t) BlockIndex * Schedule->NumArenas
+                         ];
+  for (
+    unsigned int ArenaIndex = 0;
+    ArenaIndex < Schedule->NumArenas;
+    ++ArenaIndex
+    ) {
+    ScArenaFree(&Arenas[ArenaIndex]);
+  }
+}
+
+/*
+  Rates the tiles of a step of budgeted mode while loading the blocks of the
+  next step.
+
+  @param[in] Schedule       The block schedule.
+  @param[in] Tiles          The tiles of the step.
+  @param[in] NumTiles       The number of elements in Tiles.
+  @param[in] LoadBlocks     The indices of the blocks to load.
+  @param[in] NumLoadBlocks  The number of elements in LoadBlocks.
+*/
+static void ScRateBlockStep(
+  const sc_block_schedule_t *Schedule,
+  const sc_pair_tile_t      *Tiles,
+  size_t                    NumTiles,
+  const unsigned int        *LoadBlocks,
+  unsigned int              NumLoadBlocks
+  )
+{
+  assert(Schedule != NULL);
+  assert(Tiles != NULL || NumTiles == 0);
+  assert(LoadBlocks != NULL || NumLoadBlocks == 0);
+  assert(NumLoadBlocks <= 2U);
+
+  size_t NumFirstLoads = 0;
+  size_t NumLoads      = 0;
+  for (unsigned int Index = 0; Index < NumLoadBlocks; ++Index) {
+    const sc_file_block_t *Block = &Schedule->Blocks[LoadBlocks[Index]];
+    NumLoads += Block->End - Block->Start;
+    if (Index == 0) {
+      NumFirstLoads = NumLoads;
+    }
+  }
+  //
+  // Interleave loading the next blocks with rating the current ones, so that
+  // I/O and cleansing overlap with the comparisons.
+  //
+  const size_t NumCommon = SC_MIN(NumTiles, NumLoads);
+  const size_t NumItems  = NumTiles + NumLoads;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t ItemIndex = 0; ItemIndex < NumItems; ++ItemIndex) {
+    bool   IsTile;
+    size_t Index;
+    if (ItemIndex < 2U * NumCommon) {
+      IsTile = ItemIndex % 2U == 0;
+      Index  = ItemIndex / 2U;
+    } else {
+      IsTile = NumTiles > NumCommon;
+      Index  = ItemIndex - NumCommon;
+    }
+
+    if (IsTile) {
+      ScRateTile(Schedule->Context, &Tiles[Index]);
+    } else {
+      const bool         First      = Index < NumFirstLoads;
+      const unsigned int BlockIndex = LoadBlocks[First ? 0 : 1];
+      const size_t       FileOffset = First ? Index : Index - NumFirstLoads;
+      ScLoadBlockFile(
+        Schedule,
+        BlockIndex,
+        Schedule->Blocks[BlockIndex].Start + (unsigned int) FileOffset
+        );
+    }
+  }
+}
+
+/*
+  Rates all file pairings block by block, so that at most
+  SC_MAX_RESIDENT_BLOCKS blocks are loaded at once. All files must be
+  unloaded and are unloaded again on return.
+
+  @param[in] Schedule     The block schedule.
+  @param[in] NumRowFiles  The number of leading query files.
+
+  @returns  Whether all pairings have been rated successfully.
+*/
+static bool ScRateFileBlocks(
+  const sc_block_schedule_t *Schedule,
+  unsigned int              NumRowFiles
+  )
+{
+  assert(Schedule != NULL);
+  assert(Schedule->NumBlocks > 0);
+
+  sc_file_block_steps_t Steps;
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS];
+  unsigned int          NumEvict;
+  unsigned int          Load[2];
+  unsigned int          NumLoad = ScFileBlocksStart(
+                                    &Steps,
+                                    Schedule->Blocks,
+                                    Schedule->NumBlocks,
+                                    NumRowFiles,
+                                    Load
+                                    );
+  ScRateBlockStep(Schedule, NULL, 0, Load, NumLoad);
+
+  bool         Result = true;
+  unsigned int Row;
+  unsigned int Column;
+  while (
+    ScFileBlocksNextStep(
+      &Steps,
+      &Row,
+      &Column,
+      Evict,
+      &NumEvict,
+      Load,
+      &NumLoad
+      )
+    ) {
+    for (unsigned int Index = 0; Index < NumEvict; ++Index) {
+      ScEvictBlock(Schedule, Evict[Index]);
+    }
+
+    const sc_file_block_t *RowBlock    = &Schedule->Blocks[Row];
+    const sc_file_block_t *ColumnBlock = &Schedule->Blocks[Column];
+    size_t                NumTiles;
+    unsigned int          TileSize;
+    sc_pair_tile_t        *Tiles       = ScCreatePairTiles(
+                                           Schedule->Files,
+                                           Schedule->Context->NumFiles,
+                                           RowBlock->Start,
+                                           SC_MIN(RowBlock->End, NumRowFiles),
+                                           ColumnBlock->Start,
+                                           ColumnBlock->End,
+                                           ScGetMinNumTiles(
+                                             Schedule->Context->Options
+                                             ),
+                                           &NumTiles,
+                                           &TileSize
+                                           );
+    if (Tiles == NULL) {
+      Result = false;
+      break;
+    }
+
+    ScRateBlockStep(Schedule, Tiles, NumTiles, Load, NumLoad);
+    free(Tiles);
+  }
+  if (!Result) {
+    NumEvict = ScFileBlocksStop(&Steps, Evict);
+  }
+
+  for (unsigned int Index = 0; Index < NumEvict; ++Index) {
+    ScEvictBlock(Schedule, Evict[Index]);
+  }
+
+  return Result;
+}
+
+/*
+  Rates all file pairings in budgeted mode, loading the files block by block
+  within the memory budget of Context->Options.
+
+  @param[in]  Context      The rating context.
+  @param[out] Files        The file list, which Context->Files refers to. No
+                           file must be loaded and none is loaded on return.
+  @param[out] Sketches     The pre-filter sketches of the files, which
+                           Context->Sketches refers to. It may be NULL.
+  @param[in]  NumRowFiles  The number of leading query files.
+  @param[in]  NumArenas    The number of threads that may load files.
+
+  @returns  Whether all pairings have been rated successfully.
+*/
+static bool ScRateFilesBudgeted(
+  const sc_rating_context_t *Context,
+  sc_cleanse_file_t         *Files,
+  sc_min_hash_t             *Sketches,
+  unsigned int              NumRowFiles,
+  unsigned int              NumArenas
+  )
+{
+  assert(Context != NULL);
+  assert(Context->Options->MemoryBudget > 0);
+  assert(Files != NULL);
+  assert(NumArenas > 0);
+
+  const sc_main_options_t *Options  = Context->Options;
+  const unsigned int      NumFiles  = Context->NumFiles;
+  sc_file_block_t         *Blocks   = malloc(NumFiles * sizeof(*Blocks));
+  bool                    *Failed   = calloc(NumFiles, sizeof(*Failed));
+  size_t                  *Sizes    = malloc(NumFiles * sizeof(*Sizes));
+  if (Blocks == NULL || Failed == NULL || Sizes == NULL) {
+    free(Blocks);
+    free(Failed);
+    free(Sizes);
+    return false;
+  }
+  //
+  // Files are only loaded by the schedule. Use the Reserved field to store
+  // the associated file name index.
+  //
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    Files[FileIndex].Buffer   = NULL;
+    Files[FileIndex].Reserved = FileIndex;
+  }
+  //
+  // The blocks being rated and loaded at once share the budget.
+  //
+  const uint64_t     BlockBudget = (uint64_t) Options->MemoryBudget
+                                     * 1024U * 1024U
+                                     / SC_MAX_RESIDENT_BLOCKS;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    if (!ScGetFileSize(Context->FileArgs[FileIndex], &Sizes[FileIndex])) {
+      Sizes[FileIndex] = SIZE_MAX;
+    }
+  }
+
+  const unsigned int NumBlocks   = ScFileBlocksPartition(
+                                     Sizes,
+                                     NumFiles,
+                                     Options->MaxFileSize,
+                                     BlockBudget,
+                                     Blocks
+                                     );
+  free(Sizes);
+
+  sc_arena_t *Arenas = NULL;
+  size_t     NumBlockArenas;
+  size_t     Size;
+  if (!ScSafeMulSize(NumBlocks, NumArenas, &NumBlockArenas)
+   && !ScSafeMulSize(NumBlockArenas, sizeof(*Arenas), &Size)) {
+    Arenas = malloc(Size);
+  }
+
+  if (Arenas == NULL) {
+    free(Blocks);
+    free(Failed);
+    return false;
+  }
+
+  for (size_t ArenaIndex = 0; ArenaIndex < NumBlockArenas; ++ArenaIndex) {
+    ScArenaInitialise(&Arenas[ArenaIndex]);
+  }
+
+  const sc_block_schedule_t Schedule = {
+    Context,
+    Files,
+    Sketches,
+    Failed,
+    Blocks,
+    NumBlocks,
+    Arenas,
+    NumArenas
+  };
+  const bool Result = ScRateFileBlocks(&Schedule, NumRowFiles);
+
+  free(Arenas);
+  free(Failed);
+  free(Blocks);
+
+  return Result;
+}
+
+/*
+  Reads and cleanses all input files. Files that cannot be loaded are
+  eliminated from the file list, unless the pairings are sharded.
+
+  @param[in]     Options       The command line options of this tool.
+  @param[out]    Files         The file list. On failure, the Buffer of the
+                               files that have not been loaded is NULL.
+  @param[in]     FileArgs      The input file paths.
+  @param[in,out] NumFiles      On input, the number of elements in FileArgs.
+                               On output, the number of elements in Files.
+  @param[in,out] NumRowFiles   On input, the number of leading query files.
+                               On output, the number of those loaded.
+  @param[out]    Sketches      The pre-filter sketches of the files, or NULL.
+  @param[out]    FileDomains   The NUMA domain that holds the data of every
+                               file, or NULL.
+  @param[in]     PlaceDomains  The NUMA domain of every OpenMP place, or NULL.
+  @param[in,out] Arenas        One arena for every thread to move its files
+                               to.
+  @param[in]     NumArenas     The number of elements in Arenas.
+
+  @returns  Whether the file list is complete enough to be rated.
+*/
+static bool ScLoadInputFiles(
+  const sc_main_options_t *Options,
+  sc_cleanse_file_t       *Files,
+  char *const             *FileArgs,
+  unsigned int            *NumFiles,
+  unsigned int            *NumRowFiles,
+  sc_min_hash_t           *Sketches,
+  unsigned int            *FileDomains,
+  const unsigned int      *PlaceDomains,
+  sc_arena_t              *Arenas,
+  unsigned int            NumArenas
+  )
+{
+  assert(Options != NULL);
+  assert(Files != NULL);
+  assert(FileArgs != NULL);
+  assert(NumFiles != NULL);
+  assert(NumRowFiles != NULL);
+  assert(Arenas != NULL);
+  //
+  // Silence the compiler for when asserts are disabled.
+  //
+  (void) NumArenas;
+
+  const unsigned int NumInputFiles = *NumFiles;
+  //
+  // In batched mode, start fetching all files before cleansing any, so that
+  // the storage can serve all requests concurrently.
+  //
+  if (Options->BatchIo) {
+    #pragma omp parallel for
+    for (unsigned int FileIndex = 0; FileIndex < NumInputFiles; ++FileIndex) {
+      ScLoadFile(
+        &Files[FileIndex],
+        FileArgs[FileIndex],
+        Options->MaxFileSize,
+        true
+        );
+    }
+  }
+
+  bool FilesResult = true;
+  #pragma omp parallel for
+  for (unsigned int FileIndex = 0; FileIndex < NumInputFiles; ++FileIndex) {
+    unsigned int ArenaIndex = 0;
+#ifdef _OPENMP
+    ArenaIndex = (unsigned int) omp_get_thread_num();
+#endif
+    assert(ArenaIndex < NumArenas);
+
+    const bool Result = ScLoadInputFile(
+                          Options,
+                          &Files[FileIndex],
+                          FileArgs[FileIndex],
+                          FileIndex,
+                          Options->BatchIo,
+                          &Arenas[ArenaIndex]
+                          );
+    if (FileDomains != NULL) {
+      FileDomains[FileIndex] = ScNumaGetThreadDomain(PlaceDomains);
+    }
+    //
+    // FilesResult is not read within the parallel block and hence this
+    // write does not need to be atomic.
+    //
+    if (!Result) {
+      FilesResult = false;
+    }
+  }
+  //
+  // All shards split the tiles by the costs of the same files. A shard that
+  // eliminated a file would select tiles of a different split, and merging
+  // would silently miss and duplicate pairings.
+  //
+  if (!FilesResult && Options->NumShards > 0) {
+    fprintf(stderr, "Shard input error: all input files must be loaded\n");
+    return false;
+  }
+  //
+  // If an error occured for any file reading or cleansing, eliminate the
+  // invalid entries. This is done in a separate step from reading to not
+  // harm parallelisation. As this is clearly a user error condition,
+  // performance is allowed to drop in such case.
+  //
+  if (!FilesResult) {
+    for (unsigned int FileIndex = 0; FileIndex < *NumFiles; ++FileIndex) {
+      if (Files[FileIndex].Buffer == NULL) {
+        //
+        // The query files stay the leading files.
+        //
+        if (FileIndex < *NumRowFiles) {
+          --(*NumRowFiles);
+        }
+
+        --(*NumFiles);
+        memmove(
+          &Files[FileIndex],
+          &Files[FileIndex + 1],
+          (*NumFiles - FileIndex) * sizeof(*Files)
+          );
+        if (FileDomains != NULL) {
+          memmove(
+            &FileDomains[FileIndex],
+            &FileDomains[FileIndex + 1],
+            (*NumFiles - FileIndex) * sizeof(*FileDomains)
+            );
+        }
+        --FileIndex;
+      }
+    }
+  }
+
+  if (Sketches != NULL) {
+    const unsigned int NumLoaded = *NumFiles;
+    #pragma omp parallel for
+    for (unsigned int FileIndex = 0; FileIndex < NumLoaded; ++FileIndex) {
+      ScSketchCleansedFile(&Sketches[FileIndex], &Files[FileIndex]);
+    }
+  }
+
+  return true;
+}
+
+/*
+  Splits the rating matrix into tiles to balance the load and, if the
+  pairings are sharded, selects the tiles of this shard.
+
+  @param[in]  Context       The rating context. Its ShardRatings are not used.
+  @param[in]  NumRowFiles   The number of leading query files.
+  @param[out] ShardRatings  On success, the ratings of the tiles of this
+                            shard. Its Ratings are NULL if ratings are not
+                            sharded or in top-K mode.
+  @param[out] NumTiles      On success, the number of returned tiles.
+
+  @retval NULL   An allocation error has occured.
+  @retval other  The tiles to rate. They are allocated with malloc and
+                 caller-owned.
+*/
+static sc_pair_tile_t *ScCreateRatingTiles(
+  const sc_rating_context_t *Context,
+  unsigned int              NumRowFiles,
+  sc_shard_ratings_t        *ShardRatings,
+  size_t                    *NumTiles
+  )
+{
+  assert(Context != NULL);
+  assert(ShardRatings != NULL);
+  assert(NumTiles != NULL);
+
+  const sc_main_options_t *Options = Context->Options;
+  const unsigned int      NumFiles = Context->NumFiles;
+  unsigned int            TileSize = 0;
+  sc_pair_tile_t          *Tiles   = ScCreatePairTiles(
+                                       Context->Files,
+                                       NumFiles,
+                                       0,
+                                       NumRowFiles,
+                                       0,
+                                       NumFiles,
+                                       ScGetMinNumTiles(Options),
+                                       NumTiles,
+                                       &TileSize
+                                       );
+  //
+  // Shards only rate their own tiles. In top-K mode, they only output the
+  // match lists of their own pairings, which the merge combines.
+  //
+  if (Tiles != NULL && Options->NumShards > 0) {
+    const bool ShardResult = ScShardSelectTiles(
+                               Tiles,
+                               *NumTiles,
+                               Options->ShardIndex,
+                               Options->NumShards,
+                               NumTiles
+                               );
+    if (!ShardResult) {
+      free(Tiles);
+      Tiles = NULL;
+    }
+  }
+
+  //
+  // Shards output the ratings of their tiles ordered by their files, so that
+  // merging their outputs only needs to stream them. In top-K mode, they
+  // output the match lists instead.
+  //
+  if (Tiles != NULL && Options->NumShards > 0 && Options->TopMatches == 0) {
+    const bool ShardResult = ScShardRatingsCreate(
+                               ShardRatings,
+                               Tiles,
+                               *NumTiles,
+                               TileSize,
+                               NumFiles,
+                               NumRowFiles
+                               );
+    if (!ShardResult) {
+      free(Tiles);
+      Tiles = NULL;
+    }
+  }
+
+  if (Tiles != NULL && Context->FileDomains != NULL) {
+    ScPairTilesAssignDomains(
+      Tiles,
+      *NumTiles,
+      Context->FileDomains,
+      Context->NumDomains
+      );
+  }
+
+  unsigned int *NumPending = Context->TopMatches->NumPending;
+  if (Tiles != NULL && Options->NumShards > 0 && NumPending != NULL) {
+    memset(NumPending, 0, NumFiles * sizeof(*NumPending));
+    for (size_t TileIndex = 0; TileIndex < *NumTiles; ++TileIndex) {
+      const sc_pair_tile_t *Tile = &Tiles[TileIndex];
+      for (
+        unsigned int File1Index = Tile->RowStart;
+        File1Index < Tile->RowEnd;
+        ++File1Index
+        ) {
+        for (
+          unsigned int File2Index = SC_MAX(Tile->ColumnStart, File1Index + 1U);
+          File2Index < Tile->ColumnEnd;
+          ++File2Index
+          ) {
+          ++NumPending[File1Index];
+          ++NumPending[File2Index];
+        }
+      }
+    }
+  }
+
+  return Tiles;
+}
+
+/*
+  Rates all file pairings with the engine of the command line options.
+
+  @param[in,out] Context      The rating context.
+  @param[in]     Tiles        The tiles to rate. They are unused by the
+                              winnowing engine and in budgeted mode.
+  @param[in]     NumTiles     The number of elements in Tiles.
+  @param[in,out] Files        The file list, which Context->Files refers to.
+  @param[in,out] Sketches     The pre-filter sketches of the files, which
+                              Context->Sketches refers to, or NULL.
+  @param[in]     NumRowFiles  The number of leading query files.
+  @param[in]     NumArenas    The number of arenas per block in budgeted mode.
+
+  @returns  Whether all pairings have been rated successfully.
+*/
+static bool ScRateFiles(
+  sc_rating_context_t  *Context,
+  const sc_pair_tile_t *Tiles,
+  size_t               NumTiles,
+  sc_cleanse_file_t    *Files,
+  sc_min_hash_t        *Sketches,
+  unsigned int         NumRowFiles,
+  unsigned int         NumArenas
+  )
+{
+  assert(Context != NULL);
+
+  const sc_main_options_t *Options = Context->Options;
+  if (Options->Engine == ScEngineWinnow) {
+    return ScRateFilesWinnowed(Context, NumRowFiles);
+  }
+
+#if SC_OFFLOAD
+  if (Options->Engine == ScEngineOffload) {
+    return ScRateTilesOffloaded(Context, Tiles, NumTiles);
+  }
+#endif
+
+  if (Options->MemoryBudget > 0) {
+    return ScRateFilesBudgeted(
+             Context,
+             Files,
+             Sketches,
+             NumRowFiles,
+             NumArenas
+             );
+  }
+
+  if (Options->RescoreFraction < 0) {
+    ScRateTiles(Context, Tiles, NumTiles);
+    return true;
+  }
+  //
+  // Rate all pairings with the coarse window first and only rate the best
+  // ones again with the full window. The pre-filter has been applied by the
+  // first pass already.
+  //
+  Context->NumLinesSwap = Options->CoarseNumLinesSwap;
+  ScRateTiles(Context, Tiles, NumTiles);
+
+  const bool Result = ScGetRescoreCutoff(
+                        Context->Ratings,
+                        Context->NumFiles,
+                        NumRowFiles,
+                        Options->RescoreFraction,
+                        &Context->RescoreCutoff
+                        );
+  //
+  // If no pairing is selected, the second pass only marks all as skipped.
+  //
+  if (Result) {
+    Context->NumLinesSwap = Options->NumLinesSwap;
+    Context->Sketches     = NULL;
+    ScRateTiles(Context, Tiles, NumTiles);
+  }
+
+  return Result;
+}
+
+/*
+  Outputs the ratings that have not been output while rating and completes
+  the output.
+
+  @param[in] Context      The rating context.
+  @param[in] NumRowFiles  The number of leading query files.
+
+  @returns  Whether the output has been written successfully.
+*/
+static bool ScWriteRatings(
+  const sc_rating_context_t *Context,
+  unsigned int              NumRowFiles
+  )
+{
+  assert(Context != NULL);
+
+  const sc_main_options_t *Options = Context->Options;
+  const sc_cleanse_file_t *Files   = Context->Files;
+  const unsigned int      NumFiles = Context->NumFiles;
+  double                  *Ratings = Context->Ratings;
+  bool                    Result   = true;
+
+  const unsigned int NumFilesMinus1      = NumFiles - 1;
+  const size_t       NumFilesMinus1Gauss = SC_GAUSS_SUM(NumFilesMinus1);
+  //
+  // Print the results separately from the distance loop to not harm
+  // parallelisation.
+  //
+  SC_INSTRUMENT_REGION_START(PrintMark);
+  SC_INSTRUMENT_PHASE_START(PrintTimer);
+
+  const bool OutputMatrix = Options->OutputFormat == ScOutputFormatMatrix;
+  if (Ratings != NULL && OutputMatrix) {
+    Result = ScWriteRatingsMatrix(
+               Options,
+               Files,
+               NumFiles,
+               NumRowFiles,
+               Ratings
+               );
+    if (!Result) {
+      fprintf(stderr, "Output error\n");
+    }
+  }
+
+  size_t DistIndex = 0;
+  for (
+    unsigned int File1Index = 0;
+    Ratings != NULL && !OutputMatrix && File1Index < NumRowFiles;
+    ++File1Index
+    ) {
+    //
+    // These constants are used in the assert below. They are declared in the
+    // same exact way as in the loop above to illustrate its correctness.
+    //
+    const unsigned int FilesLeft = NumFilesMinus1 - File1Index;
+    const size_t File1DistStart = NumFilesMinus1Gauss - SC_GAUSS_SUM(FilesLeft);
+    //
+    // Silence the compiler for when asserts are disabled.
+    //
+    (void) File1DistStart;
+    for (
+      unsigned int File2Index = File1Index + 1;
+      File2Index < NumFiles;
+      ++File2Index
+      ) {
+      //
+      // This implicitly sanitises the correctness of above's loop and ensures
+      // both stay in-sync in terms of data.
+      //
+      assert(DistIndex == File1DistStart + (File2Index - (File1Index + 1)));
+      double Rating = Ratings[DistIndex];
+      ++DistIndex;
+      //
+      // Pairings skipped by the second rating are not output, as their coarse
+      // ratings are not comparable to the others.
+      //
+      if (Rating == SC_RATING_SKIPPED) {
+        continue;
+      }
+      //
+      // Pruned pairings are reported as not similar.
+      //
+      if (Rating == SC_RATING_PRUNED) {
+        if (Options->OmitPruned) {
+          continue;
+        }
+
+        Rating = 0;
+      }
+      //
+      // The Reserved field is used to store the associated file name index.
+      //
+      ScOutputWriteRating(
+        stdout,
+        Options->OutputFormat,
+        Files[File1Index].Reserved,
+        Files[File2Index].Reserved,
+        Rating
+        );
+    }
+  }
+
+  if (Result && Context->ShardRatings != NULL) {
+    Result = ScWriteShardRatings(Options, Files, Context->ShardRatings);
+  }
+
+  if (Result) {
+    Result = ScFinishOutput();
+  }
+
+  SC_INSTRUMENT_PHASE_STOP(PrintTimer, ScInstrumentPhasePrint);
+  SC_INSTRUMENT_REGION_STOP(PrintMark, ScInstrumentRegionPrint);
+
+  return Result;
+}
+
+#if SC_INSTRUMENTATION
+/*
+  Reports the instrumentation once the output is complete, so that the report
+  covers all phases.
+
+  @param[in] Options  The command line options of this tool.
+*/
+static void ScReportInstrumentation(
+  const sc_main_options_t *Options
+  )
+{
+  assert(Options != NULL);
+
+  FILE *ReportStream = stderr;
+  if (Options->ReportPath != NULL) {
+    ReportStream = fopen(Options->ReportPath, "w");
+  }
+
+  if (ReportStream == NULL || !ScInstrumentReport(ReportStream)) {
+    fprintf(stderr, "Instrumentation report error\n");
+  }
+
+  if (ReportStream != NULL && ReportStream != stderr) {
+    fclose(ReportStream);
+  }
+}
+#endif
+
+bool ScRateInputFiles(
+  const sc_main_options_t *Options,
+  char *const             *FileArgs,
+  size_t                  NumInputFiles
+  )
+{
+  assert(Options != NULL);
+  assert(FileArgs != NULL);
+  assert(NumInputFiles >= 2);
+
+  ScCleanseMatchersInitialise(mScCleanseMatchers);
+  //
+  // Allocate, read and cleanse one file per path.
+  //
+  unsigned int NumFiles = (unsigned int) SC_MIN(NumInputFiles, UINT_MAX);
+  //
+  // Limit the amount of input files to prevent memory overflows.
+  //
+  if (NumInputFiles > SC_MAX_NUM_FILES) {
+    fprintf(
+      stderr,
+      "Truncated input files to %llu.\n",
+      (unsigned long long) SC_MAX_NUM_FILES
+      );
+    NumFiles = SC_MAX_NUM_FILES;
+  }
+  //
+  // SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) is safe because multiplications
+  // in one power of two space with at most one value being one larger than its
+  // maximum value cannot overflow in any space of a higher power of two.
+  //
+  // This ensures
+  //   1) SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) cannot overflow in size_t.
+  //   2) sizeof(*Files) * NumFiles cannot overflow in size_t.
+  //   3) sizeof(*Sketches) * NumFiles cannot overflow in size_t.
+  //
+  _Static_assert(
+    sizeof(sc_cleanse_file_t) <= UINT_MAX
+    && sizeof(sc_min_hash_t) <= UINT_MAX
+    && SC_MAX_NUM_FILES <= UINT32_MAX
+    && SC_GAUSS_SUM((uint64_t) SC_MAX_NUM_FILES) <= SIZE_MAX / sizeof(double),
+    "The memory arithmetics below may overflow."
+    );
+
+  sc_cleanse_file_t *Files = malloc(sizeof(*Files) * NumFiles);
+  //
+  // Only output files in the order of rating if requested. Otherwise, allocate
+  // the ratings result list. As NumFiles files must be cross-compared, its size
+  // is precisely the Gauss Sum of NumFiles - 1. If only the pairings of the
+  // query files are rated, only their leading rows of the ratings are
+  // required.
+  //
+  // Budgeted mode outputs all pairings as soon as they are rated, as holding
+  // all ratings would defeat the budget. Shards only rate a subset of the
+  // pairings, which are merged later.
+  //
+  const bool StreamRatings = Options->Threshold >= 0
+                          || Options->TopMatches > 0
+                          || Options->MemoryBudget > 0
+                          || Options->NumShards > 0;
+
+  unsigned int NumRowFiles = NumFiles;
+  if (Options->NumQueries > 0 && Options->NumQueries < NumFiles) {
+    NumRowFiles = Options->NumQueries;
+  }
+
+  double *Ratings = NULL;
+  if (!StreamRatings) {
+    Ratings = malloc(
+                ScGetNumRatedPairings(NumFiles, NumRowFiles) * sizeof(double)
+                );
+  }
+  //
+  // In top-K mode, only keep the best matches of every file, which grows
+  // linearly with NumFiles.
+  //
+  sc_top_matches_t TopMatches;
+  memset(&TopMatches, 0, sizeof(TopMatches));
+  bool TopResult = true;
+  if (Options->TopMatches > 0) {
+    TopResult = ScTopMatchesCreate(&TopMatches, NumFiles, Options->TopMatches);
+  }
+  //
+  // Sketch all files for the pre-filter to estimate their similarity cheaply.
+  //
+  sc_min_hash_t *Sketches = NULL;
+  if (Options->PrefilterCutoff >= 0) {
+    Sketches = malloc(sizeof(*Sketches) * NumFiles);
+  }
+  //
+  // Share one line pair distance cache among all comparisons, as cleansed
+  // files tend to have many lines in common.
+  //
+  sc_line_cache_t *LineCache = ScLineCacheCreate(SC_LINE_CACHE_SIZE_LOG2);
+  //
+  // Every thread moves the files it has cleansed to its own arena, so that
+  // they are stored contiguously without contention on the heap.
+  //
+  unsigned int NumArenas = 1;
+#ifdef _OPENMP
+  NumArenas = (unsigned int) omp_get_max_threads();
+#endif
+  sc_arena_t *Arenas = malloc(sizeof(*Arenas) * NumArenas);
+  if (Arenas != NULL) {
+    for (unsigned int ArenaIndex = 0; ArenaIndex < NumArenas; ++ArenaIndex) {
+      ScArenaInitialise(&Arenas[ArenaIndex]);
+    }
+  }
+  //
+  // The arenas are first touched by the threads that load their files, which
+  // places them on the threads' NUMA domains. If the threads are bound to
+  // multiple domains, record them to rate the pairings where their files are.
+  // Without this information, all threads share a single queue.
+  //
+  unsigned int NumDomains;
+  unsigned int *PlaceDomains = ScNumaCreatePlaceDomains(&NumDomains);
+  unsigned int *FileDomains  = NULL;
+  if (NumDomains > 1 && Options->MemoryBudget == 0) {
+    FileDomains = malloc(SC_MAX(NumFiles, 1U) * sizeof(*FileDomains));
+  }
+
+  //
+  // Every thread compares its pairings with its own scratch buffer, which is
+  // sized for the longest lines accepted rather than for the worst case.
+  //
+  const size_t PeqSize     = SC_LEVENSHTEIN_PEQ_SIZE(Options->MaxLineLength);
+  uint64_t     *PeqScratch = NULL;
+  if (Options->Engine != ScEngineWinnow) {
+    PeqScratch = calloc((size_t) NumArenas * PeqSize, sizeof(*PeqScratch));
+  }
+
+  sc_shard_ratings_t ShardRatings;
+  memset(&ShardRatings, 0, sizeof(ShardRatings));
+
+  bool Result = Files != NULL
+             && (StreamRatings || Ratings != NULL)
+             && TopResult
+             && (Options->PrefilterCutoff < 0 || Sketches != NULL)
+             && LineCache != NULL
+             && Arenas != NULL
+             && (Options->Engine == ScEngineWinnow || PeqScratch != NULL);
+  if (!Result) {
+    fprintf(stderr, "Allocation error\n");
+  }
+  //
+  // Records refer to the input file paths, hence their header is known before
+  // loading. The matrix refers to the loaded files.
+  //
+  if (Result
+   && Options->OutputFormat == ScOutputFormatRecords
+   && !ScOutputWriteHeader(
+         stdout,
+         Options->OutputFormat,
+         NumFiles,
+         NumRowFiles
+         )) {
+    fprintf(stderr, "Output error\n");
+    Result = false;
+  }
+
+  //
+  // In budgeted mode, the files are loaded and freed while rating instead.
+  //
+  const bool Initialised = Result;
+  const bool LoadFiles   = Initialised && Options->MemoryBudget == 0;
+  if (Initialised) {
+#if SC_INSTRUMENTATION
+    if (!ScInstrumentInitialise(NumArenas)) {
+      fprintf(stderr, "Instrumentation allocation error\n");
+    }
+#endif
+    //
+    // Read and cleanse all provided files.
+    //
+    SC_INSTRUMENT_REGION_START(LoadMark);
+    if (LoadFiles) {
+      Result = ScLoadInputFiles(
+                 Options,
+                 Files,
+                 FileArgs,
+                 &NumFiles,
+                 &NumRowFiles,
+                 Sketches,
+                 FileDomains,
+                 PlaceDomains,
+                 Arenas,
+                 NumArenas
+                 );
+    }
+
+    SC_INSTRUMENT_REGION_STOP(LoadMark, ScInstrumentRegionLoad);
+  }
+
+  //
+  // Query files are paired with all other files, while the remaining files are
+  // only paired with the query files.
+  //
+  if (Result && TopMatches.NumPending != NULL) {
+    for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+      TopMatches.NumPending[FileIndex] = FileIndex < NumRowFiles
+                                           ? NumFiles - 1U
+                                           : NumRowFiles;
+    }
+  }
+
+  sc_rating_context_t Context = {
+    Options,
+    Files,
+    FileArgs,
+    NumFiles,
+    Ratings,
+    &TopMatches,
+    NULL,
+    Sketches,
+    LineCache,
+    PeqScratch,
+    PeqSize,
+    Options->NumLinesSwap,
+    -1.0,
+    FileDomains,
+    NumDomains,
+    PlaceDomains
+  };
+  //
+  // Split the rating matrix into tiles to balance the load. Budgeted mode
+  // splits every step separately.
+  //
+  size_t         NumTiles = 0;
+  sc_pair_tile_t *Tiles   = NULL;
+  if (Result
+   && Options->MemoryBudget == 0
+   && Options->Engine != ScEngineWinnow) {
+    Tiles = ScCreateRatingTiles(
+              &Context,
+              NumRowFiles,
+              &ShardRatings,
+              &NumTiles
+              );
+    if (Tiles == NULL) {
+      fprintf(stderr, "Allocation error\n");
+      Result = false;
+    }
+  }
+
+  if (Result) {
+    if (ShardRatings.Ratings != NULL) {
+      Context.ShardRatings = &ShardRatings;
+    }
+    //
+    // Cross-compare all files and store their ratings.
+    //
+    SC_INSTRUMENT_REGION_START(CompareMark);
+    Result = ScRateFiles(
+               &Context,
+               Tiles,
+               NumTiles,
+               Files,
+               Sketches,
+               NumRowFiles,
+               NumArenas
+               );
+    free(Tiles);
+
+    SC_INSTRUMENT_REGION_STOP(CompareMark, ScInstrumentRegionCompare);
+
+    if (!Result) {
+      fprintf(stderr, "Allocation error\n");
+    } else {
+      Result = ScWriteRatings(&Context, NumRowFiles);
+    }
+
+#if SC_INSTRUMENTATION
+    ScReportInstrumentation(Options);
+#endif
+  }
+
+#if SC_INSTRUMENTATION
+  if (Initialised) {
+    ScInstrumentFree();
+  }
+#endif
+  //
+  // Free all allocated files and information structures. Only files that
+  // could not be moved to an arena are freed individually. Files that failed
+  // to load are only kept in shard mode. Budgeted mode has freed all files
+  // already.
+  //
+  for (
+    unsigned int FileIndex = 0;
+    LoadFiles && FileIndex < NumFiles;
+    ++FileIndex
+    ) {
+    if (Files[FileIndex].Buffer != NULL) {
+      ScFreeCleansedFile(&Files[FileIndex]);
+    }
+  }
+
+  for (
+    unsigned int ArenaIndex = 0;
+    Arenas != NULL && ArenaIndex < NumArenas;
+    ++ArenaIndex
+    ) {
+    ScArenaFree(&Arenas[ArenaIndex]);
+  }
+
+  free(Arenas);
+  free(FileDomains);
+  free(PlaceDomains);
+
+  free(Sketches);
+  free(LineCache);
+  free(PeqScratch);
+  ScTopMatchesFree(&TopMatches);
+  ScShardRatingsFree(&ShardRatings);
+  free(Ratings);
+  free(Files);
+
+  return Result;
+}
@@ -0,0 +1,32 @@
+/*@file
+  Provides the rating of all file pairings of the similarity checker tool.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_RATING_H_
+#define SC_RATING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ScMainOptions.h"
+
+/*
+  Loads the input files, rates their pairings as configured by Options and
+  outputs the ratings to stdout. Files that cannot be loaded are skipped.
+
+  @param[in] Options        The command line options of this tool.
+  @param[in] FileArgs       The input file paths.
+  @param[in] NumInputFiles  The number of elements in FileArgs. It must be at
+                            least 2.
+
+  @returns  Whether all pairings have been rated and output successfully.
+*/
+bool ScRateInputFiles(
+  const sc_main_options_t *Options,
+  char *const             *FileArgs,
+  size_t                  NumInputFiles
+  );
+
+#endif // SC_RATING_H_
@@ -6,20 +6,61 @@
 */
 
 #include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <ScCleanseConfigs.h>
+#include <ScCleanseInput.h>
 #include <ScDistances.h>
+#include <ScFileBlocks.h>
+#include <ScFileIo.h>
+#include <ScLineCache.h>
+#include <ScMinHash.h>
+#include <ScNuma.h>
+#include <ScOutput.h>
+#include <ScPairTiles.h>
+#include <ScRescore.h>
+#include <ScSafeInt.h>
+#include <ScShard.h>
+#include <ScSimilarityChecker.h>
+#include <ScStringMisc.h>
+#include <ScTopMatches.h>
+#include <ScWinnow.h>
 
 #include "ScCommon.h"
 
+///
+/// The first Levenshtein Matrix row required for ScLevenshteinDistance().
+///
+static size_t mScUnitTestMatrixInit[SC_MAX_LINE_LENGTH];
+
 ///
 /// The Levenshtein Matrix scratch buffer required for ScLevenshteinDistance().
 ///
 static size_t mScUnitTestMatrixScratch[SC_MAX_LINE_LENGTH];
 
+///
+/// The bit-parallel scratch buffer required for
+/// ScLevenshteinDistanceBitParallel().
+///
+static uint64_t mScUnitTestPeqScratch[
+  SC_LEVENSHTEIN_PEQ_SIZE(SC_MAX_LINE_LENGTH)
+  ];
+
+///
+/// The compiled pattern buffer required for
+/// ScLevenshteinDistanceCompiledBatch().
+///
+static sc_levenshtein_peq_entry_t mScUnitTestPeqEntries[SC_MAX_LINE_LENGTH];
+
 /*
-  Performs a unit test of ScLevenshteinDistance() with prepared inputs.
+  Performs a unit test of ScLevenshteinDistance(),
+  ScLevenshteinDistanceBitParallel() and ScLevenshteinDistanceCompiledBatch()
+  with prepared inputs.
   The result of this test is printed to stdout.
 
   @param[in] String1           The first string to compare. It needs to be
@@ -40,7 +81,7 @@ static void ScUnitTestLevenshtein(
       || ExpectedDistance <= strlen(String2));
 
   size_t Distance = ScLevenshteinDistance(
-    mScLevenshteinMatrixInit,
+    mScUnitTestMatrixInit,
     mScUnitTestMatrixScratch,
     String1,
     strlen(String1),
@@ -58,15 +99,1542 @@ static void ScUnitTestLevenshtein(
     return;
   }
 
+  Distance = ScLevenshteinDistanceBitParallel(
+    mScUnitTestPeqScratch,
+    String1,
+    strlen(String1),
+    String2,
+    strlen(String2)
+    );
+  if (Distance != ExpectedDistance) {
+    printf(
+      "FAILURE[\"%s\", \"%s\"]! Expected %zu, got %zu (bit-parallel).\n",
+      String1,
+      String2,
+      ExpectedDistance,
+      Distance
+      );
+    return;
+  }
+
+  //
+  // Compare the same text once without and once with a limit below the
+  // distance, which must be reported as exceeded.
+  //
+  const size_t NumEntries = ScLevenshteinPeqCompile(
+                              mScUnitTestPeqScratch,
+                              mScUnitTestPeqEntries,
+                              String1,
+                              strlen(String1)
+                              );
+  const sc_levenshtein_text_t Texts[] = {
+    { String2, strlen(String2), SIZE_MAX },
+    { String2, strlen(String2), ExpectedDistance - 1U }
+    };
+  size_t Distances[SC_ARRAY_LEN(Texts)];
+  ScLevenshteinDistanceCompiledBatch(
+    mScUnitTestPeqScratch,
+    mScUnitTestPeqEntries,
+    NumEntries,
+    strlen(String1),
+    Texts,
+    ExpectedDistance > 0 ? 2U : 1U,
+    Distances
+    );
+  if (Distances[0] != ExpectedDistance
+   || (ExpectedDistance > 0 && Distances[1] < ExpectedDistance)) {
+    printf(
+      "FAILURE[\"%s\", \"%s\"]! Expected %zu, got %zu (batched).\n",
+      String1,
+      String2,
+      ExpectedDistance,
+      Distances[0]
+      );
+    return;
+  }
+
+  uint8_t Histogram1[SC_LEVENSHTEIN_HISTOGRAM_SIZE];
+  uint8_t Histogram2[SC_LEVENSHTEIN_HISTOGRAM_SIZE];
+  ScLevenshteinHistogramInitialise(Histogram1, String1, strlen(String1));
+  ScLevenshteinHistogramInitialise(Histogram2, String2, strlen(String2));
+  const size_t Bound = ScLevenshteinHistogramBound(Histogram1, Histogram2);
+  if (Bound > ExpectedDistance) {
+    printf(
+      "FAILURE[\"%s\", \"%s\"]! Lower bound %zu exceeds %zu.\n",
+      String1,
+      String2,
+      Bound,
+      ExpectedDistance
+      );
+    return;
+  }
+
   printf("SUCCESS[\"%s\", \"%s\"]!\n", String1, String2);
 }
 
+/*
+  Performs a unit test of the line pair distance cache.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestLineCache(void)
+{
+  sc_line_cache_t *Cache = ScLineCacheCreate(4);
+  if (Cache == NULL) {
+    printf("FAILURE[LineCache]! Allocation error.\n");
+    return;
+  }
+
+  const uint64_t Hash1 = ScStrHash64("House", strlen("House"));
+  const uint64_t Hash2 = ScStrHash64("Mouse", strlen("Mouse"));
+
+  size_t Distance;
+  bool   Exact;
+  bool   Found = ScLineCacheLookup(Cache, Hash1, Hash2, &Distance, &Exact);
+  if (Found) {
+    printf("FAILURE[LineCache]! Found a distance in an empty cache.\n");
+    free(Cache);
+    return;
+  }
+
+  ScLineCacheInsert(Cache, Hash1, Hash2, 1, true);
+  //
+  // The distance is symmetric, hence the order of the hashes is irrelevant.
+  //
+  Found = ScLineCacheLookup(Cache, Hash2, Hash1, &Distance, &Exact);
+  if (!Found || Distance != 1 || !Exact) {
+    printf("FAILURE[LineCache]! The cached distance was not found.\n");
+    free(Cache);
+    return;
+  }
+
+  free(Cache);
+  printf("SUCCESS[LineCache]!\n");
+}
+
+/*
+  Performs a unit test of the MinHash similarity estimate with partially
+  overlapping sets of hashes.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestMinHash(void)
+{
+  sc_min_hash_t Sketch1;
+  sc_min_hash_t Sketch2;
+  ScMinHashInitialise(&Sketch1);
+  ScMinHashInitialise(&Sketch2);
+
+  for (uint64_t Index = 0; Index < 1000; ++Index) {
+    const uint64_t Hash1 = ScStrHash64((const char *) &Index, sizeof(Index));
+    const uint64_t Index2 = Index + 500;
+    const uint64_t Hash2 = ScStrHash64((const char *) &Index2, sizeof(Index2));
+    ScMinHashAdd(&Sketch1, Hash1);
+    ScMinHashAdd(&Sketch2, Hash2);
+  }
+
+  if (ScMinHashSimilarity(&Sketch1, &Sketch1) != 1) {
+    printf("FAILURE[MinHash]! Identical sets are not similar.\n");
+    return;
+  }
+  //
+  // The Jaccard similarity is 500 / 1500. Allow for a generous error to not
+  // depend on the particular hash function.
+  //
+  const double Similarity = ScMinHashSimilarity(&Sketch1, &Sketch2);
+  if (Similarity < 0.1 || Similarity > 0.6) {
+    printf("FAILURE[MinHash]! Estimated %f instead of 0.33.\n", Similarity);
+    return;
+  }
+
+  printf("SUCCESS[MinHash]!\n");
+}
+
+/*
+  Performs a unit test of the winnowing fingerprints, their index and the
+  corpus ratings with a buffer, a copy of it with line breaks and an unrelated
+  buffer.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestWinnow(void)
+{
+  char     Buffers[3][512];
+  uint32_t State = 1;
+  for (size_t Index = 0; Index < sizeof(Buffers[0]); ++Index) {
+    State             = State * 1103515245U + 12345U;
+    Buffers[0][Index] = (char) ('a' + (State >> 16U) % 26U);
+    State             = State * 1103515245U + 12345U;
+    Buffers[2][Index] = (char) ('a' + (State >> 16U) % 26U);
+  }
+  //
+  // Line breaks must not change the fingerprint.
+  //
+  size_t Length1 = 0;
+  for (size_t Index = 0; Index < sizeof(Buffers[0]) - 64U; ++Index) {
+    if (Index % 8U == 0) {
+      Buffers[1][Length1] = '\n';
+      ++Length1;
+    }
+
+    Buffers[1][Length1] = Buffers[0][Index];
+    ++Length1;
+  }
+
+  const size_t Lengths[3] = {
+    sizeof(Buffers[0]) - 64U,
+    Length1,
+    sizeof(Buffers[2])
+  };
+
+  sc_winnow_fingerprint_t Fingerprints[3];
+  for (size_t Index = 0; Index < 3; ++Index) {
+    const bool FingerprintResult = ScWinnowFingerprint(
+                                     &Fingerprints[Index],
+                                     Buffers[Index],
+                                     Lengths[Index]
+                                     );
+    if (!FingerprintResult) {
+      for (size_t FreeIndex = 0; FreeIndex < Index; ++FreeIndex) {
+        ScWinnowFreeFingerprint(&Fingerprints[FreeIndex]);
+      }
+
+      printf("FAILURE[Winnow]! Allocation error.\n");
+      return;
+    }
+  }
+
+  const bool Equal = Fingerprints[0].NumHashes == Fingerprints[1].NumHashes
+                  && memcmp(
+                       Fingerprints[0].Hashes,
+                       Fingerprints[1].Hashes,
+                       Fingerprints[0].NumHashes * sizeof(uint64_t)
+                       ) == 0;
+
+  sc_winnow_index_t WinnowIndex;
+  uint32_t          Counts[3]  = { 0, 0, 0 };
+  unsigned int      Sharing[2] = { 0, 0 };
+  size_t            NumSharing = 0;
+  size_t            NumIndexed = 0;
+  const bool        Result     = ScWinnowCreateIndex(
+                                   &WinnowIndex,
+                                   Fingerprints,
+                                   3,
+                                   3
+                                   );
+  if (Result) {
+    NumIndexed = ScWinnowCountShared(
+                   &WinnowIndex,
+                   &Fingerprints[0],
+                   0,
+                   Counts,
+                   Sharing,
+                   &NumSharing
+                   );
+    ScWinnowFreeIndex(&WinnowIndex);
+  }
+
+  for (size_t Index = 0; Index < 3; ++Index) {
+    ScWinnowFreeFingerprint(&Fingerprints[Index]);
+  }
+
+  if (!Result) {
+    printf("FAILURE[Winnow]! Allocation error.\n");
+    return;
+  }
+
+  if (!Equal || NumIndexed == 0 || Counts[1] != NumIndexed) {
+    printf("FAILURE[Winnow]! Line breaks changed the fingerprint.\n");
+    return;
+  }
+
+  if (Counts[0] != 0 || Counts[2] != 0) {
+    printf("FAILURE[Winnow]! Unrelated buffers share hashes.\n");
+    return;
+  }
+
+  if (NumSharing != 1 || Sharing[0] != 1) {
+    printf("FAILURE[Winnow]! The sharing files are wrong.\n");
+    return;
+  }
+  //
+  // Sparse scans only rate the sharing files, dense scans rate all, and both
+  // reset the counters for the next file.
+  //
+  sc_winnow_corpus_t Corpus;
+  sc_winnow_scan_t   SparseScan;
+  sc_winnow_scan_t   DenseScan;
+  if (!ScWinnowCorpusCreate(&Corpus, 3)) {
+    printf("FAILURE[Winnow]! Allocation error.\n");
+    return;
+  }
+
+  bool CorpusResult = true;
+  for (unsigned int Index = 0; CorpusResult && Index < 3; ++Index) {
+    CorpusResult = ScWinnowCorpusAddFile(
+                     &Corpus,
+                     Index,
+                     Buffers[Index],
+                     Lengths[Index]
+                     );
+  }
+
+  const bool SparseResult = ScWinnowScanCreate(&SparseScan, &Corpus, true);
+  const bool DenseResult  = ScWinnowScanCreate(&DenseScan, &Corpus, false);
+  CorpusResult = CorpusResult
+              && SparseResult
+              && DenseResult
+              && ScWinnowCorpusIndex(&Corpus);
+  bool Rated = false;
+  if (CorpusResult) {
+    Rated = ScWinnowScanFile(&Corpus, &SparseScan, 0) == 1
+         && SparseScan.Sharing[0] == 1
+         && ScWinnowScanRate(&Corpus, &SparseScan, 1) == 1.0
+         && ScWinnowScanFile(&Corpus, &SparseScan, 1) == 0
+         && ScWinnowScanFile(&Corpus, &DenseScan, 0) == 0
+         && ScWinnowScanRate(&Corpus, &DenseScan, 1) == 1.0
+         && ScWinnowScanRate(&Corpus, &DenseScan, 2) == 0
+         && ScWinnowScanFile(&Corpus, &DenseScan, 1) == 0
+         && ScWinnowScanRate(&Corpus, &DenseScan, 2) == 0;
+  }
+
+  ScWinnowScanFree(&SparseScan);
+  ScWinnowScanFree(&DenseScan);
+  ScWinnowCorpusFree(&Corpus);
+  if (!CorpusResult) {
+    printf("FAILURE[Winnow]! Allocation error.\n");
+    return;
+  }
+
+  if (!Rated) {
+    printf("FAILURE[Winnow]! Wrong corpus ratings.\n");
+    return;
+  }
+
+  printf("SUCCESS[Winnow]!\n");
+}
+
+/*
+  Performs a unit test of the bounded match lists of four files with two
+  matches each. Every list must become final with its last pairing and hold
+  its best matches, ties resolved in favour of the lower file index.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestTopMatches(void)
+{
+  static const struct {
+    unsigned int File1Index;
+    unsigned int File2Index;
+    double       Score;
+    bool         Valid;
+    unsigned int NumFinal;
+  } Pairings[] = {
+    { 0, 1, 0.5, true,  0 },
+    { 0, 2, 0.9, true,  0 },
+    { 0, 3, 0.5, true,  1 },
+    { 1, 2, 0.7, true,  0 },
+    { 1, 3, 0.2, false, 1 },
+    { 2, 3, 0.9, true,  2 }
+  };
+  //
+  // The expected final lists, best match first.
+  //
+  static const sc_match_t Expected[4][2] = {
+    { { 0.9, 2 }, { 0.5, 1 } },
+    { { 0.7, 2 }, { 0.5, 0 } },
+    { { 0.9, 0 }, { 0.9, 3 } },
+    { { 0.9, 2 }, { 0.5, 0 } }
+  };
+
+  sc_top_matches_t TopMatches;
+  if (!ScTopMatchesCreate(&TopMatches, 4, 2)) {
+    printf("FAILURE[TopMatches]! Allocation error.\n");
+    ScTopMatchesFree(&TopMatches);
+    return;
+  }
+
+  for (unsigned int FileIndex = 0; FileIndex < 4; ++FileIndex) {
+    TopMatches.NumPending[FileIndex] = 3;
+  }
+
+  unsigned int NumFinalised = 0;
+  for (size_t Index = 0; Index < SC_ARRAY_LEN(Pairings); ++Index) {
+    unsigned int       Final[2];
+    const unsigned int NumFinal = ScTopMatchesAdd(
+                                    &TopMatches,
+                                    Pairings[Index].File1Index,
+                                    Pairings[Index].File2Index,
+                                    Pairings[Index].Score,
+                                    Pairings[Index].Valid,
+                                    Final
+                                    );
+    if (NumFinal != Pairings[Index].NumFinal) {
+      printf("FAILURE[TopMatches]! Pairing %zu finalised lists.\n", Index);
+      ScTopMatchesFree(&TopMatches);
+      return;
+    }
+
+    for (unsigned int FinalIndex = 0; FinalIndex < NumFinal; ++FinalIndex) {
+      const unsigned int FileIndex = Final[FinalIndex];
+      if (FileIndex != NumFinalised) {
+        printf("FAILURE[TopMatches]! File %u was finalised.\n", FileIndex);
+        ScTopMatchesFree(&TopMatches);
+        return;
+      }
+
+      unsigned int      NumMatches;
+      const sc_match_t *Matches = ScTopMatchesFinalise(
+                                    &TopMatches,
+                                    FileIndex,
+                                    &NumMatches
+                                    );
+      if (NumMatches != 2) {
+        printf("FAILURE[TopMatches]! File %u has no 2 matches.\n", FileIndex);
+        ScTopMatchesFree(&TopMatches);
+        return;
+      }
+
+      for (unsigned int MatchIndex = 0; MatchIndex < NumMatches; ++MatchIndex) {
+        const sc_match_t *Match = &Expected[FileIndex][MatchIndex];
+        if (Matches[MatchIndex].Score != Match->Score
+         || Matches[MatchIndex].FileIndex != Match->FileIndex) {
+          printf("FAILURE[TopMatches]! Wrong matches of file %u.\n", FileIndex);
+          ScTopMatchesFree(&TopMatches);
+          return;
+        }
+      }
+
+      ++NumFinalised;
+    }
+  }
+
+  ScTopMatchesFree(&TopMatches);
+
+  if (NumFinalised != 4) {
+    printf("FAILURE[TopMatches]! Not all lists were finalised.\n");
+    return;
+  }
+
+  printf("SUCCESS[TopMatches]!\n");
+}
+
+/*
+  Compares two ratings for sorting them in ascending order.
+*/
+static int ScUnitTestCompareRatings(
+  const void *Rating1,
+  const void *Rating2
+  )
+{
+  const double Value1 = *(const double *) Rating1;
+  const double Value2 = *(const double *) Rating2;
+  return (Value1 > Value2) - (Value1 < Value2);
+}
+
+/*
+  Performs a unit test of the rescoring cutoff over the ratings of the query
+  rows of different file lists. The ratings are allocated to hold exactly the
+  rated pairings, so that the sanitizers detect reading past them. The cutoff
+  must equal the one of a sorted reference of the rated pairings.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestRescore(void)
+{
+  static const struct {
+    unsigned int NumFiles;
+    unsigned int NumRowFiles;
+    double       Fraction;
+  } Cases[] = {
+    { 2,  2,  1.0  },
+    { 5,  5,  0.3  },
+    { 7,  3,  0.5  },
+    { 7,  7,  0.1  },
+    { 12, 1,  0.25 },
+    { 12, 12, 0.0  },
+    { 60, 60, 0.1  }
+  };
+
+  for (size_t CaseIndex = 0; CaseIndex < SC_ARRAY_LEN(Cases); ++CaseIndex) {
+    const unsigned int NumFiles    = Cases[CaseIndex].NumFiles;
+    const unsigned int NumRowFiles = Cases[CaseIndex].NumRowFiles;
+    //
+    // Count the rated pairings independently from the module.
+    //
+    size_t NumRatings = 0;
+    for (unsigned int File1Index = 0; File1Index < NumRowFiles; ++File1Index) {
+      NumRatings += NumFiles - 1U - File1Index;
+    }
+
+    if (ScGetNumRatedPairings(NumFiles, NumRowFiles) != NumRatings) {
+      printf("FAILURE[Rescore]! Case %zu counted pairings.\n", CaseIndex);
+      return;
+    }
+
+    double *Ratings = malloc(NumRatings * sizeof(*Ratings));
+    double *Sorted  = malloc(NumRatings * sizeof(*Sorted));
+    if (Ratings == NULL || Sorted == NULL) {
+      printf("FAILURE[Rescore]! Allocation error.\n");
+      free(Ratings);
+      free(Sorted);
+      return;
+    }
+    //
+    // Mix valid ratings with pruned, skipped and failed ones.
+    //
+    size_t NumScores = 0;
+    for (size_t Index = 0; Index < NumRatings; ++Index) {
+      if (Index % 7U == 3U) {
+        Ratings[Index] = -1.0;
+      } else if (Index % 11U == 5U) {
+        Ratings[Index] = (double) INFINITY;
+      } else {
+        Ratings[Index] = (double) ((Index * 37U) % 101U) / 100.0;
+        Sorted[NumScores] = Ratings[Index];
+        ++NumScores;
+      }
+    }
+
+    qsort(Sorted, NumScores, sizeof(*Sorted), ScUnitTestCompareRatings);
+
+    const double Selected    = Cases[CaseIndex].Fraction * (double) NumScores;
+    size_t       NumSelected = (size_t) Selected;
+    if ((double) NumSelected < Selected) {
+      ++NumSelected;
+    }
+
+    const double Expected = NumSelected == 0
+                              ? (double) INFINITY
+                              : Sorted[NumScores - NumSelected];
+
+    double     Cutoff;
+    const bool Result = ScGetRescoreCutoff(
+                          Ratings,
+                          NumFiles,
+                          NumRowFiles,
+                          Cases[CaseIndex].Fraction,
+                          &Cutoff
+                          );
+    free(Ratings);
+    free(Sorted);
+
+    if (!Result || Cutoff != Expected) {
+      printf(
+        "FAILURE[Rescore]! Case %zu selected %f instead of %f.\n",
+        CaseIndex,
+        Cutoff,
+        Expected
+        );
+      return;
+    }
+  }
+
+  printf("SUCCESS[Rescore]!\n");
+}
+
+/*
+  Performs a unit test of the parser of system ID lists, e.g. sysfs cpulists.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestIdRanges(void)
+{
+  static const struct {
+    const char    *List;
+    unsigned int  NumRanges;
+    unsigned long Ranges[2][2];
+  } Lists[] = {
+    { "0-3,8-11", 2, { { 0, 3 }, { 8, 11 } } },
+    { "5",        1, { { 5, 5 } } },
+    { "0-3\n",    1, { { 0, 3 } } },
+    { "2,4-4",    2, { { 2, 2 }, { 4, 4 } } },
+    { "",         0, { { 0 } } },
+    { "\n",       0, { { 0 } } },
+    { "3-1",      0, { { 0 } } },
+    { "1-",       0, { { 0 } } },
+    { "-1",       0, { { 0 } } }
+  };
+
+  for (size_t Index = 0; Index < SC_ARRAY_LEN(Lists); ++Index) {
+    const char    *Pos      = Lists[Index].List;
+    unsigned int  NumRanges = 0;
+    unsigned long First;
+    unsigned long Last;
+    while (ScNumaParseIdRange(&Pos, &First, &Last)) {
+      if (NumRanges >= Lists[Index].NumRanges
+       || First != Lists[Index].Ranges[NumRanges][0]
+       || Last != Lists[Index].Ranges[NumRanges][1]) {
+        printf("FAILURE[IdRanges]! Misparsed \"%s\".\n", Lists[Index].List);
+        return;
+      }
+
+      ++NumRanges;
+    }
+
+    if (NumRanges != Lists[Index].NumRanges) {
+      printf("FAILURE[IdRanges]! Misparsed \"%s\".\n", Lists[Index].List);
+      return;
+    }
+  }
+  //
+  // Without a place map, all threads share the first domain.
+  //
+  if (ScNumaGetThreadDomain(NULL) != 0) {
+    printf("FAILURE[IdRanges]! Unbound threads have a domain.\n");
+    return;
+  }
+
+  printf("SUCCESS[IdRanges]!\n");
+}
+
+/*
+  Performs a unit test of the tiles of the rating matrix. Every pairing of
+  their files must be covered exactly once, and a thread must take the tiles
+  of its own domain first.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestPairTiles(void)
+{
+  static const struct {
+    unsigned int RowStart;
+    unsigned int RowEnd;
+    unsigned int ColumnStart;
+    unsigned int ColumnEnd;
+    size_t       MinNumTiles;
+  } Ranges[] = {
+    { 0,  37, 0,  37, 8  },
+    { 0,  5,  0,  37, 4  },
+    { 0,  10, 20, 37, 64 },
+    { 20, 37, 0,  37, 1  }
+  };
+
+  sc_tile_file_t Files[37];
+  unsigned int   FileDomains[37];
+  uint8_t        Covered[37][37];
+  for (unsigned int FileIndex = 0; FileIndex < 37; ++FileIndex) {
+    Files[FileIndex].NumLines = FileIndex % 5U;
+    Files[FileIndex].Length   = 10U * FileIndex;
+    FileDomains[FileIndex]    = FileIndex < 18 ? 0 : 1;
+  }
+
+  for (size_t Index = 0; Index < SC_ARRAY_LEN(Ranges); ++Index) {
+    size_t         NumTiles;
+    unsigned int   TileSize;
+    sc_pair_tile_t *Tiles = ScPairTilesCreate(
+                              Files,
+                              Ranges[Index].RowStart,
+                              Ranges[Index].RowEnd,
+                              Ranges[Index].ColumnStart,
+                              Ranges[Index].ColumnEnd,
+                              Ranges[Index].MinNumTiles,
+                              &NumTiles,
+                              &TileSize
+                              );
+    if (Tiles == NULL) {
+      printf("FAILURE[PairTiles]! Allocation error.\n");
+      return;
+    }
+
+    memset(Covered, 0, sizeof(Covered));
+    bool Result = true;
+    for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+      const sc_pair_tile_t *Tile = &Tiles[TileIndex];
+      if (TileIndex > 0 && Tiles[TileIndex - 1].Cost < Tile->Cost) {
+        Result = false;
+      }
+
+      for (unsigned int Row = Tile->RowStart; Row < Tile->RowEnd; ++Row) {
+        for (
+          unsigned int Column = SC_MAX(Tile->ColumnStart, Row + 1U);
+          Column < Tile->ColumnEnd;
+          ++Column
+          ) {
+          ++Covered[Row][Column];
+        }
+      }
+    }
+
+    for (unsigned int Row = 0; Row < 37; ++Row) {
+      for (unsigned int Column = 0; Column < 37; ++Column) {
+        const bool Pairing = Row >= Ranges[Index].RowStart
+                          && Row < Ranges[Index].RowEnd
+                          && Column >= Ranges[Index].ColumnStart
+                          && Column < Ranges[Index].ColumnEnd
+                          && Column > Row;
+        if (Covered[Row][Column] != (Pairing ? 1 : 0)) {
+          Result = false;
+        }
+      }
+    }
+
+    if (!Result) {
+      printf("FAILURE[PairTiles]! Wrong tiles of range %zu.\n", Index);
+      free(Tiles);
+      return;
+    }
+    //
+    // The tiles of the home domain must be taken first, and all tiles exactly
+    // once.
+    //
+    ScPairTilesAssignDomains(Tiles, NumTiles, FileDomains, 2);
+    sc_domain_queue_t *Queues = ScPairTilesCreateQueues(Tiles, NumTiles, 2);
+    if (Queues == NULL) {
+      printf("FAILURE[PairTiles]! Allocation error.\n");
+      free(Tiles);
+      return;
+    }
+
+    size_t       NumTaken = 0;
+    unsigned int Domain   = 1;
+    unsigned int Step     = 0;
+    size_t       TileIndex;
+    while (ScPairTilesDequeue(Queues, 2, 1, &Step, &TileIndex)) {
+      if (TileIndex >= NumTiles
+       || (Tiles[TileIndex].Domain != Domain && Tiles[TileIndex].Domain != 0)) {
+        Result = false;
+      }
+
+      Domain = Tiles[TileIndex].Domain;
+      ++NumTaken;
+    }
+
+    free(Queues);
+    free(Tiles);
+
+    if (!Result || NumTaken != NumTiles) {
+      printf("FAILURE[PairTiles]! Wrong queues of range %zu.\n", Index);
+      return;
+    }
+  }
+
+  printf("SUCCESS[PairTiles]!\n");
+}
+
+/*
+  Performs a unit test of the output formats by writing all of them to a
+  temporary file and reading them back.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestOutput(void)
+{
+  FILE *Stream = tmpfile();
+  if (Stream == NULL) {
+    printf("FAILURE[Output]! Cannot create a temporary file.\n");
+    return;
+  }
+
+  static const unsigned int FileIndices[3] = { 2, 0, 1 };
+  static const double       Ratings[3]     = { 0.25, 0.5, 0.75 };
+
+  bool Result = ScOutputWriteHeader(Stream, ScOutputFormatRecords, 3, 2);
+  ScOutputWriteRating(Stream, ScOutputFormatRecords, 1, 2, 0.5);
+  ScOutputWriteRating(Stream, ScOutputFormatText, 1, 2, 0.5);
+  Result = Result && ScOutputWriteMatrix(Stream, FileIndices, 3, 2, Ratings);
+  Result = Result && ScOutputFinish(Stream);
+  if (!Result || fseek(Stream, 0, SEEK_SET) != 0) {
+    printf("FAILURE[Output]! Write error.\n");
+    fclose(Stream);
+    return;
+  }
+
+  sc_output_header_t Header;
+  sc_output_record_t Record;
+  char               Line[32];
+  Result = fread(&Header, sizeof(Header), 1, Stream) == 1
+        && memcmp(Header.Magic, "SCRR", 4) == 0
+        && Header.Version == SC_OUTPUT_VERSION
+        && Header.NumFiles == 3
+        && Header.NumRowFiles == 2
+        && fread(&Record, sizeof(Record), 1, Stream) == 1
+        && Record.File1Index == 1
+        && Record.File2Index == 2
+        && Record.Score == 0.5f
+        && fread(Line, 1, strlen("1 2 0.500000\n"), Stream)
+             == strlen("1 2 0.500000\n")
+        && memcmp(Line, "1 2 0.500000\n", strlen("1 2 0.500000\n")) == 0;
+  if (!Result) {
+    printf("FAILURE[Output]! Wrong rating output.\n");
+    fclose(Stream);
+    return;
+  }
+
+  uint32_t Indices[3];
+  float    Row[3];
+  Result = fread(&Header, sizeof(Header), 1, Stream) == 1
+        && memcmp(Header.Magic, "SCRM", 4) == 0
+        && Header.NumFiles == 3
+        && Header.NumRowFiles == 2
+        && fread(Indices, sizeof(*Indices), 3, Stream) == 3
+        && Indices[0] == 2 && Indices[1] == 0 && Indices[2] == 1
+        && fread(Row, sizeof(*Row), 3, Stream) == 3
+        && Row[0] == 0.25f && Row[1] == 0.5f && Row[2] == 0.75f
+        && fread(Row, 1, 1, Stream) == 0;
+  fclose(Stream);
+  if (!Result) {
+    printf("FAILURE[Output]! Wrong matrix output.\n");
+    return;
+  }
+
+  printf("SUCCESS[Output]!\n");
+}
+
+/*
+  Performs a unit test of the partitioning of five files into blocks and of
+  the steps of rating their pairings. Every step must have its blocks loaded,
+  at most SC_MAX_RESIDENT_BLOCKS blocks may be loaded at once, and all blocks
+  must be freed in the end.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestFileBlocks(void)
+{
+  static const size_t Sizes[5] = { 10, 10, 10, SIZE_MAX, 5 };
+  sc_file_block_t     Blocks[5];
+  const unsigned int  NumBlocks = ScFileBlocksPartition(
+                                    Sizes,
+                                    5,
+                                    100,
+                                    225,
+                                    Blocks
+                                    );
+  if (NumBlocks != 4
+   || Blocks[0].Start != 0 || Blocks[0].End != 2
+   || Blocks[1].Start != 2 || Blocks[1].End != 3
+   || Blocks[2].Start != 3 || Blocks[2].End != 4
+   || Blocks[3].Start != 4 || Blocks[3].End != 5) {
+    printf("FAILURE[FileBlocks]! Wrong partition.\n");
+    return;
+  }
+  //
+  // Only the first two blocks hold query files.
+  //
+  sc_file_block_steps_t Steps;
+  bool                  Loaded[4]     = { false, false, false, false };
+  unsigned int          NumVisits[16] = { 0 };
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS];
+  unsigned int          NumEvict;
+  unsigned int          Load[2];
+  unsigned int          NumLoad = ScFileBlocksStart(
+                                    &Steps,
+                                    Blocks,
+                                    NumBlocks,
+                                    3,
+                                    Load
+                                    );
+  bool                  Result  = true;
+  unsigned int          Row;
+  unsigned int          Column;
+  unsigned int          NumLoaded = 0;
+  while (true) {
+    for (unsigned int Index = 0; Index < NumLoad; ++Index) {
+      Result = Result && !Loaded[Load[Index]];
+      Loaded[Load[Index]] = true;
+      ++NumLoaded;
+    }
+
+    const bool HasStep = ScFileBlocksNextStep(
+                           &Steps,
+                           &Row,
+                           &Column,
+                           Evict,
+                           &NumEvict,
+                           Load,
+                           &NumLoad
+                           );
+    for (unsigned int Index = 0; Index < NumEvict; ++Index) {
+      Result = Result && Loaded[Evict[Index]];
+      Loaded[Evict[Index]] = false;
+      --NumLoaded;
+    }
+
+    if (!HasStep) {
+      break;
+    }
+
+    Result = Result
+          && Row <= Column
+          && Loaded[Row]
+          && Loaded[Column]
+          && NumLoaded + NumLoad <= SC_MAX_RESIDENT_BLOCKS;
+    ++NumVisits[Row * 4U + Column];
+  }
+
+  for (unsigned int Row2 = 0; Row2 < 4; ++Row2) {
+    for (unsigned int Column2 = 0; Column2 < 4; ++Column2) {
+      const bool Visit = Row2 < 2 && Row2 <= Column2;
+      Result = Result && NumVisits[Row2 * 4U + Column2] == (Visit ? 1U : 0U);
+    }
+  }
+
+  if (!Result || NumLoaded != 0) {
+    printf("FAILURE[FileBlocks]! Wrong steps.\n");
+    return;
+  }
+  //
+  // Stopping early frees the blocks being loaded as well.
+  //
+  NumLoad = ScFileBlocksStart(&Steps, Blocks, NumBlocks, 3, Load);
+  Result  = ScFileBlocksNextStep(
+              &Steps,
+              &Row,
+              &Column,
+              Evict,
+              &NumEvict,
+              Load,
+              &NumLoad
+              )
+         && NumEvict == 0
+         && NumLoad == 1
+         && Load[0] == 1
+         && ScFileBlocksStop(&Steps, Evict) == 2
+         && Evict[0] + Evict[1] == 1U;
+  if (!Result) {
+    printf("FAILURE[FileBlocks]! Wrong early stop.\n");
+    return;
+  }
+
+  printf("SUCCESS[FileBlocks]!\n");
+}
+
+/*
+  Performs a unit test of reading file lists separated by new lines with
+  Windows line endings and empty paths, and separated by NUL characters.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestFileList(void)
+{
+  static const char NewLines[] = "a.c\r\n\nb c.c\nd.c";
+  static const char Nuls[]     = "a.c\0\0b\r.c\0";
+
+  bool Result = true;
+  for (unsigned int Index = 0; Result && Index < 2; ++Index) {
+    const bool   Nul    = Index == 1;
+    const char   *List  = Nul ? Nuls : NewLines;
+    const size_t Length = Nul ? sizeof(Nuls) - 1U : sizeof(NewLines) - 1U;
+    FILE         *File  = tmpfile();
+    Result = File != NULL
+          && fwrite(List, 1, Length, File) == Length
+          && fseek(File, 0, SEEK_SET) == 0;
+
+    char   **Paths  = NULL;
+    size_t NumPaths = 0;
+    char   *Buffer  = NULL;
+    if (Result) {
+      Buffer = ScReadFileList(&Paths, &NumPaths, File, Nul);
+      Result = Buffer != NULL;
+    }
+
+    if (Result && Nul) {
+      Result = NumPaths == 2
+            && strcmp(Paths[0], "a.c") == 0
+            && strcmp(Paths[1], "b\r.c") == 0;
+    } else if (Result) {
+      Result = NumPaths == 3
+            && strcmp(Paths[0], "a.c") == 0
+            && strcmp(Paths[1], "b c.c") == 0
+            && strcmp(Paths[2], "d.c") == 0;
+    }
+
+    free(Paths);
+    free(Buffer);
+    if (File != NULL) {
+      fclose(File);
+    }
+  }
+
+  if (!Result) {
+    printf("FAILURE[FileList]! Wrong paths.\n");
+    return;
+  }
+
+  printf("SUCCESS[FileList]!\n");
+}
+
+/*
+  Returns a temporary file with the content Content, positioned at its start.
+*/
+static FILE *ScUnitTestShardFile(
+  const char *Content
+  )
+{
+  assert(Content != NULL);
+
+  FILE *Stream = tmpfile();
+  if (Stream == NULL) {
+    return NULL;
+  }
+
+  const size_t Length = strlen(Content);
+  if (fwrite(Content, 1, Length, Stream) != Length
+   || fseek(Stream, 0, SEEK_SET) != 0) {
+    fclose(Stream);
+    return NULL;
+  }
+
+  return Stream;
+}
+
+/*
+  Merges the text shard outputs Contents and returns whether the result is
+  Status and, on success, the text Expected.
+*/
+static bool ScUnitTestShardMerge(
+  const char *const *Contents,
+  size_t            NumContents,
+  unsigned int      MaxMatches,
+  sc_shard_status_t Status,
+  size_t            FailedIndex,
+  const char        *Expected
+  )
+{
+  assert(NumContents <= 2);
+
+  FILE   *Inputs[2] = { NULL, NULL };
+  FILE   *Output    = tmpfile();
+  bool   Result     = Output != NULL;
+  for (size_t Index = 0; Result && Index < NumContents; ++Index) {
+    Inputs[Index] = ScUnitTestShardFile(Contents[Index]);
+    Result        = Inputs[Index] != NULL;
+  }
+
+  size_t Failed = SIZE_MAX;
+  Result = Result
+        && ScShardMergeOutputs(
+             Output,
+             ScOutputFormatText,
+             MaxMatches,
+             Inputs,
+             NumContents,
+             &Failed
+             ) == Status;
+  if (Status != ScShardStatusSuccess) {
+    Result = Result && Failed == FailedIndex;
+  } else {
+    char         Text[128];
+    const size_t Length = strlen(Expected);
+    Result = Result
+          && fseek(Output, 0, SEEK_SET) == 0
+          && fread(Text, 1, sizeof(Text), Output) == Length
+          && memcmp(Text, Expected, Length) == 0;
+  }
+
+  for (size_t Index = 0; Index < NumContents; ++Index) {
+    if (Inputs[Index] != NULL) {
+      fclose(Inputs[Index]);
+    }
+  }
+
+  if (Output != NULL) {
+    fclose(Output);
+  }
+
+  return Result;
+}
+
+static void ScUnitTestShard(void)
+{
+  //
+  // Blank lines are skipped and the file counts of text outputs are derived
+  // from their ratings.
+  //
+  sc_shard_stream_t  Stream;
+  sc_output_header_t Header = { { 0 }, 0, 0, 0 };
+  FILE               *File  = ScUnitTestShardFile("\n0 1 0.5\n  \n0 2 0.25\n");
+  bool               Result = File != NULL
+                           && ScShardOpenStream(&Stream, File, true, &Header)
+                           && Header.NumFiles == 3
+                           && Header.NumRowFiles == 1
+                           && Stream.HasRating
+                           && Stream.Rating.File1Index == 0
+                           && Stream.Rating.Match.FileIndex == 1
+                           && Stream.Rating.Match.Score == 0.5
+                           && ScShardReadRating(&Stream)
+                           && Stream.HasRating
+                           && Stream.Rating.Match.FileIndex == 2
+                           && ScShardReadRating(&Stream)
+                           && !Stream.HasRating;
+  if (File != NULL) {
+    fclose(File);
+  }
+
+  if (!Result) {
+    printf("FAILURE[Shard]! Wrong text ratings.\n");
+    return;
+  }
+
+  File   = ScUnitTestShardFile("0 x 0.5\n");
+  Result = File != NULL && !ScShardOpenStream(&Stream, File, false, &Header);
+  if (File != NULL) {
+    fclose(File);
+  }
+
+  if (!Result) {
+    printf("FAILURE[Shard]! Malformed rating accepted.\n");
+    return;
+  }
+
+  const sc_output_header_t Records = { { 'S', 'C', 'R', 'R' }, 2, 4, 2 };
+  File   = tmpfile();
+  Result = File != NULL
+        && fwrite(&Records, sizeof(Records), 1, File) == 1
+        && fseek(File, 0, SEEK_SET) == 0
+        && !ScShardOpenStream(&Stream, File, false, &Header);
+  if (File != NULL) {
+    fclose(File);
+  }
+
+  if (!Result) {
+    printf("FAILURE[Shard]! Wrong record version accepted.\n");
+    return;
+  }
+  //
+  // The ratings of all shards are merged ordered by their files, and the best
+  // matches are merged in top-K mode.
+  //
+  static const char *const Ordered[2]   = {
+    "0 1 0.1\n1 2 0.3\n",
+    "0 2 0.2\n"
+  };
+  static const char *const Unordered[2] = {
+    "0 1 0.1\n",
+    "1 2 0.3\n0 2 0.2\n"
+  };
+  static const char *const Matches[2]   = {
+    "0 1 0.1\n0 2 0.9\n1 2 0.3\n",
+    "0 3 0.5\n"
+  };
+  Result = ScUnitTestShardMerge(
+             Ordered,
+             2,
+             0,
+             ScShardStatusSuccess,
+             0,
+             "0 1 0.100000\n0 2 0.200000\n1 2 0.300000\n"
+             )
+        && ScUnitTestShardMerge(
+             Unordered,
+             2,
+             0,
+             ScShardStatusUnordered,
+             1,
+             NULL
+             )
+        && ScUnitTestShardMerge(
+             Matches,
+             2,
+             1,
+             ScShardStatusSuccess,
+             0,
+             "0 2 0.900000\n1 2 0.300000\n"
+             );
+  if (!Result) {
+    printf("FAILURE[Shard]! Wrong merge.\n");
+    return;
+  }
+  //
+  // Every tile is assigned to exactly one shard.
+  //
+  sc_pair_tile_t Tiles[7];
+  sc_pair_tile_t Kept[7];
+  unsigned int   NumAssigned[7] = { 0 };
+  for (unsigned int ShardIndex = 0; Result && ShardIndex < 3; ++ShardIndex) {
+    for (unsigned int Index = 0; Index < 7; ++Index) {
+      Tiles[Index].Cost     = 70U - 10U * Index;
+      Tiles[Index].RowStart = Index;
+    }
+
+    size_t NumKept;
+    Result = ScShardSelectTiles(Tiles, 7, ShardIndex, 3, &NumKept);
+    memcpy(Kept, Tiles, sizeof(Kept));
+    for (size_t Index = 0; Result && Index < NumKept; ++Index) {
+      ++NumAssigned[Kept[Index].RowStart];
+    }
+  }
+
+  for (unsigned int Index = 0; Result && Index < 7; ++Index) {
+    Result = NumAssigned[Index] == 1;
+  }
+
+  if (!Result) {
+    printf("FAILURE[Shard]! Wrong tile selection.\n");
+    return;
+  }
+  //
+  // The stored ratings are written ordered by their files without NaN ones.
+  //
+  const sc_pair_tile_t ShardTiles[2] = {
+    { 0, 0, 2, 0, 2, 0 },
+    { 0, 0, 2, 2, 3, 0 }
+  };
+  static const unsigned int FileIndices[3] = { 2, 0, 1 };
+  sc_shard_ratings_t        ShardRatings;
+  Result = ScShardRatingsCreate(&ShardRatings, ShardTiles, 2, 2, 3, 2);
+  if (!Result) {
+    printf("FAILURE[Shard]! Allocation error.\n");
+    return;
+  }
+
+  ShardRatings.Ratings[ScShardRatingsGetIndex(&ShardRatings, 0, 1)] = 0.5;
+  ShardRatings.Ratings[ScShardRatingsGetIndex(&ShardRatings, 0, 2)] = NAN;
+  ShardRatings.Ratings[ScShardRatingsGetIndex(&ShardRatings, 1, 2)] = 0.25;
+
+  char         Text[64];
+  const char   *Expected = "2 0 0.500000\n0 1 0.250000\n";
+  const size_t Length    = strlen(Expected);
+  File   = tmpfile();
+  Result = File != NULL;
+  if (Result) {
+    ScShardRatingsWrite(&ShardRatings, File, ScOutputFormatText, FileIndices);
+    Result = fseek(File, 0, SEEK_SET) == 0
+          && fread(Text, 1, sizeof(Text), File) == Length
+          && memcmp(Text, Expected, Length) == 0;
+    fclose(File);
+  }
+
+  ScShardRatingsFree(&ShardRatings);
+  if (!Result) {
+    printf("FAILURE[Shard]! Wrong shard ratings.\n");
+    return;
+  }
+
+  printf("SUCCESS[Shard]!\n");
+}
+
+/*
+  Performs a unit test of ScCleanseInput() against the separate cleansing
+  passes for all cleanse configurations.
+  The result of this test is printed to stdout.
+
+  @param[in] String  The string to cleanse. It needs to be properly
+                     terminated.
+*/
+static void ScUnitTestCleanse(
+  const char *String
+  )
+{
+  assert(String != NULL);
+
+  const size_t Length = strlen(String);
+  char         Expected[256];
+  char         Actual[256];
+  assert(Length > 0 && Length <= sizeof(Expected));
+
+  for (size_t Type = 0; Type <= ScCleanseConfigTypeMax; ++Type) {
+    const sc_cleanse_config_t *Config = gScCleanseConfigs[Type];
+
+    size_t ExpectedLength = Length;
+    memcpy(Expected, String, Length);
+    ScCleanseLines(Expected, ExpectedLength, Config);
+    ScCleanseGeneralisees(Expected, ExpectedLength, Config);
+    ScCleanseWhitespacesInLines(Expected, ExpectedLength, Config);
+    ScCleanseRemoveSpaces(Expected, &ExpectedLength);
+
+    sc_cleanse_matcher_t Matcher;
+    ScCleanseCompileConfig(&Matcher, Config);
+    if (!Matcher.Fusable) {
+      printf("FAILURE[Cleanse %zu]! Not cleansed in a single pass.\n", Type);
+      return;
+    }
+
+    size_t ActualLength = Length;
+    memcpy(Actual, String, Length);
+    ScCleanseInput(Actual, &ActualLength, &Matcher);
+
+    if (ActualLength != ExpectedLength
+     || memcmp(Actual, Expected, ActualLength) != 0) {
+      printf(
+        "FAILURE[Cleanse %zu]! Expected \"%.*s\", got \"%.*s\".\n",
+        Type,
+        (int) ExpectedLength,
+        Expected,
+        (int) ActualLength,
+        Actual
+        );
+      return;
+    }
+  }
+
+  printf("SUCCESS[Cleanse]!\n");
+}
+
+/*
+  Performs a unit test of ScCleanseInput() against the separate cleansing
+  passes for all cleanse configurations with a buffer that is cleansed in
+  chunks, including a multi line comment that spans several of them.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestCleanseChunks(void)
+{
+  static const char *const Fragments[] = {
+    "static const uint8_t Value = 1; // Comment\r\n",
+    "/* Multi\n * line */ long double Fraction;\t\v\n\n",
+    "(* Sharp\n *) let mutable Index = 0\n",
+    "  \n"
+  };
+
+  const size_t Length    = 8U * SC_CLEANSE_CHUNK_LENGTH;
+  char         *Buffer   = malloc(Length);
+  char         *Expected = malloc(Length);
+  char         *Actual   = malloc(Length);
+  if (Buffer == NULL || Expected == NULL || Actual == NULL) {
+    printf("FAILURE[CleanseChunks]! Allocation error.\n");
+    free(Buffer);
+    free(Expected);
+    free(Actual);
+    return;
+  }
+  //
+  // The fragments between the indices 1000 and 6000 are about three chunks
+  // long and form a single comment.
+  //
+  size_t Offset = 0;
+  for (size_t Index = 0; Offset < Length; ++Index) {
+    const char *Fragment = Fragments[Index % SC_ARRAY_LEN(Fragments)];
+    if (Index == 1000) {
+      Fragment = "/*";
+    } else if (Index == 6000) {
+      Fragment = "*/";
+    }
+
+    const size_t FragmentLength = SC_MIN(strlen(Fragment), Length - Offset);
+    memcpy(&Buffer[Offset], Fragment, FragmentLength);
+    Offset += FragmentLength;
+  }
+
+  bool Result = true;
+  for (size_t Type = 0; Result && Type <= ScCleanseConfigTypeMax; ++Type) {
+    const sc_cleanse_config_t *Config = gScCleanseConfigs[Type];
+
+    size_t ExpectedLength = Length;
+    memcpy(Expected, Buffer, Length);
+    ScCleanseLines(Expected, ExpectedLength, Config);
+    ScCleanseGeneralisees(Expected, ExpectedLength, Config);
+    ScCleanseWhitespacesInLines(Expected, ExpectedLength, Config);
+    ScCleanseRemoveSpaces(Expected, &ExpectedLength);
+
+    sc_cleanse_matcher_t Matcher;
+    ScCleanseCompileConfig(&Matcher, Config);
+    if (!Matcher.Splittable) {
+      printf("FAILURE[CleanseChunks %zu]! Not cleansed in chunks.\n", Type);
+      Result = false;
+      break;
+    }
+
+    size_t ActualLength = Length;
+    memcpy(Actual, Buffer, Length);
+    ScCleanseInput(Actual, &ActualLength, &Matcher);
+
+    if (ActualLength != ExpectedLength
+     || memcmp(Actual, Expected, ActualLength) != 0) {
+      printf(
+        "FAILURE[CleanseChunks %zu]! Expected %zu characters, got %zu.\n",
+        Type,
+        ExpectedLength,
+        ActualLength
+        );
+      Result = false;
+    }
+  }
+
+  free(Buffer);
+  free(Expected);
+  free(Actual);
+
+  if (Result) {
+    printf("SUCCESS[CleanseChunks]!\n");
+  }
+}
+
+/*
+  Performs a unit test of ScStrSpanNotInSet() and ScStrGetLineInfo() with
+  spans of all lengths up to and beyond the vector widths.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestStrScan(void)
+{
+  bool Members[256] = { false };
+  Members['\n'] = true;
+  Members[' ']  = true;
+  Members['/']  = true;
+  Members[0xE9] = true;
+
+  sc_str_char_set_t Set;
+  ScStrCharSetInitialise(&Set, Members);
+
+  char String[100];
+  for (size_t Span = 0; Span <= sizeof(String); ++Span) {
+    memset(String, 'a', sizeof(String));
+    if (Span < sizeof(String)) {
+      String[Span] = '/';
+    }
+
+    const size_t Result = ScStrSpanNotInSet(String, sizeof(String), &Set);
+    if (Result != Span) {
+      printf("FAILURE[StrScan]! Expected span %zu, got %zu.\n", Span, Result);
+      return;
+    }
+  }
+
+  memset(String, 'a', sizeof(String));
+  String[0]  = '\n';
+  String[41] = '\n';
+  String[42] = '\n';
+  sc_str_lines_info_t *LinesInfo = ScStrGetLineInfo(String, sizeof(String));
+  if (LinesInfo == NULL) {
+    printf("FAILURE[StrScan]! Allocation error.\n");
+    return;
+  }
+
+  const bool Correct = LinesInfo->NumLines == 4
+    && LinesInfo->MaxLineLength == 57
+    && LinesInfo->Lines[0].Length == 0
+    && LinesInfo->Lines[1].Start == &String[1]
+    && LinesInfo->Lines[1].Length == 40
+    && LinesInfo->Lines[2].Length == 0
+    && LinesInfo->Lines[3].Start == &String[43];
+  free(LinesInfo);
+  if (!Correct) {
+    printf("FAILURE[StrScan]! Incorrect line information.\n");
+    return;
+  }
+
+  printf("SUCCESS[StrScan]!\n");
+}
+
+/*
+  Performs a unit test of the comparison context with files that are added
+  from memory.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestContext(void)
+{
+  static const char File1[] =
+    "int main(void) {\n  int Value = 1;\n  return Value;\n}\n";
+  static const char File2[] =
+    "int main(void) {\n  int Result = 2;\n  return Result;\n}\n";
+
+  sc_context_t *Context = ScContextCreate(0);
+  if (Context == NULL) {
+    printf("FAILURE[Context]! Allocation error.\n");
+    return;
+  }
+
+  unsigned int Index1;
+  unsigned int Index2;
+  bool         Result = ScContextAddBuffer(
+    Context,
+    File1,
+    strlen(File1),
+    ScCleanseConfigTypeC,
+    &Index1
+    );
+  Result = Result && ScContextAddBuffer(
+    Context,
+    File2,
+    strlen(File2),
+    ScCleanseConfigTypeC,
+    &Index2
+    );
+  if (!Result || Index1 != 0 || Index2 != 1) {
+    printf("FAILURE[Context]! The files could not be added.\n");
+    ScContextDestroy(Context);
+    return;
+  }
+
+  sc_context_pairing_t Pairings[] = {
+    { Index1, Index1, 0 },
+    { Index1, Index2, 0 },
+    { Index2, Index1, 0 }
+  };
+  ScContextCompareBatch(Context, Pairings, SC_ARRAY_LEN(Pairings));
+
+  const double Score = ScContextComparePair(Context, Index1, Index2);
+  const bool   Correct = Pairings[0].Score == 1
+    && Score > 0 && Score < 1
+    && Pairings[1].Score == Score
+    && Pairings[2].Score == Score;
+  ScContextDestroy(Context);
+  if (!Correct) {
+    printf("FAILURE[Context]! Got score %f.\n", Score);
+    return;
+  }
+
+  printf("SUCCESS[Context]!\n");
+}
+
+/*
+  Performs a unit test of the line alignment with a file whose lines both match
+  the same line of another file best.
+  The result of this test is printed to stdout.
+*/
+static void ScUnitTestAlign(void)
+{
+  static const char File1[] = "Value = 1;\nValue = 1;\n";
+  static const char File2[] = "Value = 1;\nResult = 2;\n";
+
+  sc_context_t *Context = ScContextCreate(1);
+  if (Context == NULL) {
+    printf("FAILURE[Align]! Allocation error.\n");
+    return;
+  }
+
+  unsigned int Index1;
+  unsigned int Index2;
+  bool         Result = ScContextAddBuffer(
+    Context,
+    File1,
+    strlen(File1),
+    ScCleanseConfigTypeC,
+    &Index1
+    );
+  Result = Result && ScContextAddBuffer(
+    Context,
+    File2,
+    strlen(File2),
+    ScCleanseConfigTypeC,
+    &Index2
+    );
+  if (!Result) {
+    printf("FAILURE[Align]! The files could not be added.\n");
+    ScContextDestroy(Context);
+    return;
+  }
+  //
+  // Without a window, both modes match the lines of equal index.
+  //
+  ScContextSetWindow(Context, 0);
+  const double SwapScore0 = ScContextComparePair(Context, Index1, Index2);
+  ScContextSetAlignment(Context, true);
+  const double AlignScore0 = ScContextComparePair(Context, Index1, Index2);
+  //
+  // Within a window, only the window search may match the first line of file
+  // 2 twice.
+  //
+  ScContextSetWindow(Context, 1);
+  const double AlignScore1 = ScContextComparePair(Context, Index1, Index2);
+  ScContextSetAlignment(Context, false);
+  const double SwapScore1 = ScContextComparePair(Context, Index1, Index2);
+  ScContextDestroy(Context);
+  if (SwapScore0 != AlignScore0 || SwapScore1 != 1 || AlignScore1 >= 1) {
+    printf(
+      "FAILURE[Align]! Got scores %f, %f, %f and %f.\n",
+      SwapScore0,
+      AlignScore0,
+      SwapScore1,
+      AlignScore1
+      );
+    return;
+  }
+
+  printf("SUCCESS[Align]!\n");
+}
+
 /*
   Main entry point for unit testing of the SimilarityChecker project.
   A set of tests is performed and their results are printed to stdout.
 */
 int main(void) {
-  ScLevenshteinSwapInitialise();
+  //
+  // Matrix[0,0] = 0 is implicit by the loop in ScLevenshteinDistance().
+  // This is equivalent to: Fill Matrix[0,1:] with 0,...,Str2Length.
+  //
+  for (size_t Index = 0; Index < SC_MAX_LINE_LENGTH; ++Index) {
+    mScUnitTestMatrixInit[Index] = Index + 1U;
+  }
 
   ScUnitTestLevenshtein(
     "This is a test string",
@@ -78,6 +1646,47 @@ int main(void) {
   ScUnitTestLevenshtein("House", "Mouse",  1);
   ScUnitTestLevenshtein("Claus", "clause", 2);
   ScUnitTestLevenshtein("1234",  "5678",   4);
+  //
+  // Cover the multi-block path of the bit-parallel kernel.
+  //
+  ScUnitTestLevenshtein(
+    "for(int Index=0;Index<NumLines;++Index){"
+    "Total+=Lines[Index].Length*Weights[Index];}",
+    "for(int i=0;i<n;++i){sum+=lines[i].len*w[i];}",
+    49
+    );
+  ScUnitTestLevenshtein(
+    "int ScLevenshteinSwap(int*File1,int*File2,int NumLinesSwap){"
+    "int TotalDiff=0;int TotalLength=0;"
+    "for(int Line1Index=0;Line1Index<NumLines;++Line1Index){",
+    "int ScLevenshteinSwap(int*FileA,int*FileB,int NumLinesSwap){"
+    "int TotalDiff=0,TotalLength=0;"
+    "for(int Line1Index=0;Line1Index<NumLines1;Line1Index++){",
+    12
+    );
+
+  ScUnitTestLineCache();
+  ScUnitTestMinHash();
+  ScUnitTestWinnow();
+  ScUnitTestTopMatches();
+  ScUnitTestRescore();
+  ScUnitTestIdRanges();
+  ScUnitTestPairTiles();
+  ScUnitTestOutput();
+  ScUnitTestShard();
+  ScUnitTestFileBlocks();
+  ScUnitTestFileList();
+  ScUnitTestStrScan();
+  ScUnitTestContext();
+  ScUnitTestAlign();
+
+  ScUnitTestCleanse(
+    "\r\n#include <stdint.h>\n\n  static const uint8_t Value = 1; // Comment\n"
+    "/* Multi\n * line */ long double Fraction;\t\v\n"
+    "(* Sharp *) let mutable Index = 0 /*/ unterminated"
+    );
+
+  ScUnitTestCleanseChunks();
 
   return 0;
 }
@@ -0,0 +1,88 @@
+/*@file
+  Provides APIs to allocate many objects that are freed together.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_ARENA_H_
+#define SC_ARENA_H_
+
+#include <stddef.h>
+
+///
+/// The default size, in bytes, of the blocks of an arena. Larger allocations
+/// are served by dedicated blocks.
+///
+#define SC_ARENA_BLOCK_SIZE  (1U * 1024U * 1024U)
+
+///
+/// A memory block of an arena.
+///
+typedef struct sc_arena_block_ {
+  ///
+  /// The previously allocated block of the arena, or NULL.
+  ///
+  struct sc_arena_block_ *Next;
+  ///
+  /// The size, in bytes, of Data.
+  ///
+  size_t                 Size;
+  ///
+  /// The number of bytes of Data that have been allocated.
+  ///
+  size_t                 Used;
+  ///
+  /// The memory to allocate from.
+  ///
+  unsigned char          Data[];
+} sc_arena_block_t;
+
+///
+/// A bump allocator. It is not thread-safe, hence every thread should own a
+/// separate arena.
+///
+typedef struct {
+  ///
+  /// The block to allocate from, which links all other blocks.
+  ///
+  sc_arena_block_t *Blocks;
+} sc_arena_t;
+
+/*
+  Initialises Arena to not hold any memory.
+
+  @param[out] Arena  The arena to initialise.
+*/
+void ScArenaInitialise(
+  sc_arena_t *Arena
+  );
+
+/*
+  Allocates Size bytes aligned to Alignment from Arena.
+
+  @param[in,out] Arena      The arena to allocate from.
+  @param[in]     Size       The number of bytes to allocate.
+  @param[in]     Alignment  The alignment of the allocation. It must be a power
+                            of two and at most _Alignof(max_align_t).
+
+  @retval NULL   An error has occured.
+  @retval other  The allocated memory. It lives until ScArenaFree() is called
+                 on Arena.
+*/
+void *ScArenaAllocate(
+  sc_arena_t *Arena,
+  size_t     Size,
+  size_t     Alignment
+  );
+
+/*
+  Frees all memory allocated from Arena at once. Afterwards, Arena does not
+  hold any memory and may be allocated from again.
+
+  @param[in,out] Arena  The arena to free.
+*/
+void ScArenaFree(
+  sc_arena_t *Arena
+  );
+
+#endif // SC_ARENA_H_
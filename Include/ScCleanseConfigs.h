@@ -9,6 +9,13 @@
 
 #include <ScCleanseInput.h>
 
+///
+/// The revision of the cleansing configurations and the cleansing process. It
+/// must be incremented whenever either changes the cleansed output, as it
+/// invalidates persistently cached cleansed files.
+///
+#define SC_CLEANSE_CONFIGS_VERSION  1U
+
 ///
 /// Cleansing configuration type enumeration.
 ///
@@ -8,6 +8,9 @@
 #ifndef SC_CLEANSE_INPUT_H_
 #define SC_CLEANSE_INPUT_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <ScStringMisc.h>
 
 /*
@@ -82,6 +85,127 @@ typedef struct {
   size_t                        NumGeneralises;
 } sc_cleanse_config_t;
 
+///
+/// The maximum number of trie nodes of a sc_cleanse_matcher_t.
+///
+#define SC_CLEANSE_MATCHER_MAX_NODES  1024U
+
+///
+/// Character class of whitespaces that do not denote a new line.
+///
+#define SC_CLEANSE_CLASS_SPACE  0x01U
+
+///
+/// Character class of characters that are treated as new lines.
+///
+#define SC_CLEANSE_CLASS_NEW_LINE  0x02U
+
+///
+/// Character class of characters that start a path of the matcher trie.
+///
+#define SC_CLEANSE_CLASS_TRIE  0x04U
+
+///
+/// The trie node terminates a line drop prefix.
+///
+#define SC_CLEANSE_NODE_DROP_LINE  0x01U
+
+///
+/// The trie node terminates the multi line comment start.
+///
+#define SC_CLEANSE_NODE_MULTI_COMMENT  0x02U
+
+///
+/// The minimum length, in characters, of the chunks large buffers are split
+/// into to be cleansed concurrently.
+///
+#define SC_CLEANSE_CHUNK_LENGTH  (64U * 1024U)
+
+///
+/// The maximum number of chunks a buffer is split into.
+///
+#define SC_CLEANSE_MAX_CHUNKS  64U
+
+///
+/// A node of the trie of a sc_cleanse_matcher_t.
+///
+typedef struct {
+  ///
+  /// The index of the first child node. 0 denotes no children.
+  ///
+  uint16_t FirstChild;
+  ///
+  /// The index of the next node of the same parent. 0 denotes no further
+  /// siblings.
+  ///
+  uint16_t NextSibling;
+  ///
+  /// The position of the generalisee terminating at this node in the order of
+  /// the configuration. UINT16_MAX denotes none.
+  ///
+  uint16_t Ordinal;
+  ///
+  /// The index of the generalise the generalisee terminating at this node
+  /// belongs to.
+  ///
+  uint16_t Generalise;
+  ///
+  /// The character that leads to this node from its parent.
+  ///
+  char     Char;
+  ///
+  /// SC_CLEANSE_NODE_* flags describing the prefixes terminating at this node.
+  ///
+  uint8_t  Flags;
+} sc_cleanse_matcher_node_t;
+
+///
+/// A cleansing configuration compiled for matching all its prefixes and
+/// generalisees at once, independent of their number.
+///
+typedef struct {
+  ///
+  /// The configuration this matcher has been compiled from.
+  ///
+  const sc_cleanse_config_t *Config;
+  ///
+  /// Whether Config can be cleansed in a single pass. If not, the separate
+  /// passes are performed.
+  ///
+  bool                      Fusable;
+  ///
+  /// Whether Config can be cleansed in chunks split after new line characters.
+  /// It implies Fusable.
+  ///
+  bool                      Splittable;
+  ///
+  /// SC_CLEANSE_CLASS_* flags for every character.
+  ///
+  uint8_t                   Classes[256];
+  ///
+  /// The characters with any SC_CLEANSE_CLASS_* flag set in Classes.
+  ///
+  sc_str_char_set_t         Specials;
+  ///
+  /// The first characters of all line drop prefixes and the multi line
+  /// comment start.
+  ///
+  sc_str_char_set_t         CommentStarts;
+  ///
+  /// The trie root node index for every first character. 0 denotes none.
+  ///
+  uint16_t                  Roots[256];
+  ///
+  /// The number of used elements of Nodes, including the reserved node 0.
+  ///
+  uint16_t                  NumNodes;
+  ///
+  /// The trie nodes of all line drop prefixes, the multi line comment start
+  /// and all generalisees.
+  ///
+  sc_cleanse_matcher_node_t Nodes[SC_CLEANSE_MATCHER_MAX_NODES];
+} sc_cleanse_matcher_t;
+
 /*
   Cleanse Buffer of comments and line fragments with prefixes to drop.
   
@@ -136,20 +260,39 @@ void ScCleanseRemoveSpaces(
   );
 
 /*
-  Cleanse Buffer according to Config. For details regarding the operations,
-  please refer to the other functions within this header.
+  Compiles Config into Matcher for usage with ScCleanseInput().
+
+  @param[out] Matcher  The matcher to compile Config into.
+  @param[in]  Config   Configuration for the cleansing process. It must remain
+                       valid for the lifetime of Matcher.
+*/
+void ScCleanseCompileConfig(
+  sc_cleanse_matcher_t      *Matcher,
+  const sc_cleanse_config_t *Config
+  );
+
+/*
+  Cleanse Buffer according to the configuration Matcher has been compiled from.
+  For details regarding the operations, please refer to the other functions
+  within this header.
+
+  Buffers of at least two SC_CLEANSE_CHUNK_LENGTH characters are split into
+  chunks after new line characters outside of comments, which are cleansed as
+  OpenMP tasks. Within a parallel region, idle threads of the team cleanse
+  them concurrently.
 
   @param[in,out] Buffer        The text buffer to cleanse.
   @param[in,out] BufferLength  On input, the length, in characters, of Buffer.
                                It must be bigger than 0.
                                On output, the cleansed length, in characters, of
                                Buffer.
-  @param[in]     Config        Configuration for the cleansing process.
+  @param[in]     Matcher       The compiled configuration for the cleansing
+                               process.
 */
 void ScCleanseInput(
-  char                      *Buffer,
-  size_t                    *BufferLength,
-  const sc_cleanse_config_t *Config
+  char                       *Buffer,
+  size_t                     *BufferLength,
+  const sc_cleanse_matcher_t *Matcher
   );
 
 #endif // SC_CLEANSE_INPUT_H_
@@ -7,7 +7,80 @@
 #ifndef SC_DISTANCES_H_
 #define SC_DISTANCES_H_
 
+#include <limits.h>
 #include <stddef.h>
+#include <stdint.h>
+
+///
+/// The number of characters of a string processed by one bit-parallel block.
+///
+#define SC_LEVENSHTEIN_BLOCK_BITS  64U
+
+/*
+  Calculates the number of bit-parallel blocks required for a string.
+
+  @param[in] Length  The length, in characters, of the string.
+*/
+#define SC_LEVENSHTEIN_NUM_BLOCKS(Length)  \
+  (((Length) + SC_LEVENSHTEIN_BLOCK_BITS - 1U) / SC_LEVENSHTEIN_BLOCK_BITS)
+
+///
+/// The number of character classes of a Levenshtein histogram.
+///
+#define SC_LEVENSHTEIN_HISTOGRAM_SIZE  32U
+
+/*
+  Maps a character to its Levenshtein histogram class.
+
+  @param[in] Char  The character to map.
+*/
+#define SC_LEVENSHTEIN_HISTOGRAM_CLASS(Char)  \
+  (((size_t) (unsigned char) (Char)           \
+     ^ ((size_t) (unsigned char) (Char) >> 5U)) % SC_LEVENSHTEIN_HISTOGRAM_SIZE)
+
+/*
+  Calculates the number of elements of a bit-parallel scratch buffer.
+  It holds one character match bitmask block per character value and block, as
+  well as the two vertical delta vectors.
+
+  @param[in] MaxLength  The maximum length, in characters, of the shorter string
+                        to compare.
+*/
+#define SC_LEVENSHTEIN_PEQ_SIZE(MaxLength)  \
+  ((UCHAR_MAX + 1U + 2U) * SC_LEVENSHTEIN_NUM_BLOCKS(MaxLength))
+
+///
+/// Describes a non-zero element of a pattern's character match bitmask table.
+///
+typedef struct {
+  ///
+  /// The bitmask of the pattern positions that match the character.
+  ///
+  uint64_t Mask;
+  ///
+  /// The index of the element within the bitmask table.
+  ///
+  uint32_t Index;
+} sc_levenshtein_peq_entry_t;
+
+///
+/// Describes a text to compare a compiled pattern to by
+/// ScLevenshteinDistanceCompiledBatch().
+///
+typedef struct {
+  ///
+  /// The text to compare the pattern to.
+  ///
+  const char *Text;
+  ///
+  /// The length of Text. It must be larger than 0 and smaller than SIZE_MAX.
+  ///
+  size_t     Length;
+  ///
+  /// The maximum distance of interest. SIZE_MAX disables early termination.
+  ///
+  size_t     MaxDistance;
+} sc_levenshtein_text_t;
 
 /*
   Calculates the Levenshtein distance from Str1 to Str2.
@@ -35,4 +108,151 @@ size_t ScLevenshteinDistance(
   size_t       Str2Length
   );
 
+/*
+  Calculates the Levenshtein distance from Str1 to Str2 with the bit-parallel
+  algorithm by Myers and its blocked extension by Hyyrö. The result is equal to
+  the one of ScLevenshteinDistance().
+
+  @param[in,out] PeqScratch  The bit-parallel scratch buffer. It must be at
+                             least SC_LEVENSHTEIN_PEQ_SIZE(MIN(Str1Length,
+                             Str2Length)) elements in size. All elements must
+                             be 0 on input and are 0 on output.
+  @param[in]     Str1        The first string to compare.
+  @param[in]     Str1Length  The length of Str1. It must be larger than 0 and
+                             smaller than SIZE_MAX.
+  @param[in]     Str2        The second string to compare.
+  @param[in]     Str2Length  The length of Str2. It must be larger than 0 and
+                             smaller than SIZE_MAX.
+
+  @returns  The Levenshtein distance from Str1 to Str2.
+*/
+size_t ScLevenshteinDistanceBitParallel(
+  uint64_t   *PeqScratch,
+  const char *Str1,
+  size_t     Str1Length,
+  const char *Str2,
+  size_t     Str2Length
+  );
+
+/*
+  Compiles the character match bitmask table of Pattern into a compact list of
+  its non-zero elements for ScLevenshteinDistanceCompiled(). The list can be
+  computed once and reused for any number of comparisons.
+
+  @param[in,out] PeqScratch     The bit-parallel scratch buffer. It must be at
+                                least SC_LEVENSHTEIN_PEQ_SIZE(PatternLength)
+                                elements in size. All elements must be 0 on
+                                input and are 0 on output.
+  @param[out]    Entries        The buffer to return the compiled elements
+                                into. It must have room for PatternLength
+                                elements. If it is NULL, the elements are only
+                                counted.
+  @param[in]     Pattern        The pattern to compile.
+  @param[in]     PatternLength  The length, in characters, of Pattern. It must
+                                be larger than 0.
+
+  @returns  The number of compiled elements. It is at most PatternLength.
+*/
+size_t ScLevenshteinPeqCompile(
+  uint64_t                   *PeqScratch,
+  sc_levenshtein_peq_entry_t *Entries,
+  const char                 *Pattern,
+  size_t                     PatternLength
+  );
+
+/*
+  Calculates the Levenshtein distance from a pattern compiled by
+  ScLevenshteinPeqCompile() to Text. The result is equal to the one of
+  ScLevenshteinDistance(). The calculation is terminated early once the
+  distance is known to exceed MaxDistance.
+
+  @param[in,out] PeqScratch     The bit-parallel scratch buffer. It must be at
+                                least SC_LEVENSHTEIN_PEQ_SIZE(PatternLength)
+                                elements in size. All elements must be 0 on
+                                input and are 0 on output.
+  @param[in]     Entries        The compiled elements of the pattern.
+  @param[in]     NumEntries     The number of elements in Entries.
+  @param[in]     PatternLength  The length, in characters, of the pattern. It
+                                must be larger than 0.
+  @param[in]     Text           The text to compare the pattern to.
+  @param[in]     TextLength     The length of Text. It must be larger than 0
+                                and smaller than SIZE_MAX.
+  @param[in]     MaxDistance    The maximum distance of interest. SIZE_MAX
+                                disables early termination.
+
+  @returns  The Levenshtein distance from the pattern to Text if it is at most
+            MaxDistance, otherwise a value larger than MaxDistance.
+*/
+size_t ScLevenshteinDistanceCompiled(
+  uint64_t                         *PeqScratch,
+  const sc_levenshtein_peq_entry_t *Entries,
+  size_t                           NumEntries,
+  size_t                           PatternLength,
+  const char                       *Text,
+  size_t                           TextLength,
+  size_t                           MaxDistance
+  );
+
+/*
+  Calculates the Levenshtein distances from a pattern compiled by
+  ScLevenshteinPeqCompile() to every text of Texts. The results are equal to
+  the ones of ScLevenshteinDistanceCompiled(), but the pattern is only set up
+  once for all texts.
+
+  @param[in,out] PeqScratch     The bit-parallel scratch buffer. It must be at
+                                least SC_LEVENSHTEIN_PEQ_SIZE(PatternLength)
+                                elements in size. All elements must be 0 on
+                                input and are 0 on output.
+  @param[in]     Entries        The compiled elements of the pattern.
+  @param[in]     NumEntries     The number of elements in Entries.
+  @param[in]     PatternLength  The length, in characters, of the pattern. It
+                                must be larger than 0.
+  @param[in]     Texts          The texts to compare the pattern to.
+  @param[in]     NumTexts       The number of elements in Texts.
+  @param[out]    Distances      The Levenshtein distance from the pattern to
+                                every text of Texts if it is at most the text's
+                                MaxDistance, otherwise a value larger than it.
+                                It must be NumTexts elements in size.
+*/
+void ScLevenshteinDistanceCompiledBatch(
+  uint64_t                         *PeqScratch,
+  const sc_levenshtein_peq_entry_t *Entries,
+  size_t                           NumEntries,
+  size_t                           PatternLength,
+  const sc_levenshtein_text_t      *Texts,
+  size_t                           NumTexts,
+  size_t                           *Distances
+  );
+
+/*
+  Calculates the character class histogram of String for
+  ScLevenshteinHistogramBound().
+
+  @param[out] Histogram     The histogram to initialise. It must be
+                            SC_LEVENSHTEIN_HISTOGRAM_SIZE elements in size.
+  @param[in]  String        The string to calculate the histogram of.
+  @param[in]  StringLength  The length, in characters, of String.
+*/
+void ScLevenshteinHistogramInitialise(
+  uint8_t    *Histogram,
+  const char *String,
+  size_t     StringLength
+  );
+
+/*
+  Calculates a lower bound of the Levenshtein distance between two strings
+  from their character class histograms.
+
+  @param[in] Histogram1  The histogram of the first string.
+  @param[in] Histogram2  The histogram of the second string.
+
+  @returns  A lower bound of the Levenshtein distance between both strings. It
+            is at least the difference of their lengths if neither exceeds
+            UINT8_MAX characters per class.
+*/
+size_t ScLevenshteinHistogramBound(
+  const uint8_t *Histogram1,
+  const uint8_t *Histogram2
+  );
+
 #endif // SC_DISTANCES_H_
@@ -0,0 +1,165 @@
+/*@file
+  Provides APIs to partition the file list into blocks within a memory budget
+  and to schedule the loading and freeing of the blocks while their pairings
+  are rated.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_FILE_BLOCKS_H_
+#define SC_FILE_BLOCKS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// The maximum number of file blocks held at once: the two blocks being rated
+/// and the block being loaded for the next step.
+///
+#define SC_MAX_RESIDENT_BLOCKS  3U
+
+///
+/// A range of consecutive files that are loaded and freed together.
+///
+typedef struct {
+  ///
+  /// The index of the first file of the block.
+  ///
+  unsigned int Start;
+  ///
+  /// The index past the last file of the block.
+  ///
+  unsigned int End;
+} sc_file_block_t;
+
+///
+/// The steps to rate the pairings of the files block by block. Every step
+/// rates the pairings of the files of one row block with those of the same or
+/// a later column block. Only row blocks with query files are visited.
+///
+typedef struct {
+  ///
+  /// The indices of the loaded blocks.
+  ///
+  unsigned int Resident[SC_MAX_RESIDENT_BLOCKS];
+  ///
+  /// The number of elements in Resident.
+  ///
+  unsigned int NumResident;
+  ///
+  /// The indices of the blocks being loaded for the next step.
+  ///
+  unsigned int Loading[2];
+  ///
+  /// The number of elements in Loading.
+  ///
+  unsigned int NumLoading;
+  ///
+  /// The index of the row block of the next step.
+  ///
+  unsigned int Row;
+  ///
+  /// The index of the column block of the next step.
+  ///
+  unsigned int Column;
+  ///
+  /// The number of blocks.
+  ///
+  unsigned int NumBlocks;
+  ///
+  /// The number of blocks with query files.
+  ///
+  unsigned int NumRowBlocks;
+  ///
+  /// Whether there is a next step.
+  ///
+  bool         HasStep;
+} sc_file_block_steps_t;
+
+/*
+  Partitions the file list into blocks of consecutive files, whose estimated
+  memory footprint is at most BlockBudget each. Files that exceed it by
+  themselves form a block of their own.
+
+  @param[in]  FileSizes    The size, in bytes, of every file. Sizes that are
+                           not known in advance are SIZE_MAX.
+  @param[in]  NumFiles     The number of elements in FileSizes.
+  @param[in]  MaxFileSize  The maximum size, in bytes, of accepted files.
+  @param[in]  BlockBudget  The memory budget, in bytes, of every block.
+  @param[out] Blocks       The blocks. It must be able to hold NumFiles
+                           elements.
+
+  @returns  The number of blocks.
+*/
+unsigned int ScFileBlocksPartition(
+  const size_t    *FileSizes,
+  unsigned int    NumFiles,
+  size_t          MaxFileSize,
+  uint64_t        BlockBudget,
+  sc_file_block_t *Blocks
+  );
+
+/*
+  Starts the steps of rating the pairings of the files block by block. No
+  block must be loaded.
+
+  @param[out] Steps        The steps.
+  @param[in]  Blocks       The blocks partitioning the file list.
+  @param[in]  NumBlocks    The number of elements in Blocks. It must not be 0.
+  @param[in]  NumRowFiles  The number of leading query files.
+  @param[out] Load         The indices of the blocks to load before the first
+                           step.
+
+  @returns  The number of elements written to Load.
+*/
+unsigned int ScFileBlocksStart(
+  sc_file_block_steps_t *Steps,
+  const sc_file_block_t *Blocks,
+  unsigned int          NumBlocks,
+  unsigned int          NumRowFiles,
+  unsigned int          Load[2]
+  );
+
+/*
+  Advances to the next step. The blocks of the step are loaded once the
+  blocks to load of the previous call are.
+
+  @param[in,out] Steps     The steps.
+  @param[out]    Row       If there is a step, the index of its row block.
+  @param[out]    Column    If there is a step, the index of its column block.
+  @param[out]    Evict     The indices of the blocks to free, which are not
+                           needed anymore. Once all steps are done, these are
+                           all remaining loaded blocks.
+  @param[out]    NumEvict  The number of elements written to Evict.
+  @param[out]    Load      The indices of the blocks to load while rating the
+                           step, which the next step needs.
+  @param[out]    NumLoad   The number of elements written to Load.
+
+  @returns  Whether there is a step.
+*/
+bool ScFileBlocksNextStep(
+  sc_file_block_steps_t *Steps,
+  unsigned int          *Row,
+  unsigned int          *Column,
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS],
+  unsigned int          *NumEvict,
+  unsigned int          Load[2],
+  unsigned int          *NumLoad
+  );
+
+/*
+  Stops the steps before all are done, e.g. on failure.
+
+  @param[in,out] Steps  The steps.
+  @param[out]    Evict  The indices of all blocks that are loaded or are being
+                        loaded, which are to be freed.
+
+  @returns  The number of elements written to Evict.
+*/
+unsigned int ScFileBlocksStop(
+  sc_file_block_steps_t *Steps,
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS]
+  );
+
+#endif // SC_FILE_BLOCKS_H_
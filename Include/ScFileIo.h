@@ -10,6 +10,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /*
   Reads the file from path FileName.
@@ -29,21 +30,137 @@ char *ScReadFile(
   size_t     MaxFileSize
   );
 
+/*
+  Reads the remaining contents of FileHandle, whose size is not known in
+  advance, e.g. for pipes.
+
+  @param[out] FileSize     A pointer into which the file buffer's size is
+                           returned.
+  @param[in]  FileHandle   The handle of the file to read.
+  @param[in]  MaxFileSize  The maximum number of bytes to read. It must be
+                           smaller than SIZE_MAX.
+
+  @retval NULL   An unexpected error has occured or the contents exceed
+                 MaxFileSize, no memory has been allocated.
+  @retval other  A buffer containing the file's content. It is allocated by
+                 malloc and caller-owned. It holds at least one byte past
+                 *FileSize, e.g. for a terminator.
+*/
+char *ScReadFileStream(
+  size_t *FileSize,
+  FILE   *FileHandle,
+  size_t MaxFileSize
+  );
+
+/*
+  Reads the remaining contents of FileHandle as a list of file paths and
+  splits it in-place. Empty paths are skipped, and carriage returns of lists
+  with Windows line endings are stripped.
+
+  @param[out] Paths         On success, the terminated paths, which point into
+                            the returned buffer. They are allocated with
+                            malloc and caller-owned.
+  @param[out] NumPaths      On success, the number of elements in Paths.
+  @param[in]  FileHandle    The handle of the list to read, e.g. stdin.
+  @param[in]  NulSeparated  Whether the paths are separated by NUL characters
+                            instead of new lines.
+
+  @retval NULL   An unexpected error has occured, no memory has been allocated.
+  @retval other  The buffer holding the paths. It is allocated with malloc and
+                 caller-owned.
+*/
+char *ScReadFileList(
+  char   ***Paths,
+  size_t *NumPaths,
+  FILE   *FileHandle,
+  bool   NulSeparated
+  );
+
+/*
+  Maps the file from path FileName into memory copy-on-write, where supported.
+  Files that cannot be mapped, e.g. pipes, are read by ScReadFile() instead.
+
+  @param[out] FileSize     A pointer into which the file buffer's size is
+                           returned.
+  @param[out] MappingSize  A pointer into which the size of the mapping is
+                           returned. It is 0 if the file has been read.
+  @param[in]  FileName     The path of the file to map.
+  @param[in]  MaxFileSize  The maximum number of bytes to map.
+  @param[in]  Prefetch     Whether to start reading the file asynchronously,
+                           so that many files can be fetched concurrently.
+
+  @retval NULL   An unexpected error has occured, no memory has been allocated.
+  @retval other  A writable buffer containing the file's content. Writes do
+                 not affect the file. It must be freed by ScUnmapFile().
+*/
+char *ScMapFile(
+  size_t     *FileSize,
+  size_t     *MappingSize,
+  const char *FileName,
+  size_t     MaxFileSize,
+  bool       Prefetch
+  );
+
+/*
+  Frees a file buffer returned by ScMapFile().
+
+  @param[in] Buffer       The file buffer to free.
+  @param[in] MappingSize  The mapping size returned by ScMapFile().
+*/
+void ScUnmapFile(
+  char   *Buffer,
+  size_t MappingSize
+  );
+
 /*
   Writes a file to path FileName.
 
-  @param[in]  FileData  The data to write to the file. It does not need to be
-                        terminated.
-  @param[out] FileSize  The size of FileData, in bytes, to write.
-  @param[in]  FileName  The path of the file to write. It needs to be properly
-                        terminated.
+  @param[in] FileName  The path of the file to write. It needs to be properly
+                       terminated.
+  @param[in] FileSize  The size of Buffer, in bytes, to write.
+  @param[in] Buffer    The data to write to the file. It does not need to be
+                       terminated.
 
   @returns  Whether the file has been written successfully.
 */
 bool ScWriteFile(
-  const char *FileData,
+  const char *FileName,
   size_t     FileSize,
-  const char *FileName
+  const char *Buffer
+  );
+
+/*
+  Replaces the file at path FileName. The data is written to a uniquely named
+  temporary file first, which is moved into place, so that concurrent readers
+  never observe partially written files and concurrent writers, including
+  those of other processes, never write to the same file.
+
+  @param[in] FileName  The path of the file to replace. It needs to be
+                       properly terminated.
+  @param[in] FileSize  The size of Buffer, in bytes, to write.
+  @param[in] Buffer    The data to write to the file. It does not need to be
+                       terminated.
+
+  @returns  Whether the file has been replaced successfully.
+*/
+bool ScReplaceFile(
+  const char *FileName,
+  size_t     FileSize,
+  const char *Buffer
+  );
+
+/*
+  Retrieves the size of the regular file at path FileName without reading it.
+
+  @param[in]  FileName  The path of the file to inspect.
+  @param[out] FileSize  On success, the size, in bytes, of the file.
+
+  @returns  Whether the size has been retrieved. It cannot be retrieved for
+            files that are no regular files, e.g. pipes.
+*/
+bool ScGetFileSize(
+  const char *FileName,
+  size_t     *FileSize
   );
 
 /*
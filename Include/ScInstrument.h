@@ -0,0 +1,203 @@
+/*@file
+  Provides APIs to measure the phases of a run and to count hot-path events.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_INSTRUMENT_H_
+#define SC_INSTRUMENT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//
+// Instrumentation is compiled out unless it is requested at build time.
+//
+#ifndef SC_INSTRUMENTATION
+  #define SC_INSTRUMENTATION  0
+#endif
+
+///
+/// The events counted by the instrumentation.
+///
+typedef enum {
+  ///
+  /// The number of file pairings rated.
+  ///
+  ScInstrumentCounterPairings,
+  ///
+  /// The number of candidate line pairs within the line swap windows.
+  ///
+  ScInstrumentCounterWindowCandidates,
+  ///
+  /// The number of candidate line pairs skipped as no distance could improve
+  /// the best match, or as a lower bound of their distance exceeds the
+  /// distances of interest.
+  ///
+  ScInstrumentCounterWindowPruned,
+  ///
+  /// The number of candidate line pairs whose distance has been determined
+  /// exactly without calculating it, i.e. identical lines and cached
+  /// distances.
+  ///
+  ScInstrumentCounterWindowResolved,
+  ///
+  /// The number of Levenshtein distances calculated.
+  ///
+  ScInstrumentCounterDistances,
+  ///
+  /// The number of Levenshtein matrix cells of the calculated distances.
+  ///
+  ScInstrumentCounterDpCells,
+  ///
+  /// The number of line pair distance cache lookups.
+  ///
+  ScInstrumentCounterCacheLookups,
+  ///
+  /// The number of line pair distance cache lookups that found an entry.
+  ///
+  ScInstrumentCounterCacheHits,
+  ScInstrumentCounterMax
+} sc_instrument_counter_t;
+
+///
+/// The phases whose durations are measured per thread.
+///
+typedef enum {
+  ScInstrumentPhaseRead,
+  ScInstrumentPhaseCleanse,
+  ScInstrumentPhaseLineInfo,
+  ScInstrumentPhaseSketch,
+  ScInstrumentPhaseCompare,
+  ScInstrumentPhasePrint,
+  ScInstrumentPhaseMax
+} sc_instrument_phase_t;
+
+///
+/// The regions whose wall and CPU times are measured as a whole. Every phase
+/// belongs to one region.
+///
+typedef enum {
+  ScInstrumentRegionLoad,
+  ScInstrumentRegionCompare,
+  ScInstrumentRegionPrint,
+  ScInstrumentRegionMax
+} sc_instrument_region_t;
+
+///
+/// The start of a region measurement.
+///
+typedef struct {
+  ///
+  /// The wall time, in seconds, at the start.
+  ///
+  double Wall;
+  ///
+  /// The processor time, in seconds, of the process at the start.
+  ///
+  double Cpu;
+} sc_instrument_mark_t;
+
+/*
+  Prepares the instrumentation for up to NumThreads threads and resets all
+  measurements. Events of threads with larger thread numbers are not
+  recorded.
+
+  @param[in] NumThreads  The number of threads to record events of.
+
+  @returns  Whether the instrumentation has been prepared successfully.
+*/
+bool ScInstrumentInitialise(
+  unsigned int NumThreads
+  );
+
+/*
+  Frees the resources of the instrumentation. Afterwards, no events are
+  recorded until ScInstrumentInitialise() is called again.
+*/
+void ScInstrumentFree(void);
+
+/*
+  Returns the current wall time, in seconds.
+*/
+double ScInstrumentGetTime(void);
+
+/*
+  Returns the current wall and processor times.
+*/
+sc_instrument_mark_t ScInstrumentGetMark(void);
+
+/*
+  Adds Value to the counter Counter of the calling thread.
+
+  @param[in] Counter  The counter to add to.
+  @param[in] Value    The value to add.
+*/
+void ScInstrumentCount(
+  sc_instrument_counter_t Counter,
+  uint64_t                Value
+  );
+
+/*
+  Adds Seconds to the duration of the phase Phase of the calling thread.
+
+  @param[in] Phase    The phase to add to.
+  @param[in] Seconds  The duration to add.
+*/
+void ScInstrumentAddPhaseTime(
+  sc_instrument_phase_t Phase,
+  double                Seconds
+  );
+
+/*
+  Adds the times elapsed since Start to the region Region. It must be called
+  outside of parallel regions.
+
+  @param[in] Region  The region to add to.
+  @param[in] Start   The start of the measurement.
+*/
+void ScInstrumentAddRegionTime(
+  sc_instrument_region_t     Region,
+  const sc_instrument_mark_t *Start
+  );
+
+/*
+  Writes all measurements as a JSON object to Stream.
+
+  @param[in,out] Stream  The stream to write to.
+
+  @returns  Whether the report has been written successfully.
+*/
+bool ScInstrumentReport(
+  FILE *Stream
+  );
+
+//
+// Hot paths use the following macros, which expand to nothing unless
+// instrumentation is enabled. Their arguments must not have side effects.
+//
+#if SC_INSTRUMENTATION
+  #define SC_INSTRUMENT_COUNT(Counter, Value)  \
+    ScInstrumentCount((Counter), (uint64_t) (Value))
+
+  #define SC_INSTRUMENT_PHASE_START(Timer)  \
+    const double Timer = ScInstrumentGetTime()
+
+  #define SC_INSTRUMENT_PHASE_STOP(Timer, Phase)  \
+    ScInstrumentAddPhaseTime((Phase), ScInstrumentGetTime() - (Timer))
+
+  #define SC_INSTRUMENT_REGION_START(Mark)  \
+    const sc_instrument_mark_t Mark = ScInstrumentGetMark()
+
+  #define SC_INSTRUMENT_REGION_STOP(Mark, Region)  \
+    ScInstrumentAddRegionTime((Region), &(Mark))
+#else
+  #define SC_INSTRUMENT_COUNT(Counter, Value)      ((void) 0)
+  #define SC_INSTRUMENT_PHASE_START(Timer)         ((void) 0)
+  #define SC_INSTRUMENT_PHASE_STOP(Timer, Phase)   ((void) 0)
+  #define SC_INSTRUMENT_REGION_START(Mark)         ((void) 0)
+  #define SC_INSTRUMENT_REGION_STOP(Mark, Region)  ((void) 0)
+#endif
+
+#endif // SC_INSTRUMENT_H_
@@ -0,0 +1,105 @@
+/*@file
+  Provides APIs to memoise distances between pairs of lines.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_LINE_CACHE_H_
+#define SC_LINE_CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// The maximum distance that can be stored in the line pair distance cache.
+///
+#define SC_LINE_CACHE_MAX_DISTANCE  0x7FFFU
+
+///
+/// A single slot of the line pair distance cache.
+///
+typedef struct {
+  ///
+  /// The primary key of the line pair. 0 denotes an empty slot.
+  ///
+  uint64_t Key;
+  ///
+  /// The secondary key of the line pair in the upper 48 bits and the distance
+  /// in the lower 16 bits. If the top bit of the distance is set, the
+  /// remaining bits denote a lower bound of the distance.
+  ///
+  uint64_t TagDistance;
+} sc_line_cache_slot_t;
+
+///
+/// A fixed-size, lossy cache mapping pairs of line hashes to their distance.
+/// It may be shared by all threads without locking, as every slot word is
+/// accessed atomically and torn slots fail the secondary key check.
+///
+typedef struct {
+  ///
+  /// The mask to map a primary key to the index of a slot in Slots.
+  ///
+  size_t               SlotMask;
+  ///
+  /// The cache slots.
+  ///
+  sc_line_cache_slot_t Slots[];
+} sc_line_cache_t;
+
+/*
+  Creates an empty line pair distance cache.
+
+  @param[in] NumSlotsLog2  The binary logarithm of the number of slots.
+
+  @retval NULL   An error has occured.
+  @retval other  The line pair distance cache. It is allocated with malloc and
+                 caller-owned.
+*/
+sc_line_cache_t *ScLineCacheCreate(
+  size_t NumSlotsLog2
+  );
+
+/*
+  Looks up the distance between the lines with hashes Hash1 and Hash2. The
+  order of the hashes is irrelevant.
+
+  @param[in]  Cache     The line pair distance cache.
+  @param[in]  Hash1     The hash of the first line.
+  @param[in]  Hash2     The hash of the second line.
+  @param[out] Distance  On success, the cached distance or lower bound.
+  @param[out] Exact     On success, whether Distance is the exact distance
+                        rather than a lower bound.
+
+  @returns  Whether the distance has been found in Cache.
+*/
+bool ScLineCacheLookup(
+  const sc_line_cache_t *Cache,
+  uint64_t              Hash1,
+  uint64_t              Hash2,
+  size_t                *Distance,
+  bool                  *Exact
+  );
+
+/*
+  Stores the distance between the lines with hashes Hash1 and Hash2. An older
+  entry may be evicted. The order of the hashes is irrelevant.
+
+  @param[in,out] Cache     The line pair distance cache.
+  @param[in]     Hash1     The hash of the first line.
+  @param[in]     Hash2     The hash of the second line.
+  @param[in]     Distance  The distance or lower bound to store. It must be
+                           at most SC_LINE_CACHE_MAX_DISTANCE.
+  @param[in]     Exact     Whether Distance is the exact distance rather than
+                           a lower bound.
+*/
+void ScLineCacheInsert(
+  sc_line_cache_t *Cache,
+  uint64_t        Hash1,
+  uint64_t        Hash2,
+  size_t          Distance,
+  bool            Exact
+  );
+
+#endif // SC_LINE_CACHE_H_
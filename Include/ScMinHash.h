@@ -0,0 +1,64 @@
+/*@file
+  Provides APIs to estimate the similarity of sets of hashes.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_MIN_HASH_H_
+#define SC_MIN_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// The number of hash functions of a MinHash sketch. The standard error of the
+/// similarity estimate is at most 1 / (2 * sqrt(SC_MIN_HASH_NUM_HASHES)).
+///
+#define SC_MIN_HASH_NUM_HASHES  64U
+
+///
+/// A MinHash sketch of a set of hashes.
+///
+typedef struct {
+  ///
+  /// The minimum over the set for every hash function.
+  ///
+  uint64_t Minima[SC_MIN_HASH_NUM_HASHES];
+} sc_min_hash_t;
+
+/*
+  Initialises Sketch to represent the empty set.
+
+  @param[out] Sketch  The sketch to initialise.
+*/
+void ScMinHashInitialise(
+  sc_min_hash_t *Sketch
+  );
+
+/*
+  Adds Hash to the set represented by Sketch. Adding a hash more than once has
+  no effect.
+
+  @param[in,out] Sketch  The sketch to add Hash to.
+  @param[in]     Hash    The well-distributed hash to add.
+*/
+void ScMinHashAdd(
+  sc_min_hash_t *Sketch,
+  uint64_t      Hash
+  );
+
+/*
+  Estimates the Jaccard similarity of the sets represented by Sketch1 and
+  Sketch2.
+
+  @param[in] Sketch1  The sketch of the first set.
+  @param[in] Sketch2  The sketch of the second set.
+
+  @returns  The estimated similarity between 0 and 1.
+*/
+double ScMinHashSimilarity(
+  const sc_min_hash_t *Sketch1,
+  const sc_min_hash_t *Sketch2
+  );
+
+#endif // SC_MIN_HASH_H_
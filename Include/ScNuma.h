@@ -0,0 +1,75 @@
+/*@file
+  Provides APIs to map the OpenMP places the threads are bound to onto the NUMA
+  domains of the system.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_NUMA_H_
+#define SC_NUMA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Parses the next range of a system ID list, e.g. "0-3,8-11", as found in the
+  cpulist files of Linux sysfs.
+
+  @param[in,out] List   The position within the list. On success, it is
+                        advanced past the range and its separator.
+  @param[out]    First  On success, the first ID of the range.
+  @param[out]    Last   On success, the last ID of the range.
+
+  @returns  Whether a range has been parsed. It is false at the end of the
+            list and for malformed ranges.
+*/
+bool ScNumaParseIdRange(
+  const char    **List,
+  unsigned long *First,
+  unsigned long *Last
+  );
+
+/*
+  Returns the NUMA node of every processor. Only Linux sysfs is supported, on
+  other platforms the nodes are always unknown.
+
+  @param[out] NumProcs  On success, the number of returned nodes.
+
+  @retval NULL   The nodes are unknown.
+  @retval other  The node of every processor ID, or UINT_MAX for IDs of no
+                 node. It is allocated with malloc and caller-owned.
+*/
+unsigned int *ScNumaGetProcNodes(
+  size_t *NumProcs
+  );
+
+/*
+  Returns the NUMA domain of every OpenMP place the threads are bound to. If
+  the nodes of the processors are known, the places are grouped by the node of
+  their processors, so that places of cores or hardware threads share the
+  domain of their node. Otherwise, the places are only considered domains with
+  OMP_PLACES=sockets or OMP_PLACES=numa_domains.
+
+  @param[out] NumDomains  The number of NUMA domains the threads are bound to.
+                          It is 1 if the result is NULL.
+
+  @retval NULL   The threads are not bound to multiple domains.
+  @retval other  The domain of every place, numbered from 0 in the order of
+                 the places. It is allocated with malloc and caller-owned.
+*/
+unsigned int *ScNumaCreatePlaceDomains(
+  unsigned int *NumDomains
+  );
+
+/*
+  Returns the NUMA domain the calling thread is bound to.
+
+  @param[in] PlaceDomains  The domain of every place of
+                           ScNumaCreatePlaceDomains(). If it is NULL, all
+                           threads share domain 0.
+*/
+unsigned int ScNumaGetThreadDomain(
+  const unsigned int *PlaceDomains
+  );
+
+#endif // SC_NUMA_H_
@@ -0,0 +1,156 @@
+/*@file
+  Provides APIs to write the ratings of file pairings in the text and binary
+  output formats.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_OUTPUT_H_
+#define SC_OUTPUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+///
+/// The version of the binary output formats.
+///
+#define SC_OUTPUT_VERSION  1U
+
+///
+/// The formats to output the ratings in.
+///
+typedef enum {
+  ///
+  /// One "index1 index2 score" line per pairing.
+  ///
+  ScOutputFormatText,
+  ///
+  /// One sc_output_record_t per pairing.
+  ///
+  ScOutputFormatRecords,
+  ///
+  /// The rows of the upper triangle of the rating matrix as float values.
+  ///
+  ScOutputFormatMatrix
+} sc_output_format_t;
+
+///
+/// The header of the binary output formats. All values are stored in the byte
+/// order of the host.
+///
+typedef struct {
+  ///
+  /// "SCRR" for the record format and "SCRM" for the matrix format.
+  ///
+  char     Magic[4];
+  ///
+  /// SC_OUTPUT_VERSION.
+  ///
+  uint32_t Version;
+  ///
+  /// The number of files.
+  ///
+  uint32_t NumFiles;
+  ///
+  /// The number of leading query files, whose pairings are rated.
+  ///
+  uint32_t NumRowFiles;
+} sc_output_header_t;
+
+///
+/// A rated pairing of the record format.
+///
+typedef struct {
+  ///
+  /// The index of the first file within the input file paths.
+  ///
+  uint32_t File1Index;
+  ///
+  /// The index of the second file within the input file paths.
+  ///
+  uint32_t File2Index;
+  ///
+  /// The score of the pairing, as in the text format.
+  ///
+  float    Score;
+} sc_output_record_t;
+
+_Static_assert(
+  sizeof(sc_output_header_t) == 16 && sizeof(sc_output_record_t) == 12,
+  "The binary output structures must not be padded."
+  );
+
+/*
+  Writes the header of the binary output format Format to Stream.
+
+  @param[in,out] Stream       The stream to write to.
+  @param[in]     Format       The binary output format.
+  @param[in]     NumFiles     The number of files.
+  @param[in]     NumRowFiles  The number of leading query files.
+
+  @returns  Whether the header has been written successfully.
+*/
+bool ScOutputWriteHeader(
+  FILE               *Stream,
+  sc_output_format_t Format,
+  unsigned int       NumFiles,
+  unsigned int       NumRowFiles
+  );
+
+/*
+  Writes the rating of a file pairing in the text or record format to Stream.
+  Write errors are reported by ScOutputFinish().
+
+  @param[in,out] Stream      The stream to write to.
+  @param[in]     Format      The text or record format.
+  @param[in]     File1Index  The index of the first file within the input
+                             paths.
+  @param[in]     File2Index  The index of the second file within the input
+                             paths.
+  @param[in]     Score       The score of the pairing.
+*/
+void ScOutputWriteRating(
+  FILE               *Stream,
+  sc_output_format_t Format,
+  unsigned int       File1Index,
+  unsigned int       File2Index,
+  double             Score
+  );
+
+/*
+  Writes the ratings of a rating matrix in the matrix format to Stream: the
+  header, the input path index of every file, and the ratings of every query
+  file with all larger files.
+
+  @param[in,out] Stream       The stream to write to.
+  @param[in]     FileIndices  The input path index of every file.
+  @param[in]     NumFiles     The number of files.
+  @param[in]     NumRowFiles  The number of leading query files.
+  @param[in]     Ratings      The ratings of every query file with all larger
+                              files, row by row.
+
+  @returns  Whether the matrix has been written successfully.
+*/
+bool ScOutputWriteMatrix(
+  FILE               *Stream,
+  const unsigned int *FileIndices,
+  unsigned int       NumFiles,
+  unsigned int       NumRowFiles,
+  const double       *Ratings
+  );
+
+/*
+  Flushes Stream and reports whether all output has been written successfully.
+  Ratings are written without checking every single write, hence this must be
+  called once all output is complete.
+
+  @param[in,out] Stream  The stream that has been written to.
+
+  @returns  Whether all output has been written successfully.
+*/
+bool ScOutputFinish(
+  FILE *Stream
+  );
+
+#endif // SC_OUTPUT_H_
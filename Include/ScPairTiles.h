@@ -0,0 +1,169 @@
+/*@file
+  Provides APIs to split the file pairings of a rating matrix into tiles of
+  balanced cost and to schedule them onto NUMA domains.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_PAIR_TILES_H_
+#define SC_PAIR_TILES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// The properties of a file that determine the cost of rating its pairings.
+///
+typedef struct {
+  ///
+  /// The number of lines of the file. It is 0 for files that are not rated.
+  ///
+  size_t NumLines;
+  ///
+  /// The length, in characters, of the file.
+  ///
+  size_t Length;
+} sc_tile_file_t;
+
+///
+/// A rectangular tile of file pairings of the upper triangle of the rating
+/// matrix.
+///
+typedef struct {
+  ///
+  /// The estimated cost of rating all pairings of the tile.
+  ///
+  uint64_t     Cost;
+  ///
+  /// The index of the first file of the tile's rows.
+  ///
+  unsigned int RowStart;
+  ///
+  /// The index past the last file of the tile's rows.
+  ///
+  unsigned int RowEnd;
+  ///
+  /// The index of the first file of the tile's columns.
+  ///
+  unsigned int ColumnStart;
+  ///
+  /// The index past the last file of the tile's columns.
+  ///
+  unsigned int ColumnEnd;
+  ///
+  /// The NUMA domain that holds the data of most of the tile's files.
+  ///
+  unsigned int Domain;
+} sc_pair_tile_t;
+
+///
+/// The queue of the tiles of a NUMA domain.
+///
+typedef struct {
+  ///
+  /// The index of the next tile to rate.
+  ///
+  size_t        Next;
+  ///
+  /// The index past the last tile of the domain.
+  ///
+  size_t        End;
+  ///
+  /// Separates the queues of neighbouring domains by at least a cache line to
+  /// prevent false sharing.
+  ///
+  unsigned char Padding[64];
+} sc_domain_queue_t;
+
+/*
+  Splits the pairings of the files with indices in [RowStart, RowEnd) with the
+  larger files with indices in [ColumnStart, ColumnEnd) into tiles ordered from
+  most to least expensive. The pairings of the whole rating matrix are covered
+  by RowStart = ColumnStart = 0.
+
+  @param[in]  Files        The cost properties of all files.
+  @param[in]  RowStart     The index of the first file of the rows.
+  @param[in]  RowEnd       The index past the last file of the rows.
+  @param[in]  ColumnStart  The index of the first file of the columns. It must
+                           be at most RowStart or at least RowEnd.
+  @param[in]  ColumnEnd    The index past the last file of the columns.
+  @param[in]  MinNumTiles  The number of tiles to balance the load across.
+  @param[out] NumTiles     On success, the number of returned tiles.
+  @param[out] TileSize     On success, the edge length, in files, of the tiles.
+                           The tiles start at multiples of it from RowStart
+                           and ColumnStart, and only those at the ends are
+                           smaller.
+
+  @retval NULL   An error has occured.
+  @retval other  The tiles. They are allocated with malloc and caller-owned.
+*/
+sc_pair_tile_t *ScPairTilesCreate(
+  const sc_tile_file_t *Files,
+  unsigned int         RowStart,
+  unsigned int         RowEnd,
+  unsigned int         ColumnStart,
+  unsigned int         ColumnEnd,
+  size_t               MinNumTiles,
+  size_t               *NumTiles,
+  unsigned int         *TileSize
+  );
+
+/*
+  Assigns every tile to the NUMA domain that holds the data of most of its
+  files and groups the tiles by their domains. Within every domain, they stay
+  ordered from most to least expensive.
+
+  @param[in,out] Tiles        The tiles ordered from most to least expensive.
+  @param[in]     NumTiles     The number of elements in Tiles.
+  @param[in]     FileDomains  The domain of every file.
+  @param[in]     NumDomains   The number of domains.
+*/
+void ScPairTilesAssignDomains(
+  sc_pair_tile_t     *Tiles,
+  size_t             NumTiles,
+  const unsigned int *FileDomains,
+  unsigned int       NumDomains
+  );
+
+/*
+  Creates the queues of the tiles of every NUMA domain.
+
+  @param[in] Tiles       The tiles grouped by ScPairTilesAssignDomains().
+  @param[in] NumTiles    The number of elements in Tiles.
+  @param[in] NumDomains  The number of domains.
+
+  @retval NULL   An error has occured.
+  @retval other  The queue of every domain. It is allocated with malloc and
+                 caller-owned.
+*/
+sc_domain_queue_t *ScPairTilesCreateQueues(
+  const sc_pair_tile_t *Tiles,
+  size_t               NumTiles,
+  unsigned int         NumDomains
+  );
+
+/*
+  Takes the next tile to rate for a thread of the domain Home. The tiles of
+  Home are taken first, then those of the other domains in turn. It may be
+  called concurrently.
+
+  @param[in,out] Queues      The queues of ScPairTilesCreateQueues().
+  @param[in]     NumDomains  The number of domains.
+  @param[in]     Home        The domain of the calling thread.
+  @param[in,out] Step        The number of domains the calling thread has
+                             exhausted. It must be 0 for the first call.
+  @param[out]    TileIndex   On success, the index of the taken tile.
+
+  @returns  Whether a tile has been taken. It is false once all queues have
+            been exhausted.
+*/
+bool ScPairTilesDequeue(
+  sc_domain_queue_t *Queues,
+  unsigned int      NumDomains,
+  unsigned int      Home,
+  unsigned int      *Step,
+  size_t            *TileIndex
+  );
+
+#endif // SC_PAIR_TILES_H_
@@ -0,0 +1,52 @@
+/*@file
+  Provides APIs to select the file pairings to rate again.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_RESCORE_H_
+#define SC_RESCORE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Retrieves the number of file pairings the leading query files form with all
+  files that follow them.
+
+  @param[in] NumFiles     The number of files.
+  @param[in] NumRowFiles  The number of leading query files. It must be at
+                          most NumFiles.
+
+  @returns  The number of file pairings.
+*/
+size_t ScGetNumRatedPairings(
+  unsigned int NumFiles,
+  unsigned int NumRowFiles
+  );
+
+/*
+  Calculates the minimum rating of the best fraction of the rated file
+  pairings. Ratings that are negative or not finite have not been rated and
+  are not considered.
+
+  @param[in]  Ratings      The ratings of the file pairings of the query files
+                           in row-major order.
+  @param[in]  NumFiles     The number of files.
+  @param[in]  NumRowFiles  The number of leading query files. It must be at
+                           most NumFiles.
+  @param[in]  Fraction     The fraction of the rated pairings to select.
+  @param[out] Cutoff       On success, the minimum rating of the selected
+                           pairings. If none is selected, it is INFINITY.
+
+  @returns  Whether the cutoff has been calculated successfully.
+*/
+bool ScGetRescoreCutoff(
+  const double *Ratings,
+  unsigned int NumFiles,
+  unsigned int NumRowFiles,
+  double       Fraction,
+  double       *Cutoff
+  );
+
+#endif // SC_RESCORE_H_
@@ -0,0 +1,268 @@
+/*@file
+  Provides APIs to split the file pairings into cost-balanced shards and to
+  merge the outputs of all shards.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_SHARD_H_
+#define SC_SHARD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <ScOutput.h>
+#include <ScPairTiles.h>
+#include <ScTopMatches.h>
+
+///
+/// A rating read from the output of a shard to merge.
+///
+typedef struct {
+  ///
+  /// The index of the first file of the pairing.
+  ///
+  unsigned int File1Index;
+  ///
+  /// The score and the index of the second file of the pairing.
+  ///
+  sc_match_t   Match;
+} sc_shard_rating_t;
+
+///
+/// The output of a shard that is read as a stream to merge.
+///
+typedef struct {
+  ///
+  /// The handle of the output.
+  ///
+  FILE              *Handle;
+  ///
+  /// The current rating of the output.
+  ///
+  sc_shard_rating_t Rating;
+  ///
+  /// Whether the output is in the record format.
+  ///
+  bool              Records;
+  ///
+  /// Whether Rating is valid. It is false once the output has ended.
+  ///
+  bool              HasRating;
+} sc_shard_stream_t;
+
+///
+/// The ratings of the tiles of a shard, which are output ordered by their
+/// files once all are rated. The rating matrix is divided into a grid of
+/// cells of the tile size, of which the shard holds the ratings of its own.
+///
+typedef struct {
+  ///
+  /// The ratings of every tile of the shard, row by row.
+  ///
+  double       *Ratings;
+  ///
+  /// The offset of the ratings of every cell of the grid within Ratings, row
+  /// by row. It is SIZE_MAX for the cells of other shards.
+  ///
+  size_t       *Offsets;
+  ///
+  /// The edge length, in files, of the cells.
+  ///
+  unsigned int TileSize;
+  ///
+  /// The number of rows of cells.
+  ///
+  unsigned int NumRows;
+  ///
+  /// The number of columns of cells.
+  ///
+  unsigned int NumColumns;
+  ///
+  /// The number of files.
+  ///
+  unsigned int NumFiles;
+  ///
+  /// The number of leading query files.
+  ///
+  unsigned int NumRowFiles;
+} sc_shard_ratings_t;
+
+///
+/// The results of merging the outputs of shards.
+///
+typedef enum {
+  ///
+  /// The outputs have been merged successfully.
+  ///
+  ScShardStatusSuccess,
+  ///
+  /// Memory could not be allocated.
+  ///
+  ScShardStatusAllocationError,
+  ///
+  /// A shard output could not be read or is malformed.
+  ///
+  ScShardStatusReadError,
+  ///
+  /// A shard output is not ordered by its files.
+  ///
+  ScShardStatusUnordered,
+  ///
+  /// The merged output could not be written.
+  ///
+  ScShardStatusOutputError
+} sc_shard_status_t;
+
+/*
+  Assigns the tiles to NumShards shards of balanced cost and keeps only the
+  tiles of the shard with index ShardIndex. The assignment only depends on the
+  tiles, so that all shards agree on it.
+
+  @param[in,out] Tiles       The tiles ordered from most to least expensive.
+                             On output, the leading tiles are those of the
+                             shard in their original order.
+  @param[in]     NumTiles    The number of elements in Tiles.
+  @param[in]     ShardIndex  The index of the shard to keep the tiles of.
+  @param[in]     NumShards   The number of shards.
+  @param[out]    NumKept     On success, the number of kept tiles.
+
+  @returns  Whether the tiles have been assigned successfully.
+*/
+bool ScShardSelectTiles(
+  sc_pair_tile_t *Tiles,
+  size_t         NumTiles,
+  unsigned int   ShardIndex,
+  unsigned int   NumShards,
+  size_t         *NumKept
+  );
+
+/*
+  Allocates the ratings of the tiles of a shard.
+
+  @param[out] ShardRatings  On success, the ratings of the tiles.
+  @param[in]  Tiles         The tiles of the shard, as split by
+                            ScPairTilesCreate() for the whole rating matrix.
+  @param[in]  NumTiles      The number of elements in Tiles.
+  @param[in]  TileSize      The tile size of ScPairTilesCreate().
+  @param[in]  NumFiles      The number of files.
+  @param[in]  NumRowFiles   The number of leading query files.
+
+  @returns  Whether the ratings have been allocated successfully.
+*/
+bool ScShardRatingsCreate(
+  sc_shard_ratings_t   *ShardRatings,
+  const sc_pair_tile_t *Tiles,
+  size_t               NumTiles,
+  unsigned int         TileSize,
+  unsigned int         NumFiles,
+  unsigned int         NumRowFiles
+  );
+
+/*
+  Frees the ratings of the tiles of a shard.
+
+  @param[in,out] ShardRatings  The ratings to free.
+*/
+void ScShardRatingsFree(
+  sc_shard_ratings_t *ShardRatings
+  );
+
+/*
+  Calculates the index of the rating of a file pairing within the ratings of
+  the tiles of a shard.
+
+  @param[in] ShardRatings  The ratings of the tiles of the shard.
+  @param[in] File1Index    The index of the first file of the pairing.
+  @param[in] File2Index    The index of the second file of the pairing. It
+                           must be larger than File1Index, and the pairing
+                           must be in a tile of the shard.
+
+  @returns  The index of the rating within ShardRatings->Ratings.
+*/
+size_t ScShardRatingsGetIndex(
+  const sc_shard_ratings_t *ShardRatings,
+  unsigned int             File1Index,
+  unsigned int             File2Index
+  );
+
+/*
+  Writes the ratings of the tiles of a shard ordered by their files, so that
+  the outputs of all shards can be merged as streams. NaN ratings are not
+  written.
+
+  @param[in]     ShardRatings  The ratings of the tiles of the shard.
+  @param[in,out] Stream        The stream to write to.
+  @param[in]     Format        The text or record format.
+  @param[in]     FileIndices   The input path index of every file.
+*/
+void ScShardRatingsWrite(
+  const sc_shard_ratings_t *ShardRatings,
+  FILE                     *Stream,
+  sc_output_format_t       Format,
+  const unsigned int       *FileIndices
+  );
+
+/*
+  Reads the next rating of the text or record output of a shard.
+
+  @param[in,out] Stream  The output of the shard. On success, its current
+                         rating is the next one, or HasRating is false if the
+                         output has ended.
+
+  @returns  Whether the output has been read successfully.
+*/
+bool ScShardReadRating(
+  sc_shard_stream_t *Stream
+  );
+
+/*
+  Starts reading the text or record output of a shard and reads its first
+  rating.
+
+  @param[out]    Stream      On success, the output of the shard.
+  @param[in]     Handle      The seekable handle of the output. It is not
+                             closed by the stream.
+  @param[in]     CountFiles  Whether the file counts of text outputs are
+                             derived from their ratings, which reads them
+                             twice.
+  @param[in,out] Header      The file counts of the shards. They are raised to
+                             those of this shard.
+
+  @returns  Whether the output has been read successfully.
+*/
+bool ScShardOpenStream(
+  sc_shard_stream_t  *Stream,
+  FILE               *Handle,
+  bool               CountFiles,
+  sc_output_header_t *Header
+  );
+
+/*
+  Merges the text or record outputs of all shards into a single output in the
+  format Format. The outputs are ordered by their files and are merged as
+  streams. In top-K mode, only the best matches of every file across all
+  shards are output.
+
+  @param[in,out] Output       The stream to write the merged output to.
+  @param[in]     Format       The text or record format.
+  @param[in]     MaxMatches   The number of matches to output per file in
+                              top-K mode, or 0 to merge all ratings.
+  @param[in]     Inputs       The seekable handles of the shard outputs.
+  @param[in]     NumInputs    The number of elements in Inputs.
+  @param[out]    FailedIndex  On read errors and for unordered outputs, the
+                              index of the shard output.
+
+  @returns  The result of merging.
+*/
+sc_shard_status_t ScShardMergeOutputs(
+  FILE               *Output,
+  sc_output_format_t Format,
+  unsigned int       MaxMatches,
+  FILE *const        *Inputs,
+  size_t             NumInputs,
+  size_t             *FailedIndex
+  );
+
+#endif // SC_SHARD_H_
@@ -0,0 +1,187 @@
+/*@file
+  Provides the library APIs to compare code inputs within a long-lived context.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_SIMILARITY_CHECKER_H_
+#define SC_SIMILARITY_CHECKER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ScCleanseConfigs.h>
+
+///
+/// A comparison context owning cleansed files and all state shared by their
+/// comparisons. Its layout is private to the library.
+///
+typedef struct sc_context_ sc_context_t;
+
+///
+/// A file pairing to be rated by ScContextCompareBatch().
+///
+typedef struct {
+  ///
+  /// The index of the first file of the pairing.
+  ///
+  unsigned int File1Index;
+  ///
+  /// The index of the second file of the pairing.
+  ///
+  unsigned int File2Index;
+  ///
+  /// The score of the pairing as returned by ScContextComparePair().
+  ///
+  double       Score;
+} sc_context_pairing_t;
+
+/*
+  Creates a comparison context without any files.
+
+  @param[in] NumThreads  The number of threads to compare batches with. If it
+                         is 0, the default number of threads is used.
+
+  @retval NULL   An error has occured.
+  @retval other  The comparison context. It must be freed with
+                 ScContextDestroy().
+*/
+sc_context_t *ScContextCreate(
+  unsigned int NumThreads
+  );
+
+/*
+  Frees Context and all files added to it.
+
+  @param[in] Context  The context to free. It may be NULL.
+*/
+void ScContextDestroy(
+  sc_context_t *Context
+  );
+
+/*
+  Sets the radius of the window of lines of the second file that every line of
+  the first file is compared to. It applies to all subsequent comparisons.
+  This must not be called concurrently with any other call on Context.
+
+  @param[in,out] Context       The context to configure.
+  @param[in]     NumLinesSwap  The number of lines before and after the line of
+                               equal index to compare to. By default, the
+                               window of the command line tool is used.
+*/
+void ScContextSetWindow(
+  sc_context_t *Context,
+  size_t       NumLinesSwap
+  );
+
+/*
+  Sets whether the lines of both files are aligned within the window, so that
+  every line of the second file is matched at most once and in order. It
+  applies to all subsequent comparisons. This must not be called concurrently
+  with any other call on Context.
+
+  @param[in,out] Context     The context to configure.
+  @param[in]     AlignLines  Whether to align the lines. By default, every line
+                             of the first file is matched with its best match
+                             within the window.
+*/
+void ScContextSetAlignment(
+  sc_context_t *Context,
+  bool         AlignLines
+  );
+
+/*
+  Sets the limits of the files added to Context subsequently. Files exceeding
+  them are rejected. This must not be called concurrently with any other call
+  on Context.
+
+  @param[in,out] Context        The context to configure.
+  @param[in]     MaxFileSize    The maximum size, in characters, of the file
+                                contents.
+  @param[in]     MaxLineLength  The maximum length, in characters, of the lines
+                                of the cleansed files.
+
+  @returns  Whether the limits are supported. By default, and at most, the
+            limits the library has been built with are applied.
+*/
+bool ScContextSetFileLimits(
+  sc_context_t *Context,
+  size_t       MaxFileSize,
+  size_t       MaxLineLength
+  );
+
+/*
+  Reads the file from path FileName, cleanses it and adds it to Context.
+  This must not be called concurrently with any other call on Context.
+
+  @param[in,out] Context    The context to add the file to.
+  @param[in]     FileName   The path of the file to read. It needs to be
+                            correctly terminated.
+  @param[in]     FileType   The cleansing type of the file.
+                            If ScCleanseConfigTypeMax is passed, the type will
+                            be automatically detected based on the file
+                            extension of FileName.
+  @param[out]    FileIndex  On success, the index of the file within Context.
+
+  @returns  Whether the file has been read, cleansed and added successfully.
+*/
+bool ScContextAddFile(
+  sc_context_t             *Context,
+  const char               *FileName,
+  sc_cleanse_config_type_t FileType,
+  unsigned int             *FileIndex
+  );
+
+/*
+  Cleanses a copy of Buffer and adds it to Context as a file.
+  This must not be called concurrently with any other call on Context.
+
+  @param[in,out] Context    The context to add the file to.
+  @param[in]     Buffer     The file contents.
+  @param[in]     Length     The length, in characters, of Buffer.
+  @param[in]     FileType   The cleansing type of the file.
+  @param[out]    FileIndex  On success, the index of the file within Context.
+
+  @returns  Whether the file has been cleansed and added successfully.
+*/
+bool ScContextAddBuffer(
+  sc_context_t             *Context,
+  const char               *Buffer,
+  size_t                   Length,
+  sc_cleanse_config_type_t FileType,
+  unsigned int             *FileIndex
+  );
+
+/*
+  Rates the similarity of two files of Context. Ratings may be requested
+  concurrently.
+
+  @param[in] Context     The context holding the files.
+  @param[in] File1Index  The index of the first file to compare.
+  @param[in] File2Index  The index of the second file to compare.
+
+  @retval INFINITY  An error occured while comparing the files.
+  @retval other     The similarity score between 0 and 1.
+*/
+double ScContextComparePair(
+  const sc_context_t *Context,
+  unsigned int       File1Index,
+  unsigned int       File2Index
+  );
+
+/*
+  Rates the similarity of all file pairings of Pairings in parallel with the
+  configured number of threads.
+
+  @param[in]     Context      The context holding the files.
+  @param[in,out] Pairings     The file pairings to rate. On output, the Score
+                              field of every element is set.
+  @param[in]     NumPairings  The number of elements in Pairings.
+*/
+void ScContextCompareBatch(
+  const sc_context_t   *Context,
+  sc_context_pairing_t *Pairings,
+  size_t               NumPairings
+  );
+
+#endif // SC_SIMILARITY_CHECKER_H_
@@ -9,6 +9,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 ///
 /// Structure to declare string literals together with their length.
@@ -51,6 +52,30 @@ typedef struct {
   sc_str_line_info_t Lines[];
 } sc_str_lines_info_t;
 
+///
+/// A set of characters for vectorised scanning with ScStrSpanNotInSet().
+///
+typedef struct {
+  ///
+  /// Whether the set can be tested by LowNibbles and HighNibbles. If not,
+  /// only Members is used.
+  ///
+  bool    Nibbles;
+  ///
+  /// The group bits of every low nibble of the set's characters.
+  ///
+  uint8_t LowNibbles[16];
+  ///
+  /// The group bit of every high nibble of the set's characters. A character
+  /// is a member iff the bits of its low and high nibbles intersect.
+  ///
+  uint8_t HighNibbles[16];
+  ///
+  /// Whether a character is a member of the set, indexed by character.
+  ///
+  bool    Members[256];
+} sc_str_char_set_t;
+
 /*
   Compares the prefix of String to Prefix.
 
@@ -71,6 +96,51 @@ int ScStrnPrefix(
   size_t     PrefixLength
   );
 
+/*
+  Calculates a 64-bit non-cryptographic hash of String. The result does not
+  depend on the endianness of the platform.
+
+  @param[in] String        The string to hash. It does not need to be
+                           terminated.
+  @param[in] StringLength  The length, in characters, of String.
+
+  @returns  The hash of String.
+*/
+uint64_t ScStrHash64(
+  const char *String,
+  size_t     StringLength
+  );
+
+/*
+  Initialises Set with the characters marked in Members.
+
+  @param[out] Set      The set to initialise.
+  @param[in]  Members  Whether a character is a member of the set, indexed by
+                       character.
+*/
+void ScStrCharSetInitialise(
+  sc_str_char_set_t *Set,
+  const bool        Members[256]
+  );
+
+/*
+  Returns the length of the prefix of String that contains no member of Set.
+  The scan is vectorised with the best instruction set supported by the CPU.
+
+  @param[in] String        The string to scan. It does not need to be
+                           terminated.
+  @param[in] StringLength  The length, in characters, of String.
+  @param[in] Set           The set of characters to stop at.
+
+  @returns  The index of the first member of Set in String, or StringLength if
+            there is none.
+*/
+size_t ScStrSpanNotInSet(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  );
+
 /*
   Returns line information about String.
 
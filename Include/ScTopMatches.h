@@ -0,0 +1,143 @@
+/*@file
+  Provides APIs to keep the best matches of every file while its pairings are
+  rated.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_TOP_MATCHES_H_
+#define SC_TOP_MATCHES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+///
+/// A match of a file with a rated file pairing.
+///
+typedef struct {
+  ///
+  /// The score of the pairing.
+  ///
+  double       Score;
+  ///
+  /// The index of the matched file within the file list.
+  ///
+  unsigned int FileIndex;
+} sc_match_t;
+
+///
+/// The bounded match lists of a set of files. Pairings may be added
+/// concurrently, as every list has its own lock.
+///
+typedef struct {
+  ///
+  /// MaxMatches matches for every file, the worst one first as a binary heap.
+  ///
+  sc_match_t   *Matches;
+  ///
+  /// The number of valid entries in every file's match list.
+  ///
+  unsigned int *NumMatches;
+  ///
+  /// The number of pairings of every file that have not been added yet. It
+  /// is initialised to 0 and must be set by the caller before adding any.
+  ///
+  unsigned int *NumPending;
+#ifdef _OPENMP
+  ///
+  /// The locks of every file's match list.
+  ///
+  omp_lock_t   *Locks;
+#endif
+  ///
+  /// The capacity of every match list.
+  ///
+  unsigned int MaxMatches;
+  ///
+  /// The number of files the match lists are allocated for.
+  ///
+  unsigned int NumFiles;
+} sc_top_matches_t;
+
+/*
+  qsort() comparison function to order matches from best to worst. Ties are
+  resolved in favour of the lower file index to not depend on the order of
+  rating.
+*/
+int ScCompareMatches(
+  const void *Match1,
+  const void *Match2
+  );
+
+/*
+  Allocates the empty match lists of NumFiles files.
+
+  @param[out] TopMatches  On success, the empty match lists. On failure, they
+                          must still be freed by ScTopMatchesFree().
+  @param[in]  NumFiles    The number of files.
+  @param[in]  MaxMatches  The capacity of every match list. It must not be 0.
+
+  @returns  Whether the match lists have been allocated successfully.
+*/
+bool ScTopMatchesCreate(
+  sc_top_matches_t *TopMatches,
+  unsigned int     NumFiles,
+  unsigned int     MaxMatches
+  );
+
+/*
+  Frees the match lists of TopMatches.
+
+  @param[in,out] TopMatches  The match lists to free.
+*/
+void ScTopMatchesFree(
+  sc_top_matches_t *TopMatches
+  );
+
+/*
+  Adds the rating of a file pairing to the match lists of both of its files
+  and counts it as no longer pending for them. It may be called concurrently.
+
+  @param[in,out] TopMatches  The match lists.
+  @param[in]     File1Index  The index of the first file of the pairing.
+  @param[in]     File2Index  The index of the second file of the pairing.
+  @param[in]     Score       The score of the pairing.
+  @param[in]     Valid       Whether the pairing is to be added to the lists.
+                             Invalid pairings are only counted.
+  @param[out]    Final       The indices of the files that have no pairings
+                             pending anymore. Their lists are final and are
+                             no longer accessed by other threads.
+
+  @returns  The number of elements written to Final.
+*/
+unsigned int ScTopMatchesAdd(
+  sc_top_matches_t *TopMatches,
+  unsigned int     File1Index,
+  unsigned int     File2Index,
+  double           Score,
+  bool             Valid,
+  unsigned int     Final[2]
+  );
+
+/*
+  Orders the final match list of the file with index FileIndex from best to
+  worst. No other thread may access the list anymore.
+
+  @param[in,out] TopMatches  The match lists.
+  @param[in]     FileIndex   The index of the file.
+  @param[out]    NumMatches  The number of returned matches.
+
+  @returns  The matches of the file from best to worst. They are owned by
+            TopMatches and must not be added to anymore.
+*/
+const sc_match_t *ScTopMatchesFinalise(
+  sc_top_matches_t *TopMatches,
+  unsigned int     FileIndex,
+  unsigned int     *NumMatches
+  );
+
+#endif // SC_TOP_MATCHES_H_
@@ -0,0 +1,305 @@
+/*@file
+  Provides APIs to fingerprint buffers by winnowing and to count the
+  fingerprint hashes files share through an inverted index.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+#ifndef SC_WINNOW_H_
+#define SC_WINNOW_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// The length, in characters, of the hashed k-grams.
+///
+#define SC_WINNOW_K  16U
+
+///
+/// The number of consecutive k-gram hashes to select the minimum of. Every
+/// common substring of at least SC_WINNOW_K + SC_WINNOW_W - 1 characters
+/// shares a fingerprint hash.
+///
+#define SC_WINNOW_W  16U
+
+///
+/// The winnowing fingerprint of a buffer.
+///
+typedef struct {
+  ///
+  /// The distinct selected hashes in ascending order. It is allocated with
+  /// malloc.
+  ///
+  uint64_t *Hashes;
+  ///
+  /// The number of elements in Hashes.
+  ///
+  size_t   NumHashes;
+} sc_winnow_fingerprint_t;
+
+///
+/// An inverted index from fingerprint hashes to the files they occur in.
+///
+typedef struct {
+  ///
+  /// The distinct indexed hashes in ascending order.
+  ///
+  uint64_t     *Hashes;
+  ///
+  /// The start of the postings of every element of Hashes within FileIndices,
+  /// followed by the number of elements in FileIndices.
+  ///
+  size_t       *Offsets;
+  ///
+  /// The indices of the files every hash occurs in, in ascending order per
+  /// hash.
+  ///
+  unsigned int *FileIndices;
+  ///
+  /// The number of elements in Hashes.
+  ///
+  size_t       NumHashes;
+} sc_winnow_index_t;
+
+///
+/// The fingerprints and the inverted index of a set of files to rate the file
+/// pairings of by the Jaccard similarity of their indexed hashes.
+///
+typedef struct {
+  ///
+  /// The fingerprint of every file.
+  ///
+  sc_winnow_fingerprint_t *Fingerprints;
+  ///
+  /// The number of indexed hashes of every file.
+  ///
+  size_t                  *NumIndexed;
+  ///
+  /// The inverted index of Fingerprints.
+  ///
+  sc_winnow_index_t       Index;
+  ///
+  /// The number of files.
+  ///
+  unsigned int            NumFiles;
+} sc_winnow_corpus_t;
+
+///
+/// The state of a thread to rate the pairings of a file of a corpus with all
+/// files with a larger index.
+///
+typedef struct {
+  ///
+  /// The number of hashes every file shares with the scanned file.
+  ///
+  uint32_t     *Counts;
+  ///
+  /// The indices of the files that share hashes with the scanned file. It is
+  /// NULL if all pairings are rated.
+  ///
+  unsigned int *Sharing;
+  ///
+  /// The index of the scanned file.
+  ///
+  unsigned int File1Index;
+} sc_winnow_scan_t;
+
+/*
+  Fingerprints Buffer by winnowing its k-gram hashes. New line characters are
+  skipped, so that the fingerprint does not depend on line breaks.
+
+  @param[out] Fingerprint  On success, the fingerprint of Buffer.
+  @param[in]  Buffer       The buffer to fingerprint.
+  @param[in]  Length       The length, in characters, of Buffer.
+
+  @returns  Whether the fingerprint has been created successfully.
+*/
+bool ScWinnowFingerprint(
+  sc_winnow_fingerprint_t *Fingerprint,
+  const char              *Buffer,
+  size_t                  Length
+  );
+
+/*
+  Frees the resources of Fingerprint.
+
+  @param[in,out] Fingerprint  The fingerprint to free.
+*/
+void ScWinnowFreeFingerprint(
+  sc_winnow_fingerprint_t *Fingerprint
+  );
+
+/*
+  Creates the inverted index of the fingerprints of NumFiles files. Hashes that
+  occur in more than MaxFiles files are considered boilerplate and are not
+  indexed.
+
+  @param[out] Index         On success, the index.
+  @param[in]  Fingerprints  The fingerprints of the files.
+  @param[in]  NumFiles      The number of elements in Fingerprints.
+  @param[in]  MaxFiles      The maximum number of files of an indexed hash.
+
+  @returns  Whether the index has been created successfully.
+*/
+bool ScWinnowCreateIndex(
+  sc_winnow_index_t             *Index,
+  const sc_winnow_fingerprint_t *Fingerprints,
+  unsigned int                  NumFiles,
+  unsigned int                  MaxFiles
+  );
+
+/*
+  Frees the resources of Index.
+
+  @param[in,out] Index  The index to free.
+*/
+void ScWinnowFreeIndex(
+  sc_winnow_index_t *Index
+  );
+
+/*
+  Counts the indexed hashes of the fingerprint of the file with index
+  FileIndex that every file with a larger index shares with it.
+
+  @param[in]     Index        The index.
+  @param[in]     Fingerprint  The fingerprint of the file.
+  @param[in]     FileIndex    The index of the file.
+  @param[in,out] Counts       The counters of all files. The counter of every
+                              file with a larger index than FileIndex is
+                              incremented by the number of shared hashes. If
+                              it is NULL, only the indexed hashes are
+                              counted.
+  @param[out]    Sharing      If it is not NULL, the indices of the files whose
+                              counter has been raised from 0, in the order of
+                              their first shared hash. It must hold an element
+                              for every file with a larger index than
+                              FileIndex.
+  @param[out]    NumSharing   The number of elements written to Sharing. It
+                              must not be NULL if Sharing is not NULL.
+
+  @returns  The number of hashes of Fingerprint that are indexed.
+*/
+size_t ScWinnowCountShared(
+  const sc_winnow_index_t       *Index,
+  const sc_winnow_fingerprint_t *Fingerprint,
+  unsigned int                  FileIndex,
+  uint32_t                      *Counts,
+  unsigned int                  *Sharing,
+  size_t                        *NumSharing
+  );
+
+/*
+  Allocates a corpus of NumFiles files without fingerprints.
+
+  @param[out] Corpus    On success, the corpus.
+  @param[in]  NumFiles  The number of files.
+
+  @returns  Whether the corpus has been allocated successfully.
+*/
+bool ScWinnowCorpusCreate(
+  sc_winnow_corpus_t *Corpus,
+  unsigned int       NumFiles
+  );
+
+/*
+  Frees the resources of Corpus.
+
+  @param[in,out] Corpus  The corpus to free.
+*/
+void ScWinnowCorpusFree(
+  sc_winnow_corpus_t *Corpus
+  );
+
+/*
+  Fingerprints the file with index FileIndex of Corpus. Distinct files may be
+  fingerprinted concurrently.
+
+  @param[in,out] Corpus     The corpus.
+  @param[in]     FileIndex  The index of the file.
+  @param[in]     Buffer     The buffer of the file.
+  @param[in]     Length     The length, in characters, of Buffer.
+
+  @returns  Whether the file has been fingerprinted successfully.
+*/
+bool ScWinnowCorpusAddFile(
+  sc_winnow_corpus_t *Corpus,
+  unsigned int       FileIndex,
+  const char         *Buffer,
+  size_t             Length
+  );
+
+/*
+  Indexes the fingerprints of all files of Corpus. Hashes that occur in many
+  files are considered boilerplate and are disregarded.
+
+  @param[in,out] Corpus  The corpus with all files fingerprinted.
+
+  @returns  Whether the corpus has been indexed successfully.
+*/
+bool ScWinnowCorpusIndex(
+  sc_winnow_corpus_t *Corpus
+  );
+
+/*
+  Allocates the state of a thread to rate the pairings of Corpus.
+
+  @param[out] Scan    On success, the state. On failure, it can be freed.
+  @param[in]  Corpus  The corpus.
+  @param[in]  Sparse  Whether only the pairings that share indexed hashes are
+                      rated.
+
+  @returns  Whether the state has been allocated successfully.
+*/
+bool ScWinnowScanCreate(
+  sc_winnow_scan_t         *Scan,
+  const sc_winnow_corpus_t *Corpus,
+  bool                     Sparse
+  );
+
+/*
+  Frees the resources of Scan.
+
+  @param[in,out] Scan  The state to free.
+*/
+void ScWinnowScanFree(
+  sc_winnow_scan_t *Scan
+  );
+
+/*
+  Starts rating the pairings of the file with index File1Index with all files
+  with a larger index. Every such pairing must then be rated by
+  ScWinnowScanRate() before the next file is scanned: those with the indices
+  Scan->Sharing[0] to Scan->Sharing[n - 1] for sparse states, and all
+  otherwise.
+
+  @param[in]     Corpus      The indexed corpus.
+  @param[in,out] Scan        The state of the calling thread.
+  @param[in]     File1Index  The index of the file to scan.
+
+  @returns  The number n of files that share indexed hashes with the file.
+            It is 0 for states that are not sparse.
+*/
+size_t ScWinnowScanFile(
+  const sc_winnow_corpus_t *Corpus,
+  sc_winnow_scan_t         *Scan,
+  unsigned int             File1Index
+  );
+
+/*
+  Returns the Jaccard similarity of the indexed hashes of the scanned file and
+  the file with index File2Index.
+
+  @param[in]     Corpus      The indexed corpus.
+  @param[in,out] Scan        The state of the calling thread.
+  @param[in]     File2Index  The index of the second file of the pairing. It
+                             must be larger than that of the scanned file.
+*/
+double ScWinnowScanRate(
+  const sc_winnow_corpus_t *Corpus,
+  sc_winnow_scan_t         *Scan,
+  unsigned int             File2Index
+  );
+
+#endif // SC_WINNOW_H_
@@ -0,0 +1,101 @@
+/*@file
+  Provides functions to allocate many objects that are freed together.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ScArena.h>
+#include <ScSafeInt.h>
+
+void ScArenaInitialise(
+  sc_arena_t *Arena
+  )
+{
+  assert(Arena != NULL);
+
+  Arena->Blocks = NULL;
+}
+
+void *ScArenaAllocate(
+  sc_arena_t *Arena,
+  size_t     Size,
+  size_t     Alignment
+  )
+{
+  assert(Arena != NULL);
+  assert(Alignment > 0 && (Alignment & (Alignment - 1U)) == 0);
+  assert(Alignment <= _Alignof(max_align_t));
+  //
+  // Allocate from the current block if the aligned request fits.
+  //
+  sc_arena_block_t *Block = Arena->Blocks;
+  if (Block != NULL) {
+    const uintptr_t Address = (uintptr_t) &Block->Data[Block->Used];
+    const size_t    Padding = (size_t) (0U - Address) & (Alignment - 1U);
+    if (Block->Size - Block->Used >= Padding
+     && Block->Size - Block->Used - Padding >= Size) {
+      void *Memory = &Block->Data[Block->Used + Padding];
+      Block->Used += Padding + Size;
+      return Memory;
+    }
+  }
+  //
+  // Reserve space to align the allocation, as Data is not necessarily
+  // maximally aligned.
+  //
+  size_t     BlockSize;
+  const bool Overflow = ScSafeAddSize(Size, Alignment - 1U, &BlockSize);
+  if (Overflow || BlockSize > SIZE_MAX - sizeof(sc_arena_block_t)) {
+    return NULL;
+  }
+
+  const bool Dedicated = BlockSize > SC_ARENA_BLOCK_SIZE / 4U;
+  if (!Dedicated) {
+    BlockSize = SC_ARENA_BLOCK_SIZE;
+  }
+
+  sc_arena_block_t *NewBlock = malloc(sizeof(*NewBlock) + BlockSize);
+  if (NewBlock == NULL) {
+    return NULL;
+  }
+
+  const uintptr_t Address = (uintptr_t) &NewBlock->Data[0];
+  const size_t    Padding = (size_t) (0U - Address) & (Alignment - 1U);
+  NewBlock->Size = BlockSize;
+  NewBlock->Used = Padding + Size;
+  //
+  // Dedicated blocks are full, hence keep allocating from the current block.
+  //
+  if (Dedicated && Block != NULL) {
+    NewBlock->Next = Block->Next;
+    Block->Next    = NewBlock;
+  } else {
+    NewBlock->Next = Block;
+    Arena->Blocks  = NewBlock;
+  }
+
+  return &NewBlock->Data[Padding];
+}
+
+void ScArenaFree(
+  sc_arena_t *Arena
+  )
+{
+  assert(Arena != NULL);
+
+  sc_arena_block_t *Block = Arena->Blocks;
+  while (Block != NULL) {
+    sc_arena_block_t *Next = Block->Next;
+    free(Block);
+    Block = Next;
+  }
+
+  Arena->Blocks = NULL;
+}
@@ -6,10 +6,13 @@
 */
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stddef.h>
 
 #include <ScCleanseInput.h>
+#include <ScSafeInt.h>
 #include <ScStringMisc.h>
 
 /*
@@ -397,15 +400,17 @@ void ScCleanseRemoveSpaces(
     // Found a new fragment to preserve.
     //
     if (Buffer[SourceIndex] != ' ') {
-      size_t SourceIndexEnd;
       //
       // Find the end of the fragment.
       //
-      for (SourceIndexEnd = SourceIndex + 1; SourceIndexEnd < *BufferLength; ++SourceIndexEnd) {
-        if (Buffer[SourceIndexEnd] == ' ') {
-          break;
-        }
-      }
+      const char *FragmentEnd = memchr(
+        &Buffer[SourceIndex + 1],
+        ' ',
+        *BufferLength - (SourceIndex + 1)
+        );
+      const size_t SourceIndexEnd = FragmentEnd != NULL
+        ? (size_t) (FragmentEnd - Buffer)
+        : *BufferLength;
       //
       // Strip the whitespaces prior to the fragment.
       //
@@ -425,21 +430,748 @@ void ScCleanseRemoveSpaces(
   *BufferLength = TargetIndex;
 }
 
-void ScCleanseInput(
-  char                      *Buffer,
-  size_t                    *BufferLength,
+///
+/// The number of verbatim characters to copy individually before moving the
+/// rest of their run as a whole.
+///
+#define SC_CLEANSE_PROBE_LENGTH  16U
+
+/*
+  Returns whether String of length StringLength starts with Prefix.
+*/
+static bool ScCleanseIsPrefixed(
+  const char                 *String,
+  size_t                     StringLength,
+  const sc_lenghted_string_t *Prefix
+  )
+{
+  assert(String != NULL || StringLength == 0);
+  assert(Prefix != NULL);
+  assert(Prefix->String != NULL || Prefix->Length == 0);
+
+  return Prefix->Length <= StringLength
+    && memcmp(String, Prefix->String, Prefix->Length) == 0;
+}
+
+/*
+  Returns whether a match of Generalisee may overlap with Prefix in a way that
+  the separate passes of ScCleanseLines() and ScCleanseGeneralisees() would
+  resolve differently from a single pass.
+*/
+static bool ScCleanseGeneraliseeOverlaps(
+  const sc_lenghted_string_t *Generalisee,
+  const sc_lenghted_string_t *Prefix
+  )
+{
+  assert(Generalisee != NULL);
+  assert(Prefix != NULL);
+
+  for (size_t Offset = 0; Offset < Generalisee->Length; ++Offset) {
+    const size_t Length = SC_MIN(Generalisee->Length - Offset, Prefix->Length);
+    if (memcmp(&Generalisee->String[Offset], Prefix->String, Length) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*
+  Inserts String into the trie of Matcher.
+
+  @param[in,out] Matcher  The matcher to insert String into.
+  @param[in]     String   The string to insert. It must not be empty.
+
+  @retval 0      The trie capacity has been exhausted.
+  @retval other  The index of the trie node String terminates at.
+*/
+static uint16_t ScCleanseMatcherInsert(
+  sc_cleanse_matcher_t       *Matcher,
+  const sc_lenghted_string_t *String
+  )
+{
+  assert(Matcher != NULL);
+  assert(String != NULL);
+  assert(String->Length > 0);
+
+  uint16_t *Link = &Matcher->Roots[(unsigned char) String->String[0]];
+  uint16_t NodeIndex;
+  for (size_t Depth = 0;;) {
+    //
+    // Find the child for the current character or append it to the siblings.
+    //
+    for (NodeIndex = *Link; NodeIndex != 0;) {
+      if (Matcher->Nodes[NodeIndex].Char == String->String[Depth]) {
+        break;
+      }
+
+      Link      = &Matcher->Nodes[NodeIndex].NextSibling;
+      NodeIndex = *Link;
+    }
+
+    if (NodeIndex == 0) {
+      if (Matcher->NumNodes == SC_CLEANSE_MATCHER_MAX_NODES) {
+        return 0;
+      }
+
+      NodeIndex = Matcher->NumNodes;
+      ++Matcher->NumNodes;
+
+      sc_cleanse_matcher_node_t *Node = &Matcher->Nodes[NodeIndex];
+      Node->FirstChild  = 0;
+      Node->NextSibling = 0;
+      Node->Ordinal     = UINT16_MAX;
+      Node->Generalise  = 0;
+      Node->Char        = String->String[Depth];
+      Node->Flags       = 0;
+
+      *Link = NodeIndex;
+    }
+
+    ++Depth;
+    if (Depth == String->Length) {
+      return NodeIndex;
+    }
+
+    Link = &Matcher->Nodes[NodeIndex].FirstChild;
+  }
+}
+
+void ScCleanseCompileConfig(
+  sc_cleanse_matcher_t      *Matcher,
   const sc_cleanse_config_t *Config
   )
+{
+  assert(Matcher != NULL);
+  assert(Config != NULL);
+
+  Matcher->Config     = Config;
+  Matcher->Fusable    = false;
+  Matcher->Splittable = false;
+  //
+  // Reserve the node at index 0 to denote the absence of a node.
+  //
+  Matcher->NumNodes = 1;
+  memset(Matcher->Roots, 0, sizeof(Matcher->Roots));
+  memset(Matcher->Classes, 0, sizeof(Matcher->Classes));
+
+  for (size_t Index = 0; Index < Config->NumNewLineChars; ++Index) {
+    Matcher->Classes[(unsigned char) Config->NewLineChars[Index]] =
+      SC_CLEANSE_CLASS_NEW_LINE;
+  }
+  //
+  // Whitespaces take precedence over configured new line characters.
+  //
+  Matcher->Classes[(unsigned char) '\r'] = SC_CLEANSE_CLASS_NEW_LINE;
+  Matcher->Classes[(unsigned char) '\n'] = SC_CLEANSE_CLASS_NEW_LINE;
+  Matcher->Classes[(unsigned char) '\t'] = SC_CLEANSE_CLASS_SPACE;
+  Matcher->Classes[(unsigned char) '\v'] = SC_CLEANSE_CLASS_SPACE;
+  Matcher->Classes[(unsigned char) ' ']  = SC_CLEANSE_CLASS_SPACE;
+
+  for (size_t Index = 0; Index < Config->NumLineDropPrefixes; ++Index) {
+    const sc_lenghted_string_t *Prefix = &Config->LineDropPrefixes[Index];
+    if (Prefix->Length == 0) {
+      return;
+    }
+
+    const uint16_t NodeIndex = ScCleanseMatcherInsert(Matcher, Prefix);
+    if (NodeIndex == 0) {
+      return;
+    }
+
+    Matcher->Nodes[NodeIndex].Flags |= SC_CLEANSE_NODE_DROP_LINE;
+  }
+
+  if (Config->MultiCommentStart.Length > 0) {
+    const uint16_t NodeIndex = ScCleanseMatcherInsert(
+      Matcher,
+      &Config->MultiCommentStart
+      );
+    if (NodeIndex == 0) {
+      return;
+    }
+
+    Matcher->Nodes[NodeIndex].Flags |= SC_CLEANSE_NODE_MULTI_COMMENT;
+  }
+
+  uint16_t Ordinal = 0;
+  for (size_t GenIndex = 0; GenIndex < Config->NumGeneralises; ++GenIndex) {
+    const sc_cleanse_generalise_t *Generalise = &Config->Generalises[GenIndex];
+    for (size_t Index = 0; Index < Generalise->NumGeneralisees; ++Index) {
+      const sc_lenghted_string_t *Generalisee =
+        &Generalise->Generalisees[Index];
+      //
+      // A single pass matches generalisees against the uncleansed input.
+      // This is only equivalent if comments cannot start within a generalisee
+      // and no generalisee can match the spaces comments are cleansed to.
+      //
+      if (Generalisee->Length == 0
+       || memchr(Generalisee->String, ' ', Generalisee->Length) != NULL) {
+        return;
+      }
+
+      for (
+        size_t DropIndex = 0;
+        DropIndex < Config->NumLineDropPrefixes;
+        ++DropIndex
+        ) {
+        const bool Overlaps = ScCleanseGeneraliseeOverlaps(
+          Generalisee,
+          &Config->LineDropPrefixes[DropIndex]
+          );
+        if (Overlaps) {
+          return;
+        }
+      }
+
+      if (Config->MultiCommentStart.Length > 0) {
+        const bool Overlaps = ScCleanseGeneraliseeOverlaps(
+          Generalisee,
+          &Config->MultiCommentStart
+          );
+        if (Overlaps) {
+          return;
+        }
+      }
+
+      const uint16_t NodeIndex = ScCleanseMatcherInsert(Matcher, Generalisee);
+      if (NodeIndex == 0 || Ordinal == UINT16_MAX) {
+        return;
+      }
+      //
+      // The separate passes prefer earlier generalisees over later ones in
+      // case of duplicates.
+      //
+      sc_cleanse_matcher_node_t *Node = &Matcher->Nodes[NodeIndex];
+      if (Node->Ordinal == UINT16_MAX) {
+        Node->Ordinal    = Ordinal;
+        Node->Generalise = (uint16_t) GenIndex;
+      }
+
+      ++Ordinal;
+    }
+  }
+  //
+  // Any character that starts a trie path needs to be matched.
+  //
+  for (size_t Char = 0; Char < SC_ARRAY_LEN(Matcher->Roots); ++Char) {
+    if (Matcher->Roots[Char] != 0) {
+      Matcher->Classes[Char] |= SC_CLEANSE_CLASS_TRIE;
+    }
+  }
+
+  bool Specials[SC_ARRAY_LEN(Matcher->Classes)];
+  for (size_t Char = 0; Char < SC_ARRAY_LEN(Matcher->Classes); ++Char) {
+    Specials[Char] = Matcher->Classes[Char] != 0;
+  }
+
+  ScStrCharSetInitialise(&Matcher->Specials, Specials);
+
+  bool CommentStarts[SC_ARRAY_LEN(Matcher->Classes)];
+  memset(CommentStarts, 0, sizeof(CommentStarts));
+  for (size_t Index = 0; Index < Config->NumLineDropPrefixes; ++Index) {
+    CommentStarts[(unsigned char) Config->LineDropPrefixes[Index].String[0]] =
+      true;
+  }
+
+  if (Config->MultiCommentStart.Length > 0) {
+    CommentStarts[(unsigned char) Config->MultiCommentStart.String[0]] = true;
+  }
+
+  ScStrCharSetInitialise(&Matcher->CommentStarts, CommentStarts);
+
+  Matcher->Fusable = true;
+  //
+  // Chunks start after new line characters, hence no match may span one.
+  //
+  Matcher->Splittable = Config->MultiCommentEnd.Length == 0
+    || memchr(
+         Config->MultiCommentEnd.String,
+         '\n',
+         Config->MultiCommentEnd.Length
+         ) == NULL;
+  for (size_t Index = 1; Index < Matcher->NumNodes; ++Index) {
+    if (Matcher->Nodes[Index].Char == '\n') {
+      Matcher->Splittable = false;
+    }
+  }
+}
+
+/*
+  Skips a multi line comment of the configuration of Matcher in Buffer.
+
+  @param[in] Buffer   The text buffer that contains the comment.
+  @param[in] Length   The length, in characters, of Buffer.
+  @param[in] InIndex  The index of the first character after the comment
+                      start.
+  @param[in] Matcher  The compiled configuration for the cleansing process.
+
+  @returns  The index of the character after the end of the comment, or Length
+            if it is unterminated.
+*/
+static size_t ScCleanseSkipMultiComment(
+  const char                 *Buffer,
+  size_t                     Length,
+  size_t                     InIndex,
+  const sc_cleanse_matcher_t *Matcher
+  )
+{
+  assert(Buffer != NULL);
+  assert(InIndex <= Length);
+  assert(Matcher != NULL);
+
+  const sc_lenghted_string_t *CommentEnd = &Matcher->Config->MultiCommentEnd;
+  while (InIndex < Length) {
+    if (CommentEnd->Length > 0) {
+      const char *Candidate = memchr(
+        &Buffer[InIndex],
+        CommentEnd->String[0],
+        Length - InIndex
+        );
+      if (Candidate == NULL) {
+        return Length;
+      }
+
+      InIndex = (size_t) (Candidate - Buffer);
+    }
+
+    const bool Terminated = ScCleanseIsPrefixed(
+      &Buffer[InIndex],
+      Length - InIndex,
+      CommentEnd
+      );
+    if (Terminated) {
+      return InIndex + CommentEnd->Length;
+    }
+
+    ++InIndex;
+  }
+
+  return Length;
+}
+
+/*
+  Appends a character of the comment-free and generalised input to the output
+  of ScCleanseFused(), performing the operations of
+  ScCleanseWhitespacesInLines() and ScCleanseRemoveSpaces() on the fly.
+
+  @param[in,out] Buffer          The output buffer.
+  @param[in,out] OutIndex        The index of the next output character.
+  @param[in,out] PendingNewLine  Whether a new line is to precede the next
+                                 non-whitespace character.
+  @param[in]     Classes         The character class table.
+  @param[in]     Char            The character to append.
+*/
+static void ScCleanseEmit(
+  char          *Buffer,
+  size_t        *OutIndex,
+  bool          *PendingNewLine,
+  const uint8_t *Classes,
+  char          Char
+  )
+{
+  assert(Buffer != NULL);
+  assert(OutIndex != NULL);
+  assert(PendingNewLine != NULL);
+  assert(Classes != NULL);
+
+  const uint8_t Class = Classes[(unsigned char) Char];
+  //
+  // Spaces are removed entirely, hence they do not separate new lines.
+  //
+  if ((Class & SC_CLEANSE_CLASS_SPACE) != 0) {
+    return;
+  }
+  //
+  // Subsequent new lines are merged and trailing ones are dropped, hence only
+  // emit them once it is known that a non-whitespace follows.
+  //
+  if ((Class & SC_CLEANSE_CLASS_NEW_LINE) != 0) {
+    *PendingNewLine = true;
+    return;
+  }
+  //
+  // Leading new lines are dropped.
+  //
+  if (*PendingNewLine) {
+    if (*OutIndex > 0) {
+      Buffer[*OutIndex] = '\n';
+      ++(*OutIndex);
+    }
+
+    *PendingNewLine = false;
+  }
+
+  Buffer[*OutIndex] = Char;
+  ++(*OutIndex);
+}
+
+/*
+  Cleanse Buffer according to Matcher in a single forward pass. The result is
+  identical to that of the separate passes performed by ScCleanseInput().
+  Buffer is cleansed in place, as the output never overtakes the input.
+
+  @param[in,out] Buffer        The text buffer to cleanse.
+  @param[in,out] BufferLength  On input, the length, in characters, of Buffer.
+                               On output, the cleansed length, in characters,
+                               of Buffer.
+  @param[in]     Matcher       The compiled configuration for the cleansing
+                               process.
+*/
+static void ScCleanseFused(
+  char                       *Buffer,
+  size_t                     *BufferLength,
+  const sc_cleanse_matcher_t *Matcher
+  )
 {
   assert(Buffer != NULL);
   assert(BufferLength != NULL);
-  assert(*BufferLength > 0);
-  assert(Config != NULL);
+  assert(Matcher != NULL);
+  assert(Matcher->Fusable);
+
+  const sc_cleanse_config_t *Config  = Matcher->Config;
+  const uint8_t             *Classes = Matcher->Classes;
+
+  const size_t Length         = *BufferLength;
+  size_t       InIndex        = 0;
+  size_t       OutIndex       = 0;
+  bool         PendingNewLine = false;
+  while (InIndex < Length) {
+    const char    Char  = Buffer[InIndex];
+    const uint8_t Class = Classes[(unsigned char) Char];
+    //
+    // Most characters are copied verbatim. Copy short runs of them directly
+    // and move longer runs as a whole.
+    //
+    if (Class == 0) {
+      ScCleanseEmit(Buffer, &OutIndex, &PendingNewLine, Classes, Char);
+      ++InIndex;
+
+      const size_t ProbeTop = SC_MIN(Length, InIndex + SC_CLEANSE_PROBE_LENGTH);
+      while (
+        InIndex < ProbeTop
+        && Classes[(unsigned char) Buffer[InIndex]] == 0
+        ) {
+        Buffer[OutIndex] = Buffer[InIndex];
+        ++OutIndex;
+        ++InIndex;
+      }
+
+      if (InIndex == ProbeTop && InIndex < Length) {
+        const size_t RunLength = ScStrSpanNotInSet(
+          &Buffer[InIndex],
+          Length - InIndex,
+          &Matcher->Specials
+          );
+        memmove(&Buffer[OutIndex], &Buffer[InIndex], RunLength);
+        OutIndex += RunLength;
+        InIndex  += RunLength;
+      }
+
+      continue;
+    }
+
+    if ((Class & SC_CLEANSE_CLASS_TRIE) == 0) {
+      ScCleanseEmit(Buffer, &OutIndex, &PendingNewLine, Classes, Char);
+      ++InIndex;
+      continue;
+    }
+    //
+    // Walk the trie to find all prefixes and generalisees matching at InIndex.
+    // As in the separate passes, drop prefixes take precedence over multi line
+    // comments, which take precedence over generalisees.
+    //
+    const size_t Remaining    = Length - InIndex;
+    bool         DropLine     = false;
+    bool         MultiComment = false;
+    uint16_t     Ordinal      = UINT16_MAX;
+    uint16_t     Generalise   = 0;
+    size_t       MatchLength  = 0;
+    uint16_t     NodeIndex    = Matcher->Roots[(unsigned char) Char];
+    for (size_t Depth = 1; NodeIndex != 0; ++Depth) {
+      const sc_cleanse_matcher_node_t *Node = &Matcher->Nodes[NodeIndex];
+      if ((Node->Flags & SC_CLEANSE_NODE_DROP_LINE) != 0) {
+        DropLine = true;
+        break;
+      }
+
+      MultiComment |= (Node->Flags & SC_CLEANSE_NODE_MULTI_COMMENT) != 0;
+
+      if (Node->Ordinal < Ordinal) {
+        Ordinal     = Node->Ordinal;
+        Generalise  = Node->Generalise;
+        MatchLength = Depth;
+      }
+
+      if (Depth == Remaining) {
+        break;
+      }
+
+      const char NextChar = Buffer[InIndex + Depth];
+      for (NodeIndex = Node->FirstChild; NodeIndex != 0;) {
+        if (Matcher->Nodes[NodeIndex].Char == NextChar) {
+          break;
+        }
+
+        NodeIndex = Matcher->Nodes[NodeIndex].NextSibling;
+      }
+    }
+    //
+    // Drop the rest of the line up until the new line, which is preserved.
+    //
+    if (DropLine) {
+      const char *NewLine = memchr(&Buffer[InIndex], '\n', Remaining);
+      InIndex = NewLine != NULL ? (size_t) (NewLine - Buffer) : Length;
+      continue;
+    }
+    //
+    // Multi line comments are dropped including their new lines.
+    //
+    if (MultiComment) {
+      InIndex = ScCleanseSkipMultiComment(
+        Buffer,
+        Length,
+        InIndex + Config->MultiCommentStart.Length,
+        Matcher
+        );
+      continue;
+    }
+
+    if (Ordinal != UINT16_MAX) {
+      const sc_lenghted_string_t *Generaliser =
+        &Config->Generalises[Generalise].Generaliser;
+      //
+      // Generalisees are at least as long as their generalisers, hence this
+      // cannot overwrite any unprocessed input.
+      //
+      assert(Generaliser->Length <= MatchLength);
+      for (size_t Index = 0; Index < Generaliser->Length; ++Index) {
+        ScCleanseEmit(
+          Buffer,
+          &OutIndex,
+          &PendingNewLine,
+          Classes,
+          Generaliser->String[Index]
+          );
+      }
+
+      InIndex += MatchLength;
+      continue;
+    }
+
+    ScCleanseEmit(Buffer, &OutIndex, &PendingNewLine, Classes, Char);
+    ++InIndex;
+  }
+
+  *BufferLength = OutIndex;
+}
+
+/*
+  Splits Buffer into chunks of about equal length that ScCleanseFused() may
+  cleanse independently. Chunks end after new line characters outside of
+  comments, as no cleansing state but the comment state carries across them.
 
-  ScCleanseLines(Buffer, *BufferLength, Config);
-  ScCleanseGeneralisees(Buffer, *BufferLength, Config);
-  ScCleanseWhitespacesInLines(Buffer, *BufferLength, Config);
-  ScCleanseRemoveSpaces(Buffer, BufferLength);
+  @param[in]  Buffer     The text buffer to split.
+  @param[in]  Length     The length, in characters, of Buffer.
+  @param[in]  Matcher    The compiled configuration for the cleansing process.
+  @param[in]  NumChunks  The targeted number of chunks. It must be at most
+                         SC_CLEANSE_MAX_CHUNKS.
+  @param[out] ChunkEnds  The end indices of the chunks. The last one is
+                         Length.
+
+  @returns  The number of chunks.
+*/
+static size_t ScCleanseSplitChunks(
+  const char                 *Buffer,
+  size_t                     Length,
+  const sc_cleanse_matcher_t *Matcher,
+  size_t                     NumChunks,
+  size_t                     ChunkEnds[SC_CLEANSE_MAX_CHUNKS]
+  )
+{
+  assert(Buffer != NULL);
+  assert(Matcher != NULL);
+  assert(Matcher->Splittable);
+  assert(NumChunks > 0 && NumChunks <= SC_CLEANSE_MAX_CHUNKS);
+  assert(ChunkEnds != NULL);
+
+  const sc_cleanse_config_t *Config = Matcher->Config;
+
+  const size_t ChunkLength = Length / NumChunks;
+  size_t       NumSplits   = 0;
+  size_t       InIndex     = 0;
+  while (InIndex < Length && NumSplits + 1U < NumChunks) {
+    //
+    // The span up to the next comment start candidate is outside of comments.
+    // Split it at the first new line after the targeted chunk end.
+    //
+    const size_t SpanEnd = InIndex + ScStrSpanNotInSet(
+                                       &Buffer[InIndex],
+                                       Length - InIndex,
+                                       &Matcher->CommentStarts
+                                       );
+    const size_t Target  = (NumSplits + 1U) * ChunkLength;
+    if (SpanEnd > Target) {
+      const size_t SplitStart = SC_MAX(InIndex, Target);
+      const char   *NewLine   = memchr(
+                                  &Buffer[SplitStart],
+                                  '\n',
+                                  SpanEnd - SplitStart
+                                  );
+      if (NewLine != NULL) {
+        InIndex              = (size_t) (NewLine - Buffer) + 1U;
+        ChunkEnds[NumSplits] = InIndex;
+        ++NumSplits;
+        continue;
+      }
+    }
+
+    InIndex = SpanEnd;
+    if (InIndex == Length) {
+      break;
+    }
+    //
+    // As in the separate passes, line drop prefixes take precedence over
+    // multi line comments. Generalisees cannot overlap with either.
+    //
+    const size_t Remaining = Length - InIndex;
+    size_t       DropIndex;
+    for (DropIndex = 0; DropIndex < Config->NumLineDropPrefixes; ++DropIndex) {
+      const bool Prefixed = ScCleanseIsPrefixed(
+        &Buffer[InIndex],
+        Remaining,
+        &Config->LineDropPrefixes[DropIndex]
+        );
+      if (Prefixed) {
+        break;
+      }
+    }
+    //
+    // The new line ending a dropped line is outside of comments.
+    //
+    if (DropIndex < Config->NumLineDropPrefixes) {
+      const char *NewLine = memchr(&Buffer[InIndex], '\n', Remaining);
+      InIndex = NewLine != NULL ? (size_t) (NewLine - Buffer) : Length;
+      continue;
+    }
+
+    const bool MultiComment = Config->MultiCommentStart.Length > 0
+      && ScCleanseIsPrefixed(
+           &Buffer[InIndex],
+           Remaining,
+           &Config->MultiCommentStart
+           );
+    if (MultiComment) {
+      InIndex = ScCleanseSkipMultiComment(
+        Buffer,
+        Length,
+        InIndex + Config->MultiCommentStart.Length,
+        Matcher
+        );
+      continue;
+    }
+
+    ++InIndex;
+  }
+
+  ChunkEnds[NumSplits] = Length;
+  return NumSplits + 1U;
+}
+
+/*
+  Cleanse Buffer according to Matcher by splitting it into chunks that are
+  cleansed concurrently. The result is identical to that of ScCleanseFused().
+
+  @param[in,out] Buffer        The text buffer to cleanse.
+  @param[in,out] BufferLength  On input, the length, in characters, of Buffer.
+                               On output, the cleansed length, in characters,
+                               of Buffer.
+  @param[in]     Matcher       The compiled configuration for the cleansing
+                               process.
+*/
+static void ScCleanseChunked(
+  char                       *Buffer,
+  size_t                     *BufferLength,
+  const sc_cleanse_matcher_t *Matcher
+  )
+{
+  assert(Buffer != NULL);
+  assert(BufferLength != NULL);
+  assert(Matcher != NULL);
+
+  size_t       ChunkEnds[SC_CLEANSE_MAX_CHUNKS];
+  size_t       ChunkLengths[SC_CLEANSE_MAX_CHUNKS];
+  const size_t NumChunks = ScCleanseSplitChunks(
+    Buffer,
+    *BufferLength,
+    Matcher,
+    SC_MIN(*BufferLength / SC_CLEANSE_CHUNK_LENGTH, SC_CLEANSE_MAX_CHUNKS),
+    ChunkEnds
+    );
+
+  //
+  // The arrays are automatic variables and hence must be shared explicitly.
+  //
+  #pragma omp taskloop grainsize(1) shared(ChunkEnds, ChunkLengths)
+  for (size_t Index = 0; Index < NumChunks; ++Index) {
+    const size_t ChunkStart = Index > 0 ? ChunkEnds[Index - 1U] : 0;
+    ChunkLengths[Index] = ChunkEnds[Index] - ChunkStart;
+    ScCleanseFused(&Buffer[ChunkStart], &ChunkLengths[Index], Matcher);
+  }
+  //
+  // Every chunk but the last ends with a new line that has not been emitted
+  // yet, hence there is room to separate the cleansed chunks by it. Leading
+  // and trailing new lines are dropped as usual.
+  //
+  size_t OutIndex = ChunkLengths[0];
+  for (size_t Index = 1; Index < NumChunks; ++Index) {
+    if (ChunkLengths[Index] == 0) {
+      continue;
+    }
+
+    if (OutIndex > 0) {
+      Buffer[OutIndex] = '\n';
+      ++OutIndex;
+    }
+
+    assert(OutIndex <= ChunkEnds[Index - 1U]);
+    memmove(
+      &Buffer[OutIndex],
+      &Buffer[ChunkEnds[Index - 1U]],
+      ChunkLengths[Index]
+      );
+    OutIndex += ChunkLengths[Index];
+  }
+
+  *BufferLength = OutIndex;
+}
+
+void ScCleanseInput(
+  char                       *Buffer,
+  size_t                     *BufferLength,
+  const sc_cleanse_matcher_t *Matcher
+  )
+{
+  assert(Buffer != NULL);
+  assert(BufferLength != NULL);
+  assert(*BufferLength > 0);
+  assert(Matcher != NULL);
+  //
+  // Prefer the single pass engine where it is equivalent to the separate
+  // passes, which is the case for all shipped configurations.
+  //
+  if (Matcher->Splittable
+   && *BufferLength >= 2U * (size_t) SC_CLEANSE_CHUNK_LENGTH) {
+    ScCleanseChunked(Buffer, BufferLength, Matcher);
+  } else if (Matcher->Fusable) {
+    ScCleanseFused(Buffer, BufferLength, Matcher);
+  } else {
+    const sc_cleanse_config_t *Config = Matcher->Config;
+    ScCleanseLines(Buffer, *BufferLength, Config);
+    ScCleanseGeneralisees(Buffer, *BufferLength, Config);
+    ScCleanseWhitespacesInLines(Buffer, *BufferLength, Config);
+    ScCleanseRemoveSpaces(Buffer, BufferLength);
+  }
   //
   // After cleansing there may not be empty lines.
   //
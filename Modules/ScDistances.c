@@ -6,9 +6,12 @@
 */
 
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <ScDistances.h>
+#include <ScInstrument.h>
 #include <ScSafeInt.h>
 
 size_t ScLevenshteinDistance(
@@ -24,6 +27,9 @@ size_t ScLevenshteinDistance(
   assert(MatrixScratch != NULL);
   assert(Str1 != NULL && Str1Length != 0);
   assert(Str2 != NULL && Str2Length != 0);
+
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterDistances, 1);
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterDpCells, Str1Length * Str2Length);
   //
   // Calculate the remaining Levenshtein Matrix entries with the algorithm.
   //
@@ -102,3 +108,511 @@ size_t ScLevenshteinDistance(
   //
   return MatrixTop[Str2Length - 1];
 }
+
+/*
+  Sets up the character match bitmasks of Pattern.
+
+  @param[in,out] Peq            The character match bitmask table. It must be
+                                at least (UCHAR_MAX + 1) * NumBlocks elements in
+                                size and all elements must be 0.
+  @param[in]     NumBlocks      The number of blocks per character value.
+  @param[in]     Pattern        The pattern to set up the bitmasks for.
+  @param[in]     PatternLength  The length, in characters, of Pattern. It must
+                                be at most
+                                NumBlocks * SC_LEVENSHTEIN_BLOCK_BITS.
+*/
+static void ScLevenshteinPeqSetup(
+  uint64_t   *Peq,
+  size_t     NumBlocks,
+  const char *Pattern,
+  size_t     PatternLength
+  )
+{
+  assert(Peq != NULL);
+  assert(Pattern != NULL);
+  assert(PatternLength <= NumBlocks * SC_LEVENSHTEIN_BLOCK_BITS);
+
+  for (size_t CharIndex = 0; CharIndex < PatternLength; ++CharIndex) {
+    const size_t BlockIndex = CharIndex / SC_LEVENSHTEIN_BLOCK_BITS;
+    const size_t BitIndex   = CharIndex % SC_LEVENSHTEIN_BLOCK_BITS;
+    //
+    // char is unsigned as per the static assertion in ScFileIo.c, hence this
+    // cannot index out of bounds.
+    //
+    Peq[(size_t) Pattern[CharIndex] * NumBlocks + BlockIndex] |=
+      (uint64_t) 1U << BitIndex;
+  }
+}
+
+/*
+  Restores the character match bitmasks of Pattern to 0. Only the elements that
+  ScLevenshteinPeqSetup() may have modified are written to.
+
+  @param[in,out] Peq            The character match bitmask table.
+  @param[in]     NumBlocks      The number of blocks per character value.
+  @param[in]     Pattern        The pattern the bitmasks have been set up for.
+  @param[in]     PatternLength  The length, in characters, of Pattern.
+*/
+static void ScLevenshteinPeqClear(
+  uint64_t   *Peq,
+  size_t     NumBlocks,
+  const char *Pattern,
+  size_t     PatternLength
+  )
+{
+  assert(Peq != NULL);
+  assert(Pattern != NULL);
+
+  for (size_t CharIndex = 0; CharIndex < PatternLength; ++CharIndex) {
+    const size_t BlockIndex = CharIndex / SC_LEVENSHTEIN_BLOCK_BITS;
+    Peq[(size_t) Pattern[CharIndex] * NumBlocks + BlockIndex] = 0;
+  }
+}
+
+/*
+  Calculates the Levenshtein distance from a pattern of at most
+  SC_LEVENSHTEIN_BLOCK_BITS characters to Text.
+
+  @param[in] Peq            The character match bitmask table of the pattern
+                            with a single block per character value.
+  @param[in] PatternLength  The length, in characters, of the pattern. It must
+                            be larger than 0 and at most
+                            SC_LEVENSHTEIN_BLOCK_BITS.
+  @param[in] Text           The text to compare the pattern to.
+  @param[in] TextLength     The length, in characters, of Text.
+  @param[in] Cutoff         The saturated sum of the maximum distance of
+                            interest and TextLength.
+
+  @returns  The Levenshtein distance from the pattern to Text, or a value
+            larger than the maximum distance of interest.
+*/
+static size_t ScLevenshteinMyers(
+  const uint64_t *Peq,
+  size_t         PatternLength,
+  const char     *Text,
+  size_t         TextLength,
+  size_t         Cutoff
+  )
+{
+  assert(Peq != NULL);
+  assert(PatternLength > 0 && PatternLength <= SC_LEVENSHTEIN_BLOCK_BITS);
+  assert(Text != NULL);
+  //
+  // Pv and Mv describe the positive and negative vertical deltas of the
+  // current column. The first column is 0,...,PatternLength, hence all deltas
+  // are +1.
+  //
+  const uint64_t HighBit = (uint64_t) 1U << (PatternLength - 1U);
+  uint64_t       Pv      = ~(uint64_t) 0U;
+  uint64_t       Mv      = 0;
+  size_t         Score   = PatternLength;
+  for (size_t TextIndex = 0; TextIndex < TextLength; ++TextIndex) {
+    const uint64_t Eq = Peq[(size_t) Text[TextIndex]];
+    const uint64_t Xv = Eq | Mv;
+    const uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    uint64_t       Ph = Mv | ~(Xh | Pv);
+    uint64_t       Mh = Pv & Xh;
+    //
+    // The score is tracked via the horizontal delta of the last pattern row.
+    // A distance can never become negative, hence this cannot wrap around.
+    //
+    Score += (Ph & HighBit) != 0;
+    Score -= (Mh & HighBit) != 0;
+    //
+    // The first row is 0,...,TextLength, hence its horizontal delta is +1.
+    //
+    Ph = (Ph << 1U) | 1U;
+    Mh = Mh << 1U;
+    Pv = Mh | ~(Xv | Ph);
+    Mv = Ph & Xv;
+    //
+    // Every remaining text character can lower the score by at most 1. Stop
+    // once the maximum distance of interest can no longer be reached.
+    //
+    if (Score + TextIndex >= Cutoff) {
+      return Score - (TextLength - TextIndex - 1U);
+    }
+  }
+
+  return Score;
+}
+
+/*
+  Calculates the Levenshtein distance from a pattern of arbitrary length to
+  Text.
+
+  @param[in,out] PeqScratch     The bit-parallel scratch buffer set up for the
+                                pattern with NumBlocks blocks per character
+                                value. The vertical delta vectors are 0 on
+                                output.
+  @param[in]     NumBlocks      The number of blocks per character value.
+  @param[in]     PatternLength  The length, in characters, of the pattern. It
+                                must be larger than 0 and at most
+                                NumBlocks * SC_LEVENSHTEIN_BLOCK_BITS.
+  @param[in]     Text           The text to compare the pattern to.
+  @param[in]     TextLength     The length, in characters, of Text.
+  @param[in]     Cutoff         The saturated sum of the maximum distance of
+                                interest and TextLength.
+
+  @returns  The Levenshtein distance from the pattern to Text, or a value
+            larger than the maximum distance of interest.
+*/
+static size_t ScLevenshteinMyersBlocked(
+  uint64_t   *PeqScratch,
+  size_t     NumBlocks,
+  size_t     PatternLength,
+  const char *Text,
+  size_t     TextLength,
+  size_t     Cutoff
+  )
+{
+  assert(PeqScratch != NULL);
+  assert(NumBlocks > 0);
+  assert(PatternLength > 0);
+  assert(PatternLength <= NumBlocks * SC_LEVENSHTEIN_BLOCK_BITS);
+  assert(Text != NULL);
+  //
+  // The vertical delta vectors are stored right after the bitmask table.
+  //
+  uint64_t *const Pv = &PeqScratch[(UCHAR_MAX + 1U) * NumBlocks];
+  uint64_t *const Mv = &Pv[NumBlocks];
+  for (size_t BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex) {
+    Pv[BlockIndex] = ~(uint64_t) 0U;
+    Mv[BlockIndex] = 0;
+  }
+
+  const size_t   LastBlock   = NumBlocks - 1U;
+  const uint64_t LastHighBit =
+    (uint64_t) 1U << ((PatternLength - 1U) % SC_LEVENSHTEIN_BLOCK_BITS);
+  const uint64_t HighBit     =
+    (uint64_t) 1U << (SC_LEVENSHTEIN_BLOCK_BITS - 1U);
+
+  size_t Score = PatternLength;
+  for (size_t TextIndex = 0; TextIndex < TextLength; ++TextIndex) {
+    const uint64_t *const Eqs =
+      &PeqScratch[(size_t) Text[TextIndex] * NumBlocks];
+    //
+    // The horizontal delta entering the first block is the one of the first
+    // row, which is +1. Every following block receives the horizontal delta
+    // of the last row of its predecessor.
+    //
+    int HorizontalIn = 1;
+    for (size_t BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex) {
+      uint64_t       Eq      = Eqs[BlockIndex];
+      const uint64_t PvBlock = Pv[BlockIndex];
+      const uint64_t MvBlock = Mv[BlockIndex];
+      const uint64_t Xv      = Eq | MvBlock;
+      //
+      // A negative incoming delta behaves like a match in the first row of
+      // the block.
+      //
+      Eq |= (uint64_t) (HorizontalIn < 0);
+
+      const uint64_t Xh = (((Eq & PvBlock) + PvBlock) ^ PvBlock) | Eq;
+      uint64_t       Ph = MvBlock | ~(Xh | PvBlock);
+      uint64_t       Mh = PvBlock & Xh;
+
+      const uint64_t BlockHighBit = BlockIndex == LastBlock
+                                      ? LastHighBit
+                                      : HighBit;
+      const int HorizontalOut = ((Ph & BlockHighBit) != 0)
+                                  - ((Mh & BlockHighBit) != 0);
+
+      Ph = (Ph << 1U) | (uint64_t) (HorizontalIn > 0);
+      Mh = (Mh << 1U) | (uint64_t) (HorizontalIn < 0);
+
+      Pv[BlockIndex] = Mh | ~(Xv | Ph);
+      Mv[BlockIndex] = Ph & Xv;
+
+      HorizontalIn = HorizontalOut;
+    }
+    //
+    // A distance can never become negative, hence this cannot wrap around.
+    //
+    Score += (size_t) HorizontalIn;
+    //
+    // Every remaining text character can lower the score by at most 1. Stop
+    // once the maximum distance of interest can no longer be reached.
+    //
+    if (Score + TextIndex >= Cutoff) {
+      Score -= TextLength - TextIndex - 1U;
+      break;
+    }
+  }
+  //
+  // The vertical delta vectors overlap with the bitmask table of patterns with
+  // more blocks, hence restore them to 0 for subsequent calls.
+  //
+  for (size_t BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex) {
+    Pv[BlockIndex] = 0;
+    Mv[BlockIndex] = 0;
+  }
+
+  return Score;
+}
+
+/*
+  Calculates the Levenshtein distance from a pattern to Text with the
+  bit-parallel kernel suitable for the pattern length.
+
+  @param[in,out] PeqScratch     The bit-parallel scratch buffer set up for the
+                                pattern with NumBlocks blocks per character
+                                value.
+  @param[in]     NumBlocks      The number of blocks per character value.
+  @param[in]     PatternLength  The length, in characters, of the pattern.
+  @param[in]     Text           The text to compare the pattern to.
+  @param[in]     TextLength     The length, in characters, of Text.
+  @param[in]     MaxDistance    The maximum distance of interest.
+
+  @returns  The Levenshtein distance from the pattern to Text, or a value
+            larger than MaxDistance.
+*/
+static size_t ScLevenshteinMyersDispatch(
+  uint64_t   *PeqScratch,
+  size_t     NumBlocks,
+  size_t     PatternLength,
+  const char *Text,
+  size_t     TextLength,
+  size_t     MaxDistance
+  )
+{
+  assert(NumBlocks == SC_LEVENSHTEIN_NUM_BLOCKS(PatternLength));
+  //
+  // Saturate the cutoff such that an unlimited MaxDistance never terminates
+  // early.
+  //
+  size_t     Cutoff;
+  const bool Result = ScSafeAddSize(MaxDistance, TextLength, &Cutoff);
+  if (Result) {
+    Cutoff = SIZE_MAX;
+  }
+
+  if (NumBlocks == 1) {
+    return ScLevenshteinMyers(
+      PeqScratch,
+      PatternLength,
+      Text,
+      TextLength,
+      Cutoff
+      );
+  }
+
+  return ScLevenshteinMyersBlocked(
+    PeqScratch,
+    NumBlocks,
+    PatternLength,
+    Text,
+    TextLength,
+    Cutoff
+    );
+}
+
+size_t ScLevenshteinDistanceBitParallel(
+  uint64_t   *PeqScratch,
+  const char *Str1,
+  size_t     Str1Length,
+  const char *Str2,
+  size_t     Str2Length
+  )
+{
+  assert(PeqScratch != NULL);
+  assert(Str1 != NULL && Str1Length != 0);
+  assert(Str2 != NULL && Str2Length != 0);
+  //
+  // The Levenshtein distance is symmetric. Use the shorter string as the
+  // pattern to minimise the number of blocks.
+  //
+  const char *Pattern;
+  size_t     PatternLength;
+  const char *Text;
+  size_t     TextLength;
+  if (Str1Length <= Str2Length) {
+    Pattern       = Str1;
+    PatternLength = Str1Length;
+    Text          = Str2;
+    TextLength    = Str2Length;
+  } else {
+    Pattern       = Str2;
+    PatternLength = Str2Length;
+    Text          = Str1;
+    TextLength    = Str1Length;
+  }
+
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterDistances, 1);
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterDpCells, PatternLength * TextLength);
+
+  const size_t NumBlocks = SC_LEVENSHTEIN_NUM_BLOCKS(PatternLength);
+  ScLevenshteinPeqSetup(PeqScratch, NumBlocks, Pattern, PatternLength);
+
+  size_t Distance = ScLevenshteinMyersDispatch(
+    PeqScratch,
+    NumBlocks,
+    PatternLength,
+    Text,
+    TextLength,
+    SIZE_MAX
+    );
+
+  ScLevenshteinPeqClear(PeqScratch, NumBlocks, Pattern, PatternLength);
+
+  return Distance;
+}
+
+size_t ScLevenshteinPeqCompile(
+  uint64_t                   *PeqScratch,
+  sc_levenshtein_peq_entry_t *Entries,
+  const char                 *Pattern,
+  size_t                     PatternLength
+  )
+{
+  assert(PeqScratch != NULL);
+  assert(Pattern != NULL && PatternLength != 0);
+
+  const size_t NumBlocks = SC_LEVENSHTEIN_NUM_BLOCKS(PatternLength);
+  ScLevenshteinPeqSetup(PeqScratch, NumBlocks, Pattern, PatternLength);
+  //
+  // Emit every non-zero table element on its first occurence and clear it, so
+  // that every element is emitted exactly once and the table is restored.
+  //
+  size_t NumEntries = 0;
+  for (size_t CharIndex = 0; CharIndex < PatternLength; ++CharIndex) {
+    const size_t BlockIndex = CharIndex / SC_LEVENSHTEIN_BLOCK_BITS;
+    const size_t PeqIndex   = (size_t) Pattern[CharIndex] * NumBlocks
+                                + BlockIndex;
+    if (PeqScratch[PeqIndex] != 0) {
+      if (Entries != NULL) {
+        Entries[NumEntries].Mask  = PeqScratch[PeqIndex];
+        Entries[NumEntries].Index = (uint32_t) PeqIndex;
+      }
+
+      PeqScratch[PeqIndex] = 0;
+      ++NumEntries;
+    }
+  }
+
+  assert(NumEntries <= PatternLength);
+  return NumEntries;
+}
+
+size_t ScLevenshteinDistanceCompiled(
+  uint64_t                         *PeqScratch,
+  const sc_levenshtein_peq_entry_t *Entries,
+  size_t                           NumEntries,
+  size_t                           PatternLength,
+  const char                       *Text,
+  size_t                           TextLength,
+  size_t                           MaxDistance
+  )
+{
+  const sc_levenshtein_text_t Texts[] = { { Text, TextLength, MaxDistance } };
+
+  size_t Distance;
+  ScLevenshteinDistanceCompiledBatch(
+    PeqScratch,
+    Entries,
+    NumEntries,
+    PatternLength,
+    Texts,
+    SC_ARRAY_LEN(Texts),
+    &Distance
+    );
+
+  return Distance;
+}
+
+void ScLevenshteinDistanceCompiledBatch(
+  uint64_t                         *PeqScratch,
+  const sc_levenshtein_peq_entry_t *Entries,
+  size_t                           NumEntries,
+  size_t                           PatternLength,
+  const sc_levenshtein_text_t      *Texts,
+  size_t                           NumTexts,
+  size_t                           *Distances
+  )
+{
+  assert(PeqScratch != NULL);
+  assert(Entries != NULL);
+  assert(NumEntries > 0 && NumEntries <= PatternLength);
+  assert(Texts != NULL || NumTexts == 0);
+  assert(Distances != NULL || NumTexts == 0);
+  //
+  // Scatter the compiled bitmasks into the table once for all texts and
+  // gather them back after the calculations.
+  //
+  for (size_t EntryIndex = 0; EntryIndex < NumEntries; ++EntryIndex) {
+    PeqScratch[Entries[EntryIndex].Index] = Entries[EntryIndex].Mask;
+  }
+
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterDistances, NumTexts);
+
+  const size_t NumBlocks = SC_LEVENSHTEIN_NUM_BLOCKS(PatternLength);
+  for (size_t TextIndex = 0; TextIndex < NumTexts; ++TextIndex) {
+    assert(Texts[TextIndex].Text != NULL && Texts[TextIndex].Length != 0);
+
+    SC_INSTRUMENT_COUNT(
+      ScInstrumentCounterDpCells,
+      PatternLength * Texts[TextIndex].Length
+      );
+
+    Distances[TextIndex] = ScLevenshteinMyersDispatch(
+                             PeqScratch,
+                             NumBlocks,
+                             PatternLength,
+                             Texts[TextIndex].Text,
+                             Texts[TextIndex].Length,
+                             Texts[TextIndex].MaxDistance
+                             );
+  }
+
+  for (size_t EntryIndex = 0; EntryIndex < NumEntries; ++EntryIndex) {
+    PeqScratch[Entries[EntryIndex].Index] = 0;
+  }
+}
+
+void ScLevenshteinHistogramInitialise(
+  uint8_t    *Histogram,
+  const char *String,
+  size_t     StringLength
+  )
+{
+  assert(Histogram != NULL);
+  assert(String != NULL || StringLength == 0);
+
+  for (size_t Index = 0; Index < SC_LEVENSHTEIN_HISTOGRAM_SIZE; ++Index) {
+    Histogram[Index] = 0;
+  }
+
+  for (size_t CharIndex = 0; CharIndex < StringLength; ++CharIndex) {
+    const size_t Class = SC_LEVENSHTEIN_HISTOGRAM_CLASS(String[CharIndex]);
+    //
+    // Saturation keeps the bound valid, as it never increases the difference
+    // of two counts.
+    //
+    if (Histogram[Class] < UINT8_MAX) {
+      ++Histogram[Class];
+    }
+  }
+}
+
+size_t ScLevenshteinHistogramBound(
+  const uint8_t *Histogram1,
+  const uint8_t *Histogram2
+  )
+{
+  assert(Histogram1 != NULL);
+  assert(Histogram2 != NULL);
+  //
+  // Every edit operation removes at most one surplus and one deficit of a
+  // character class, hence the distance is at least the larger of both sums.
+  //
+  unsigned int Surplus = 0;
+  unsigned int Deficit = 0;
+  for (size_t Index = 0; Index < SC_LEVENSHTEIN_HISTOGRAM_SIZE; ++Index) {
+    const uint8_t Count1 = Histogram1[Index];
+    const uint8_t Count2 = Histogram2[Index];
+    Surplus += (uint8_t) (Count1 > Count2 ? Count1 - Count2 : 0);
+    Deficit += (uint8_t) (Count2 > Count1 ? Count2 - Count1 : 0);
+  }
+
+  return SC_MAX(Surplus, Deficit);
+}
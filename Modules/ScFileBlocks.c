@@ -0,0 +1,210 @@
+/*@file
+  Provides functions to partition the file list into blocks within a memory
+  budget and to schedule the loading and freeing of the blocks while their
+  pairings are rated.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ScFileBlocks.h>
+#include <ScSafeInt.h>
+
+///
+/// The estimated ratio of the memory of a loaded file to its size. The line
+/// profiles dominate, which amount to about 8.4 times the size of typical
+/// source files.
+///
+#define SC_FILE_FOOTPRINT_FACTOR  9U
+
+unsigned int ScFileBlocksPartition(
+  const size_t    *FileSizes,
+  unsigned int    NumFiles,
+  size_t          MaxFileSize,
+  uint64_t        BlockBudget,
+  sc_file_block_t *Blocks
+  )
+{
+  assert(FileSizes != NULL || NumFiles == 0);
+  assert(Blocks != NULL || NumFiles == 0);
+
+  unsigned int NumBlocks = 0;
+  uint64_t     Used      = 0;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    //
+    // Assume the worst for files whose size is not known in advance. Larger
+    // files are rejected when loading.
+    //
+    const uint64_t Footprint = (uint64_t) SC_MIN(
+                                            FileSizes[FileIndex],
+                                            MaxFileSize
+                                            )
+                                 * SC_FILE_FOOTPRINT_FACTOR;
+    if (NumBlocks == 0 || (Used > 0 && Used + Footprint > BlockBudget)) {
+      Blocks[NumBlocks].Start = FileIndex;
+      ++NumBlocks;
+      Used = 0;
+    }
+
+    Used                     += Footprint;
+    Blocks[NumBlocks - 1U].End = FileIndex + 1U;
+  }
+
+  return NumBlocks;
+}
+
+unsigned int ScFileBlocksStart(
+  sc_file_block_steps_t *Steps,
+  const sc_file_block_t *Blocks,
+  unsigned int          NumBlocks,
+  unsigned int          NumRowFiles,
+  unsigned int          Load[2]
+  )
+{
+  assert(Steps != NULL);
+  assert(Blocks != NULL);
+  assert(NumBlocks > 0);
+  assert(Load != NULL);
+
+  unsigned int NumRowBlocks = 0;
+  while (NumRowBlocks < NumBlocks && Blocks[NumRowBlocks].Start < NumRowFiles) {
+    ++NumRowBlocks;
+  }
+
+  Steps->NumResident  = 0;
+  Steps->Loading[0]   = 0;
+  Steps->NumLoading   = 1;
+  Steps->Row          = 0;
+  Steps->Column       = 0;
+  Steps->NumBlocks    = NumBlocks;
+  Steps->NumRowBlocks = NumRowBlocks;
+  Steps->HasStep      = NumRowBlocks > 0;
+
+  Load[0] = 0;
+  return 1;
+}
+
+bool ScFileBlocksNextStep(
+  sc_file_block_steps_t *Steps,
+  unsigned int          *Row,
+  unsigned int          *Column,
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS],
+  unsigned int          *NumEvict,
+  unsigned int          Load[2],
+  unsigned int          *NumLoad
+  )
+{
+  assert(Steps != NULL);
+  assert(Row != NULL);
+  assert(Column != NULL);
+  assert(Evict != NULL);
+  assert(NumEvict != NULL);
+  assert(Load != NULL);
+  assert(NumLoad != NULL);
+  assert(Steps->NumResident + Steps->NumLoading <= SC_MAX_RESIDENT_BLOCKS);
+  //
+  // The blocks loaded during the previous step are resident now.
+  //
+  for (unsigned int Index = 0; Index < Steps->NumLoading; ++Index) {
+    Steps->Resident[Steps->NumResident] = Steps->Loading[Index];
+    ++Steps->NumResident;
+  }
+
+  Steps->NumLoading = 0;
+  *NumEvict         = 0;
+  *NumLoad          = 0;
+
+  if (!Steps->HasStep) {
+    for (unsigned int Index = 0; Index < Steps->NumResident; ++Index) {
+      Evict[Index] = Steps->Resident[Index];
+    }
+
+    *NumEvict          = Steps->NumResident;
+    Steps->NumResident = 0;
+    return false;
+  }
+
+  *Row    = Steps->Row;
+  *Column = Steps->Column;
+
+  unsigned int NextRow    = *Row;
+  unsigned int NextColumn = *Column + 1U;
+  if (NextColumn == Steps->NumBlocks) {
+    ++NextRow;
+    NextColumn = NextRow;
+  }
+
+  const bool HasNext = NextRow < Steps->NumRowBlocks;
+  //
+  // Free the blocks that neither this nor the next step needs.
+  //
+  for (unsigned int Index = 0; Index < Steps->NumResident; ++Index) {
+    const unsigned int BlockIndex = Steps->Resident[Index];
+    if (BlockIndex == *Row
+     || BlockIndex == *Column
+     || (HasNext && (BlockIndex == NextRow || BlockIndex == NextColumn))) {
+      continue;
+    }
+
+    Evict[*NumEvict] = BlockIndex;
+    ++(*NumEvict);
+    --Steps->NumResident;
+    Steps->Resident[Index] = Steps->Resident[Steps->NumResident];
+    --Index;
+  }
+  //
+  // Collect the blocks of the next step that are not loaded yet.
+  //
+  for (unsigned int Index = 0; HasNext && Index < 2U; ++Index) {
+    const unsigned int BlockIndex = Index == 0 ? NextRow : NextColumn;
+    bool               Loaded     = Index == 1U && NextColumn == NextRow;
+    for (unsigned int Index2 = 0; Index2 < Steps->NumResident; ++Index2) {
+      Loaded = Loaded || Steps->Resident[Index2] == BlockIndex;
+    }
+
+    if (!Loaded) {
+      Load[*NumLoad]                   = BlockIndex;
+      Steps->Loading[Steps->NumLoading] = BlockIndex;
+      ++(*NumLoad);
+      ++Steps->NumLoading;
+    }
+  }
+
+  assert(Steps->NumResident + Steps->NumLoading <= SC_MAX_RESIDENT_BLOCKS);
+
+  Steps->Row     = NextRow;
+  Steps->Column  = NextColumn;
+  Steps->HasStep = HasNext;
+  return true;
+}
+
+unsigned int ScFileBlocksStop(
+  sc_file_block_steps_t *Steps,
+  unsigned int          Evict[SC_MAX_RESIDENT_BLOCKS]
+  )
+{
+  assert(Steps != NULL);
+  assert(Evict != NULL);
+  assert(Steps->NumResident + Steps->NumLoading <= SC_MAX_RESIDENT_BLOCKS);
+
+  unsigned int NumEvict = 0;
+  for (unsigned int Index = 0; Index < Steps->NumResident; ++Index) {
+    Evict[NumEvict] = Steps->Resident[Index];
+    ++NumEvict;
+  }
+
+  for (unsigned int Index = 0; Index < Steps->NumLoading; ++Index) {
+    Evict[NumEvict] = Steps->Loading[Index];
+    ++NumEvict;
+  }
+
+  Steps->NumResident = 0;
+  Steps->NumLoading  = 0;
+  Steps->HasStep     = false;
+  return NumEvict;
+}
@@ -5,13 +5,36 @@
   SPDX-License-Identifier: BSD-3-Clause
 */
 
+//
+// Expose the POSIX APIs used for file mapping in strict ISO C mode.
+//
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE  200809L
+#endif
+
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+
+  #define SC_FILE_MAPPING_SUPPORTED
+#elif defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+
+  #define SC_FILE_MAPPING_SUPPORTED
+#endif
 
 #include <ScFileIo.h>
+#include <ScSafeInt.h>
 
 //
 // We may perform bitwise operations on the file data, e.g. to normalise or
@@ -26,6 +49,140 @@ _Static_assert(
   "For code safety reasons, please ensure char is an unsigned 8-bit value."
   );
 
+char *ScReadFileStream(
+  size_t *FileSize,
+  FILE   *FileHandle,
+  size_t MaxFileSize
+  )
+{
+  assert(FileSize != NULL);
+  assert(FileHandle != NULL);
+
+  assert(MaxFileSize < SIZE_MAX);
+
+  size_t BufferSize = MaxFileSize < 4096U ? MaxFileSize + 1U : 4096U;
+  size_t DataSize   = 0;
+  char   *Buffer    = NULL;
+  while (true) {
+    if (DataSize == BufferSize || Buffer == NULL) {
+      //
+      // Read one byte past MaxFileSize to detect oversized contents.
+      //
+      if (Buffer != NULL) {
+        BufferSize = BufferSize <= MaxFileSize / 2U
+                       ? BufferSize * 2U
+                       : MaxFileSize + 1U;
+      }
+
+      char *NewBuffer = realloc(Buffer, BufferSize);
+      if (NewBuffer == NULL) {
+        free(Buffer);
+        return NULL;
+      }
+
+      Buffer = NewBuffer;
+    }
+
+    const size_t ReadSize = fread(
+      &Buffer[DataSize],
+      1,
+      BufferSize - DataSize,
+      FileHandle
+      );
+    DataSize += ReadSize;
+
+    if (DataSize > MaxFileSize) {
+      free(Buffer);
+      return NULL;
+    }
+
+    if (DataSize < BufferSize) {
+      if (ferror(FileHandle) != 0) {
+        free(Buffer);
+        return NULL;
+      }
+
+      if (feof(FileHandle) != 0) {
+        break;
+      }
+    }
+  }
+
+  *FileSize = DataSize;
+  return Buffer;
+}
+
+char *ScReadFileList(
+  char   ***Paths,
+  size_t *NumPaths,
+  FILE   *FileHandle,
+  bool   NulSeparated
+  )
+{
+  assert(Paths != NULL);
+  assert(NumPaths != NULL);
+  assert(FileHandle != NULL);
+
+  size_t ListSize;
+  char   *List = ScReadFileStream(&ListSize, FileHandle, SIZE_MAX / 2U);
+  if (List == NULL) {
+    return NULL;
+  }
+  //
+  // Terminate the last path, which may lack a separator.
+  //
+  List[ListSize] = '\0';
+  //
+  // Every path of the list is followed by a separator or the terminator.
+  //
+  const char Separator = NulSeparated ? '\0' : '\n';
+  size_t     MaxPaths  = 1;
+  for (size_t Index = 0; Index < ListSize; ++Index) {
+    if (List[Index] == Separator) {
+      ++MaxPaths;
+    }
+  }
+
+  char   **ListPaths = NULL;
+  size_t Size;
+  if (!ScSafeMulSize(MaxPaths, sizeof(*ListPaths), &Size)) {
+    ListPaths = malloc(Size);
+  }
+
+  if (ListPaths == NULL) {
+    free(List);
+    return NULL;
+  }
+  //
+  // Split the list in-place and skip empty paths, e.g. of a trailing
+  // separator. Strip carriage returns of lists with Windows line endings.
+  //
+  size_t NumListed = 0;
+  size_t Start     = 0;
+  for (size_t Index = 0; Index <= ListSize; ++Index) {
+    if (List[Index] != Separator && Index < ListSize) {
+      continue;
+    }
+
+    size_t End = Index;
+    if (!NulSeparated && End > Start && List[End - 1U] == '\r') {
+      --End;
+    }
+
+    List[End] = '\0';
+    if (End > Start) {
+      ListPaths[NumListed] = &List[Start];
+      ++NumListed;
+    }
+
+    Start = Index + 1U;
+  }
+
+  *Paths    = ListPaths;
+  *NumPaths = NumListed;
+  return List;
+}
+
 char *ScReadFile(
   size_t     *FileSize,
   const char *FileName,
@@ -34,6 +191,7 @@ char *ScReadFile(
 {
   assert(FileSize != NULL);
   assert(FileName != NULL);
+  assert(MaxFileSize < SIZE_MAX);
   //
   // Open files in binary mode to avoid unexpected text translation effects.
   //
@@ -41,62 +199,309 @@ char *ScReadFile(
   if (FileHandle == NULL) {
     return NULL;
   }
+
+  char   *FileBuffer;
+  size_t BinFileSize;
   //
   // Set the current position to the end of the file to retrieve the file size.
   // Due to binary open mode, this is technically Implementation-defined
   // Behaviour, however all common implementations support this fine.
+  // Streams like pipes cannot be seeked, hence read them incrementally.
   //
   int SeekResult = fseek(FileHandle, 0, SEEK_END);
   if (SeekResult != 0) {
+    FileBuffer = ScReadFileStream(&BinFileSize, FileHandle, MaxFileSize);
+  } else {
+    //
+    // Retrieve and sanitize the file size in bytes.
+    // The cast in the second condition is safe due to the first condition.
+    //
+    long BinFileTell = ftell(FileHandle);
+    if (BinFileTell < 0 || (unsigned long) BinFileTell > MaxFileSize) {
+      fclose(FileHandle);
+      return NULL;
+    }
+
+    BinFileSize = (size_t) BinFileTell;
+    //
+    // Rewind the file to its start position to account for size retrieval.
+    //
+    rewind(FileHandle);
+
+    FileBuffer = malloc(BinFileSize);
+    if (FileBuffer != NULL) {
+      //
+      // Read the file's entire content into FileBuffer up to the actual data
+      // size.
+      //
+      size_t ReadSize = fread(
+        FileBuffer,
+        1,
+        BinFileSize,
+        FileHandle
+        );
+      if (ReadSize != BinFileSize) {
+        free(FileBuffer);
+        FileBuffer = NULL;
+      }
+    }
+  }
+  //
+  // Close the file handle as it is no longer required.
+  // While an error-exit due to closing failure may be unintuitive, we must not
+  // allow dangling resources to pile up.
+  //
+  int CloseResult = fclose(FileHandle);
+  if (CloseResult != 0) {
+    free(FileBuffer);
+    return NULL;
+  }
+
+  if (FileBuffer == NULL) {
     return NULL;
   }
   //
-  // Retrieve and sanitize the file size in bytes.
-  // The cast in the second condition is safe due to the first condition.
+  // Return the read file data.
   //
-  long BinFileTell = ftell(FileHandle);
-  if (BinFileTell < 0 || (unsigned long) BinFileTell > MaxFileSize) {
+  *FileSize = BinFileSize;
+  return FileBuffer;
+}
+
+#if defined(SC_FILE_MAPPING_SUPPORTED)
+/*
+  Maps the regular file from path FileName copy-on-write.
+
+  @param[out] FileSize     A pointer into which the file buffer's size is
+                           returned.
+  @param[in]  FileName     The path of the file to map.
+  @param[in]  MaxFileSize  The maximum size of the file.
+  @param[in]  Prefetch     Whether to start reading the file asynchronously.
+  @param[out] Fallback     Whether the file could not be mapped and is to be
+                           read instead, e.g. because it is no regular file.
+
+  @retval NULL   The file could not be mapped.
+  @retval other  The mapped file's contents.
+*/
+static char *ScMapFileInternal(
+  size_t     *FileSize,
+  const char *FileName,
+  size_t     MaxFileSize,
+  bool       Prefetch,
+  bool       *Fallback
+  )
+{
+  assert(FileSize != NULL);
+  assert(FileName != NULL);
+  assert(Fallback != NULL);
+
+  *Fallback = false;
+
+#if defined(_WIN32)
+  //
+  // Prefetching is left to the cache manager.
+  //
+  (void) Prefetch;
+
+  HANDLE FileHandle = CreateFileA(
+    FileName,
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    NULL,
+    OPEN_EXISTING,
+    FILE_FLAG_SEQUENTIAL_SCAN,
+    NULL
+    );
+  if (FileHandle == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+
+  LARGE_INTEGER Size;
+  if (GetFileType(FileHandle) != FILE_TYPE_DISK
+   || !GetFileSizeEx(FileHandle, &Size)
+   || Size.QuadPart == 0) {
+    CloseHandle(FileHandle);
+    *Fallback = true;
     return NULL;
   }
 
-  size_t BinFileSize = (size_t) BinFileTell;
+  if ((unsigned long long) Size.QuadPart > MaxFileSize) {
+    CloseHandle(FileHandle);
+    return NULL;
+  }
   //
-  // Rewind the file to its start position to account for size retrieval.
+  // Map the file copy-on-write, so that cleansing can modify the buffer in
+  // place without affecting the file. The view stays valid after closing the
+  // handles.
   //
-  rewind(FileHandle);
+  HANDLE MappingHandle = CreateFileMappingA(
+    FileHandle,
+    NULL,
+    PAGE_WRITECOPY,
+    0,
+    0,
+    NULL
+    );
+  CloseHandle(FileHandle);
+  if (MappingHandle == NULL) {
+    *Fallback = true;
+    return NULL;
+  }
 
-  char *FileBuffer = malloc(BinFileSize);
-  if (FileBuffer == NULL) {
+  char *Buffer = MapViewOfFile(MappingHandle, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(MappingHandle);
+  if (Buffer == NULL) {
+    *Fallback = true;
     return NULL;
   }
+
+  *FileSize = (size_t) Size.QuadPart;
+  return Buffer;
+#else
+  int FileDescriptor = open(FileName, O_RDONLY);
+  if (FileDescriptor < 0) {
+    return NULL;
+  }
+
+  struct stat FileStat;
+  int         Result = fstat(FileDescriptor, &FileStat);
+  if (Result != 0 || !S_ISREG(FileStat.st_mode) || FileStat.st_size == 0) {
+    close(FileDescriptor);
+    *Fallback = true;
+    return NULL;
+  }
+
+  if ((unsigned long long) FileStat.st_size > MaxFileSize) {
+    close(FileDescriptor);
+    return NULL;
+  }
+
+  const size_t Size = (size_t) FileStat.st_size;
   //
-  // Read the file's entire content into FileBuffer up to the actual data size.
+  // Map the file copy-on-write, so that cleansing can modify the buffer in
+  // place without affecting the file. The mapping stays valid after closing
+  // the file descriptor.
   //
-  size_t ReadSize = fread(
-    FileBuffer,
-    1,
-    BinFileSize,
-    FileHandle
+  void *Buffer = mmap(
+    NULL,
+    Size,
+    PROT_READ | PROT_WRITE,
+    MAP_PRIVATE,
+    FileDescriptor,
+    0
     );
-  if (ReadSize != BinFileSize) {
-    free(FileBuffer);
+  close(FileDescriptor);
+  if (Buffer == MAP_FAILED) {
+    *Fallback = true;
     return NULL;
   }
   //
+  // The mapping is accessed front to back exactly once by cleansing.
+  //
+  posix_madvise(
+    Buffer,
+    Size,
+    Prefetch ? POSIX_MADV_WILLNEED : POSIX_MADV_SEQUENTIAL
+    );
+
+  *FileSize = Size;
+  return Buffer;
+#endif
+}
+#endif
+
+char *ScMapFile(
+  size_t     *FileSize,
+  size_t     *MappingSize,
+  const char *FileName,
+  size_t     MaxFileSize,
+  bool       Prefetch
+  )
+{
+  assert(FileSize != NULL);
+  assert(MappingSize != NULL);
+  assert(FileName != NULL);
+
+#if defined(SC_FILE_MAPPING_SUPPORTED)
+  bool Fallback;
+  char *Buffer = ScMapFileInternal(
+    FileSize,
+    FileName,
+    MaxFileSize,
+    Prefetch,
+    &Fallback
+    );
+  if (Buffer != NULL) {
+    *MappingSize = *FileSize;
+    return Buffer;
+  }
+
+  if (!Fallback) {
+    return NULL;
+  }
+#else
+  (void) Prefetch;
+#endif
+
+  *MappingSize = 0;
+  return ScReadFile(FileSize, FileName, MaxFileSize);
+}
+
+void ScUnmapFile(
+  char   *Buffer,
+  size_t MappingSize
+  )
+{
+  if (MappingSize == 0) {
+    free(Buffer);
+    return;
+  }
+
+  assert(Buffer != NULL);
+
+#if defined(_WIN32)
+  UnmapViewOfFile(Buffer);
+#elif defined(SC_FILE_MAPPING_SUPPORTED)
+  munmap(Buffer, MappingSize);
+#else
+  assert(false);
+#endif
+}
+
+/*
+  Writes a buffer to the file opened as FileHandle and closes it.
+
+  @param[in] FileHandle  The handle of the file to write. It is closed in any
+                         case.
+  @param[in] FileSize    The size of Buffer, in bytes, to write.
+  @param[in] Buffer      The data to write to the file.
+
+  @returns  Whether the file has been written successfully.
+*/
+static bool ScWriteFileHandle(
+  FILE       *FileHandle,
+  size_t     FileSize,
+  const char *Buffer
+  )
+{
+  assert(FileHandle != NULL);
+  assert(Buffer != NULL || FileSize == 0);
+
+  size_t WrittenSize = fwrite(Buffer, 1, FileSize, FileHandle);
+  if (WrittenSize != FileSize) {
+    fclose(FileHandle);
+    return false;
+  }
+  //
   // Close the file handle as it is no longer required.
   // While an error-exit due to closing failure may be unintuitive, we must not
   // allow dangling resources to pile up.
   //
   int CloseResult = fclose(FileHandle);
   if (CloseResult != 0) {
-    free(FileBuffer);
-    return NULL;
+    return false;
   }
-  //
-  // Return the read file data.
-  //
-  *FileSize = BinFileSize;
-  return FileBuffer;
+
+  return true;
 }
 
 bool ScWriteFile(
@@ -116,21 +521,128 @@ bool ScWriteFile(
     return false;
   }
 
-  size_t WrittenSize = fwrite(Buffer, 1, FileSize, FileHandle);
-  if (WrittenSize != FileSize) {
+  return ScWriteFileHandle(FileHandle, FileSize, Buffer);
+}
+
+bool ScReplaceFile(
+  const char *FileName,
+  size_t     FileSize,
+  const char *Buffer
+  )
+{
+  assert(FileName != NULL);
+  assert(Buffer != NULL || FileSize == 0);
+
+  const size_t PathLength = strlen(FileName);
+  char         *TempPath  = malloc(PathLength + 48U);
+  if (TempPath == NULL) {
     return false;
   }
+
+  FILE *FileHandle = NULL;
+#if defined(SC_FILE_MAPPING_SUPPORTED) && !defined(_WIN32)
   //
-  // Close the file handle as it is no longer required.
-  // While an error-exit due to closing failure may be unintuitive, we must not
-  // allow dangling resources to pile up.
+  // mkstemp() creates a file of a unique name, which no other process or
+  // thread can have opened.
   //
-  int CloseResult = fclose(FileHandle);
-  if (CloseResult != 0) {
+  snprintf(TempPath, PathLength + 48U, "%s.XXXXXX", FileName);
+  int FileDesc = mkstemp(TempPath);
+  if (FileDesc != -1) {
+    //
+    // mkstemp() restricts the access to the owner, but the file replaced
+    // may be shared.
+    //
+    if (fchmod(FileDesc, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0) {
+      FileHandle = fdopen(FileDesc, "wb");
+    }
+
+    if (FileHandle == NULL) {
+      close(FileDesc);
+      remove(TempPath);
+    }
+  }
+#else
+  //
+  // The process ID distinguishes concurrent processes, and the counter
+  // distinguishes concurrent writers within this process.
+  //
+  static unsigned long long mScTempCounter = 0;
+
+  unsigned long long TempIndex;
+  #pragma omp atomic capture
+  TempIndex = mScTempCounter++;
+
+  unsigned long ProcessId = 0;
+  #if defined(_WIN32)
+  ProcessId = (unsigned long) GetCurrentProcessId();
+  #endif
+
+  snprintf(
+    TempPath,
+    PathLength + 48U,
+    "%s.%lx.%llx.tmp",
+    FileName,
+    ProcessId,
+    TempIndex
+    );
+  FileHandle = fopen(TempPath, "wb");
+#endif
+
+  if (FileHandle == NULL) {
+    free(TempPath);
+    return false;
+  }
+
+  bool Result = ScWriteFileHandle(FileHandle, FileSize, Buffer);
+  if (!Result || rename(TempPath, FileName) != 0) {
+    remove(TempPath);
+    Result = false;
+  }
+
+  free(TempPath);
+  return Result;
+}
+
+bool ScGetFileSize(
+  const char *FileName,
+  size_t     *FileSize
+  )
+{
+  assert(FileName != NULL);
+  assert(FileSize != NULL);
+
+#if defined(_WIN32)
+  WIN32_FILE_ATTRIBUTE_DATA FileData;
+  if (!GetFileAttributesExA(FileName, GetFileExInfoStandard, &FileData)
+   || (FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+    return false;
+  }
+
+  const unsigned long long Size =
+    ((unsigned long long) FileData.nFileSizeHigh << 32U)
+      | FileData.nFileSizeLow;
+  if (Size > SIZE_MAX) {
+    return false;
+  }
+
+  *FileSize = (size_t) Size;
+  return true;
+#elif defined(SC_FILE_MAPPING_SUPPORTED)
+  struct stat FileStat;
+  int         Result = stat(FileName, &FileStat);
+  if (Result != 0
+   || !S_ISREG(FileStat.st_mode)
+   || (unsigned long long) FileStat.st_size > SIZE_MAX) {
     return false;
   }
 
+  *FileSize = (size_t) FileStat.st_size;
   return true;
+#else
+  (void) FileName;
+  (void) FileSize;
+  return false;
+#endif
 }
 
 const char *
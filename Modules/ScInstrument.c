@@ -0,0 +1,345 @@
+/*@file
+  Provides functions to measure the phases of a run and to count hot-path
+  events.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include <ScInstrument.h>
+#include <ScSafeInt.h>
+
+///
+/// The measurements of a single thread.
+///
+typedef struct {
+  ///
+  /// The values of all counters.
+  ///
+  uint64_t      Counters[ScInstrumentCounterMax];
+  ///
+  /// The durations, in seconds, of all phases.
+  ///
+  double        PhaseSeconds[ScInstrumentPhaseMax];
+  ///
+  /// Separates the measurements of neighbouring threads by at least a cache
+  /// line to prevent false sharing.
+  ///
+  unsigned char Padding[64];
+} sc_instrument_thread_t;
+
+///
+/// The names of the counters for the report.
+///
+static const char *const mScInstrumentCounterNames[ScInstrumentCounterMax] = {
+  [ScInstrumentCounterPairings]         = "pairings",
+  [ScInstrumentCounterWindowCandidates] = "window_candidates",
+  [ScInstrumentCounterWindowPruned]     = "window_pruned",
+  [ScInstrumentCounterWindowResolved]   = "window_resolved",
+  [ScInstrumentCounterDistances]        = "distances",
+  [ScInstrumentCounterDpCells]          = "dp_cells",
+  [ScInstrumentCounterCacheLookups]     = "cache_lookups",
+  [ScInstrumentCounterCacheHits]        = "cache_hits"
+};
+
+///
+/// The names of the phases for the report.
+///
+static const char *const mScInstrumentPhaseNames[ScInstrumentPhaseMax] = {
+  [ScInstrumentPhaseRead]     = "read",
+  [ScInstrumentPhaseCleanse]  = "cleanse",
+  [ScInstrumentPhaseLineInfo] = "line_info",
+  [ScInstrumentPhaseSketch]   = "sketch",
+  [ScInstrumentPhaseCompare]  = "compare",
+  [ScInstrumentPhasePrint]    = "print"
+};
+
+///
+/// The regions the phases belong to.
+///
+static const sc_instrument_region_t mScInstrumentPhaseRegions[
+  ScInstrumentPhaseMax
+  ] = {
+  [ScInstrumentPhaseRead]     = ScInstrumentRegionLoad,
+  [ScInstrumentPhaseCleanse]  = ScInstrumentRegionLoad,
+  [ScInstrumentPhaseLineInfo] = ScInstrumentRegionLoad,
+  [ScInstrumentPhaseSketch]   = ScInstrumentRegionLoad,
+  [ScInstrumentPhaseCompare]  = ScInstrumentRegionCompare,
+  [ScInstrumentPhasePrint]    = ScInstrumentRegionPrint
+};
+
+///
+/// The names of the regions for the report.
+///
+static const char *const mScInstrumentRegionNames[ScInstrumentRegionMax] = {
+  [ScInstrumentRegionLoad]    = "load",
+  [ScInstrumentRegionCompare] = "compare",
+  [ScInstrumentRegionPrint]   = "print"
+};
+
+///
+/// The measurements of all threads. It is NULL if the instrumentation is not
+/// initialised.
+///
+static sc_instrument_thread_t *mScInstrumentThreads;
+
+///
+/// The number of elements in mScInstrumentThreads.
+///
+static unsigned int mScInstrumentNumThreads;
+
+///
+/// The wall times, in seconds, of all regions.
+///
+static double mScInstrumentRegionWall[ScInstrumentRegionMax];
+
+///
+/// The processor times, in seconds, of all regions.
+///
+static double mScInstrumentRegionCpu[ScInstrumentRegionMax];
+
+bool ScInstrumentInitialise(
+  unsigned int NumThreads
+  )
+{
+  assert(NumThreads > 0);
+
+  ScInstrumentFree();
+
+  mScInstrumentThreads = calloc(NumThreads, sizeof(*mScInstrumentThreads));
+  if (mScInstrumentThreads == NULL) {
+    return false;
+  }
+
+  mScInstrumentNumThreads = NumThreads;
+  for (size_t Region = 0; Region < ScInstrumentRegionMax; ++Region) {
+    mScInstrumentRegionWall[Region] = 0;
+    mScInstrumentRegionCpu[Region]  = 0;
+  }
+
+  return true;
+}
+
+void ScInstrumentFree(void)
+{
+  free(mScInstrumentThreads);
+  mScInstrumentThreads    = NULL;
+  mScInstrumentNumThreads = 0;
+}
+
+double ScInstrumentGetTime(void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  struct timespec Time;
+  timespec_get(&Time, TIME_UTC);
+  return (double) Time.tv_sec + (double) Time.tv_nsec / 1e9;
+#endif
+}
+
+sc_instrument_mark_t ScInstrumentGetMark(void)
+{
+  //
+  // clock() measures the processor time of all threads of the process.
+  //
+  const sc_instrument_mark_t Mark = {
+    ScInstrumentGetTime(),
+    (double) clock() / CLOCKS_PER_SEC
+  };
+  return Mark;
+}
+
+/*
+  Returns the measurements of the calling thread, or NULL if they are not
+  recorded.
+*/
+static sc_instrument_thread_t *ScInstrumentGetThread(void)
+{
+  unsigned int ThreadIndex = 0;
+#ifdef _OPENMP
+  ThreadIndex = (unsigned int) omp_get_thread_num();
+#endif
+  if (ThreadIndex >= mScInstrumentNumThreads) {
+    return NULL;
+  }
+
+  return &mScInstrumentThreads[ThreadIndex];
+}
+
+void ScInstrumentCount(
+  sc_instrument_counter_t Counter,
+  uint64_t                Value
+  )
+{
+  assert(Counter < ScInstrumentCounterMax);
+
+  sc_instrument_thread_t *Thread = ScInstrumentGetThread();
+  if (Thread != NULL) {
+    Thread->Counters[Counter] += Value;
+  }
+}
+
+void ScInstrumentAddPhaseTime(
+  sc_instrument_phase_t Phase,
+  double                Seconds
+  )
+{
+  assert(Phase < ScInstrumentPhaseMax);
+
+  sc_instrument_thread_t *Thread = ScInstrumentGetThread();
+  if (Thread != NULL) {
+    Thread->PhaseSeconds[Phase] += Seconds;
+  }
+}
+
+void ScInstrumentAddRegionTime(
+  sc_instrument_region_t     Region,
+  const sc_instrument_mark_t *Start
+  )
+{
+  assert(Region < ScInstrumentRegionMax);
+  assert(Start != NULL);
+
+  const sc_instrument_mark_t Stop = ScInstrumentGetMark();
+  mScInstrumentRegionWall[Region] += Stop.Wall - Start->Wall;
+  mScInstrumentRegionCpu[Region]  += Stop.Cpu - Start->Cpu;
+}
+
+/*
+  Returns the duration, in seconds, a thread has spent in the phases of a
+  region.
+
+  @param[in] Thread  The measurements of the thread.
+  @param[in] Region  The region to sum up the phases of.
+*/
+static double ScInstrumentGetRegionBusy(
+  const sc_instrument_thread_t *Thread,
+  sc_instrument_region_t       Region
+  )
+{
+  assert(Thread != NULL);
+
+  double Seconds = 0;
+  for (size_t Phase = 0; Phase < ScInstrumentPhaseMax; ++Phase) {
+    if (mScInstrumentPhaseRegions[Phase] == Region) {
+      Seconds += Thread->PhaseSeconds[Phase];
+    }
+  }
+
+  return Seconds;
+}
+
+bool ScInstrumentReport(
+  FILE *Stream
+  )
+{
+  assert(Stream != NULL);
+
+  if (mScInstrumentThreads == NULL) {
+    return false;
+  }
+
+  fprintf(Stream, "{\n  \"threads\": %u,\n", mScInstrumentNumThreads);
+  //
+  // Report the busy times of the threads per region, whose spread denotes the
+  // load imbalance of its parallel loops. 1 is perfectly balanced.
+  //
+  fprintf(Stream, "  \"regions\": {");
+  for (size_t Region = 0; Region < ScInstrumentRegionMax; ++Region) {
+    double MaxBusy = 0;
+    double SumBusy = 0;
+    fprintf(
+      Stream,
+      "%s\n    \"%s\": {\n      \"wall_seconds\": %.6f,"
+      " \"cpu_seconds\": %.6f,\n      \"thread_busy_seconds\": [",
+      Region > 0 ? "," : "",
+      mScInstrumentRegionNames[Region],
+      mScInstrumentRegionWall[Region],
+      mScInstrumentRegionCpu[Region]
+      );
+    for (
+      unsigned int ThreadIndex = 0;
+      ThreadIndex < mScInstrumentNumThreads;
+      ++ThreadIndex
+      ) {
+      const double Busy = ScInstrumentGetRegionBusy(
+                            &mScInstrumentThreads[ThreadIndex],
+                            (sc_instrument_region_t) Region
+                            );
+      MaxBusy  = SC_MAX(MaxBusy, Busy);
+      SumBusy += Busy;
+      fprintf(Stream, "%s%.6f", ThreadIndex > 0 ? ", " : "", Busy);
+    }
+
+    const double MeanBusy = SumBusy / mScInstrumentNumThreads;
+    fprintf(
+      Stream,
+      "],\n      \"imbalance\": %.3f\n    }",
+      MeanBusy > 0 ? MaxBusy / MeanBusy : 1.0
+      );
+  }
+  //
+  // Report the phases as the sum of the durations of all threads.
+  //
+  fprintf(Stream, "\n  },\n  \"phases\": {");
+  for (size_t Phase = 0; Phase < ScInstrumentPhaseMax; ++Phase) {
+    double MaxSeconds = 0;
+    double SumSeconds = 0;
+    for (
+      unsigned int ThreadIndex = 0;
+      ThreadIndex < mScInstrumentNumThreads;
+      ++ThreadIndex
+      ) {
+      const double Seconds =
+        mScInstrumentThreads[ThreadIndex].PhaseSeconds[Phase];
+      MaxSeconds  = SC_MAX(MaxSeconds, Seconds);
+      SumSeconds += Seconds;
+    }
+
+    fprintf(
+      Stream,
+      "%s\n    \"%s\": { \"thread_seconds\": %.6f,"
+      " \"max_thread_seconds\": %.6f }",
+      Phase > 0 ? "," : "",
+      mScInstrumentPhaseNames[Phase],
+      SumSeconds,
+      MaxSeconds
+      );
+  }
+
+  fprintf(Stream, "\n  },\n  \"counters\": {");
+  for (size_t Counter = 0; Counter < ScInstrumentCounterMax; ++Counter) {
+    uint64_t Value = 0;
+    for (
+      unsigned int ThreadIndex = 0;
+      ThreadIndex < mScInstrumentNumThreads;
+      ++ThreadIndex
+      ) {
+      Value += mScInstrumentThreads[ThreadIndex].Counters[Counter];
+    }
+
+    fprintf(
+      Stream,
+      "%s\n    \"%s\": %llu",
+      Counter > 0 ? "," : "",
+      mScInstrumentCounterNames[Counter],
+      (unsigned long long) Value
+      );
+  }
+
+  fprintf(Stream, "\n  }\n}\n");
+  return !ferror(Stream);
+}
@@ -0,0 +1,202 @@
+/*@file
+  Provides functions to memoise distances between pairs of lines.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ScInstrument.h>
+#include <ScLineCache.h>
+#include <ScSafeInt.h>
+
+///
+/// The number of consecutive slots a key may be stored in.
+///
+#define SC_LINE_CACHE_NUM_WAYS  4U
+
+///
+/// The mask of the distance within sc_line_cache_slot_t.TagDistance.
+///
+#define SC_LINE_CACHE_DISTANCE_MASK  0xFFFFULL
+
+///
+/// The flag of sc_line_cache_slot_t.TagDistance denoting a lower bound.
+///
+#define SC_LINE_CACHE_BOUND_FLAG  0x8000ULL
+
+/*
+  Derives the keys of a line pair from the hashes of its lines.
+
+  @param[in]  Hash1  The hash of the first line.
+  @param[in]  Hash2  The hash of the second line.
+  @param[out] Key    The primary key of the pair. It is never 0.
+  @param[out] Tag    The secondary key of the pair in the upper 48 bits.
+*/
+static void ScLineCacheGetKeys(
+  uint64_t Hash1,
+  uint64_t Hash2,
+  uint64_t *Key,
+  uint64_t *Tag
+  )
+{
+  assert(Key != NULL);
+  assert(Tag != NULL);
+  //
+  // The Levenshtein distance is symmetric, hence normalise the order.
+  //
+  if (Hash1 > Hash2) {
+    const uint64_t HashTmp = Hash1;
+    Hash1 = Hash2;
+    Hash2 = HashTmp;
+  }
+
+  uint64_t Mixed = (Hash1 ^ ((Hash2 << 32U) | (Hash2 >> 32U)))
+                     * 0x9E3779B97F4A7C15ULL;
+  Mixed ^= Mixed >> 29U;
+  //
+  // 0 denotes an empty slot.
+  //
+  *Key = Mixed != 0 ? Mixed : 1;
+
+  uint64_t MixedTag = (Hash2 + Hash1 * 0xC2B2AE3D27D4EB4FULL)
+                        * 0x165667B19E3779F9ULL;
+  MixedTag ^= MixedTag >> 31U;
+  *Tag = MixedTag & ~SC_LINE_CACHE_DISTANCE_MASK;
+}
+
+sc_line_cache_t *ScLineCacheCreate(
+  size_t NumSlotsLog2
+  )
+{
+  assert(NumSlotsLog2 < sizeof(size_t) * 8U);
+
+  const size_t NumSlots = (size_t) 1U << NumSlotsLog2;
+  //
+  // Calculate the size required to hold the cache.
+  //
+  size_t CacheSize;
+  bool Result = ScSafeMulSize(
+    NumSlots,
+    sizeof(sc_line_cache_slot_t),
+    &CacheSize
+    );
+  Result |= ScSafeAddSize(sizeof(sc_line_cache_t), CacheSize, &CacheSize);
+  if (Result) {
+    return NULL;
+  }
+  //
+  // Zero-initialise the cache, which marks all slots as empty.
+  //
+  sc_line_cache_t *Cache = calloc(1, CacheSize);
+  if (Cache == NULL) {
+    return NULL;
+  }
+
+  Cache->SlotMask = NumSlots - 1U;
+  return Cache;
+}
+
+bool ScLineCacheLookup(
+  const sc_line_cache_t *Cache,
+  uint64_t              Hash1,
+  uint64_t              Hash2,
+  size_t                *Distance,
+  bool                  *Exact
+  )
+{
+  assert(Cache != NULL);
+  assert(Distance != NULL);
+  assert(Exact != NULL);
+
+  SC_INSTRUMENT_COUNT(ScInstrumentCounterCacheLookups, 1);
+
+  uint64_t Key;
+  uint64_t Tag;
+  ScLineCacheGetKeys(Hash1, Hash2, &Key, &Tag);
+
+  for (size_t Way = 0; Way < SC_LINE_CACHE_NUM_WAYS; ++Way) {
+    const sc_line_cache_slot_t *Slot =
+      &Cache->Slots[((size_t) Key + Way) & Cache->SlotMask];
+
+    uint64_t SlotKey;
+    #pragma omp atomic read
+    SlotKey = Slot->Key;
+
+    if (SlotKey == Key) {
+      uint64_t SlotTagDistance;
+      #pragma omp atomic read
+      SlotTagDistance = Slot->TagDistance;
+      //
+      // A concurrent insertion may have replaced the slot contents between
+      // both reads, in which case the secondary key does not match.
+      //
+      if ((SlotTagDistance & ~SC_LINE_CACHE_DISTANCE_MASK) == Tag) {
+        *Distance = (size_t) (SlotTagDistance & SC_LINE_CACHE_MAX_DISTANCE);
+        *Exact    = (SlotTagDistance & SC_LINE_CACHE_BOUND_FLAG) == 0;
+        SC_INSTRUMENT_COUNT(ScInstrumentCounterCacheHits, 1);
+        return true;
+      }
+    } else if (SlotKey == 0) {
+      //
+      // Keys are inserted into the first empty slot, hence the key cannot be
+      // stored in any of the following slots.
+      //
+      break;
+    }
+  }
+
+  return false;
+}
+
+void ScLineCacheInsert(
+  sc_line_cache_t *Cache,
+  uint64_t        Hash1,
+  uint64_t        Hash2,
+  size_t          Distance,
+  bool            Exact
+  )
+{
+  assert(Cache != NULL);
+  assert(Distance <= SC_LINE_CACHE_MAX_DISTANCE);
+
+  uint64_t Key;
+  uint64_t Tag;
+  ScLineCacheGetKeys(Hash1, Hash2, &Key, &Tag);
+  //
+  // Use the first empty slot. If all slots are occupied, evict one chosen by
+  // the secondary key to spread evictions evenly.
+  //
+  const size_t Base = (size_t) Key;
+  size_t       Way;
+  for (Way = 0; Way < SC_LINE_CACHE_NUM_WAYS; ++Way) {
+    uint64_t SlotKey;
+    #pragma omp atomic read
+    SlotKey = Cache->Slots[(Base + Way) & Cache->SlotMask].Key;
+
+    if (SlotKey == 0 || SlotKey == Key) {
+      break;
+    }
+  }
+
+  if (Way == SC_LINE_CACHE_NUM_WAYS) {
+    Way = (size_t) (Tag >> 62U) % SC_LINE_CACHE_NUM_WAYS;
+  }
+
+  sc_line_cache_slot_t *Slot = &Cache->Slots[(Base + Way) & Cache->SlotMask];
+  //
+  // Readers that observe a mix of the old and the new slot contents fail the
+  // secondary key check, hence no further synchronisation is required.
+  //
+  #pragma omp atomic write
+  Slot->TagDistance = Tag
+                      | (Exact ? 0 : SC_LINE_CACHE_BOUND_FLAG)
+                      | (uint64_t) Distance;
+  #pragma omp atomic write
+  Slot->Key = Key;
+}
@@ -0,0 +1,71 @@
+/*@file
+  Provides functions to estimate the similarity of sets of hashes.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ScMinHash.h>
+
+///
+/// The constants to derive the multiplier of every hash function.
+///
+#define SC_MIN_HASH_PRIME1  0x9E3779B97F4A7C15ULL
+#define SC_MIN_HASH_PRIME2  0xBF58476D1CE4E5B9ULL
+
+void ScMinHashInitialise(
+  sc_min_hash_t *Sketch
+  )
+{
+  assert(Sketch != NULL);
+
+  for (size_t Index = 0; Index < SC_MIN_HASH_NUM_HASHES; ++Index) {
+    Sketch->Minima[Index] = UINT64_MAX;
+  }
+}
+
+void ScMinHashAdd(
+  sc_min_hash_t *Sketch,
+  uint64_t      Hash
+  )
+{
+  assert(Sketch != NULL);
+  //
+  // As Hash is well-distributed already, multiplying with distinct odd
+  // constants yields sufficiently independent permutations of the hash space.
+  // Fold the upper bits back, as they are mixed best.
+  //
+  for (size_t Index = 0; Index < SC_MIN_HASH_NUM_HASHES; ++Index) {
+    const uint64_t Multiplier = (SC_MIN_HASH_PRIME1
+                                  + (uint64_t) Index * SC_MIN_HASH_PRIME2)
+                                  | 1U;
+    uint64_t Value = Hash * Multiplier;
+    Value ^= Value >> 31U;
+    if (Sketch->Minima[Index] > Value) {
+      Sketch->Minima[Index] = Value;
+    }
+  }
+}
+
+double ScMinHashSimilarity(
+  const sc_min_hash_t *Sketch1,
+  const sc_min_hash_t *Sketch2
+  )
+{
+  assert(Sketch1 != NULL);
+  assert(Sketch2 != NULL);
+  //
+  // The probability of a hash function to have the same minimum for both sets
+  // is precisely their Jaccard similarity.
+  //
+  size_t NumEqual = 0;
+  for (size_t Index = 0; Index < SC_MIN_HASH_NUM_HASHES; ++Index) {
+    NumEqual += Sketch1->Minima[Index] == Sketch2->Minima[Index];
+  }
+
+  return (double) NumEqual / (double) SC_MIN_HASH_NUM_HASHES;
+}
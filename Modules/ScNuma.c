@@ -0,0 +1,297 @@
+/*@file
+  Provides functions to map the OpenMP places the threads are bound to onto the
+  NUMA domains of the system.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include <ScFileIo.h>
+#include <ScNuma.h>
+#include <ScSafeInt.h>
+
+bool ScNumaParseIdRange(
+  const char    **List,
+  unsigned long *First,
+  unsigned long *Last
+  )
+{
+  assert(List != NULL && *List != NULL);
+  assert(First != NULL);
+  assert(Last != NULL);
+
+  if (**List < '0' || **List > '9') {
+    return false;
+  }
+
+  char *End;
+  *First = strtoul(*List, &End, 10);
+  *Last  = *First;
+  if (*End == '-') {
+    const char *Pos = End + 1;
+    *Last = strtoul(Pos, &End, 10);
+    if (End == Pos || *Last < *First) {
+      return false;
+    }
+  }
+
+  if (*End == ',') {
+    ++End;
+  }
+
+  *List = End;
+  return true;
+}
+
+#if defined(__linux__)
+/*
+  Reads the contents of the system file at Path and terminates them.
+
+  @retval NULL   The file cannot be read.
+  @retval other  The contents of the file. They are allocated with malloc and
+                 caller-owned.
+*/
+static char *ScReadSystemFile(
+  const char *Path
+  )
+{
+  assert(Path != NULL);
+
+  FILE *Handle = fopen(Path, "r");
+  if (Handle == NULL) {
+    return NULL;
+  }
+
+  size_t Size;
+  char   *Contents = ScReadFileStream(&Size, Handle, 1024U * 1024U);
+  fclose(Handle);
+  if (Contents != NULL) {
+    Contents[Size] = '\0';
+  }
+
+  return Contents;
+}
+
+unsigned int *ScNumaGetProcNodes(
+  size_t *NumProcs
+  )
+{
+  assert(NumProcs != NULL);
+
+  char *Procs = ScReadSystemFile("/sys/devices/system/cpu/possible");
+  char *Nodes = ScReadSystemFile("/sys/devices/system/node/possible");
+  if (Procs == NULL || Nodes == NULL) {
+    free(Procs);
+    free(Nodes);
+    return NULL;
+  }
+
+  unsigned long MaxProc = 0;
+  unsigned long First;
+  unsigned long Last;
+  for (const char *Pos = Procs; ScNumaParseIdRange(&Pos, &First, &Last);) {
+    MaxProc = SC_MAX(MaxProc, Last);
+  }
+
+  free(Procs);
+  //
+  // Bound the map to not trust arbitrary IDs.
+  //
+  unsigned int *ProcNodes = NULL;
+  if (MaxProc < UINT16_MAX) {
+    ProcNodes = malloc((MaxProc + 1U) * sizeof(*ProcNodes));
+  }
+
+  if (ProcNodes == NULL) {
+    free(Nodes);
+    return NULL;
+  }
+
+  for (unsigned long Proc = 0; Proc <= MaxProc; ++Proc) {
+    ProcNodes[Proc] = UINT_MAX;
+  }
+
+  for (const char *Pos = Nodes; ScNumaParseIdRange(&Pos, &First, &Last);) {
+    for (
+      unsigned long Node = First;
+      Node <= Last && Node < UINT16_MAX;
+      ++Node
+      ) {
+      char Path[64];
+      snprintf(
+        Path,
+        sizeof(Path),
+        "/sys/devices/system/node/node%lu/cpulist",
+        Node
+        );
+      //
+      // Nodes without processors may not list any.
+      //
+      char *NodeProcs = ScReadSystemFile(Path);
+      if (NodeProcs == NULL) {
+        continue;
+      }
+
+      unsigned long ProcFirst;
+      unsigned long ProcLast;
+      for (
+        const char *ProcPos = NodeProcs;
+        ScNumaParseIdRange(&ProcPos, &ProcFirst, &ProcLast);
+        ) {
+        for (
+          unsigned long Proc = ProcFirst;
+          Proc <= ProcLast && Proc <= MaxProc;
+          ++Proc
+          ) {
+          ProcNodes[Proc] = (unsigned int) Node;
+        }
+      }
+
+      free(NodeProcs);
+    }
+  }
+
+  free(Nodes);
+
+  *NumProcs = MaxProc + 1U;
+  return ProcNodes;
+}
+#else
+unsigned int *ScNumaGetProcNodes(
+  size_t *NumProcs
+  )
+{
+  assert(NumProcs != NULL);
+  //
+  // Without sysfs, the nodes of the processors are unknown.
+  //
+  (void) NumProcs;
+  return NULL;
+}
+#endif
+
+unsigned int *ScNumaCreatePlaceDomains(
+  unsigned int *NumDomains
+  )
+{
+  assert(NumDomains != NULL);
+
+  *NumDomains = 1;
+#ifdef _OPENMP
+  const int NumPlaces = omp_get_num_places();
+  if (omp_get_proc_bind() == omp_proc_bind_false || NumPlaces < 2) {
+    return NULL;
+  }
+
+  unsigned int *PlaceDomains = malloc(
+                                 (size_t) NumPlaces * sizeof(*PlaceDomains)
+                                 );
+  if (PlaceDomains == NULL) {
+    return NULL;
+  }
+
+  size_t       NumProcs   = 0;
+  unsigned int NumGrouped = 0;
+  unsigned int *ProcNodes = ScNumaGetProcNodes(&NumProcs);
+  int          *ProcIds   = NULL;
+  if (ProcNodes != NULL) {
+    ProcIds = malloc(NumProcs * sizeof(*ProcIds));
+  }
+
+  unsigned int *DomainNodes = malloc(
+                                (size_t) NumPlaces * sizeof(*DomainNodes)
+                                );
+  bool Grouped = ProcIds != NULL && DomainNodes != NULL;
+  for (int Place = 0; Grouped && Place < NumPlaces; ++Place) {
+    const int NumPlaceProcs = omp_get_place_num_procs(Place);
+    if (NumPlaceProcs < 1 || (size_t) NumPlaceProcs > NumProcs) {
+      Grouped = false;
+      break;
+    }
+    //
+    // Places are expected to not span nodes, hence the node of their first
+    // processor is theirs.
+    //
+    omp_get_place_proc_ids(Place, ProcIds);
+    if (ProcIds[0] < 0
+     || (size_t) ProcIds[0] >= NumProcs
+     || ProcNodes[ProcIds[0]] == UINT_MAX) {
+      Grouped = false;
+      break;
+    }
+
+    const unsigned int Node   = ProcNodes[ProcIds[0]];
+    unsigned int       Domain = 0;
+    while (Domain < NumGrouped && DomainNodes[Domain] != Node) {
+      ++Domain;
+    }
+
+    if (Domain == NumGrouped) {
+      DomainNodes[Domain] = Node;
+      ++NumGrouped;
+    }
+
+    PlaceDomains[Place] = Domain;
+  }
+
+  if (Grouped) {
+    *NumDomains = NumGrouped;
+  }
+
+  free(DomainNodes);
+  free(ProcIds);
+  free(ProcNodes);
+  //
+  // Without the nodes of the processors, only trust places that are domains.
+  //
+  if (!Grouped) {
+    const char *Places = getenv("OMP_PLACES");
+    *NumDomains = 1;
+    if (Places != NULL
+     && (strncmp(Places, "sockets", 7) == 0
+      || strncmp(Places, "numa_domains", 12) == 0)) {
+      for (int Place = 0; Place < NumPlaces; ++Place) {
+        PlaceDomains[Place] = (unsigned int) Place;
+      }
+
+      *NumDomains = (unsigned int) NumPlaces;
+    }
+  }
+
+  if (*NumDomains > 1) {
+    return PlaceDomains;
+  }
+
+  free(PlaceDomains);
+  *NumDomains = 1;
+#endif
+  return NULL;
+}
+
+unsigned int ScNumaGetThreadDomain(
+  const unsigned int *PlaceDomains
+  )
+{
+#ifdef _OPENMP
+  const int Place = omp_get_place_num();
+  if (PlaceDomains != NULL && Place >= 0) {
+    return PlaceDomains[Place];
+  }
+#else
+  (void) PlaceDomains;
+#endif
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*@file
+  Provides functions to write the ratings of file pairings in the text and
+  binary output formats.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ScOutput.h>
+#include <ScSafeInt.h>
+
+bool ScOutputWriteHeader(
+  FILE               *Stream,
+  sc_output_format_t Format,
+  unsigned int       NumFiles,
+  unsigned int       NumRowFiles
+  )
+{
+  assert(Stream != NULL);
+  assert(Format != ScOutputFormatText);
+
+  sc_output_header_t Header = {
+    { 'S', 'C', 'R', Format == ScOutputFormatMatrix ? 'M' : 'R' },
+    SC_OUTPUT_VERSION,
+    NumFiles,
+    NumRowFiles
+  };
+  return fwrite(&Header, sizeof(Header), 1, Stream) == 1;
+}
+
+void ScOutputWriteRating(
+  FILE               *Stream,
+  sc_output_format_t Format,
+  unsigned int       File1Index,
+  unsigned int       File2Index,
+  double             Score
+  )
+{
+  assert(Stream != NULL);
+  assert(Format != ScOutputFormatMatrix);
+
+  if (Format == ScOutputFormatText) {
+    fprintf(Stream, "%u %u %f\n", File1Index, File2Index, Score);
+    return;
+  }
+
+  const sc_output_record_t Record = { File1Index, File2Index, (float) Score };
+  fwrite(&Record, sizeof(Record), 1, Stream);
+}
+
+bool ScOutputWriteMatrix(
+  FILE               *Stream,
+  const unsigned int *FileIndices,
+  unsigned int       NumFiles,
+  unsigned int       NumRowFiles,
+  const double       *Ratings
+  )
+{
+  assert(Stream != NULL);
+  assert(FileIndices != NULL || NumFiles == 0);
+  assert(NumRowFiles <= NumFiles);
+  assert(Ratings != NULL || NumRowFiles == 0);
+  //
+  // Convert one row at a time, so that it is written by a single call.
+  //
+  float    *Row     = malloc(SC_MAX(NumFiles, 1U) * sizeof(*Row));
+  uint32_t *Indices = (uint32_t *) Row;
+  if (Row == NULL) {
+    return false;
+  }
+
+  _Static_assert(
+    sizeof(*Indices) == sizeof(*Row),
+    "The row buffer cannot hold the file indices."
+    );
+
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    Indices[FileIndex] = FileIndices[FileIndex];
+  }
+
+  bool Result = ScOutputWriteHeader(
+                  Stream,
+                  ScOutputFormatMatrix,
+                  NumFiles,
+                  NumRowFiles
+                  );
+  Result = Result
+        && fwrite(Indices, sizeof(*Indices), NumFiles, Stream) == NumFiles;
+
+  size_t DistIndex = 0;
+  for (
+    unsigned int File1Index = 0;
+    Result && File1Index < NumRowFiles;
+    ++File1Index
+    ) {
+    const unsigned int NumColumns = NumFiles - File1Index - 1U;
+    for (unsigned int Column = 0; Column < NumColumns; ++Column) {
+      Row[Column] = (float) Ratings[DistIndex];
+      ++DistIndex;
+    }
+
+    Result = fwrite(Row, sizeof(*Row), NumColumns, Stream) == NumColumns;
+  }
+
+  free(Row);
+  return Result;
+}
+
+bool ScOutputFinish(
+  FILE *Stream
+  )
+{
+  assert(Stream != NULL);
+
+  return fflush(Stream) == 0 && !ferror(Stream);
+}
@@ -0,0 +1,362 @@
+/*@file
+  Provides functions to split the file pairings of a rating matrix into tiles
+  of balanced cost and to schedule them onto NUMA domains.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ScPairTiles.h>
+#include <ScSafeInt.h>
+
+///
+/// The preferred number of files per side of a rating matrix tile.
+///
+#define SC_PAIR_TILE_SIZE  16U
+
+///
+/// The maximum number of tile rows of the rating matrix.
+///
+#define SC_MAX_PAIR_TILE_ROWS  1024U
+
+/*
+  Estimates the cost of rating the pairing of File1 and File2.
+
+  ScLevenshteinSwap() compares every line of the file with fewer lines to a
+  bounded window of lines of the other file. Hence, the cost is proportional to
+  the number of lines of the former times the average line length of the
+  latter.
+*/
+static uint64_t ScEstimatePairingCost(
+  const sc_tile_file_t *File1,
+  const sc_tile_file_t *File2
+  )
+{
+  assert(File1 != NULL);
+  assert(File2 != NULL);
+
+  if (File1->NumLines > File2->NumLines) {
+    const sc_tile_file_t *const FileTmp = File1;
+    File1 = File2;
+    File2 = FileTmp;
+  }
+
+  const uint64_t NumLines2 = SC_MAX(File2->NumLines, 1U);
+  //
+  // Account for the per-line overhead to not estimate empty lines as free.
+  //
+  return (uint64_t) File1->NumLines * (File2->Length / NumLines2 + 1U);
+}
+
+/*
+  qsort() comparison function to order tiles from most to least expensive.
+*/
+static int ScComparePairTiles(
+  const void *Tile1,
+  const void *Tile2
+  )
+{
+  const sc_pair_tile_t *PairTile1 = Tile1;
+  const sc_pair_tile_t *PairTile2 = Tile2;
+
+  if (PairTile1->Cost != PairTile2->Cost) {
+    return PairTile1->Cost > PairTile2->Cost ? -1 : 1;
+  }
+  //
+  // Keep the order deterministic among tiles of equal cost.
+  //
+  if (PairTile1->RowStart != PairTile2->RowStart) {
+    return PairTile1->RowStart < PairTile2->RowStart ? -1 : 1;
+  }
+
+  if (PairTile1->ColumnStart != PairTile2->ColumnStart) {
+    return PairTile1->ColumnStart < PairTile2->ColumnStart ? -1 : 1;
+  }
+
+  return 0;
+}
+
+/*
+  qsort() comparison function to order tiles by their domains and each domain
+  from most to least expensive.
+*/
+static int ScCompareDomainTiles(
+  const void *Tile1,
+  const void *Tile2
+  )
+{
+  const sc_pair_tile_t *PairTile1 = Tile1;
+  const sc_pair_tile_t *PairTile2 = Tile2;
+
+  if (PairTile1->Domain != PairTile2->Domain) {
+    return PairTile1->Domain < PairTile2->Domain ? -1 : 1;
+  }
+
+  return ScComparePairTiles(Tile1, Tile2);
+}
+
+/*
+  Counts the tiles of TileSize files per side that cover the pairings of the
+  files with indices in [RowStart, RowEnd) with the larger files with indices
+  in [ColumnStart, ColumnEnd).
+*/
+static size_t ScCountPairTiles(
+  unsigned int TileSize,
+  unsigned int RowStart,
+  unsigned int RowEnd,
+  unsigned int ColumnStart,
+  unsigned int ColumnEnd
+  )
+{
+  assert(TileSize > 0);
+
+  const size_t NumTileColumns = ((size_t) ColumnEnd - ColumnStart
+                                   + TileSize - 1U) / TileSize;
+  size_t       Count          = 0;
+  for (
+    unsigned int TileRowStart = RowStart;
+    TileRowStart < RowEnd;
+    TileRowStart += TileSize
+    ) {
+    //
+    // Only tiles with any column larger than the first row hold pairings.
+    //
+    if (ColumnEnd <= TileRowStart + 1U) {
+      break;
+    }
+
+    size_t FirstColumn = 0;
+    if (TileRowStart + 1U >= ColumnStart) {
+      FirstColumn = (TileRowStart + 1U - ColumnStart) / TileSize;
+    }
+
+    Count += NumTileColumns - FirstColumn;
+  }
+
+  return Count;
+}
+
+sc_pair_tile_t *ScPairTilesCreate(
+  const sc_tile_file_t *Files,
+  unsigned int         RowStart,
+  unsigned int         RowEnd,
+  unsigned int         ColumnStart,
+  unsigned int         ColumnEnd,
+  size_t               MinNumTiles,
+  size_t               *NumTiles,
+  unsigned int         *TileSize
+  )
+{
+  assert(Files != NULL || ColumnEnd == 0);
+  assert(RowStart <= RowEnd && ColumnStart <= ColumnEnd);
+  assert(ColumnStart <= RowStart || ColumnStart >= RowEnd);
+  assert(NumTiles != NULL);
+  assert(TileSize != NULL);
+  //
+  // Tiles keep the profiles of few files hot in the caches. Shrink them for
+  // small inputs to have enough tiles to balance the load, and grow them for
+  // huge inputs to bound the size of the tile list.
+  //
+  unsigned int Size = SC_PAIR_TILE_SIZE;
+  while (Size > 1U) {
+    const size_t Count = ScCountPairTiles(
+                           Size,
+                           RowStart,
+                           RowEnd,
+                           ColumnStart,
+                           ColumnEnd
+                           );
+    if (Count >= MinNumTiles) {
+      break;
+    }
+
+    Size /= 2U;
+  }
+
+  const unsigned int NumColumns = ColumnEnd - ColumnStart;
+  if (NumColumns / Size > SC_MAX_PAIR_TILE_ROWS) {
+    Size = (NumColumns + SC_MAX_PAIR_TILE_ROWS - 1U) / SC_MAX_PAIR_TILE_ROWS;
+  }
+
+  const size_t Count = ScCountPairTiles(
+                         Size,
+                         RowStart,
+                         RowEnd,
+                         ColumnStart,
+                         ColumnEnd
+                         );
+
+  sc_pair_tile_t *Tiles = malloc(SC_MAX(Count, 1U) * sizeof(*Tiles));
+  if (Tiles == NULL) {
+    return NULL;
+  }
+
+  size_t TileIndex = 0;
+  for (
+    unsigned int TileRowStart = RowStart;
+    TileRowStart < RowEnd && ColumnEnd > TileRowStart + 1U;
+    TileRowStart += Size
+    ) {
+    unsigned int TileColumnStart = ColumnStart;
+    if (TileRowStart + 1U >= ColumnStart) {
+      TileColumnStart += (TileRowStart + 1U - ColumnStart) / Size * Size;
+    }
+
+    for (; TileColumnStart < ColumnEnd; TileColumnStart += Size) {
+      const unsigned int TileRowEnd    = SC_MIN(TileRowStart + Size, RowEnd);
+      const unsigned int TileColumnEnd = SC_MIN(
+                                           TileColumnStart + Size,
+                                           ColumnEnd
+                                           );
+
+      uint64_t Cost = 0;
+      for (
+        unsigned int File1Index = TileRowStart;
+        File1Index < TileRowEnd;
+        ++File1Index
+        ) {
+        for (
+          unsigned int File2Index = SC_MAX(TileColumnStart, File1Index + 1U);
+          File2Index < TileColumnEnd;
+          ++File2Index
+          ) {
+          Cost += ScEstimatePairingCost(&Files[File1Index], &Files[File2Index]);
+        }
+      }
+
+      Tiles[TileIndex].Cost        = Cost;
+      Tiles[TileIndex].RowStart    = TileRowStart;
+      Tiles[TileIndex].RowEnd      = TileRowEnd;
+      Tiles[TileIndex].ColumnStart = TileColumnStart;
+      Tiles[TileIndex].ColumnEnd   = TileColumnEnd;
+      Tiles[TileIndex].Domain      = 0;
+      ++TileIndex;
+    }
+  }
+
+  assert(TileIndex == Count);
+  //
+  // Scheduling the most expensive tiles first keeps threads from idling on a
+  // single expensive tile at the end.
+  //
+  qsort(Tiles, Count, sizeof(*Tiles), ScComparePairTiles);
+
+  *NumTiles = Count;
+  *TileSize = Size;
+  return Tiles;
+}
+
+void ScPairTilesAssignDomains(
+  sc_pair_tile_t     *Tiles,
+  size_t             NumTiles,
+  const unsigned int *FileDomains,
+  unsigned int       NumDomains
+  )
+{
+  assert(Tiles != NULL || NumTiles == 0);
+  assert(FileDomains != NULL);
+  assert(NumDomains > 0);
+  //
+  // If the counters cannot be allocated, all tiles stay in the first domain,
+  // which is equivalent to a single shared queue.
+  //
+  size_t *Counts = malloc(NumDomains * sizeof(*Counts));
+  if (Counts == NULL) {
+    return;
+  }
+
+  for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+    sc_pair_tile_t *Tile = &Tiles[TileIndex];
+    memset(Counts, 0, NumDomains * sizeof(*Counts));
+    for (unsigned int Index = Tile->RowStart; Index < Tile->RowEnd; ++Index) {
+      ++Counts[FileDomains[Index] % NumDomains];
+    }
+
+    for (
+      unsigned int Index = Tile->ColumnStart;
+      Index < Tile->ColumnEnd;
+      ++Index
+      ) {
+      ++Counts[FileDomains[Index] % NumDomains];
+    }
+
+    Tile->Domain = 0;
+    for (unsigned int Domain = 1; Domain < NumDomains; ++Domain) {
+      if (Counts[Domain] > Counts[Tile->Domain]) {
+        Tile->Domain = Domain;
+      }
+    }
+  }
+
+  free(Counts);
+
+  qsort(Tiles, NumTiles, sizeof(*Tiles), ScCompareDomainTiles);
+}
+
+sc_domain_queue_t *ScPairTilesCreateQueues(
+  const sc_pair_tile_t *Tiles,
+  size_t               NumTiles,
+  unsigned int         NumDomains
+  )
+{
+  assert(Tiles != NULL || NumTiles == 0);
+  assert(NumDomains > 0);
+
+  sc_domain_queue_t *Queues = malloc(NumDomains * sizeof(*Queues));
+  if (Queues == NULL) {
+    return NULL;
+  }
+
+  size_t TileIndex = 0;
+  for (unsigned int Domain = 0; Domain < NumDomains; ++Domain) {
+    Queues[Domain].Next = TileIndex;
+    while (TileIndex < NumTiles && Tiles[TileIndex].Domain == Domain) {
+      ++TileIndex;
+    }
+
+    Queues[Domain].End = TileIndex;
+  }
+
+  assert(TileIndex == NumTiles);
+  return Queues;
+}
+
+bool ScPairTilesDequeue(
+  sc_domain_queue_t *Queues,
+  unsigned int      NumDomains,
+  unsigned int      Home,
+  unsigned int      *Step,
+  size_t            *TileIndex
+  )
+{
+  assert(Queues != NULL);
+  assert(NumDomains > 0);
+  assert(Step != NULL);
+  assert(TileIndex != NULL);
+  //
+  // Every thread rates the tiles of its own domain first, so that it mostly
+  // reads local file data, and then helps the other domains with their
+  // remaining tiles.
+  //
+  for (; *Step < NumDomains; ++(*Step)) {
+    sc_domain_queue_t *Queue = &Queues[(Home + *Step) % NumDomains];
+
+    size_t Next;
+    #pragma omp atomic capture
+    Next = Queue->Next++;
+
+    if (Next < Queue->End) {
+      *TileIndex = Next;
+      return true;
+    }
+  }
+
+  return false;
+}
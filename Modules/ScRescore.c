@@ -0,0 +1,100 @@
+/*@file
+  Provides functions to select the file pairings to rate again.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <ScRescore.h>
+#include <ScSafeInt.h>
+
+/*
+  Compares two ratings for sorting them in descending order.
+*/
+static int ScCompareRatingsDescending(
+  const void *Rating1,
+  const void *Rating2
+  )
+{
+  const double Value1 = *(const double *) Rating1;
+  const double Value2 = *(const double *) Rating2;
+  return (Value1 < Value2) - (Value1 > Value2);
+}
+
+size_t ScGetNumRatedPairings(
+  unsigned int NumFiles,
+  unsigned int NumRowFiles
+  )
+{
+  assert(NumRowFiles <= NumFiles);
+
+  //
+  // Query file i is paired with the NumFiles - 1 - i files that follow it.
+  // The sum over all query files equals
+  // SC_GAUSS_SUM(NumFiles - 1) - SC_GAUSS_SUM(NumFiles - 1 - NumRowFiles).
+  //
+  if (NumRowFiles == 0) {
+    return 0;
+  }
+
+  return ((size_t) NumRowFiles * (2U * (size_t) NumFiles - NumRowFiles - 1U))
+           / 2U;
+}
+
+bool ScGetRescoreCutoff(
+  const double *Ratings,
+  unsigned int NumFiles,
+  unsigned int NumRowFiles,
+  double       Fraction,
+  double       *Cutoff
+  )
+{
+  assert(NumRowFiles <= NumFiles);
+  assert(Fraction >= 0 && Fraction <= 1);
+  assert(Cutoff != NULL);
+
+  const size_t NumRatings = ScGetNumRatedPairings(NumFiles, NumRowFiles);
+  assert(Ratings != NULL || NumRatings == 0);
+  //
+  // Only consider pairings that have been rated successfully.
+  //
+  double *Scores = malloc(SC_MAX(NumRatings, 1U) * sizeof(*Scores));
+  if (Scores == NULL) {
+    return false;
+  }
+
+  size_t NumScores = 0;
+  for (size_t RatingIndex = 0; RatingIndex < NumRatings; ++RatingIndex) {
+    if (Ratings[RatingIndex] >= 0 && Ratings[RatingIndex] < (double) INFINITY) {
+      Scores[NumScores] = Ratings[RatingIndex];
+      ++NumScores;
+    }
+  }
+
+  //
+  // Round the number of selected pairings up.
+  //
+  const double Selected    = Fraction * (double) NumScores;
+  size_t       NumSelected = (size_t) Selected;
+  if ((double) NumSelected < Selected) {
+    ++NumSelected;
+  }
+
+  if (NumSelected == 0) {
+    *Cutoff = (double) INFINITY;
+    free(Scores);
+    return true;
+  }
+
+  qsort(Scores, NumScores, sizeof(*Scores), ScCompareRatingsDescending);
+  *Cutoff = Scores[SC_MIN(NumSelected, NumScores) - 1U];
+
+  free(Scores);
+  return true;
+}
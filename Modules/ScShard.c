@@ -0,0 +1,752 @@
+/*@file
+  Provides functions to split the file pairings into cost-balanced shards and
+  to merge the outputs of all shards.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ScOutput.h>
+#include <ScPairTiles.h>
+#include <ScSafeInt.h>
+#include <ScShard.h>
+#include <ScTopMatches.h>
+
+/*
+  qsort() comparison function to order shard ratings by their files, as in the
+  regular output.
+*/
+static int ScCompareShardRatingsByFiles(
+  const void *Rating1,
+  const void *Rating2
+  )
+{
+  const sc_shard_rating_t *ShardRating1 = Rating1;
+  const sc_shard_rating_t *ShardRating2 = Rating2;
+
+  if (ShardRating1->File1Index != ShardRating2->File1Index) {
+    return ShardRating1->File1Index < ShardRating2->File1Index ? -1 : 1;
+  }
+
+  const unsigned int File2Index1 = ShardRating1->Match.FileIndex;
+  const unsigned int File2Index2 = ShardRating2->Match.FileIndex;
+  return (File2Index1 > File2Index2) - (File2Index1 < File2Index2);
+}
+
+/*
+  qsort() comparison function to order shard ratings by their first file and
+  their matches from best to worst, as in top-K mode.
+*/
+static int ScCompareShardRatingsByMatches(
+  const void *Rating1,
+  const void *Rating2
+  )
+{
+  const sc_shard_rating_t *ShardRating1 = Rating1;
+  const sc_shard_rating_t *ShardRating2 = Rating2;
+
+  if (ShardRating1->File1Index != ShardRating2->File1Index) {
+    return ShardRating1->File1Index < ShardRating2->File1Index ? -1 : 1;
+  }
+
+  return ScCompareMatches(&ShardRating1->Match, &ShardRating2->Match);
+}
+
+bool ScShardReadRating(
+  sc_shard_stream_t *Stream
+  )
+{
+  assert(Stream != NULL);
+  assert(Stream->Handle != NULL);
+
+  sc_shard_rating_t Rating;
+  if (Stream->Records) {
+    sc_output_record_t Record;
+    const size_t       Size = fread(&Record, 1, sizeof(Record), Stream->Handle);
+    if (Size != sizeof(Record)) {
+      Stream->HasRating = false;
+      return Size == 0 && !ferror(Stream->Handle);
+    }
+
+    Rating.File1Index      = Record.File1Index;
+    Rating.Match.FileIndex = Record.File2Index;
+    Rating.Match.Score     = Record.Score;
+  } else {
+    //
+    // Text ratings are far shorter than the line buffer. Longer lines are
+    // split and hence rejected as invalid.
+    //
+    char Line[128];
+    do {
+      if (fgets(Line, sizeof(Line), Stream->Handle) == NULL) {
+        Stream->HasRating = false;
+        return !ferror(Stream->Handle);
+      }
+    } while (Line[strspn(Line, " \t\r\n")] == '\0');
+
+    char                *End;
+    const unsigned long File1 = strtoul(Line, &End, 10);
+    const char          *Pos   = End;
+    const unsigned long File2 = strtoul(Pos, &End, 10);
+    bool                Valid  = End != Line && End != Pos;
+    Pos = End;
+    Rating.Match.Score = strtod(Pos, &End);
+    Valid = Valid
+         && End != Pos
+         && (*End == '\n' || *End == '\r' || *End == '\0')
+         && File1 <= UINT32_MAX
+         && File2 <= UINT32_MAX;
+    if (!Valid) {
+      return false;
+    }
+
+    Rating.File1Index      = (unsigned int) File1;
+    Rating.Match.FileIndex = (unsigned int) File2;
+  }
+
+  Stream->Rating    = Rating;
+  Stream->HasRating = true;
+  return true;
+}
+
+bool ScShardOpenStream(
+  sc_shard_stream_t  *Stream,
+  FILE               *Handle,
+  bool               CountFiles,
+  sc_output_header_t *Header
+  )
+{
+  assert(Stream != NULL);
+  assert(Handle != NULL);
+  assert(Header != NULL);
+
+  Stream->Handle    = Handle;
+  Stream->HasRating = false;
+
+  sc_output_header_t ShardHeader;
+  const size_t       Size = fread(
+                              &ShardHeader,
+                              1,
+                              sizeof(ShardHeader),
+                              Stream->Handle
+                              );
+  Stream->Records = Size == sizeof(ShardHeader)
+                 && memcmp(ShardHeader.Magic, "SCRR", 4) == 0;
+  if (Stream->Records) {
+    if (ShardHeader.Version != SC_OUTPUT_VERSION) {
+      return false;
+    }
+
+    Header->NumFiles    = SC_MAX(Header->NumFiles, ShardHeader.NumFiles);
+    Header->NumRowFiles = SC_MAX(Header->NumRowFiles, ShardHeader.NumRowFiles);
+    return ScShardReadRating(Stream);
+  }
+
+  if (fseek(Stream->Handle, 0, SEEK_SET) != 0) {
+    return false;
+  }
+  //
+  // Text outputs do not state the file counts, hence derive them.
+  //
+  if (CountFiles) {
+    while (true) {
+      if (!ScShardReadRating(Stream)) {
+        return false;
+      }
+
+      if (!Stream->HasRating) {
+        break;
+      }
+
+      const sc_shard_rating_t *Rating       = &Stream->Rating;
+      const uint32_t          MaxFileIndex = SC_MAX(
+                                                Rating->File1Index,
+                                                Rating->Match.FileIndex
+                                                );
+      Header->NumFiles    = SC_MAX(Header->NumFiles, MaxFileIndex + 1U);
+      Header->NumRowFiles = SC_MAX(
+                              Header->NumRowFiles,
+                              Rating->File1Index + 1U
+                              );
+    }
+
+    if (fseek(Stream->Handle, 0, SEEK_SET) != 0) {
+      return false;
+    }
+  }
+
+  return ScShardReadRating(Stream);
+}
+
+/*
+  Returns whether the current rating of the shard output with index Index1
+  precedes that of the shard output with index Index2 in the merged output.
+  Ties are resolved in favour of the lower index to keep the output
+  deterministic.
+*/
+static bool ScShardStreamPrecedes(
+  const sc_shard_stream_t *Streams,
+  size_t                  Index1,
+  size_t                  Index2
+  )
+{
+  assert(Streams != NULL);
+  assert(Streams[Index1].HasRating && Streams[Index2].HasRating);
+
+  const int Order = ScCompareShardRatingsByFiles(
+                      &Streams[Index1].Rating,
+                      &Streams[Index2].Rating
+                      );
+  return Order < 0 || (Order == 0 && Index1 < Index2);
+}
+
+/*
+  Sifts the shard output at Index of the heap Heap down to restore the heap
+  order, with the output of the first rating at its root.
+
+  @param[in]     Streams  The shard outputs.
+  @param[in,out] Heap     The heap of the indices of outputs that have not
+                          ended yet.
+  @param[in]     NumHeap  The number of elements in Heap.
+  @param[in]     Index    The index within Heap of the output to sift down.
+*/
+static void ScShardHeapSiftDown(
+  const sc_shard_stream_t *Streams,
+  size_t                  *Heap,
+  size_t                  NumHeap,
+  size_t                  Index
+  )
+{
+  assert(Streams != NULL);
+  assert(Heap != NULL);
+  assert(Index < NumHeap);
+
+  const size_t StreamIndex = Heap[Index];
+  while (true) {
+    size_t Child = 2U * Index + 1U;
+    if (Child >= NumHeap) {
+      break;
+    }
+
+    if (Child + 1U < NumHeap
+     && ScShardStreamPrecedes(Streams, Heap[Child + 1U], Heap[Child])) {
+      ++Child;
+    }
+
+    if (!ScShardStreamPrecedes(Streams, Heap[Child], StreamIndex)) {
+      break;
+    }
+
+    Heap[Index] = Heap[Child];
+    Index       = Child;
+  }
+
+  Heap[Index] = StreamIndex;
+}
+
+/*
+  Merges the shard outputs, which are ordered by their files, into a single
+  output as streams.
+
+  @param[in,out] Output       The stream to write the merged output to.
+  @param[in]     Format       The text or record format.
+  @param[in,out] Streams      The opened shard outputs.
+  @param[in]     NumOutputs   The number of elements in Streams.
+  @param[out]    FailedIndex  On read errors and for unordered outputs, the
+                              index of the shard output.
+
+  @returns  The result of merging.
+*/
+static sc_shard_status_t ScShardMergeStreams(
+  FILE               *Output,
+  sc_output_format_t Format,
+  sc_shard_stream_t  *Streams,
+  size_t             NumOutputs,
+  size_t             *FailedIndex
+  )
+{
+  assert(Output != NULL);
+  assert(Streams != NULL || NumOutputs == 0);
+  assert(FailedIndex != NULL);
+
+  size_t *Heap = malloc(SC_MAX(NumOutputs, 1U) * sizeof(*Heap));
+  if (Heap == NULL) {
+    return ScShardStatusAllocationError;
+  }
+
+  size_t NumHeap = 0;
+  for (size_t Index = 0; Index < NumOutputs; ++Index) {
+    if (Streams[Index].HasRating) {
+      Heap[NumHeap] = Index;
+      ++NumHeap;
+    }
+  }
+
+  for (size_t Index = NumHeap / 2U; Index > 0; --Index) {
+    ScShardHeapSiftDown(Streams, Heap, NumHeap, Index - 1U);
+  }
+  //
+  // Every output is ordered by its files, hence the next rating of the merged
+  // output is always the current rating of one of them.
+  //
+  sc_shard_status_t Status = ScShardStatusSuccess;
+  while (NumHeap > 0) {
+    sc_shard_stream_t       *Stream = &Streams[Heap[0]];
+    const sc_shard_rating_t Rating  = Stream->Rating;
+    ScOutputWriteRating(
+      Output,
+      Format,
+      Rating.File1Index,
+      Rating.Match.FileIndex,
+      Rating.Match.Score
+      );
+
+    if (!ScShardReadRating(Stream)) {
+      *FailedIndex = Heap[0];
+      Status       = ScShardStatusReadError;
+      break;
+    }
+
+    if (!Stream->HasRating) {
+      --NumHeap;
+      Heap[0] = Heap[NumHeap];
+    } else if (ScCompareShardRatingsByFiles(&Stream->Rating, &Rating) <= 0) {
+      //
+      // Shard outputs of top-K mode are only merged with --top.
+      //
+      *FailedIndex = Heap[0];
+      Status       = ScShardStatusUnordered;
+      break;
+    }
+
+    if (NumHeap > 0) {
+      ScShardHeapSiftDown(Streams, Heap, NumHeap, 0);
+    }
+  }
+
+  free(Heap);
+  return Status;
+}
+
+/*
+  Merges the match lists of the shard outputs of top-K mode into the best
+  matches of every file across all shards. The match lists are not ordered by
+  their files, hence all ratings are read first.
+
+  @param[in,out] Output       The stream to write the merged output to.
+  @param[in]     Format       The text or record format.
+  @param[in]     MaxMatches   The number of matches to output per file.
+  @param[in,out] Streams      The opened shard outputs.
+  @param[in]     NumOutputs   The number of elements in Streams.
+  @param[out]    FailedIndex  On read errors, the index of the shard output.
+
+  @returns  The result of merging.
+*/
+static sc_shard_status_t ScShardMergeMatches(
+  FILE               *Output,
+  sc_output_format_t Format,
+  unsigned int       MaxMatches,
+  sc_shard_stream_t  *Streams,
+  size_t             NumOutputs,
+  size_t             *FailedIndex
+  )
+{
+  assert(Output != NULL);
+  assert(MaxMatches > 0);
+  assert(Streams != NULL || NumOutputs == 0);
+  assert(FailedIndex != NULL);
+
+  sc_shard_rating_t *Ratings   = NULL;
+  size_t            NumRatings = 0;
+  size_t            MaxRatings = 0;
+  for (size_t Index = 0; Index < NumOutputs; ++Index) {
+    sc_shard_stream_t *Stream = &Streams[Index];
+    while (Stream->HasRating) {
+      if (NumRatings == MaxRatings) {
+        size_t MaxNumRatings = SC_MAX(MaxRatings * 2U, 1024U);
+        size_t AllocSize;
+        bool   Overflow      = ScSafeMulSize(
+                                 MaxNumRatings,
+                                 sizeof(*Ratings),
+                                 &AllocSize
+                                 );
+        sc_shard_rating_t *NewRatings = NULL;
+        if (!Overflow) {
+          NewRatings = realloc(Ratings, AllocSize);
+        }
+
+        if (NewRatings == NULL) {
+          free(Ratings);
+          return ScShardStatusAllocationError;
+        }
+
+        Ratings    = NewRatings;
+        MaxRatings = MaxNumRatings;
+      }
+
+      Ratings[NumRatings] = Stream->Rating;
+      ++NumRatings;
+
+      if (!ScShardReadRating(Stream)) {
+        free(Ratings);
+        *FailedIndex = Index;
+        return ScShardStatusReadError;
+      }
+    }
+  }
+
+  qsort(Ratings, NumRatings, sizeof(*Ratings), ScCompareShardRatingsByMatches);
+  //
+  // Every shard has output the best matches of every file among its own
+  // pairings, which contain the best matches among all pairings.
+  //
+  unsigned int NumFileMatches = 0;
+  for (size_t Index = 0; Index < NumRatings; ++Index) {
+    if (Index == 0
+     || Ratings[Index].File1Index != Ratings[Index - 1U].File1Index) {
+      NumFileMatches = 0;
+    }
+
+    ++NumFileMatches;
+    if (NumFileMatches > MaxMatches) {
+      continue;
+    }
+
+    ScOutputWriteRating(
+      Output,
+      Format,
+      Ratings[Index].File1Index,
+      Ratings[Index].Match.FileIndex,
+      Ratings[Index].Match.Score
+      );
+  }
+
+  free(Ratings);
+  return ScShardStatusSuccess;
+}
+
+sc_shard_status_t ScShardMergeOutputs(
+  FILE               *Output,
+  sc_output_format_t Format,
+  unsigned int       MaxMatches,
+  FILE *const        *Inputs,
+  size_t             NumInputs,
+  size_t             *FailedIndex
+  )
+{
+  assert(Output != NULL);
+  assert(Format != ScOutputFormatMatrix);
+  assert(Inputs != NULL || NumInputs == 0);
+  assert(FailedIndex != NULL);
+
+  sc_shard_stream_t *Streams = calloc(SC_MAX(NumInputs, 1U), sizeof(*Streams));
+  if (Streams == NULL) {
+    return ScShardStatusAllocationError;
+  }
+  //
+  // The record format states the file counts before all records.
+  //
+  const bool         Records = Format == ScOutputFormatRecords;
+  sc_output_header_t Header  = { { 0 }, 0, 0, 0 };
+  sc_shard_status_t  Status  = ScShardStatusSuccess;
+  for (size_t Index = 0; Index < NumInputs; ++Index) {
+    if (!ScShardOpenStream(&Streams[Index], Inputs[Index], Records, &Header)) {
+      *FailedIndex = Index;
+      Status       = ScShardStatusReadError;
+      break;
+    }
+  }
+
+  if (Status == ScShardStatusSuccess && Records) {
+    if (!ScOutputWriteHeader(
+           Output,
+           Format,
+           Header.NumFiles,
+           Header.NumRowFiles
+           )) {
+      Status = ScShardStatusOutputError;
+    }
+  }
+
+  if (Status == ScShardStatusSuccess) {
+    if (MaxMatches > 0) {
+      Status = ScShardMergeMatches(
+                 Output,
+                 Format,
+                 MaxMatches,
+                 Streams,
+                 NumInputs,
+                 FailedIndex
+                 );
+    } else {
+      Status = ScShardMergeStreams(
+                 Output,
+                 Format,
+                 Streams,
+                 NumInputs,
+                 FailedIndex
+                 );
+    }
+  }
+
+  free(Streams);
+
+  if (Status == ScShardStatusSuccess && !ScOutputFinish(Output)) {
+    Status = ScShardStatusOutputError;
+  }
+
+  return Status;
+}
+
+bool ScShardSelectTiles(
+  sc_pair_tile_t *Tiles,
+  size_t         NumTiles,
+  unsigned int   ShardIndex,
+  unsigned int   NumShards,
+  size_t         *NumKept
+  )
+{
+  assert(Tiles != NULL || NumTiles == 0);
+  assert(ShardIndex < NumShards);
+  assert(NumKept != NULL);
+
+  uint64_t *Costs = calloc(NumShards, sizeof(*Costs));
+  if (Costs == NULL) {
+    return false;
+  }
+  //
+  // Assign every tile to the shard with the least cost so far, the lowest
+  // index first among equals, which is within 4/3 of the optimal balance.
+  //
+  size_t Kept = 0;
+  for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+    unsigned int Shard = 0;
+    for (unsigned int Index = 1; Index < NumShards; ++Index) {
+      if (Costs[Index] < Costs[Shard]) {
+        Shard = Index;
+      }
+    }
+    //
+    // Account for the per-tile overhead to also distribute empty tiles.
+    //
+    Costs[Shard] += Tiles[TileIndex].Cost + 1U;
+    if (Shard == ShardIndex) {
+      Tiles[Kept] = Tiles[TileIndex];
+      ++Kept;
+    }
+  }
+
+  free(Costs);
+
+  *NumKept = Kept;
+  return true;
+}
+
+bool ScShardRatingsCreate(
+  sc_shard_ratings_t   *ShardRatings,
+  const sc_pair_tile_t *Tiles,
+  size_t               NumTiles,
+  unsigned int         TileSize,
+  unsigned int         NumFiles,
+  unsigned int         NumRowFiles
+  )
+{
+  assert(ShardRatings != NULL);
+  assert(Tiles != NULL || NumTiles == 0);
+  assert(TileSize > 0);
+  assert(NumRowFiles <= NumFiles);
+
+  const unsigned int NumRows    = NumRowFiles / TileSize
+                                    + (NumRowFiles % TileSize != 0);
+  const unsigned int NumColumns = NumFiles / TileSize
+                                    + (NumFiles % TileSize != 0);
+  size_t             NumCells;
+  size_t             OffsetsSize;
+  bool               Overflow   = ScSafeMulSize(
+                                    NumRows,
+                                    NumColumns,
+                                    &NumCells
+                                    );
+  Overflow |= ScSafeMulSize(
+                SC_MAX(NumCells, 1U),
+                sizeof(*ShardRatings->Offsets),
+                &OffsetsSize
+                );
+  if (Overflow) {
+    return false;
+  }
+
+  size_t *Offsets = malloc(OffsetsSize);
+  if (Offsets == NULL) {
+    return false;
+  }
+
+  for (size_t Cell = 0; Cell < NumCells; ++Cell) {
+    Offsets[Cell] = SIZE_MAX;
+  }
+  //
+  // The tiles only cover the pairings of the upper triangle, but are stored
+  // as whole rectangles to index them cheaply.
+  //
+  size_t NumRatings = 0;
+  for (size_t TileIndex = 0; TileIndex < NumTiles; ++TileIndex) {
+    const sc_pair_tile_t *Tile = &Tiles[TileIndex];
+    assert(Tile->RowStart % TileSize == 0);
+    assert(Tile->ColumnStart % TileSize == 0);
+
+    const size_t Cell = (size_t) (Tile->RowStart / TileSize) * NumColumns
+                          + Tile->ColumnStart / TileSize;
+    assert(Cell < NumCells);
+    Offsets[Cell] = NumRatings;
+
+    size_t TileRatings;
+    Overflow  = ScSafeMulSize(
+                  Tile->RowEnd - Tile->RowStart,
+                  Tile->ColumnEnd - Tile->ColumnStart,
+                  &TileRatings
+                  );
+    Overflow |= ScSafeAddSize(NumRatings, TileRatings, &NumRatings);
+    if (Overflow) {
+      free(Offsets);
+      return false;
+    }
+  }
+
+  size_t RatingsSize;
+  if (ScSafeMulSize(SC_MAX(NumRatings, 1U), sizeof(double), &RatingsSize)) {
+    free(Offsets);
+    return false;
+  }
+
+  double *Ratings = malloc(RatingsSize);
+  if (Ratings == NULL) {
+    free(Offsets);
+    return false;
+  }
+
+  ShardRatings->Ratings     = Ratings;
+  ShardRatings->Offsets     = Offsets;
+  ShardRatings->TileSize    = TileSize;
+  ShardRatings->NumRows     = NumRows;
+  ShardRatings->NumColumns  = NumColumns;
+  ShardRatings->NumFiles    = NumFiles;
+  ShardRatings->NumRowFiles = NumRowFiles;
+  return true;
+}
+
+void ScShardRatingsFree(
+  sc_shard_ratings_t *ShardRatings
+  )
+{
+  assert(ShardRatings != NULL);
+
+  free(ShardRatings->Ratings);
+  free(ShardRatings->Offsets);
+  ShardRatings->Ratings = NULL;
+  ShardRatings->Offsets = NULL;
+}
+
+size_t ScShardRatingsGetIndex(
+  const sc_shard_ratings_t *ShardRatings,
+  unsigned int             File1Index,
+  unsigned int             File2Index
+  )
+{
+  assert(ShardRatings != NULL);
+  assert(
+    File1Index < File2Index
+ && File1Index < ShardRatings->NumRowFiles
+ && File2Index < ShardRatings->NumFiles
+    );
+
+  const unsigned int TileSize = ShardRatings->TileSize;
+  const unsigned int Row      = File1Index / TileSize;
+  const unsigned int Column   = File2Index / TileSize;
+  const size_t       Offset   = ShardRatings->Offsets[
+                                  (size_t) Row * ShardRatings->NumColumns
+                                    + Column
+                                  ];
+  assert(Offset != SIZE_MAX);
+  //
+  // Only the cells of the last column are narrower.
+  //
+  const unsigned int ColumnStart = Column * TileSize;
+  const unsigned int Width       = SC_MIN(
+                                     TileSize,
+                                     ShardRatings->NumFiles - ColumnStart
+                                     );
+  return Offset
+           + (size_t) (File1Index - Row * TileSize) * Width
+           + (File2Index - ColumnStart);
+}
+
+void ScShardRatingsWrite(
+  const sc_shard_ratings_t *ShardRatings,
+  FILE                     *Stream,
+  sc_output_format_t       Format,
+  const unsigned int       *FileIndices
+  )
+{
+  assert(ShardRatings != NULL);
+  assert(Stream != NULL);
+  assert(Format != ScOutputFormatMatrix);
+  assert(FileIndices != NULL || ShardRatings->NumFiles == 0);
+
+  const unsigned int TileSize = ShardRatings->TileSize;
+  for (
+    unsigned int File1Index = 0;
+    File1Index < ShardRatings->NumRowFiles;
+    ++File1Index
+    ) {
+    const size_t *RowOffsets = &ShardRatings->Offsets[
+                                 (size_t) (File1Index / TileSize)
+                                   * ShardRatings->NumColumns
+                                 ];
+    for (
+      unsigned int Column = (File1Index + 1U) / TileSize;
+      Column < ShardRatings->NumColumns;
+      ++Column
+      ) {
+      if (RowOffsets[Column] == SIZE_MAX) {
+        continue;
+      }
+
+      const unsigned int ColumnStart = Column * TileSize;
+      const unsigned int ColumnEnd   = ColumnStart + SC_MIN(
+                                         TileSize,
+                                         ShardRatings->NumFiles - ColumnStart
+                                         );
+      for (
+        unsigned int File2Index = SC_MAX(ColumnStart, File1Index + 1U);
+        File2Index < ColumnEnd;
+        ++File2Index
+        ) {
+        const double Score = ShardRatings->Ratings[
+                               ScShardRatingsGetIndex(
+                                 ShardRatings,
+                                 File1Index,
+                                 File2Index
+                                 )
+                               ];
+        if (!isnan(Score)) {
+          ScOutputWriteRating(
+            Stream,
+            Format,
+            FileIndices[File1Index],
+            FileIndices[File2Index],
+            Score
+            );
+        }
+      }
+    }
+  }
+}
@@ -13,6 +13,21 @@
 #include <ScSafeInt.h>
 #include <ScStringMisc.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #include <immintrin.h>
+
+  #define SC_STR_SCAN_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #include <arm_neon.h>
+
+  #define SC_STR_SCAN_NEON
+#endif
+
+///
+/// The typical line length to estimate the number of lines of a string with.
+///
+#define SC_STR_LINE_LENGTH_ESTIMATE  32U
+
 int ScStrnPrefix(
   const char *String,
   const char *Prefix,
@@ -26,27 +41,341 @@ int ScStrnPrefix(
   if (PrefixLength > StringLength) {
     return 1;
   }
+  //
+  // Prefix may be NULL when empty, which strncmp() does not permit.
+  //
+  if (PrefixLength == 0) {
+    return 0;
+  }
 
   return strncmp(String, Prefix, PrefixLength);
 }
 
-sc_str_lines_info_t *ScStrGetLineInfo(
+void ScStrCharSetInitialise(
+  sc_str_char_set_t *Set,
+  const bool        Members[256]
+  )
+{
+  assert(Set != NULL);
+  assert(Members != NULL);
+
+  memcpy(Set->Members, Members, sizeof(Set->Members));
+  memset(Set->LowNibbles, 0, sizeof(Set->LowNibbles));
+  memset(Set->HighNibbles, 0, sizeof(Set->HighNibbles));
+  //
+  // Group the high nibbles by the set of low nibbles they form members with.
+  // Every group is assigned one bit, hence there may be at most 8 groups.
+  //
+  uint16_t GroupLows[8];
+  size_t   NumGroups = 0;
+  for (size_t High = 0; High < 16; ++High) {
+    uint16_t Lows = 0;
+    for (size_t Low = 0; Low < 16; ++Low) {
+      if (Members[(High << 4U) | Low]) {
+        Lows |= (uint16_t) (1U << Low);
+      }
+    }
+
+    if (Lows == 0) {
+      continue;
+    }
+
+    size_t Group;
+    for (Group = 0; Group < NumGroups; ++Group) {
+      if (GroupLows[Group] == Lows) {
+        break;
+      }
+    }
+
+    if (Group == NumGroups) {
+      if (NumGroups == SC_ARRAY_LEN(GroupLows)) {
+        Set->Nibbles = false;
+        return;
+      }
+
+      GroupLows[Group] = Lows;
+      ++NumGroups;
+    }
+
+    Set->HighNibbles[High] = (uint8_t) (1U << Group);
+    for (size_t Low = 0; Low < 16; ++Low) {
+      if ((Lows & (1U << Low)) != 0) {
+        Set->LowNibbles[Low] |= (uint8_t) (1U << Group);
+      }
+    }
+  }
+
+  Set->Nibbles = true;
+}
+
+/*
+  Scalar implementation of ScStrSpanNotInSet().
+*/
+static size_t ScStrSpanNotInSetScalar(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  )
+{
+  size_t CharIndex;
+  for (CharIndex = 0; CharIndex < StringLength; ++CharIndex) {
+    if (Set->Members[(unsigned char) String[CharIndex]]) {
+      break;
+    }
+  }
+
+  return CharIndex;
+}
+
+#ifdef SC_STR_SCAN_X86
+/*
+  AVX2 implementation of ScStrSpanNotInSet() for sets with nibble tables.
+*/
+__attribute__((target("avx2")))
+static size_t ScStrSpanNotInSetAvx2(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  )
+{
+  const __m256i LowTable = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *) Set->LowNibbles)
+    );
+  const __m256i HighTable = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *) Set->HighNibbles)
+    );
+  const __m256i NibbleMask = _mm256_set1_epi8(0x0F);
+  const __m256i Zero       = _mm256_setzero_si256();
+
+  size_t CharIndex = 0;
+  for (; StringLength - CharIndex >= 32; CharIndex += 32) {
+    const __m256i Chars = _mm256_loadu_si256(
+      (const __m256i *) &String[CharIndex]
+      );
+    const __m256i Lows  = _mm256_and_si256(Chars, NibbleMask);
+    const __m256i Highs = _mm256_and_si256(
+      _mm256_srli_epi16(Chars, 4),
+      NibbleMask
+      );
+    const __m256i Groups = _mm256_and_si256(
+      _mm256_shuffle_epi8(LowTable, Lows),
+      _mm256_shuffle_epi8(HighTable, Highs)
+      );
+    const uint32_t NonMembers = (uint32_t) _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(Groups, Zero)
+      );
+    if (NonMembers != UINT32_MAX) {
+      return CharIndex + (size_t) __builtin_ctz(~NonMembers);
+    }
+  }
+
+  return CharIndex + ScStrSpanNotInSetScalar(
+                       &String[CharIndex],
+                       StringLength - CharIndex,
+                       Set
+                       );
+}
+
+/*
+  SSSE3 implementation of ScStrSpanNotInSet() for sets with nibble tables.
+*/
+__attribute__((target("ssse3")))
+static size_t ScStrSpanNotInSetSsse3(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  )
+{
+  const __m128i LowTable   = _mm_loadu_si128((const __m128i *) Set->LowNibbles);
+  const __m128i HighTable  = _mm_loadu_si128(
+    (const __m128i *) Set->HighNibbles
+    );
+  const __m128i NibbleMask = _mm_set1_epi8(0x0F);
+  const __m128i Zero       = _mm_setzero_si128();
+
+  size_t CharIndex = 0;
+  for (; StringLength - CharIndex >= 16; CharIndex += 16) {
+    const __m128i Chars  = _mm_loadu_si128(
+      (const __m128i *) &String[CharIndex]
+      );
+    const __m128i Lows   = _mm_and_si128(Chars, NibbleMask);
+    const __m128i Highs  = _mm_and_si128(_mm_srli_epi16(Chars, 4), NibbleMask);
+    const __m128i Groups = _mm_and_si128(
+      _mm_shuffle_epi8(LowTable, Lows),
+      _mm_shuffle_epi8(HighTable, Highs)
+      );
+    const uint32_t NonMembers = (uint32_t) _mm_movemask_epi8(
+      _mm_cmpeq_epi8(Groups, Zero)
+      );
+    if (NonMembers != 0xFFFFU) {
+      return CharIndex + (size_t) __builtin_ctz(~NonMembers);
+    }
+  }
+
+  return CharIndex + ScStrSpanNotInSetScalar(
+                       &String[CharIndex],
+                       StringLength - CharIndex,
+                       Set
+                       );
+}
+#endif
+
+#ifdef SC_STR_SCAN_NEON
+/*
+  NEON implementation of ScStrSpanNotInSet() for sets with nibble tables.
+*/
+static size_t ScStrSpanNotInSetNeon(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  )
+{
+  const uint8x16_t LowTable   = vld1q_u8(Set->LowNibbles);
+  const uint8x16_t HighTable  = vld1q_u8(Set->HighNibbles);
+  const uint8x16_t NibbleMask = vdupq_n_u8(0x0F);
+
+  size_t CharIndex = 0;
+  for (; StringLength - CharIndex >= 16; CharIndex += 16) {
+    const uint8x16_t Chars  = vld1q_u8((const uint8_t *) &String[CharIndex]);
+    const uint8x16_t Groups = vandq_u8(
+      vqtbl1q_u8(LowTable, vandq_u8(Chars, NibbleMask)),
+      vqtbl1q_u8(HighTable, vshrq_n_u8(Chars, 4))
+      );
+    //
+    // Narrow every byte's membership to 4 bits for a 64-bit mask.
+    //
+    const uint8x16_t Member = vtstq_u8(Groups, Groups);
+    const uint64_t   Mask   = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Member), 4)),
+      0
+      );
+    if (Mask != 0) {
+      return CharIndex + (size_t) (__builtin_ctzll(Mask) >> 2U);
+    }
+  }
+
+  return CharIndex + ScStrSpanNotInSetScalar(
+                       &String[CharIndex],
+                       StringLength - CharIndex,
+                       Set
+                       );
+}
+#endif
+
+size_t ScStrSpanNotInSet(
+  const char              *String,
+  size_t                  StringLength,
+  const sc_str_char_set_t *Set
+  )
+{
+  assert(String != NULL || StringLength == 0);
+  assert(Set != NULL);
+  if (Set->Nibbles) {
+#if defined(SC_STR_SCAN_X86)
+    if (__builtin_cpu_supports("avx2")) {
+      return ScStrSpanNotInSetAvx2(String, StringLength, Set);
+    }
+
+    if (__builtin_cpu_supports("ssse3")) {
+      return ScStrSpanNotInSetSsse3(String, StringLength, Set);
+    }
+#elif defined(SC_STR_SCAN_NEON)
+    return ScStrSpanNotInSetNeon(String, StringLength, Set);
+#endif
+  }
+
+  return ScStrSpanNotInSetScalar(String, StringLength, Set);
+}
+
+///
+/// The multiplicative constants of ScStrHash64().
+///
+#define SC_STR_HASH_PRIME1  0x9E3779B185EBCA87ULL
+#define SC_STR_HASH_PRIME2  0xC2B2AE3D27D4EB4FULL
+
+/*
+  Mixes a 64-bit value such that every input bit affects every output bit.
+
+  @param[in] Value  The value to mix.
+
+  @returns  The mixed value.
+*/
+static uint64_t ScStrHashMix(
+  uint64_t Value
+  )
+{
+  Value ^= Value >> 33U;
+  Value *= 0xFF51AFD7ED558CCDULL;
+  Value ^= Value >> 33U;
+  Value *= 0xC4CEB9FE1A85EC53ULL;
+  Value ^= Value >> 33U;
+  return Value;
+}
+
+uint64_t ScStrHash64(
   const char *String,
   size_t     StringLength
   )
 {
-  assert(String != NULL && StringLength != 0);
-  assert(StringLength < SIZE_MAX);
+  assert(String != NULL || StringLength == 0);
 
-  size_t NumLines = 1;
-  for (size_t CharIndex = 0; CharIndex < StringLength; ++CharIndex) {
-    if (String[CharIndex] == '\n') {
-      //
-      // This cannot wrap around with StringLength < SIZE_MAX.
-      //
-      ++NumLines;
+  uint64_t Hash = SC_STR_HASH_PRIME1
+                    ^ ((uint64_t) StringLength * SC_STR_HASH_PRIME2);
+  //
+  // Consume the string in 8-byte little-endian words. Compilers reduce the
+  // shifting to a single load on little-endian platforms.
+  //
+  size_t CharIndex = 0;
+  for (
+    ;
+    StringLength - CharIndex >= sizeof(uint64_t);
+    CharIndex += sizeof(uint64_t)
+    ) {
+    uint64_t Word = 0;
+    for (size_t ByteIndex = 0; ByteIndex < sizeof(uint64_t); ++ByteIndex) {
+      Word |= (uint64_t) (unsigned char) String[CharIndex + ByteIndex]
+                << (ByteIndex * 8U);
     }
+
+    Hash ^= ScStrHashMix(Word * SC_STR_HASH_PRIME2);
+    Hash  = ((Hash << 27U) | (Hash >> 37U)) * SC_STR_HASH_PRIME1;
   }
+  //
+  // Consume the remaining characters as one final, zero-padded word.
+  //
+  if (CharIndex < StringLength) {
+    uint64_t Word = 0;
+    for (
+      size_t ByteIndex = 0;
+      CharIndex + ByteIndex < StringLength;
+      ++ByteIndex
+      ) {
+      Word |= (uint64_t) (unsigned char) String[CharIndex + ByteIndex]
+                << (ByteIndex * 8U);
+    }
+
+    Hash ^= ScStrHashMix(Word * SC_STR_HASH_PRIME2);
+    Hash  = ((Hash << 27U) | (Hash >> 37U)) * SC_STR_HASH_PRIME1;
+  }
+
+  return ScStrHashMix(Hash);
+}
+
+/*
+  Resizes StrLinesInfo to hold NumLines lines.
+
+  @param[in] StrLinesInfo  The string lines information to resize. It may be
+                           NULL. On failure, it is freed.
+  @param[in] NumLines      The number of lines to hold.
+
+  @retval NULL   An error has occured.
+  @retval other  The resized string lines information.
+*/
+static sc_str_lines_info_t *ScStrResizeLineInfo(
+  sc_str_lines_info_t *StrLinesInfo,
+  size_t              NumLines
+  )
+{
   //
   // Calculate the size required to hold the string lines information.
   //
@@ -62,59 +391,96 @@ sc_str_lines_info_t *ScStrGetLineInfo(
     &StrLinesInfoSize
     );
   if (Result) {
+    free(StrLinesInfo);
     return NULL;
   }
+
+  sc_str_lines_info_t *NewStrLinesInfo = realloc(
+    StrLinesInfo,
+    StrLinesInfoSize
+    );
+  if (NewStrLinesInfo == NULL) {
+    free(StrLinesInfo);
+  }
+
+  return NewStrLinesInfo;
+}
+
+sc_str_lines_info_t *ScStrGetLineInfo(
+  const char *String,
+  size_t     StringLength
+  )
+{
+  assert(String != NULL && StringLength != 0);
+  assert(StringLength < SIZE_MAX);
   //
-  // Allocate and initialise the string lines information.
+  // Guess the number of lines from a typical line length and grow the buffer
+  // by amortised doubling, so that the string is only scanned once.
   //
-  sc_str_lines_info_t *StrLinesInfo = malloc(StrLinesInfoSize);
+  size_t MaxNumLines = StringLength / SC_STR_LINE_LENGTH_ESTIMATE + 1;
+  sc_str_lines_info_t *StrLinesInfo = ScStrResizeLineInfo(NULL, MaxNumLines);
   if (StrLinesInfo == NULL) {
     return NULL;
   }
 
   StrLinesInfo->MaxLineLength = 0;
-  StrLinesInfo->NumLines      = NumLines;
-  //
-  // Describe the first line's start.
-  // The first line starts at the start of the string.
-  //
-  StrLinesInfo[0].Lines[0].Start = String;
 
-  size_t LineIndex  = 1;
-  size_t LineOffset = 0;
-  for (size_t CharIndex = 0; CharIndex < StringLength; ++CharIndex) {
-    if (String[CharIndex] == '\n') {
-      assert(LineIndex < NumLines);
-      //
-      // Describe the previous line's end and update the maximum.
-      // Any line but the last ends before the new line character.
+  size_t     NumLines   = 0;
+  const char *LineStart = String;
+  const char *StringTop = String + StringLength;
+  while (true) {
+    //
+    // memchr() is vectorised by the C standard library, hence this is bound by
+    // memory bandwidth rather than by the number of characters.
+    //
+    const char *LineEnd = memchr(
+      LineStart,
+      '\n',
+      (size_t) (StringTop - LineStart)
+      );
+    if (NumLines == MaxNumLines) {
       //
-      StrLinesInfo->Lines[LineIndex - 1].Length = CharIndex - LineOffset;
-      StrLinesInfo->MaxLineLength = SC_MAX(
-        StrLinesInfo->MaxLineLength,
-        StrLinesInfo->Lines[LineIndex - 1].Length
-        );
+      // This cannot wrap around as there are less lines than characters.
       //
-      // Describe the current line's start.
-      // Any line but the first starts after the new line character.
-      //
-      LineOffset = CharIndex + 1;
-      StrLinesInfo->Lines[LineIndex].Start = &String[LineOffset];
+      MaxNumLines *= 2;
+      StrLinesInfo = ScStrResizeLineInfo(StrLinesInfo, MaxNumLines);
+      if (StrLinesInfo == NULL) {
+        return NULL;
+      }
+    }
+    //
+    // Any line but the last ends before the new line character. The last line
+    // ends before EOF.
+    //
+    const char *LineTop = LineEnd != NULL ? LineEnd : StringTop;
+    StrLinesInfo->Lines[NumLines].Start  = LineStart;
+    StrLinesInfo->Lines[NumLines].Length = (size_t) (LineTop - LineStart);
+    StrLinesInfo->MaxLineLength = SC_MAX(
+      StrLinesInfo->MaxLineLength,
+      StrLinesInfo->Lines[NumLines].Length
+      );
+    ++NumLines;
 
-      ++LineIndex;
+    if (LineEnd == NULL) {
+      break;
     }
+    //
+    // Any line but the first starts after the new line character.
+    //
+    LineStart = LineEnd + 1;
   }
 
-  assert(LineIndex == NumLines);
+  StrLinesInfo->NumLines = NumLines;
   //
-  // Describe the last line's end and update the maximum.
-  // The last line ends before EOF.
+  // Release the unused capacity, which may fail without consequences.
   //
-  StrLinesInfo->Lines[NumLines - 1].Length = StringLength - LineOffset;
-  StrLinesInfo->MaxLineLength = SC_MAX(
-    StrLinesInfo->MaxLineLength,
-    StrLinesInfo->Lines[NumLines - 1].Length
+  sc_str_lines_info_t *ShrunkStrLinesInfo = realloc(
+    StrLinesInfo,
+    sizeof(sc_str_lines_info_t) + NumLines * sizeof(sc_str_line_info_t)
     );
+  if (ShrunkStrLinesInfo != NULL) {
+    StrLinesInfo = ShrunkStrLinesInfo;
+  }
 
   return StrLinesInfo;
 }
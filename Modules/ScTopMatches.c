@@ -0,0 +1,274 @@
+/*@file
+  Provides functions to keep the best matches of every file while its pairings
+  are rated.
+
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <ScSafeInt.h>
+#include <ScTopMatches.h>
+
+/*
+  Returns whether Match1 is a better match than Match2. Ties are resolved in
+  favour of the lower file index to not depend on the order of rating.
+*/
+static bool ScMatchIsBetter(
+  const sc_match_t *Match1,
+  const sc_match_t *Match2
+  )
+{
+  assert(Match1 != NULL);
+  assert(Match2 != NULL);
+
+  if (Match1->Score != Match2->Score) {
+    return Match1->Score > Match2->Score;
+  }
+
+  return Match1->FileIndex < Match2->FileIndex;
+}
+
+int ScCompareMatches(
+  const void *Match1,
+  const void *Match2
+  )
+{
+  if (ScMatchIsBetter(Match1, Match2)) {
+    return -1;
+  }
+
+  if (ScMatchIsBetter(Match2, Match1)) {
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+  Adds Match to the bounded heap Matches if it is better than its worst entry.
+
+  @param[in,out] Matches     The heap of at most MaxMatches matches with the
+                             worst match at its root.
+  @param[in,out] NumMatches  The number of valid entries in Matches.
+  @param[in]     MaxMatches  The capacity of Matches.
+  @param[in]     Match       The match to add.
+*/
+static void ScMatchesHeapAdd(
+  sc_match_t       *Matches,
+  unsigned int     *NumMatches,
+  unsigned int     MaxMatches,
+  const sc_match_t *Match
+  )
+{
+  assert(Matches != NULL);
+  assert(NumMatches != NULL);
+  assert(*NumMatches <= MaxMatches);
+  assert(Match != NULL);
+
+  unsigned int Index;
+  if (*NumMatches < MaxMatches) {
+    //
+    // Sift the new entry up from the end.
+    //
+    Index = *NumMatches;
+    ++(*NumMatches);
+    while (Index > 0) {
+      const unsigned int Parent = (Index - 1U) / 2U;
+      if (!ScMatchIsBetter(&Matches[Parent], Match)) {
+        break;
+      }
+
+      Matches[Index] = Matches[Parent];
+      Index          = Parent;
+    }
+
+    Matches[Index] = *Match;
+    return;
+  }
+
+  if (!ScMatchIsBetter(Match, &Matches[0])) {
+    return;
+  }
+  //
+  // Replace the worst entry and sift the new entry down from the root.
+  //
+  Index = 0;
+  while (true) {
+    unsigned int Child = 2U * Index + 1U;
+    if (Child >= MaxMatches) {
+      break;
+    }
+
+    if (Child + 1U < MaxMatches
+     && ScMatchIsBetter(&Matches[Child], &Matches[Child + 1U])) {
+      ++Child;
+    }
+
+    if (!ScMatchIsBetter(Match, &Matches[Child])) {
+      break;
+    }
+
+    Matches[Index] = Matches[Child];
+    Index          = Child;
+  }
+
+  Matches[Index] = *Match;
+}
+
+bool ScTopMatchesCreate(
+  sc_top_matches_t *TopMatches,
+  unsigned int     NumFiles,
+  unsigned int     MaxMatches
+  )
+{
+  assert(TopMatches != NULL);
+  assert(MaxMatches > 0);
+
+  TopMatches->Matches    = NULL;
+  TopMatches->NumMatches = NULL;
+  TopMatches->NumPending = NULL;
+#ifdef _OPENMP
+  TopMatches->Locks      = NULL;
+#endif
+  TopMatches->MaxMatches = MaxMatches;
+  TopMatches->NumFiles   = 0;
+
+  size_t NumMatches;
+  bool   Overflow = ScSafeMulSize(NumFiles, MaxMatches, &NumMatches);
+  Overflow |= ScSafeMulSize(NumMatches, sizeof(sc_match_t), &NumMatches);
+  if (Overflow) {
+    return false;
+  }
+
+  const size_t NumLists = SC_MAX(NumFiles, 1U);
+  TopMatches->Matches    = malloc(SC_MAX(NumMatches, 1U));
+  TopMatches->NumMatches = calloc(NumLists, sizeof(unsigned int));
+  TopMatches->NumPending = calloc(NumLists, sizeof(unsigned int));
+  bool Result = TopMatches->Matches != NULL
+             && TopMatches->NumMatches != NULL
+             && TopMatches->NumPending != NULL;
+#ifdef _OPENMP
+  TopMatches->Locks = malloc(NumLists * sizeof(omp_lock_t));
+  Result = Result && TopMatches->Locks != NULL;
+  if (Result) {
+    for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+      omp_init_lock(&TopMatches->Locks[FileIndex]);
+    }
+  }
+#endif
+  if (Result) {
+    TopMatches->NumFiles = NumFiles;
+  }
+
+  return Result;
+}
+
+void ScTopMatchesFree(
+  sc_top_matches_t *TopMatches
+  )
+{
+  assert(TopMatches != NULL);
+
+#ifdef _OPENMP
+  for (
+    unsigned int FileIndex = 0;
+    FileIndex < TopMatches->NumFiles;
+    ++FileIndex
+    ) {
+    omp_destroy_lock(&TopMatches->Locks[FileIndex]);
+  }
+
+  free(TopMatches->Locks);
+  TopMatches->Locks = NULL;
+#endif
+  free(TopMatches->Matches);
+  free(TopMatches->NumMatches);
+  free(TopMatches->NumPending);
+  TopMatches->Matches    = NULL;
+  TopMatches->NumMatches = NULL;
+  TopMatches->NumPending = NULL;
+  TopMatches->NumFiles   = 0;
+}
+
+unsigned int ScTopMatchesAdd(
+  sc_top_matches_t *TopMatches,
+  unsigned int     File1Index,
+  unsigned int     File2Index,
+  double           Score,
+  bool             Valid,
+  unsigned int     Final[2]
+  )
+{
+  assert(TopMatches != NULL);
+  assert(Final != NULL);
+
+  const unsigned int MaxMatches = TopMatches->MaxMatches;
+
+  unsigned int       NumFinal       = 0;
+  const unsigned int FileIndices[2] = { File1Index, File2Index };
+  for (unsigned int Index = 0; Index < 2; ++Index) {
+    const unsigned int FileIndex = FileIndices[Index];
+    sc_match_t *const  Matches   = &TopMatches->Matches[
+                                     (size_t) FileIndex * MaxMatches
+                                     ];
+    assert(FileIndex < TopMatches->NumFiles);
+    //
+    // Every list has its own lock, so that only ratings of the same file
+    // contend.
+    //
+    if (Valid) {
+      const sc_match_t Match = { Score, FileIndices[1U - Index] };
+#ifdef _OPENMP
+      omp_set_lock(&TopMatches->Locks[FileIndex]);
+#endif
+      ScMatchesHeapAdd(
+        Matches,
+        &TopMatches->NumMatches[FileIndex],
+        MaxMatches,
+        &Match
+        );
+#ifdef _OPENMP
+      omp_unset_lock(&TopMatches->Locks[FileIndex]);
+#endif
+    }
+    //
+    // The sequentially consistent decrement orders all additions to the list
+    // before its finalisation by the thread that adds its last pairing.
+    //
+    unsigned int NumPending;
+    #pragma omp atomic capture seq_cst
+    NumPending = --TopMatches->NumPending[FileIndex];
+
+    assert(NumPending != UINT_MAX);
+    if (NumPending == 0) {
+      Final[NumFinal] = FileIndex;
+      ++NumFinal;
+    }
+  }
+
+  return NumFinal;
+}
+
+const sc_match_t *ScTopMatchesFinalise(
+  sc_top_matches_t *TopMatches,
+  unsigned int     FileIndex,
+  unsigned int     *NumMatches
+  )
+{
+  assert(TopMatches != NULL);
+  assert(FileIndex < TopMatches->NumFiles);
+  assert(NumMatches != NULL);
+
+  sc_match_t *const Matches = &TopMatches->Matches[
+                                (size_t) FileIndex * TopMatches->MaxMatches
+                                ];
+  *NumMatches = TopMatches->NumMatches[FileIndex];
+  qsort(Matches, *NumMatches, sizeof(*Matches), ScCompareMatches);
+  return Matches;
+}
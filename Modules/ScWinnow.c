@@ -0,0 +1,567 @@
+/*@file
+  Provides functions to fingerprint buffers by winnowing and to count the
+  fingerprint hashes files share through an inverted index.
+  
+  Copyright (C) 2020 Marvin Häuser. All rights reserved.
+  SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ScSafeInt.h>
+#include <ScWinnow.h>
+
+///
+/// The base of the rolling k-gram hash.
+///
+#define SC_WINNOW_BASE  0x100000001B3ULL
+
+///
+/// The constant to mix the rolling k-gram hashes with, so that the selected
+/// minima are well-distributed.
+///
+#define SC_WINNOW_MIX  0x9E3779B97F4A7C15ULL
+
+///
+/// The minimum number of files a fingerprint hash must occur in to be
+/// considered boilerplate.
+///
+#define SC_WINNOW_MIN_BOILERPLATE_FILES  16U
+
+///
+/// The fraction of all files, as its reciprocal, a fingerprint hash must occur
+/// in to be considered boilerplate.
+///
+#define SC_WINNOW_BOILERPLATE_DIVISOR  10U
+
+///
+/// A posting of a fingerprint hash to be indexed.
+///
+typedef struct {
+  ///
+  /// The fingerprint hash.
+  ///
+  uint64_t     Hash;
+  ///
+  /// The index of the file the hash occurs in.
+  ///
+  unsigned int FileIndex;
+} sc_winnow_posting_t;
+
+/*
+  qsort() comparison function to order hashes ascendingly.
+*/
+static int ScWinnowCompareHashes(
+  const void *Hash1,
+  const void *Hash2
+  )
+{
+  const uint64_t Value1 = *(const uint64_t *) Hash1;
+  const uint64_t Value2 = *(const uint64_t *) Hash2;
+  return (Value1 > Value2) - (Value1 < Value2);
+}
+
+/*
+  qsort() comparison function to order postings by hash and file.
+*/
+static int ScWinnowComparePostings(
+  const void *Posting1,
+  const void *Posting2
+  )
+{
+  const sc_winnow_posting_t *WinnowPosting1 = Posting1;
+  const sc_winnow_posting_t *WinnowPosting2 = Posting2;
+
+  if (WinnowPosting1->Hash != WinnowPosting2->Hash) {
+    return WinnowPosting1->Hash < WinnowPosting2->Hash ? -1 : 1;
+  }
+
+  return (WinnowPosting1->FileIndex > WinnowPosting2->FileIndex)
+           - (WinnowPosting1->FileIndex < WinnowPosting2->FileIndex);
+}
+
+bool ScWinnowFingerprint(
+  sc_winnow_fingerprint_t *Fingerprint,
+  const char              *Buffer,
+  size_t                  Length
+  )
+{
+  assert(Fingerprint != NULL);
+  assert(Buffer != NULL || Length == 0);
+  //
+  // Every k-gram selects at most one hash.
+  //
+  uint64_t *Hashes = malloc(SC_MAX(Length, 1U) * sizeof(*Hashes));
+  if (Hashes == NULL) {
+    return false;
+  }
+  //
+  // The factor of the character leaving the k-gram.
+  //
+  uint64_t OutFactor = 1;
+  for (size_t Index = 1; Index < SC_WINNOW_K; ++Index) {
+    OutFactor *= SC_WINNOW_BASE;
+  }
+
+  char     Chars[SC_WINNOW_K];
+  uint64_t Window[SC_WINNOW_W];
+  uint64_t Hash      = 0;
+  size_t   NumChars  = 0;
+  size_t   NumGrams  = 0;
+  size_t   MinGram   = 0;
+  size_t   NumHashes = 0;
+  for (size_t Index = 0; Index < Length; ++Index) {
+    const char Char = Buffer[Index];
+    if (Char == '\n' || Char == '\r') {
+      continue;
+    }
+    //
+    // Roll the hash of the last SC_WINNOW_K characters.
+    //
+    if (NumChars >= SC_WINNOW_K) {
+      Hash -= OutFactor * (unsigned char) Chars[NumChars % SC_WINNOW_K];
+    }
+
+    Hash = Hash * SC_WINNOW_BASE + (unsigned char) Char;
+    Chars[NumChars % SC_WINNOW_K] = Char;
+    ++NumChars;
+    if (NumChars < SC_WINNOW_K) {
+      continue;
+    }
+
+    uint64_t Mixed = Hash * SC_WINNOW_MIX;
+    Mixed ^= Mixed >> 29U;
+    Window[NumGrams % SC_WINNOW_W] = Mixed;
+    const size_t Gram = NumGrams;
+    ++NumGrams;
+    //
+    // Select the rightmost minimum of every window of SC_WINNOW_W hashes, and
+    // record it whenever it changes.
+    //
+    if (NumGrams > SC_WINNOW_W && MinGram + SC_WINNOW_W <= Gram) {
+      MinGram = Gram + 1U - SC_WINNOW_W;
+      for (size_t Other = MinGram + 1U; Other <= Gram; ++Other) {
+        if (Window[Other % SC_WINNOW_W] <= Window[MinGram % SC_WINNOW_W]) {
+          MinGram = Other;
+        }
+      }
+
+      Hashes[NumHashes] = Window[MinGram % SC_WINNOW_W];
+      ++NumHashes;
+    } else if (Gram == 0 || Mixed <= Window[MinGram % SC_WINNOW_W]) {
+      MinGram = Gram;
+      if (NumGrams > SC_WINNOW_W) {
+        Hashes[NumHashes] = Mixed;
+        ++NumHashes;
+      }
+    }
+    //
+    // The first complete window records its minimum.
+    //
+    if (NumGrams == SC_WINNOW_W) {
+      Hashes[NumHashes] = Window[MinGram % SC_WINNOW_W];
+      ++NumHashes;
+    }
+  }
+  //
+  // Buffers too short for a complete window form a single one.
+  //
+  if (NumGrams > 0 && NumGrams < SC_WINNOW_W) {
+    Hashes[NumHashes] = Window[MinGram % SC_WINNOW_W];
+    ++NumHashes;
+  }
+  //
+  // The fingerprint is the set of the selected hashes.
+  //
+  qsort(Hashes, NumHashes, sizeof(*Hashes), ScWinnowCompareHashes);
+
+  size_t NumUnique = 0;
+  for (size_t Index = 0; Index < NumHashes; ++Index) {
+    if (NumUnique == 0 || Hashes[NumUnique - 1U] != Hashes[Index]) {
+      Hashes[NumUnique] = Hashes[Index];
+      ++NumUnique;
+    }
+  }
+
+  //
+  // Winnowing selects far fewer hashes than characters, hence release the
+  // unused space. If shrinking fails, the original allocation remains valid.
+  //
+  uint64_t *Shrunk = realloc(Hashes, SC_MAX(NumUnique, 1U) * sizeof(*Hashes));
+  if (Shrunk != NULL) {
+    Hashes = Shrunk;
+  }
+
+  Fingerprint->Hashes    = Hashes;
+  Fingerprint->NumHashes = NumUnique;
+  return true;
+}
+
+void ScWinnowFreeFingerprint(
+  sc_winnow_fingerprint_t *Fingerprint
+  )
+{
+  assert(Fingerprint != NULL);
+
+  free(Fingerprint->Hashes);
+  Fingerprint->Hashes    = NULL;
+  Fingerprint->NumHashes = 0;
+}
+
+bool ScWinnowCreateIndex(
+  sc_winnow_index_t             *Index,
+  const sc_winnow_fingerprint_t *Fingerprints,
+  unsigned int                  NumFiles,
+  unsigned int                  MaxFiles
+  )
+{
+  assert(Index != NULL);
+  assert(Fingerprints != NULL || NumFiles == 0);
+
+  size_t NumPostings = 0;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    const bool Overflow = ScSafeAddSize(
+                            NumPostings,
+                            Fingerprints[FileIndex].NumHashes,
+                            &NumPostings
+                            );
+    if (Overflow) {
+      return false;
+    }
+  }
+
+  size_t PostingsSize;
+  size_t OffsetsSize;
+  bool   Overflow = ScSafeMulSize(
+                      SC_MAX(NumPostings, 1U),
+                      sizeof(sc_winnow_posting_t),
+                      &PostingsSize
+                      );
+  Overflow |= ScSafeMulSize(NumPostings + 1U, sizeof(size_t), &OffsetsSize);
+  if (Overflow) {
+    return false;
+  }
+  //
+  // Sort the postings of all files by their hashes to group them.
+  //
+  sc_winnow_posting_t *Postings = malloc(PostingsSize);
+  Index->Hashes      = malloc(SC_MAX(NumPostings, 1U) * sizeof(uint64_t));
+  Index->Offsets     = malloc(OffsetsSize);
+  Index->FileIndices = malloc(SC_MAX(NumPostings, 1U) * sizeof(unsigned int));
+  if (Postings == NULL
+   || Index->Hashes == NULL
+   || Index->Offsets == NULL
+   || Index->FileIndices == NULL) {
+    free(Postings);
+    ScWinnowFreeIndex(Index);
+    return false;
+  }
+
+  size_t PostingIndex = 0;
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    const sc_winnow_fingerprint_t *Fingerprint = &Fingerprints[FileIndex];
+    for (
+      size_t HashIndex = 0;
+      HashIndex < Fingerprint->NumHashes;
+      ++HashIndex
+      ) {
+      Postings[PostingIndex].Hash      = Fingerprint->Hashes[HashIndex];
+      Postings[PostingIndex].FileIndex = FileIndex;
+      ++PostingIndex;
+    }
+  }
+
+  qsort(Postings, NumPostings, sizeof(*Postings), ScWinnowComparePostings);
+  //
+  // Only index the hashes that are specific to few files.
+  //
+  size_t NumHashes  = 0;
+  size_t NumIndexed = 0;
+  size_t GroupStart = 0;
+  while (GroupStart < NumPostings) {
+    size_t GroupEnd = GroupStart + 1U;
+    while (GroupEnd < NumPostings
+        && Postings[GroupEnd].Hash == Postings[GroupStart].Hash) {
+      ++GroupEnd;
+    }
+
+    if (GroupEnd - GroupStart <= MaxFiles) {
+      Index->Hashes[NumHashes]  = Postings[GroupStart].Hash;
+      Index->Offsets[NumHashes] = NumIndexed;
+      ++NumHashes;
+      for (size_t Posting = GroupStart; Posting < GroupEnd; ++Posting) {
+        Index->FileIndices[NumIndexed] = Postings[Posting].FileIndex;
+        ++NumIndexed;
+      }
+    }
+
+    GroupStart = GroupEnd;
+  }
+
+  Index->Offsets[NumHashes] = NumIndexed;
+  Index->NumHashes          = NumHashes;
+
+  free(Postings);
+  return true;
+}
+
+void ScWinnowFreeIndex(
+  sc_winnow_index_t *Index
+  )
+{
+  assert(Index != NULL);
+
+  free(Index->Hashes);
+  free(Index->Offsets);
+  free(Index->FileIndices);
+  Index->Hashes      = NULL;
+  Index->Offsets     = NULL;
+  Index->FileIndices = NULL;
+  Index->NumHashes   = 0;
+}
+
+size_t ScWinnowCountShared(
+  const sc_winnow_index_t       *Index,
+  const sc_winnow_fingerprint_t *Fingerprint,
+  unsigned int                  FileIndex,
+  uint32_t                      *Counts,
+  unsigned int                  *Sharing,
+  size_t                        *NumSharing
+  )
+{
+  assert(Index != NULL);
+  assert(Fingerprint != NULL);
+  assert(Sharing == NULL || (Counts != NULL && NumSharing != NULL));
+
+  if (Sharing != NULL) {
+    *NumSharing = 0;
+  }
+  //
+  // Both hash lists are sorted, hence the position of every hash within the
+  // index is at least the position of the previous one.
+  //
+  size_t NumIndexed = 0;
+  size_t Low        = 0;
+  for (size_t HashIndex = 0; HashIndex < Fingerprint->NumHashes; ++HashIndex) {
+    const uint64_t Hash = Fingerprint->Hashes[HashIndex];
+    size_t         High = Index->NumHashes;
+    while (Low < High) {
+      const size_t Middle = Low + (High - Low) / 2U;
+      if (Index->Hashes[Middle] < Hash) {
+        Low = Middle + 1U;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if (Low == Index->NumHashes || Index->Hashes[Low] != Hash) {
+      continue;
+    }
+
+    ++NumIndexed;
+    for (
+      size_t Posting = Index->Offsets[Low];
+      Counts != NULL && Posting < Index->Offsets[Low + 1U];
+      ++Posting
+      ) {
+      const unsigned int OtherIndex = Index->FileIndices[Posting];
+      if (OtherIndex <= FileIndex) {
+        continue;
+      }
+
+      if (Sharing != NULL && Counts[OtherIndex] == 0) {
+        Sharing[*NumSharing] = OtherIndex;
+        ++(*NumSharing);
+      }
+
+      ++Counts[OtherIndex];
+    }
+  }
+
+  return NumIndexed;
+}
+
+bool ScWinnowCorpusCreate(
+  sc_winnow_corpus_t *Corpus,
+  unsigned int       NumFiles
+  )
+{
+  assert(Corpus != NULL);
+
+  Corpus->Fingerprints = calloc(
+                           SC_MAX(NumFiles, 1U),
+                           sizeof(*Corpus->Fingerprints)
+                           );
+  Corpus->NumIndexed   = calloc(
+                           SC_MAX(NumFiles, 1U),
+                           sizeof(*Corpus->NumIndexed)
+                           );
+  Corpus->Index.Hashes      = NULL;
+  Corpus->Index.Offsets     = NULL;
+  Corpus->Index.FileIndices = NULL;
+  Corpus->Index.NumHashes   = 0;
+  Corpus->NumFiles          = NumFiles;
+  if (Corpus->Fingerprints == NULL || Corpus->NumIndexed == NULL) {
+    ScWinnowCorpusFree(Corpus);
+    return false;
+  }
+
+  return true;
+}
+
+void ScWinnowCorpusFree(
+  sc_winnow_corpus_t *Corpus
+  )
+{
+  assert(Corpus != NULL);
+
+  for (
+    unsigned int FileIndex = 0;
+    Corpus->Fingerprints != NULL && FileIndex < Corpus->NumFiles;
+    ++FileIndex
+    ) {
+    ScWinnowFreeFingerprint(&Corpus->Fingerprints[FileIndex]);
+  }
+
+  ScWinnowFreeIndex(&Corpus->Index);
+  free(Corpus->Fingerprints);
+  free(Corpus->NumIndexed);
+  Corpus->Fingerprints = NULL;
+  Corpus->NumIndexed   = NULL;
+  Corpus->NumFiles     = 0;
+}
+
+bool ScWinnowCorpusAddFile(
+  sc_winnow_corpus_t *Corpus,
+  unsigned int       FileIndex,
+  const char         *Buffer,
+  size_t             Length
+  )
+{
+  assert(Corpus != NULL);
+  assert(FileIndex < Corpus->NumFiles);
+
+  return ScWinnowFingerprint(
+           &Corpus->Fingerprints[FileIndex],
+           Buffer,
+           Length
+           );
+}
+
+bool ScWinnowCorpusIndex(
+  sc_winnow_corpus_t *Corpus
+  )
+{
+  assert(Corpus != NULL);
+
+  const unsigned int NumFiles = Corpus->NumFiles;
+  const bool         Result   = ScWinnowCreateIndex(
+                                  &Corpus->Index,
+                                  Corpus->Fingerprints,
+                                  NumFiles,
+                                  SC_MAX(
+                                    SC_WINNOW_MIN_BOILERPLATE_FILES,
+                                    NumFiles / SC_WINNOW_BOILERPLATE_DIVISOR
+                                    )
+                                  );
+  if (!Result) {
+    return false;
+  }
+  //
+  // The similarity only considers the indexed hashes.
+  //
+  #pragma omp parallel for
+  for (unsigned int FileIndex = 0; FileIndex < NumFiles; ++FileIndex) {
+    Corpus->NumIndexed[FileIndex] = ScWinnowCountShared(
+                                      &Corpus->Index,
+                                      &Corpus->Fingerprints[FileIndex],
+                                      FileIndex,
+                                      NULL,
+                                      NULL,
+                                      NULL
+                                      );
+  }
+
+  return true;
+}
+
+bool ScWinnowScanCreate(
+  sc_winnow_scan_t         *Scan,
+  const sc_winnow_corpus_t *Corpus,
+  bool                     Sparse
+  )
+{
+  assert(Scan != NULL);
+  assert(Corpus != NULL);
+
+  const size_t NumFiles = SC_MAX(Corpus->NumFiles, 1U);
+  Scan->Counts     = calloc(NumFiles, sizeof(*Scan->Counts));
+  Scan->Sharing    = NULL;
+  Scan->File1Index = 0;
+  if (Sparse) {
+    Scan->Sharing = malloc(NumFiles * sizeof(*Scan->Sharing));
+  }
+
+  return Scan->Counts != NULL && (!Sparse || Scan->Sharing != NULL);
+}
+
+void ScWinnowScanFree(
+  sc_winnow_scan_t *Scan
+  )
+{
+  assert(Scan != NULL);
+
+  free(Scan->Counts);
+  free(Scan->Sharing);
+  Scan->Counts  = NULL;
+  Scan->Sharing = NULL;
+}
+
+size_t ScWinnowScanFile(
+  const sc_winnow_corpus_t *Corpus,
+  sc_winnow_scan_t         *Scan,
+  unsigned int             File1Index
+  )
+{
+  assert(Corpus != NULL);
+  assert(Scan != NULL);
+  assert(File1Index < Corpus->NumFiles);
+  //
+  // The similarity of a file to all files with a larger index is found by a
+  // single pass over the postings of its hashes.
+  //
+  size_t NumSharing = 0;
+  (void) ScWinnowCountShared(
+           &Corpus->Index,
+           &Corpus->Fingerprints[File1Index],
+           File1Index,
+           Scan->Counts,
+           Scan->Sharing,
+           &NumSharing
+           );
+  Scan->File1Index = File1Index;
+  return NumSharing;
+}
+
+double ScWinnowScanRate(
+  const sc_winnow_corpus_t *Corpus,
+  sc_winnow_scan_t         *Scan,
+  unsigned int             File2Index
+  )
+{
+  assert(Corpus != NULL);
+  assert(Scan != NULL);
+  assert(Scan->File1Index < File2Index && File2Index < Corpus->NumFiles);
+  //
+  // Reset the counter for the next scanned file.
+  //
+  const size_t Shared = Scan->Counts[File2Index];
+  const size_t Union  = Corpus->NumIndexed[Scan->File1Index]
+                          + Corpus->NumIndexed[File2Index] - Shared;
+  Scan->Counts[File2Index] = 0;
+  return Union > 0 ? (double) Shared / (double) Union : 0;
+}